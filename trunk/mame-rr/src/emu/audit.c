@@ -56,7 +56,8 @@
 media_auditor::media_auditor(const driver_enumerator &enumerator)
 	: m_enumerator(enumerator),
 	  m_validation(AUDIT_VALIDATE_FULL),
-	  m_searchpath(NULL)
+	  m_searchpath(NULL),
+	  m_hashcache(enumerator.options())
 {
 }
 
@@ -405,7 +406,7 @@ audit_record *media_auditor::audit_one_rom(const rom_entry *rom)
 		// if it worked, get the actual length and hashes, then stop
 		if (filerr == FILERR_NONE)
 		{
-			record.set_actual(file.hashes(m_validation), file.size());
+			record.set_actual(m_hashcache.hashes(file, m_validation), file.size());
 			break;
 		}
 	}
@@ -43,6 +43,7 @@
 #define __AUDIT_H__
 
 #include "hash.h"
+#include "hashcache.h"
 
 
 
@@ -190,6 +191,7 @@ private:
 	const driver_enumerator &	m_enumerator;
 	const char *				m_validation;
 	const char *				m_searchpath;
+	file_hash_cache				m_hashcache;
 };
 
 
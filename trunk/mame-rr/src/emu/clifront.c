@@ -164,6 +164,9 @@ int cli_frontend::execute(int argc, char **argv)
 		if (option_errors)
 			printf("Error in command line:\n%s\n", option_errors.trimspace().cstr());
 
+		// commands open ZIPs too, so configure them before anything else
+		zip_file_cache_configure(m_options.zip_cache(), m_options.zip_mmap());
+
 		// determine the base name of the EXE
 		astring exename;
 		core_filename_extract_base(&exename, argv[0], TRUE);
@@ -1420,7 +1423,10 @@ media_identifier::media_identifier(cli_options &options)
 	: m_drivlist(options),
 	  m_total(0),
 	  m_matches(0),
-	  m_nonroms(0)
+	  m_nonroms(0),
+	  m_indexed(false),
+	  m_driverentries(NULL),
+	  m_driverlists(NULL)
 {
 }
 
@@ -1616,60 +1622,187 @@ int media_identifier::find_by_hash(const hash_collection &hashes, int length)
 {
 	int found = 0;
 
-	// iterate over drivers
-	m_drivlist.reset();
-	while (m_drivlist.next())
+	// build the index the first time through
+	if (!m_indexed)
+		build_index();
+
+	// look up each of our hashes; a ROM that only shares some of them may
+	// not be filed under the first
+	astring key, hashstring;
+	for (hash_base *hash = hashes.first(); hash != NULL; hash = hash->next())
 	{
-		// iterate over sources, regions and files within the region */
-		for (const rom_source *source = rom_first_source(m_drivlist.config()); source != NULL; source = rom_next_source(*source))
+		key.printf("%c%s", hash->id(), hash->string(hashstring));
+		hash_bucket *bucket = m_hashmap.find(key);
+		if (bucket == NULL)
+			continue;
+
+		for (index_ref *ref = bucket->m_refs.first(); ref != NULL; ref = ref->next())
+		{
+			index_entry *entry = &ref->m_entry;
+			hash_collection romhashes(entry->m_hashdata);
+
+			// anything carrying one of the earlier hashes was already considered
+			bool seen = false;
+			for (hash_base *prev = hashes.first(); prev != hash && !seen; prev = prev->next())
+				seen = (romhashes.hash(prev->id()) != NULL);
+			if (!seen && hashes == romhashes)
+			{
+				bool baddump = romhashes.flag(hash_collection::FLAG_BAD_DUMP);
+
+				// output information about the match
+				if (found)
+					mame_printf_info("                    ");
+				mame_printf_info("= %s%-20s  %s %s\n", baddump ? "(BAD) " : "", entry->m_name.cstr(), entry->m_owner.cstr(), entry->m_description.cstr());
+				found++;
+			}
+		}
+	}
+
+	return found;
+}
+
+
+//-------------------------------------------------
+//  build_index - collect the ROMs of every driver
+//  and software list into a map keyed by hash,
+//  so each file is a lookup rather than a scan
+//  of the whole database
+//-------------------------------------------------
+
+void media_identifier::build_index()
+{
+	m_indexed = true;
+
+	// gather the ROMs of each driver in parallel; every driver has its own
+	// slot, so the merge below sees them in driver order
+	int count = driver_list::total();
+	m_driverentries = global_alloc_array(simple_list<index_entry>, count);
+	m_driverlists = global_alloc_array(astring, count);
+	osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	if (queue != NULL)
+	{
+		osd_work_queue_parallel_for(queue, &media_identifier::index_drivers, this, count, 0);
+		osd_work_queue_free(queue);
+	}
+	else
+		index_drivers(this, 0, count, 0);
+
+	// merge the drivers, noting each software list the first time we see it
+	tagmap_t<bool> seenlists;
+	astring listnames;
+	for (int drvindex = 0; drvindex < count; drvindex++)
+	{
+		for (index_entry *entry = m_driverentries[drvindex].first(); entry != NULL; entry = entry->next())
+			add_to_index(*entry);
+		m_index.append_list(m_driverentries[drvindex]);
+
+		for (int start = 0, end; start < m_driverlists[drvindex].len(); start = end + 1)
+		{
+			end = m_driverlists[drvindex].chr(start, ' ');
+			astring listname(m_driverlists[drvindex], start, end - start);
+			if (seenlists.add(listname, true) == TMERR_NONE)
+				listnames.cat(listname).cat(" ");
+		}
+	}
+	global_free(m_driverentries);
+	global_free(m_driverlists);
+	m_driverentries = NULL;
+	m_driverlists = NULL;
+
+	// each software list is read once, however many drivers share it
+	for (int start = 0, end; start < listnames.len(); start = end + 1)
+	{
+		end = listnames.chr(start, ' ');
+		astring listname(listnames, start, end - start);
+		software_list *list = software_list_open(m_drivlist.options(), listname, FALSE, NULL);
+		if (list == NULL)
+			continue;
+
+		for (software_info *swinfo = software_list_find(list, "*", NULL); swinfo != NULL; swinfo = software_list_find(list, "*", swinfo))
+			for (software_part *part = software_find_part(swinfo, NULL, NULL); part != NULL; part = software_part_next(part))
+				for (const rom_entry *region = part->romdata; region != NULL; region = rom_next_region(region))
+					for (const rom_entry *rom = rom_first_file(region); rom != NULL; rom = rom_next_file(rom))
+					{
+						index_entry &entry = m_index.append(*global_alloc(index_entry));
+						entry.m_hashdata.cpy(ROM_GETHASHDATA(rom));
+						entry.m_name.cpy(ROM_GETNAME(rom));
+						entry.m_owner.printf("%s:%s", listname.cstr(), swinfo->shortname);
+						entry.m_description.cpy(swinfo->longname);
+						add_to_index(entry);
+					}
+
+		software_list_close(list);
+	}
+}
+
+
+//-------------------------------------------------
+//  index_drivers - collect the ROMs and software
+//  list names of a range of drivers; called from
+//  worker threads, each with its own drivers
+//-------------------------------------------------
+
+void media_identifier::index_drivers(void *param, INT32 start, INT32 end, int threadid)
+{
+	media_identifier &identifier = *reinterpret_cast<media_identifier *>(param);
+
+	for (int drvindex = start; drvindex < end; drvindex++)
+	{
+		if (!identifier.m_drivlist.included(drvindex))
+			continue;
+
+		// build a private configuration; the enumerator's cache is not
+		// safe to share between threads
+		const game_driver &driver = driver_list::driver(drvindex);
+		machine_config config(driver, identifier.m_drivlist.options());
+
+		// iterate over sources, regions and files within the region
+		for (const rom_source *source = rom_first_source(config); source != NULL; source = rom_next_source(*source))
 			for (const rom_entry *region = rom_first_region(*source); region != NULL; region = rom_next_region(region))
 				for (const rom_entry *rom = rom_first_file(region); rom != NULL; rom = rom_next_file(rom))
 				{
 					hash_collection romhashes(ROM_GETHASHDATA(rom));
-					if (!romhashes.flag(hash_collection::FLAG_NO_DUMP) && hashes == romhashes)
-					{
-						bool baddump = romhashes.flag(hash_collection::FLAG_BAD_DUMP);
-
-						// output information about the match
-						if (found)
-							mame_printf_info("                    ");
-						mame_printf_info("= %s%-20s  %-10s %s\n", baddump ? "(BAD) " : "", ROM_GETNAME(rom), m_drivlist.driver().name, m_drivlist.driver().description);
-						found++;
-					}
+					if (romhashes.flag(hash_collection::FLAG_NO_DUMP))
+						continue;
+
+					index_entry &entry = identifier.m_driverentries[drvindex].append(*global_alloc(index_entry));
+					entry.m_hashdata.cpy(ROM_GETHASHDATA(rom));
+					entry.m_name.cpy(ROM_GETNAME(rom));
+					entry.m_owner.printf("%-10s", driver.name);
+					entry.m_description.cpy(driver.description);
 				}
 
-		// next iterate over softlists
-		for (const device_t *dev = m_drivlist.config().devicelist().first(SOFTWARE_LIST); dev != NULL; dev = dev->typenext())
+		// note the software lists for later
+		for (const device_t *dev = config.devicelist().first(SOFTWARE_LIST); dev != NULL; dev = dev->typenext())
 		{
 			software_list_config *swlist = (software_list_config *)downcast<const legacy_device_base *>(dev)->inline_config();
-
 			for (int listnum = 0; listnum < DEVINFO_STR_SWLIST_MAX - DEVINFO_STR_SWLIST_0; listnum++)
 				if (swlist->list_name[listnum] != NULL)
-				{
-					software_list *list = software_list_open(m_drivlist.options(), swlist->list_name[listnum], FALSE, NULL);
+					identifier.m_driverlists[drvindex].cat(swlist->list_name[listnum]).cat(" ");
+		}
+	}
+}
 
-					for (software_info *swinfo = software_list_find(list, "*", NULL); swinfo != NULL; swinfo = software_list_find(list, "*", swinfo))
-						for (software_part *part = software_find_part(swinfo, NULL, NULL); part != NULL; part = software_part_next(part))
-							for (const rom_entry *region = part->romdata; region != NULL; region = rom_next_region(region))
-								for (const rom_entry *rom = rom_first_file(region); rom != NULL; rom = rom_next_file(rom))
-								{
-									hash_collection romhashes(ROM_GETHASHDATA(rom));
-									if (hashes == romhashes)
-									{
-										bool baddump = romhashes.flag(hash_collection::FLAG_BAD_DUMP);
 
-										// output information about the match
-										if (found)
-											mame_printf_info("                    ");
-										mame_printf_info("= %s%-20s  %s:%s %s\n", baddump ? "(BAD) " : "", ROM_GETNAME(rom), swlist->list_name[listnum], swinfo->shortname, swinfo->longname);
-										found++;
-									}
-								}
+//-------------------------------------------------
+//  add_to_index - file an entry under each of its
+//  hashes, after any earlier entries with the
+//  same hash
+//-------------------------------------------------
 
-					software_list_close(list);
-				}
+void media_identifier::add_to_index(index_entry &entry)
+{
+	astring key, hashstring;
+	hash_collection romhashes(entry.m_hashdata);
+	for (hash_base *hash = romhashes.first(); hash != NULL; hash = hash->next())
+	{
+		key.printf("%c%s", hash->id(), hash->string(hashstring));
+		hash_bucket *bucket = m_hashmap.find(key);
+		if (bucket == NULL)
+		{
+			bucket = &m_buckets.append(*global_alloc(hash_bucket));
+			m_hashmap.add(key, bucket);
 		}
+		bucket->m_refs.append(*global_alloc(index_ref(entry)));
 	}
-
-	return found;
 }
@@ -155,11 +155,64 @@ public:
 	int find_by_hash(const hash_collection &hashes, int length);
 
 private:
+	// an entry in the hash index: one ROM of a driver or a piece of software
+	class index_entry
+	{
+		friend class simple_list<index_entry>;
+
+	public:
+		index_entry *next() const { return m_next; }
+
+		index_entry *		m_next;
+		astring				m_hashdata;				// hashes in internal string form
+		astring				m_name;					// name of the ROM
+		astring				m_owner;				// driver name, or list:software
+		astring				m_description;			// driver description or software name
+	};
+
+	// a reference to an entry from the bucket of one of its hashes
+	class index_ref
+	{
+		friend class simple_list<index_ref>;
+
+	public:
+		index_ref(index_entry &entry)
+			: m_next(NULL),
+			  m_entry(entry) { }
+		index_ref *next() const { return m_next; }
+
+		index_ref *			m_next;
+		index_entry &		m_entry;
+	};
+
+	// every entry filed under one hash, in the order they were added
+	class hash_bucket
+	{
+		friend class simple_list<hash_bucket>;
+
+	public:
+		hash_bucket *next() const { return m_next; }
+
+		hash_bucket *		m_next;
+		simple_list<index_ref> m_refs;
+	};
+
+	// internal helpers
+	void build_index();
+	void add_to_index(index_entry &entry);
+	static void index_drivers(void *param, INT32 start, INT32 end, int threadid);
+
 	// internal state
 	driver_enumerator	m_drivlist;
 	int					m_total;
 	int					m_matches;
 	int					m_nonroms;
+	bool				m_indexed;				// has the hash index been built?
+	simple_list<index_entry> m_index;		// every indexed ROM, in driver order
+	simple_list<hash_bucket> m_buckets;		// every bucket in the map, for cleanup
+	tagmap_t<hash_bucket *> m_hashmap;		// map from hash to the entries with it
+	simple_list<index_entry> *m_driverentries;	// per-driver entries while building
+	astring *			m_driverlists;			// per-driver software list names while building
 };
 
 
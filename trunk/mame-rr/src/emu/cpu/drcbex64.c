@@ -599,6 +599,48 @@ inline void drcbe_x64::emit_smart_call_m64(x86code *&dst, x86code **target)
 }
 
 
+//-------------------------------------------------
+//  emit_profile_charge - charge the host cycles
+//  since the last timestamp to the current
+//  profile entry; clobbers rax, rdx and flags
+//-------------------------------------------------
+
+void drcbe_x64::emit_profile_charge(x86code *&dst)
+{
+	drcuml_profile_state &profile = *m_drcuml.profile_state();
+
+	emit_rdtsc(dst);																	// rdtsc
+	emit_shl_r64_imm(dst, REG_RDX, 32);													// shl   rdx,32
+	emit_or_r64_r64(dst, REG_RAX, REG_RDX);												// or    rax,rdx
+	emit_sub_r64_m64(dst, REG_RAX, MABS(&profile.timestamp));							// sub   rax,[timestamp]
+	emit_add_m64_r64(dst, MABS(&profile.timestamp), REG_RAX);							// add   [timestamp],rax
+	emit_mov_r64_m64(dst, REG_RDX, MABS(&profile.current));								// mov   rdx,[current]
+	emit_add_m64_r64(dst, MBD(REG_RDX, offsetof(drcuml_profile_entry, cycles)), REG_RAX);// add   [rdx].cycles,rax
+}
+
+
+//-------------------------------------------------
+//  emit_profile_entry - count an execution of the
+//  given entry point and make it current
+//-------------------------------------------------
+
+void drcbe_x64::emit_profile_entry(x86code *&dst, UINT32 mode, UINT32 pc)
+{
+	drcuml_profile_state &profile = *m_drcuml.profile_state();
+	drcuml_profile_entry *entry = m_drcuml.profile_entry(mode, pc);
+	if (entry == NULL)
+		return;
+
+	// flags may be live across a hash point, so preserve them
+	emit_pushf(dst);																	// pushf
+	emit_profile_charge(dst);															// <charge cycles>
+	emit_lea_r64_m64(dst, REG_RAX, MABS(entry));										// lea   rax,[entry]
+	emit_mov_m64_r64(dst, MABS(&profile.current), REG_RAX);								// mov   [current],rax
+	emit_add_m64_imm(dst, MABS(&entry->executions), 1);									// add   [entry].executions,1
+	emit_popf(dst);																		// popf
+}
+
+
 
 //**************************************************************************
 //  BACKEND CALLBACKS
@@ -741,12 +783,31 @@ void drcbe_x64::reset()
 	emit_sub_r64_imm(dst, REG_RSP, 8);													// sub   rsp,8
 	emit_mov_m64_r64(dst, MABS(&m_near.stacksave), REG_RSP);							// mov   [stacksave],rsp
 	emit_stmxcsr_m32(dst, MABS(&m_near.ssemode));										// stmxcsr [ssemode]
-	emit_jmp_r64(dst, REG_PARAM2);														// jmp   param2
+	if (m_drcuml.profiling())
+	{
+		drcuml_profile_state &profile = *m_drcuml.profile_state();
+		emit_mov_r64_r64(dst, REG_R11, REG_PARAM2);										// mov   r11,param2
+		emit_rdtsc(dst);																// rdtsc
+		emit_shl_r64_imm(dst, REG_RDX, 32);												// shl   rdx,32
+		emit_or_r64_r64(dst, REG_RAX, REG_RDX);											// or    rax,rdx
+		emit_mov_m64_r64(dst, MABS(&profile.timestamp), REG_RAX);						// mov   [timestamp],rax
+		emit_lea_r64_m64(dst, REG_RAX, MABS(&profile.outside));							// lea   rax,[outside]
+		emit_mov_m64_r64(dst, MABS(&profile.current), REG_RAX);							// mov   [current],rax
+		emit_jmp_r64(dst, REG_R11);														// jmp   r11
+	}
+	else
+		emit_jmp_r64(dst, REG_PARAM2);													// jmp   param2
 	if (m_log != NULL)
 		x86log_disasm_code_range(m_log, "entry_point", (x86code *)m_entry, dst);
 
 	// generate an exit point
 	m_exit = dst;
+	if (m_drcuml.profiling())
+	{
+		emit_mov_r64_r64(dst, REG_R11, REG_RAX);										// mov   r11,rax
+		emit_profile_charge(dst);														// <charge cycles>
+		emit_mov_r64_r64(dst, REG_RAX, REG_R11);										// mov   rax,r11
+	}
 	emit_ldmxcsr_m32(dst, MABS(&m_near.ssemode));										// ldmxcsr [ssemode]
 	emit_mov_r64_m64(dst, REG_RSP, MABS(&m_near.hashstacksave));						// mov   rsp,[hashstacksave]
 	emit_add_r64_imm(dst, REG_RSP, 32);													// add   rsp,32
@@ -2706,6 +2767,10 @@ void drcbe_x64::op_hash(x86code *&dst, const instruction &inst)
 
 	// register the current pointer for the mode/PC
 	m_hash.set_codeptr(inst.param(0).immediate(), inst.param(1).immediate(), dst);
+
+	// when profiling, every entry point counts itself
+	if (m_drcuml.profiling())
+		emit_profile_entry(dst, inst.param(0).immediate(), inst.param(1).immediate());
 }
 
 
@@ -148,6 +148,8 @@ private:
 	int get_base_register_and_offset(x86code *&dst, void *target, UINT8 reg, INT32 &offset);
 	void emit_smart_call_r64(x86code *&dst, x86code *target, UINT8 reg);
 	void emit_smart_call_m64(x86code *&dst, x86code **target);
+	void emit_profile_charge(x86code *&dst);
+	void emit_profile_entry(x86code *&dst, UINT32 mode, UINT32 pc);
 
 	void fixup_label(void *parameter, drccodeptr labelcodeptr);
 	void fixup_exception(drccodeptr *codeptr, void *param1, void *param2);
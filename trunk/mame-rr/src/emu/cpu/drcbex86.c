@@ -445,6 +445,51 @@ inline void drcbe_x86::emit_combine_z_shl_flags(x86code *&dst)
 }
 
 
+//-------------------------------------------------
+//  emit_profile_charge - charge the host cycles
+//  since the last timestamp to the current
+//  profile entry; clobbers eax, ecx, edx and flags
+//-------------------------------------------------
+
+void drcbe_x86::emit_profile_charge(x86code *&dst)
+{
+	drcuml_profile_state &profile = *m_drcuml.profile_state();
+
+	emit_rdtsc(dst);																	// rdtsc
+	emit_sub_r32_m32(dst, REG_EAX, MABS(&profile.timestamp));							// sub   eax,[timestamp].lo
+	emit_sbb_r32_m32(dst, REG_EDX, MABS((UINT8 *)&profile.timestamp + 4));				// sbb   edx,[timestamp].hi
+	emit_add_m32_r32(dst, MABS(&profile.timestamp), REG_EAX);							// add   [timestamp].lo,eax
+	emit_adc_m32_r32(dst, MABS((UINT8 *)&profile.timestamp + 4), REG_EDX);				// adc   [timestamp].hi,edx
+	emit_mov_r32_m32(dst, REG_ECX, MABS(&profile.current));								// mov   ecx,[current]
+	emit_add_m32_r32(dst, MBD(REG_ECX, offsetof(drcuml_profile_entry, cycles)), REG_EAX);
+																						// add   [ecx].cycles.lo,eax
+	emit_adc_m32_r32(dst, MBD(REG_ECX, offsetof(drcuml_profile_entry, cycles) + 4), REG_EDX);
+																						// adc   [ecx].cycles.hi,edx
+}
+
+
+//-------------------------------------------------
+//  emit_profile_entry - count an execution of the
+//  given entry point and make it current
+//-------------------------------------------------
+
+void drcbe_x86::emit_profile_entry(x86code *&dst, UINT32 mode, UINT32 pc)
+{
+	drcuml_profile_state &profile = *m_drcuml.profile_state();
+	drcuml_profile_entry *entry = m_drcuml.profile_entry(mode, pc);
+	if (entry == NULL)
+		return;
+
+	// flags may be live across a hash point, so preserve them
+	emit_pushf(dst);																	// pushf
+	emit_profile_charge(dst);															// <charge cycles>
+	emit_mov_m32_imm(dst, MABS(&profile.current), (FPTR)entry);							// mov   [current],entry
+	emit_add_m32_imm(dst, MABS(&entry->executions), 1);									// add   [entry].executions.lo,1
+	emit_adc_m32_imm(dst, MABS((UINT8 *)&entry->executions + 4), 0);					// adc   [entry].executions.hi,0
+	emit_popf(dst);																		// popf
+}
+
+
 //-------------------------------------------------
 //  reset_last_upper_lower_reg - reset the last
 //  upper/lower register state
@@ -623,7 +668,7 @@ void drcbe_x86::reset()
 		x86log_printf(m_log, "\n\n===========\nCACHE RESET\n===========\n\n");
 
 	// generate a little bit of glue code to set up the environment
-	drccodeptr *cachetop = m_cache.begin_codegen(500);
+	drccodeptr *cachetop = m_cache.begin_codegen(600);
 	if (cachetop == NULL)
 		fatalerror("Out of cache space after a reset!");
 
@@ -653,12 +698,29 @@ void drcbe_x86::reset()
 	emit_sub_r32_imm(dst, REG_ESP, 4);													// sub   esp,4
 	emit_mov_m32_r32(dst, MABS(&m_stacksave), REG_ESP);							// mov   [stacksave],esp
 	emit_fstcw_m16(dst, MABS(&m_fpumode));											// fstcw [fpumode]
-	emit_jmp_r32(dst, REG_EAX);															// jmp   eax
+	if (m_drcuml.profiling())
+	{
+		drcuml_profile_state &profile = *m_drcuml.profile_state();
+		emit_mov_r32_r32(dst, REG_ECX, REG_EAX);										// mov   ecx,eax
+		emit_rdtsc(dst);																// rdtsc
+		emit_mov_m32_r32(dst, MABS(&profile.timestamp), REG_EAX);						// mov   [timestamp].lo,eax
+		emit_mov_m32_r32(dst, MABS((UINT8 *)&profile.timestamp + 4), REG_EDX);			// mov   [timestamp].hi,edx
+		emit_mov_m32_imm(dst, MABS(&profile.current), (FPTR)&profile.outside);			// mov   [current],outside
+		emit_jmp_r32(dst, REG_ECX);														// jmp   ecx
+	}
+	else
+		emit_jmp_r32(dst, REG_EAX);														// jmp   eax
 	if (m_log != NULL && !m_logged_common)
 		x86log_disasm_code_range(m_log, "entry_point", (x86code *)m_entry, dst);
 
 	// generate an exit point
 	m_exit = dst;
+	if (m_drcuml.profiling())
+	{
+		emit_push_r32(dst, REG_EAX);													// push  eax
+		emit_profile_charge(dst);														// <charge cycles>
+		emit_pop_r32(dst, REG_EAX);														// pop   eax
+	}
 	emit_fldcw_m16(dst, MABS(&m_fpumode));											// fldcw [fpumode]
 	emit_mov_r32_m32(dst, REG_ESP, MABS(&m_hashstacksave));						// mov   esp,[hashstacksave]
 	emit_add_r32_imm(dst, REG_ESP, 24);													// add   esp,24
@@ -2936,6 +2998,10 @@ void drcbe_x86::op_hash(x86code *&dst, const instruction &inst)
 	// register the current pointer for the mode/PC
 	m_hash.set_codeptr(inst.param(0).immediate(), inst.param(1).immediate(), dst);
 	reset_last_upper_lower_reg();
+
+	// when profiling, every entry point counts itself
+	if (m_drcuml.profiling())
+		emit_profile_entry(dst, inst.param(0).immediate(), inst.param(1).immediate());
 }
 
 
@@ -144,6 +144,8 @@ private:
 	void normalize_commutative(be_parameter &inner, be_parameter &outer);
 	void emit_combine_z_flags(x86code *&dst);
 	void emit_combine_z_shl_flags(x86code *&dst);
+	void emit_profile_charge(x86code *&dst);
+	void emit_profile_entry(x86code *&dst, UINT32 mode, UINT32 pc);
 	void reset_last_upper_lower_reg();
 	void set_last_lower_reg(x86code *&dst, const be_parameter &param, UINT8 reglo);
 	void set_last_upper_reg(x86code *&dst, const be_parameter &param, UINT8 reghi);
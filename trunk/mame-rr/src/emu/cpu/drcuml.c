@@ -64,10 +64,12 @@
 ***************************************************************************/
 
 #include "emu.h"
+#include "emuopts.h"
 #include "drcuml.h"
 #include "drcbec.h"
 #include "drcbex86.h"
 #include "drcbex64.h"
+#include <zlib.h>
 
 using namespace uml;
 
@@ -82,6 +84,31 @@ using namespace uml;
 
 
 
+//**************************************************************************
+//  CONSTANTS
+//**************************************************************************
+
+// persistent cache file signature; the final byte is the format version
+const UINT8 PERSIST_MAGIC[8] = { 'M', 'A', 'M', 'E', 'D', 'R', 'C', 2 };
+
+// kinds of persistent block dependencies
+const UINT8 PERSIST_DEPEND_GUEST = 0;			// range of the CPU's program space
+const UINT8 PERSIST_DEPEND_HOST = 1;			// range of relocatable host memory
+
+// relocatable host pointer encodings
+const UINT64 PERSIST_POINTER_NEAR = U64(1) << 56;	// offset into the near cache
+const UINT64 PERSIST_POINTER_SYMBOL = U64(2) << 56;	// symbol index in bits 32-55, offset in bits 0-31
+const UINT64 PERSIST_POINTER_TYPE_MASK = U64(0xff) << 56;
+
+// worst-case encoded size of a single instruction
+const UINT32 PERSIST_MAX_INST_BYTES = 5 + instruction::MAX_PARAMS * (2 + 255);
+
+// sanity limits when reading a cache file
+const UINT32 PERSIST_MAX_FILE_INSTS = 65536;
+const UINT32 PERSIST_MAX_FILE_DATA = PERSIST_MAX_FILE_INSTS * 64;
+
+
+
 //**************************************************************************
 //  TYPE DEFINITIONS
 //**************************************************************************
@@ -155,11 +182,42 @@ drcuml_state::drcuml_state(device_t &device, drc_cache &cache, UINT32 flags, int
 			*static_cast<drcbe_interface *>(auto_alloc(device.machine(), drcbe_native(*this, device, cache, flags, modes, addrbits, ignorebits)))),
 	  m_umllog(NULL),
 	  m_blocklist(device.machine().respool()),
-	  m_symlist(device.machine().respool())
+	  m_symlist(device.machine().respool()),
+	  m_persist_enabled(false),
+	  m_persist_loaded(false),
+	  m_persist_dirty(false),
+	  m_persist_list(device.machine().respool()),
+	  m_persist_scratch(NULL),
+	  m_persist_scratch_size(0),
+	  m_profile(NULL),
+	  m_profile_count(0)
 {
 	// if we're to log, create the logfile
 	if (flags & DRCUML_OPTION_LOG_UML)
 		m_umllog = fopen("drcuml.asm", "w");
+
+	// translations are only kept when they can't contain logging or debugger hooks
+	memset(m_persist_hash, 0, sizeof(m_persist_hash));
+	running_machine &machine = device.machine();
+	if (machine.options().drc_cache() && m_umllog == NULL && (machine.debug_flags & DEBUG_FLAG_ENABLED) == 0)
+	{
+		m_persist_enabled = true;
+		machine.add_notifier(MACHINE_NOTIFY_EXIT, machine_notify_delegate(FUNC(drcuml_state::persist_save), this));
+	}
+
+	// set up profiling; the state must be in the near cache so the back-ends can reach it
+	memset(m_profile_hash, 0, sizeof(m_profile_hash));
+	if (machine.options().drc_profile())
+	{
+		m_profile = (drcuml_profile_state *)m_cache.alloc_near(sizeof(*m_profile));
+		if (m_profile != NULL)
+		{
+			memset(m_profile, 0, sizeof(*m_profile));
+			m_profile->outside.mode = ~0;
+			m_profile->current = &m_profile->outside;
+			machine.add_notifier(MACHINE_NOTIFY_EXIT, machine_notify_delegate(FUNC(drcuml_state::profile_report), this));
+		}
+	}
 }
 
 
@@ -175,6 +233,10 @@ drcuml_state::~drcuml_state()
 	// close any files
 	if (m_umllog != NULL)
 		fclose(m_umllog);
+
+	// free the persistent encoding buffer
+	if (m_persist_scratch != NULL)
+		global_free(m_persist_scratch);
 }
 
 
@@ -289,6 +351,145 @@ const char *drcuml_state::symbol_find(void *base, UINT32 *offset)
 }
 
 
+//-------------------------------------------------
+//  profile_entry - return the statistics entry
+//  for a mode/pc, allocating it on first use;
+//  returns NULL if the near cache is exhausted
+//-------------------------------------------------
+
+drcuml_profile_entry *drcuml_state::profile_entry(UINT32 mode, UINT32 pc)
+{
+	assert(m_profile != NULL);
+
+	// entries survive cache flushes, so a recompiled block keeps accumulating
+	drcuml_profile_entry **bucket = &m_profile_hash[((pc >> 2) ^ (pc >> 14) ^ (mode << 7)) & (PROFILE_HASH_SIZE - 1)];
+	for (drcuml_profile_entry *entry = *bucket; entry != NULL; entry = entry->hashnext)
+		if (entry->mode == mode && entry->pc == pc)
+			return entry;
+
+	// allocate a new one from the near cache
+	drcuml_profile_entry *entry = (drcuml_profile_entry *)m_cache.alloc_near(sizeof(*entry));
+	if (entry == NULL)
+		return NULL;
+	memset(entry, 0, sizeof(*entry));
+	entry->mode = mode;
+	entry->pc = pc;
+	entry->hashnext = *bucket;
+	*bucket = entry;
+	m_profile_count++;
+	return entry;
+}
+
+
+//-------------------------------------------------
+//  profile_compare - sort profile entries by
+//  descending cycle count
+//-------------------------------------------------
+
+int drcuml_state::profile_compare(const void *item1, const void *item2)
+{
+	const drcuml_profile_entry *entry1 = *(const drcuml_profile_entry * const *)item1;
+	const drcuml_profile_entry *entry2 = *(const drcuml_profile_entry * const *)item2;
+	if (entry1->cycles != entry2->cycles)
+		return (entry1->cycles > entry2->cycles) ? -1 : 1;
+	return (entry1->executions > entry2->executions) ? -1 : (entry1->executions < entry2->executions);
+}
+
+
+//-------------------------------------------------
+//  profile_report - write out the hottest blocks
+//  along with a disassembly of each one
+//-------------------------------------------------
+
+void drcuml_state::profile_report()
+{
+	const int MAX_REPORTED = 200;
+	const int MAX_DISASM = 8;
+
+	if (m_profile_count == 0)
+		return;
+
+	// gather and sort all the entries
+	drcuml_profile_entry **sorted = global_alloc_array(drcuml_profile_entry *, m_profile_count);
+	UINT32 count = 0;
+	UINT64 totalcycles = m_profile->outside.cycles;
+	UINT64 totalexecs = 0;
+	for (int bucket = 0; bucket < PROFILE_HASH_SIZE; bucket++)
+		for (drcuml_profile_entry *entry = m_profile_hash[bucket]; entry != NULL; entry = entry->hashnext)
+		{
+			sorted[count++] = entry;
+			totalcycles += entry->cycles;
+			totalexecs += entry->executions;
+		}
+	qsort(sorted, count, sizeof(sorted[0]), profile_compare);
+
+	// open the report file
+	astring filename(m_device.tag());
+	filename.replacechr(':', '_').ins(0, "drcprof_").cat(".txt");
+	FILE *report = fopen(filename, "w");
+	if (report == NULL)
+	{
+		global_free(sorted);
+		return;
+	}
+
+	fprintf(report, "DRC profile for '%s': %d entry points, %" I64FMT "u executions, %" I64FMT "u host cycles (%.2f%% outside of recompiled code)\n\n",
+			m_device.tag(), count, totalexecs, totalcycles,
+			(totalcycles == 0) ? 0.0 : 100.0 * (double)m_profile->outside.cycles / (double)totalcycles);
+	fprintf(report, "Rank   %%Cycles          Cycles       Executions  Cyc/Exec  Mode  PC\n");
+	fprintf(report, "----  -------  --------------  ---------------  --------  ----  --------\n");
+
+	// find the disassembler and program space, if we have them
+	device_disasm_interface *disasm = NULL;
+	m_device.interface(disasm);
+	address_space *space = m_device.memory().space(AS_PROGRAM);
+	UINT32 maxbytes = (disasm != NULL) ? MIN(disasm->max_opcode_bytes(), 64) : 0;
+
+	// output the hottest entries
+	for (UINT32 entrynum = 0; entrynum < count && entrynum < MAX_REPORTED; entrynum++)
+	{
+		const drcuml_profile_entry &entry = *sorted[entrynum];
+		fprintf(report, "%4d  %6.2f%%  %14" I64FMT "u  %15" I64FMT "u  %8.1f  %4d  %08X\n", entrynum + 1,
+				(totalcycles == 0) ? 0.0 : 100.0 * (double)entry.cycles / (double)totalcycles,
+				entry.cycles, entry.executions,
+				(entry.executions == 0) ? 0.0 : (double)entry.cycles / (double)entry.executions, entry.mode, entry.pc);
+
+		// disassemble the start of the block
+		if (disasm == NULL || space == NULL)
+			continue;
+		offs_t pc = entry.pc;
+		for (int instnum = 0; instnum < MAX_DISASM; instnum++)
+		{
+			offs_t pcbyte = space->address_to_byte(pc) & space->bytemask();
+			if (!m_device.memory().translate(AS_PROGRAM, TRANSLATE_FETCH_DEBUG, pcbyte))
+				break;
+
+			UINT8 opbuf[64], argbuf[64];
+			for (UINT32 bytenum = 0; bytenum < maxbytes; bytenum++)
+			{
+				opbuf[bytenum] = space->direct().read_decrypted_byte(pcbyte + bytenum);
+				argbuf[bytenum] = space->direct().read_raw_byte(pcbyte + bytenum);
+			}
+
+			char buffer[256];
+			offs_t result = disasm->disassemble(buffer, pc, opbuf, argbuf);
+			fprintf(report, "%56s%08X: %s\n", "", pc, buffer);
+
+			// stop at anything that transfers control
+			if (result & DASMFLAG_STEP_OUT)
+				break;
+			pc += space->byte_to_address(result & DASMFLAG_LENGTHMASK);
+			if ((result & DASMFLAG_LENGTHMASK) == 0)
+				break;
+		}
+	}
+
+	fclose(report);
+	global_free(sorted);
+	mame_printf_verbose("Wrote DRC profile for %s to %s\n", m_device.tag(), filename.cstr());
+}
+
+
 //-------------------------------------------------
 //  log_printf - directly printf to the UML log
 //  if generated
@@ -310,6 +511,580 @@ void drcuml_state::log_printf(const char *format, ...)
 
 
 
+//**************************************************************************
+//  PERSISTENT TRANSLATION CACHE
+//**************************************************************************
+
+//-------------------------------------------------
+//  persist_anchor - a fixed point in the image
+//  that C function pointers are stored relative
+//  to, so that they survive address randomization
+//-------------------------------------------------
+
+static void persist_anchor(void *param)
+{
+}
+
+
+//-------------------------------------------------
+//  persist_identity - describe the executable
+//  image; version.c is rebuilt on every link, so
+//  build_id changes whenever the image does, and
+//  the anchor offset catches a different layout
+//  of the same sources
+//-------------------------------------------------
+
+static astring &persist_identity(astring &dest)
+{
+	dest.printf("%s %s %" I64FMT "x", build_version, build_id, (INT64)((FPTR)build_version - (FPTR)persist_anchor));
+	return dest;
+}
+
+
+//-------------------------------------------------
+//  persist_hash - compute the hash bucket for a
+//  given mode/pc pair
+//-------------------------------------------------
+
+INLINE UINT32 persist_hash(UINT32 mode, offs_t pc, int size)
+{
+	return ((pc >> 1) ^ (pc >> 13) ^ (mode << 7)) & (size - 1);
+}
+
+
+//-------------------------------------------------
+//  persist_write/persist_read - little-endian
+//  helpers for the encoded stream
+//-------------------------------------------------
+
+INLINE UINT8 *persist_write(UINT8 *dest, UINT64 value, int bytes)
+{
+	for (int bytenum = 0; bytenum < bytes; bytenum++)
+		*dest++ = value >> (8 * bytenum);
+	return dest;
+}
+
+INLINE UINT64 persist_read(const UINT8 *&src, int bytes)
+{
+	UINT64 result = 0;
+	for (int bytenum = 0; bytenum < bytes; bytenum++)
+		result |= UINT64(*src++) << (8 * bytenum);
+	return result;
+}
+
+
+//-------------------------------------------------
+//  persist_restore - look for a translation of
+//  the given mode/pc from a previous session and
+//  hand it straight to the back-end; returns
+//  false if the block must be compiled normally
+//-------------------------------------------------
+
+bool drcuml_state::persist_restore(UINT32 mode, offs_t pc, UINT32 context)
+{
+	if (!m_persist_enabled)
+		return false;
+
+	// read the cache file the first time through
+	if (!m_persist_loaded)
+		persist_load();
+
+	// find an entry whose source memory still matches
+	for (persist_entry *entry = m_persist_hash[persist_hash(mode, pc, PERSIST_HASH_SIZE)]; entry != NULL; entry = entry->m_hashnext)
+		if (entry->m_mode == mode && entry->m_pc == pc && entry->m_context == context && persist_validate(*entry))
+		{
+			drcuml_block *block = begin_block(entry->m_numinst);
+			if (!persist_decode(*entry, block->m_inst))
+			{
+				block->m_inuse = false;
+				continue;
+			}
+
+			// the stream was captured post-optimization, so it goes directly to the back-end
+			block->m_nextinst = entry->m_numinst;
+			if (logging())
+				block->disassemble();
+			generate(*block, block->m_inst, block->m_nextinst);
+			block->m_inuse = false;
+			return true;
+		}
+
+	return false;
+}
+
+
+//-------------------------------------------------
+//  persist_capture - record a freshly generated
+//  block so that it can be reused later
+//-------------------------------------------------
+
+void drcuml_state::persist_capture(drcuml_block &block)
+{
+	// encode the instructions; anything that can't be relocated is skipped
+	UINT32 length = persist_encode(block.m_inst, block.m_nextinst);
+	if (length == 0)
+		return;
+
+	// fill in the entry, snapshotting the memory it was compiled from
+	persist_entry &entry = *auto_alloc(m_device.machine(), persist_entry);
+	entry.m_mode = block.m_persist_mode;
+	entry.m_pc = block.m_persist_pc;
+	entry.m_context = block.m_persist_context;
+	entry.m_numinst = block.m_nextinst;
+	entry.m_depends = block.m_persist_depends;
+	for (int depnum = 0; depnum < entry.m_depends; depnum++)
+	{
+		entry.m_depend[depnum] = block.m_persist_depend[depnum];
+		entry.m_depend[depnum].crc = persist_depend_crc(entry.m_depend[depnum]);
+	}
+	entry.m_datalen = length;
+	entry.m_data = global_alloc_array(UINT8, length);
+	memcpy(entry.m_data, m_persist_scratch, length);
+
+	persist_add(entry);
+	m_persist_dirty = true;
+}
+
+
+//-------------------------------------------------
+//  persist_add - add an entry to the hash table,
+//  discarding stale variants of the same block
+//-------------------------------------------------
+
+void drcuml_state::persist_add(persist_entry &entry)
+{
+	persist_entry **bucket = &m_persist_hash[persist_hash(entry.m_mode, entry.m_pc, PERSIST_HASH_SIZE)];
+
+	// new entries go to the front so that they are found first
+	m_persist_list.append(entry);
+	entry.m_hashnext = *bucket;
+	*bucket = &entry;
+
+	// walk the remaining entries, removing exact duplicates and excess variants
+	int variants = 1;
+	for (persist_entry **prevptr = &entry.m_hashnext; *prevptr != NULL; )
+	{
+		persist_entry &scan = **prevptr;
+		if (scan.m_mode == entry.m_mode && scan.m_pc == entry.m_pc && scan.m_context == entry.m_context)
+		{
+			bool same = (scan.m_depends == entry.m_depends);
+			for (int depnum = 0; same && depnum < entry.m_depends; depnum++)
+				same = (scan.m_depend[depnum].address == entry.m_depend[depnum].address &&
+						scan.m_depend[depnum].length == entry.m_depend[depnum].length &&
+						scan.m_depend[depnum].crc == entry.m_depend[depnum].crc);
+			if (same || ++variants > PERSIST_MAX_VARIANTS)
+			{
+				*prevptr = scan.m_hashnext;
+				m_persist_list.remove(scan);
+				continue;
+			}
+		}
+		prevptr = &scan.m_hashnext;
+	}
+}
+
+
+//-------------------------------------------------
+//  persist_validate - verify that all memory an
+//  entry was compiled from is unchanged
+//-------------------------------------------------
+
+bool drcuml_state::persist_validate(const persist_entry &entry)
+{
+	for (int depnum = 0; depnum < entry.m_depends; depnum++)
+		if (persist_depend_crc(entry.m_depend[depnum]) != entry.m_depend[depnum].crc)
+			return false;
+	return true;
+}
+
+
+//-------------------------------------------------
+//  persist_depend_crc - compute the current CRC
+//  of a dependency range
+//-------------------------------------------------
+
+UINT32 drcuml_state::persist_depend_crc(const drcuml_persist_depend &depend)
+{
+	// host memory must still resolve to a registered location
+	if (depend.kind == PERSIST_DEPEND_HOST)
+	{
+		const UINT8 *base = (const UINT8 *)persist_decode_pointer(depend.address);
+		if (base == NULL || persist_decode_pointer(depend.address + depend.length - 1) != base + depend.length - 1)
+			return ~crc32(0, NULL, 0);
+		return crc32(0, base, depend.length);
+	}
+
+	// guest memory is fetched the same way the front-end fetches opcodes
+	direct_read_data &direct = m_device.memory().space(AS_PROGRAM)->direct();
+	UINT8 buffer[256];
+	UINT32 crc = crc32(0, NULL, 0);
+	for (UINT32 offset = 0; offset < depend.length; )
+	{
+		UINT32 chunk = MIN(depend.length - offset, sizeof(buffer));
+		for (UINT32 bytenum = 0; bytenum < chunk; bytenum++)
+			buffer[bytenum] = direct.read_decrypted_byte(depend.address + offset + bytenum);
+		crc = crc32(crc, buffer, chunk);
+		offset += chunk;
+	}
+	return crc;
+}
+
+
+//-------------------------------------------------
+//  persist_encode_pointer - convert a host
+//  pointer into a session-independent value
+//-------------------------------------------------
+
+bool drcuml_state::persist_encode_pointer(const void *ptr, UINT64 &encoded)
+{
+	// the near cache is allocated identically every session
+	if (m_cache.contains_near_pointer(ptr))
+	{
+		encoded = PERSIST_POINTER_NEAR | ((const UINT8 *)ptr - m_cache.near());
+		return true;
+	}
+
+	// otherwise, it must fall within a registered symbol
+	UINT64 symnum = 0;
+	for (symbol *cursym = m_symlist.first(); cursym != NULL; cursym = cursym->next(), symnum++)
+		if ((const UINT8 *)ptr >= cursym->m_base && (const UINT8 *)ptr < cursym->m_base + cursym->m_length)
+		{
+			encoded = PERSIST_POINTER_SYMBOL | (symnum << 32) | ((const UINT8 *)ptr - cursym->m_base);
+			return true;
+		}
+	return false;
+}
+
+
+//-------------------------------------------------
+//  persist_decode_pointer - convert an encoded
+//  pointer back to this session's address
+//-------------------------------------------------
+
+void *drcuml_state::persist_decode_pointer(UINT64 encoded)
+{
+	if ((encoded & PERSIST_POINTER_TYPE_MASK) == PERSIST_POINTER_NEAR)
+	{
+		drccodeptr result = m_cache.near() + (encoded & ~PERSIST_POINTER_TYPE_MASK);
+		return m_cache.contains_near_pointer(result) ? result : NULL;
+	}
+
+	if ((encoded & PERSIST_POINTER_TYPE_MASK) == PERSIST_POINTER_SYMBOL)
+	{
+		UINT64 symnum = (encoded >> 32) & 0xffffff;
+		UINT32 offset = encoded & 0xffffffff;
+		for (symbol *cursym = m_symlist.first(); cursym != NULL; cursym = cursym->next(), symnum--)
+			if (symnum == 0)
+				return (offset < cursym->m_length) ? cursym->m_base + offset : NULL;
+	}
+	return NULL;
+}
+
+
+//-------------------------------------------------
+//  persist_encode - encode a list of instructions
+//  into the scratch buffer, returning the number
+//  of bytes or 0 if the block can't be kept
+//-------------------------------------------------
+
+UINT32 drcuml_state::persist_encode(const instruction *inst, UINT32 numinst)
+{
+	UINT32 offset = 0;
+	for (UINT32 instnum = 0; instnum < numinst; instnum++)
+	{
+		const instruction &curinst = inst[instnum];
+
+		// make sure there is room for the worst case
+		if (offset + PERSIST_MAX_INST_BYTES > m_persist_scratch_size)
+		{
+			UINT32 newsize = MAX(m_persist_scratch_size * 2, 65536);
+			UINT8 *newscratch = global_alloc_array(UINT8, newsize);
+			if (m_persist_scratch != NULL)
+			{
+				memcpy(newscratch, m_persist_scratch, offset);
+				global_free(m_persist_scratch);
+			}
+			m_persist_scratch = newscratch;
+			m_persist_scratch_size = newsize;
+		}
+
+		// opcode header
+		UINT8 *dest = &m_persist_scratch[offset];
+		*dest++ = curinst.m_opcode;
+		*dest++ = curinst.m_condition;
+		*dest++ = curinst.m_flags;
+		*dest++ = curinst.m_size;
+		*dest++ = curinst.m_numparams;
+
+		// parameters, relocating anything that is session-specific
+		for (int pnum = 0; pnum < curinst.m_numparams; pnum++)
+		{
+			const parameter &param = curinst.m_param[pnum];
+			UINT64 value = param.m_value;
+			*dest++ = param.m_type;
+			switch (param.m_type)
+			{
+				case parameter::PTYPE_MEMORY:
+					if (!persist_encode_pointer(param.memory(), value))
+						return 0;
+					break;
+
+				case parameter::PTYPE_C_FUNCTION:
+					value = (FPTR)param.cfunc() - (FPTR)persist_anchor;
+					break;
+
+				// handles are stored by name
+				case parameter::PTYPE_CODE_HANDLE:
+				{
+					const char *name = param.handle().string();
+					UINT32 length = strlen(name);
+					if (length > 255)
+						return 0;
+					*dest++ = length;
+					memcpy(dest, name, length);
+					dest += length;
+					continue;
+				}
+
+				// strings only come from logging comments
+				case parameter::PTYPE_STRING:
+					return 0;
+
+				default:
+					break;
+			}
+			dest = persist_write(dest, value, 8);
+		}
+		offset = dest - m_persist_scratch;
+	}
+	return offset;
+}
+
+
+//-------------------------------------------------
+//  persist_decode - decode an entry's stream into
+//  a list of instructions for this session
+//-------------------------------------------------
+
+bool drcuml_state::persist_decode(const persist_entry &entry, instruction *inst)
+{
+	const UINT8 *src = entry.m_data;
+	const UINT8 *end = src + entry.m_datalen;
+
+	for (UINT32 instnum = 0; instnum < entry.m_numinst; instnum++)
+	{
+		instruction &curinst = inst[instnum];
+
+		// opcode header
+		if (end - src < 5)
+			return false;
+		curinst.m_opcode = opcode_t(*src++);
+		curinst.m_condition = condition_t(*src++);
+		curinst.m_flags = *src++;
+		curinst.m_size = *src++;
+		curinst.m_numparams = *src++;
+		if (curinst.m_opcode >= OP_MAX || curinst.m_numparams > instruction::MAX_PARAMS)
+			return false;
+
+		// parameters
+		for (int pnum = 0; pnum < curinst.m_numparams; pnum++)
+		{
+			if (end - src < 1)
+				return false;
+			parameter::parameter_type type = parameter::parameter_type(*src++);
+			parameter::parameter_value value;
+
+			// handles are looked up by name
+			if (type == parameter::PTYPE_CODE_HANDLE)
+			{
+				if (end - src < 1 || end - src < 1 + *src)
+					return false;
+				UINT32 length = *src++;
+				code_handle *handle;
+				for (handle = m_handlelist.first(); handle != NULL; handle = handle->next())
+					if (handle->m_string.len() == length && memcmp(handle->m_string.cstr(), src, length) == 0)
+						break;
+				if (handle == NULL)
+					return false;
+				src += length;
+				value = reinterpret_cast<parameter::parameter_value>(handle);
+			}
+			else
+			{
+				if (end - src < 8)
+					return false;
+				value = persist_read(src, 8);
+				if (type == parameter::PTYPE_MEMORY)
+				{
+					void *ptr = persist_decode_pointer(value);
+					if (ptr == NULL)
+						return false;
+					value = reinterpret_cast<parameter::parameter_value>(ptr);
+				}
+				else if (type == parameter::PTYPE_C_FUNCTION)
+					value = (FPTR)persist_anchor + value;
+				else if (type == parameter::PTYPE_NONE || type == parameter::PTYPE_STRING || type >= parameter::PTYPE_MAX)
+					return false;
+			}
+			curinst.m_param[pnum] = parameter(type, value);
+		}
+	}
+	return (src == end);
+}
+
+
+//-------------------------------------------------
+//  persist_filename - build the name of the cache
+//  file for this CPU
+//-------------------------------------------------
+
+astring &drcuml_state::persist_filename(astring &dest)
+{
+	astring tag(m_device.tag());
+	tag.replacechr(':', '_');
+	dest.printf("%s" PATH_SEPARATOR "%s.drc", m_device.machine().basename(), tag.cstr());
+	return dest;
+}
+
+
+//-------------------------------------------------
+//  persist_load - read translations saved by a
+//  previous session
+//-------------------------------------------------
+
+void drcuml_state::persist_load()
+{
+	m_persist_loaded = true;
+
+	astring filename;
+	emu_file file(m_device.machine().options().cache_directory(), OPEN_FLAG_READ);
+	if (file.open(persist_filename(filename)) != FILERR_NONE)
+		return;
+
+	// validate the header; anything from a different build is ignored
+	UINT8 header[10];
+	if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, PERSIST_MAGIC, sizeof(PERSIST_MAGIC)) != 0)
+		return;
+	const UINT8 *src = &header[8];
+	UINT32 identlen = persist_read(src, 2);
+	astring identity;
+	persist_identity(identity);
+	UINT8 saved[256];
+	if (identlen != identity.len() || identlen > sizeof(saved))
+		return;
+	if (file.read(saved, identlen) != identlen || memcmp(saved, identity.cstr(), identlen) != 0)
+		return;
+	UINT8 countdata[4];
+	if (file.read(countdata, sizeof(countdata)) != sizeof(countdata))
+		return;
+	src = countdata;
+	UINT32 count = persist_read(src, 4);
+
+	// read the entries, stopping at the first sign of damage
+	for (UINT32 entrynum = 0; entrynum < count; entrynum++)
+	{
+		UINT8 fixed[24];
+		if (file.read(fixed, sizeof(fixed)) != sizeof(fixed))
+			break;
+		src = fixed;
+		UINT32 mode = persist_read(src, 4);
+		offs_t pc = persist_read(src, 4);
+		UINT32 context = persist_read(src, 4);
+		UINT32 numinst = persist_read(src, 4);
+		UINT32 depends = persist_read(src, 4);
+		UINT32 datalen = persist_read(src, 4);
+		if (numinst == 0 || numinst > PERSIST_MAX_FILE_INSTS || depends > DRCUML_PERSIST_MAX_DEPENDS || datalen > PERSIST_MAX_FILE_DATA)
+			break;
+
+		persist_entry &entry = *auto_alloc(m_device.machine(), persist_entry);
+		entry.m_mode = mode;
+		entry.m_pc = pc;
+		entry.m_context = context;
+		entry.m_numinst = numinst;
+		entry.m_depends = depends;
+		bool valid = true;
+		for (int depnum = 0; valid && depnum < depends; depnum++)
+		{
+			UINT8 depdata[17];
+			valid = (file.read(depdata, sizeof(depdata)) == sizeof(depdata));
+			src = depdata;
+			entry.m_depend[depnum].kind = persist_read(src, 1);
+			entry.m_depend[depnum].address = persist_read(src, 8);
+			entry.m_depend[depnum].length = persist_read(src, 4);
+			entry.m_depend[depnum].crc = persist_read(src, 4);
+		}
+		entry.m_datalen = datalen;
+		entry.m_data = global_alloc_array(UINT8, datalen);
+		if (!valid || file.read(entry.m_data, datalen) != datalen)
+		{
+			auto_free(m_device.machine(), &entry);
+			break;
+		}
+
+		// entries were saved oldest first, so later ones end up ahead in the buckets
+		persist_add(entry);
+	}
+	m_persist_dirty = false;
+}
+
+
+//-------------------------------------------------
+//  persist_save - write out all translations at
+//  exit if anything changed
+//-------------------------------------------------
+
+void drcuml_state::persist_save()
+{
+	if (!m_persist_dirty)
+		return;
+
+	astring filename;
+	emu_file file(m_device.machine().options().cache_directory(), OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS);
+	if (file.open(persist_filename(filename)) != FILERR_NONE)
+		return;
+
+	// header: signature, then the identity of the build that wrote it, then the entry count
+	astring identity;
+	persist_identity(identity);
+	UINT8 header[10];
+	memcpy(header, PERSIST_MAGIC, sizeof(PERSIST_MAGIC));
+	persist_write(&header[8], identity.len(), 2);
+	file.write(header, sizeof(header));
+	file.write(identity.cstr(), identity.len());
+	UINT8 countdata[4];
+	UINT8 *dest;
+	persist_write(countdata, m_persist_list.count(), 4);
+	file.write(countdata, sizeof(countdata));
+
+	// entries, oldest first so that reloading them preserves priority
+	for (persist_entry *entry = m_persist_list.first(); entry != NULL; entry = entry->next())
+	{
+		UINT8 fixed[24];
+		dest = persist_write(fixed, entry->m_mode, 4);
+		dest = persist_write(dest, entry->m_pc, 4);
+		dest = persist_write(dest, entry->m_context, 4);
+		dest = persist_write(dest, entry->m_numinst, 4);
+		dest = persist_write(dest, entry->m_depends, 4);
+		persist_write(dest, entry->m_datalen, 4);
+		file.write(fixed, sizeof(fixed));
+
+		for (int depnum = 0; depnum < entry->m_depends; depnum++)
+		{
+			UINT8 depdata[17];
+			dest = persist_write(depdata, entry->m_depend[depnum].kind, 1);
+			dest = persist_write(dest, entry->m_depend[depnum].address, 8);
+			dest = persist_write(dest, entry->m_depend[depnum].length, 4);
+			persist_write(dest, entry->m_depend[depnum].crc, 4);
+			file.write(depdata, sizeof(depdata));
+		}
+		file.write(entry->m_data, entry->m_datalen);
+	}
+	mame_printf_verbose("Saved %d recompiled blocks for %s to %s\n", m_persist_list.count(), m_device.tag(), file.fullpath());
+	m_persist_dirty = false;
+}
+
+
+
 //**************************************************************************
 //  DRCUML BLOCK
 //**************************************************************************
@@ -324,7 +1099,12 @@ drcuml_block::drcuml_block(drcuml_state &drcuml, UINT32 maxinst)
 	  m_nextinst(0),
 	  m_maxinst(maxinst * 3/2),
 	  m_inst(auto_alloc_array(drcuml.device().machine(), instruction, m_maxinst)),
-	  m_inuse(false)
+	  m_inuse(false),
+	  m_persist(false),
+	  m_persist_mode(0),
+	  m_persist_pc(0),
+	  m_persist_context(0),
+	  m_persist_depends(0)
 {
 }
 
@@ -349,6 +1129,7 @@ void drcuml_block::begin()
 	// set up the block information and return it
 	m_inuse = true;
 	m_nextinst = 0;
+	m_persist = false;
 }
 
 
@@ -371,6 +1152,10 @@ void drcuml_block::end()
 	// generate the code via the back-end
 	m_drcuml.generate(*this, m_inst, m_nextinst);
 
+	// if this block can be reused in later sessions, record it
+	if (m_persist)
+		m_drcuml.persist_capture(*this);
+
 	// block is no longer in use
 	m_inuse = false;
 }
@@ -432,6 +1217,87 @@ void drcuml_block::append_comment(const char *format, ...)
 }
 
 
+//-------------------------------------------------
+//  persist_begin - mark this block as eligible
+//  for the persistent translation cache, keyed
+//  by its entry point and the front-end context
+//-------------------------------------------------
+
+void drcuml_block::persist_begin(UINT32 mode, offs_t pc, UINT32 context)
+{
+	m_persist = m_drcuml.persisting();
+	m_persist_mode = mode;
+	m_persist_pc = pc;
+	m_persist_context = context;
+	m_persist_depends = 0;
+}
+
+
+//-------------------------------------------------
+//  persist_depend - note a range of the CPU's
+//  program space that this block was derived
+//  from, either code or constants read at
+//  compile time
+//-------------------------------------------------
+
+void drcuml_block::persist_depend(offs_t address, UINT32 length)
+{
+	if (!m_persist || length == 0)
+		return;
+
+	// extend the previous range if this one immediately follows it
+	if (m_persist_depends > 0)
+	{
+		drcuml_persist_depend &last = m_persist_depend[m_persist_depends - 1];
+		if (last.kind == PERSIST_DEPEND_GUEST && last.address + last.length == address)
+		{
+			last.length += length;
+			return;
+		}
+	}
+
+	// too many discontiguous ranges means we won't keep this one
+	if (m_persist_depends == DRCUML_PERSIST_MAX_DEPENDS)
+	{
+		m_persist = false;
+		return;
+	}
+
+	drcuml_persist_depend &depend = m_persist_depend[m_persist_depends++];
+	depend.kind = PERSIST_DEPEND_GUEST;
+	depend.address = address;
+	depend.length = length;
+	depend.crc = 0;
+}
+
+
+//-------------------------------------------------
+//  persist_depend_host - note a range of host
+//  memory whose value was folded into the block
+//  at compile time; it must be in the near cache
+//  or a registered symbol
+//-------------------------------------------------
+
+void drcuml_block::persist_depend_host(const void *base, UINT32 length)
+{
+	if (!m_persist || length == 0)
+		return;
+
+	UINT64 encoded;
+	if (m_persist_depends == DRCUML_PERSIST_MAX_DEPENDS || !m_drcuml.persist_encode_pointer(base, encoded))
+	{
+		m_persist = false;
+		return;
+	}
+
+	drcuml_persist_depend &depend = m_persist_depend[m_persist_depends++];
+	depend.kind = PERSIST_DEPEND_HOST;
+	depend.address = encoded;
+	depend.length = length;
+	depend.crc = 0;
+}
+
+
 //-------------------------------------------------
 //  optimize - apply various optimizations to a
 //  block of code
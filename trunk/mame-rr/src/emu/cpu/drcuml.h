@@ -55,6 +55,9 @@ const UINT32 DRCUML_OPTION_USE_C		= 0x0001;		// always use the C back-end
 const UINT32 DRCUML_OPTION_LOG_UML		= 0x0002;		// generate a UML disassembly of each block
 const UINT32 DRCUML_OPTION_LOG_NATIVE	= 0x0004;		// tell the back-end to generate a native disassembly of each block
 
+// maximum number of code/data dependencies tracked for a persistent block
+const int DRCUML_PERSIST_MAX_DEPENDS	= 32;
+
 
 
 //**************************************************************************
@@ -118,10 +121,41 @@ struct drcbe_info
 };
 
 
+// a range of memory that a persistent translation was derived from
+struct drcuml_persist_depend
+{
+	UINT8				kind;				// guest program space or host memory
+	UINT64				address;			// guest address, or encoded host pointer
+	UINT32				length;				// length of the range in bytes
+	UINT32				crc;				// CRC of the range when the block was compiled
+};
+
+
+// execution statistics for a single block entry point, gathered when profiling
+struct drcuml_profile_entry
+{
+	UINT64				executions;			// number of times the entry point was reached
+	UINT64				cycles;				// host cycles spent until the next entry point
+	UINT32				mode;				// mode of the entry point
+	UINT32				pc;					// PC of the entry point
+	drcuml_profile_entry *hashnext;			// link to the next entry in the same bucket
+};
+
+
+// profiling state shared with the generated code; lives in the near cache
+struct drcuml_profile_state
+{
+	drcuml_profile_entry *current;			// entry currently accumulating cycles
+	UINT64				timestamp;			// host timestamp when the current entry was reached
+	drcuml_profile_entry outside;			// time spent outside of any block
+};
+
+
 // a drcuml_block describes a basic block of instructions
 class drcuml_block
 {
 	friend class simple_list<drcuml_block>;
+	friend class drcuml_state;
 
 public:
 	// construction/destruction
@@ -142,6 +176,12 @@ public:
 	uml::instruction &append();
 	void append_comment(const char *format, ...);
 
+	// persistent translation cache
+	void persist_begin(UINT32 mode, offs_t pc, UINT32 context);
+	void persist_depend(offs_t address, UINT32 length);
+	void persist_depend_host(const void *base, UINT32 length);
+	void persist_abandon() { m_persist = false; }
+
 	// this class is thrown if abort() is called
 	class abort_compilation : public emu_exception
 	{
@@ -162,6 +202,14 @@ private:
 	UINT32					m_maxinst;			// maximum number of instructions
 	uml::instruction *		m_inst;				// pointer to the instruction list
 	bool					m_inuse;			// this block is in use
+
+	// persistent translation state
+	bool					m_persist;			// capture this block when it ends
+	UINT32					m_persist_mode;		// mode of the block entry point
+	offs_t					m_persist_pc;		// PC of the block entry point
+	UINT32					m_persist_context;	// front-end configuration the block was built with
+	UINT32					m_persist_depends;	// number of dependencies
+	drcuml_persist_depend	m_persist_depend[DRCUML_PERSIST_MAX_DEPENDS];// memory the translation depends on
 };
 
 
@@ -222,12 +270,72 @@ public:
 	void symbol_add(void *base, UINT32 length, const char *name);
 	const char *symbol_find(void *base, UINT32 *offset = NULL);
 
+	// persistent translation cache
+	bool persisting() const { return m_persist_enabled; }
+	bool persist_restore(UINT32 mode, offs_t pc, UINT32 context);
+
+	// block profiling
+	bool profiling() const { return (m_profile != NULL); }
+	drcuml_profile_state *profile_state() const { return m_profile; }
+	drcuml_profile_entry *profile_entry(UINT32 mode, UINT32 pc);
+
 	// logging
 	bool logging() const { return (m_umllog != NULL); }
 	void log_printf(const char *format, ...);
 	void log_flush() { if (logging()) fflush(m_umllog); }
 
 private:
+	friend class drcuml_block;
+
+	// a translated block retained across sessions
+	class persist_entry
+	{
+		friend class drcuml_state;
+		friend class simple_list<persist_entry>;
+
+	public:
+		// construction/destruction
+		persist_entry()
+			: m_next(NULL),
+			  m_hashnext(NULL),
+			  m_data(NULL),
+			  m_datalen(0) { }
+		~persist_entry() { global_free(m_data); }
+
+		// getters
+		persist_entry *next() const { return m_next; }
+
+	private:
+		// internal state
+		persist_entry *			m_next;				// link to the next entry
+		persist_entry *			m_hashnext;			// link to the next entry in the same bucket
+		UINT32					m_mode;				// mode of the entry point
+		offs_t					m_pc;				// PC of the entry point
+		UINT32					m_context;			// front-end configuration
+		UINT32					m_numinst;			// number of UML instructions
+		UINT32					m_depends;			// number of dependencies
+		drcuml_persist_depend	m_depend[DRCUML_PERSIST_MAX_DEPENDS];// dependencies
+		UINT8 *					m_data;				// serialized instruction stream
+		UINT32					m_datalen;			// length of the serialized stream
+	};
+
+	// persistent translation helpers
+	void persist_capture(drcuml_block &block);
+	bool persist_validate(const persist_entry &entry);
+	UINT32 persist_depend_crc(const drcuml_persist_depend &depend);
+	bool persist_encode_pointer(const void *ptr, UINT64 &encoded);
+	void *persist_decode_pointer(UINT64 encoded);
+	UINT32 persist_encode(const uml::instruction *inst, UINT32 numinst);
+	bool persist_decode(const persist_entry &entry, uml::instruction *inst);
+	void persist_add(persist_entry &entry);
+	void persist_load();
+	void persist_save();
+	astring &persist_filename(astring &dest);
+
+	// profiling helpers
+	void profile_report();
+	static int profile_compare(const void *item1, const void *item2);
+
 	// symbol class
 	class symbol
 	{
@@ -261,6 +369,23 @@ private:
 	simple_list<drcuml_block>	m_blocklist;		// list of active blocks
 	simple_list<uml::code_handle> m_handlelist;		// list of active handles
 	simple_list<symbol>			m_symlist;			// list of symbols
+
+	// persistent translation cache
+	static const int PERSIST_HASH_SIZE = 4096;		// number of hash buckets
+	static const int PERSIST_MAX_VARIANTS = 4;		// maximum entries sharing a mode/pc/context
+	bool						m_persist_enabled;	// true if translations persist across sessions
+	bool						m_persist_loaded;	// true once the cache file has been read
+	bool						m_persist_dirty;	// true if entries were added since loading
+	simple_list<persist_entry>	m_persist_list;		// list of all entries
+	persist_entry *				m_persist_hash[PERSIST_HASH_SIZE];// hash table of entries
+	UINT8 *						m_persist_scratch;	// scratch buffer for encoding
+	UINT32						m_persist_scratch_size;// size of the scratch buffer
+
+	// block profiling
+	static const int PROFILE_HASH_SIZE = 4096;		// number of hash buckets
+	drcuml_profile_state *		m_profile;			// shared profiling state, or NULL
+	drcuml_profile_entry *		m_profile_hash[PROFILE_HASH_SIZE];// hash table of entries
+	UINT32						m_profile_count;	// number of entries
 };
 
 
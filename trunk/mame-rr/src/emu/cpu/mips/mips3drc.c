@@ -55,6 +55,7 @@
 #include "emu.h"
 #include "debugger.h"
 #include "profiler.h"
+#include <zlib.h>
 #include "mips3com.h"
 #include "mips3fe.h"
 #include "cpu/drcfe.h"
@@ -463,6 +464,8 @@ static void mips3_init(mips3_flavor flavor, int bigendian, legacy_cpu_device *de
 	mips3->impstate->drcuml->symbol_add(&mips3->impstate->arg1, sizeof(mips3->impstate->arg1), "arg1");
 	mips3->impstate->drcuml->symbol_add(&mips3->impstate->numcycles, sizeof(mips3->impstate->numcycles), "numcycles");
 	mips3->impstate->drcuml->symbol_add(&mips3->impstate->fpmode, sizeof(mips3->impstate->fpmode), "fpmode");
+	const address_space_config *spaceconfig = device_get_space_config(*device, AS_PROGRAM);
+	mips3->impstate->drcuml->symbol_add((void *)vtlb_table(mips3->vtlb), sizeof(vtlb_entry) << (spaceconfig->m_logaddr_width - spaceconfig->m_page_shift), "tlb_table");
 
 	/* initialize the front-end helper */
 	mips3->impstate->drcfe = auto_alloc(device->machine(), mips3_frontend(*mips3, COMPILE_BACKWARDS_BYTES, COMPILE_FORWARDS_BYTES, SINGLE_INSTRUCTION_MODE ? 1 : COMPILE_MAX_SEQUENCE));
@@ -750,6 +753,26 @@ static void code_flush_cache(mips3_state *mips3)
 }
 
 
+/*-------------------------------------------------
+    persist_context - compute a value describing
+    everything besides memory that affects the
+    code we generate
+-------------------------------------------------*/
+
+static UINT32 persist_context(mips3_state *mips3)
+{
+	UINT32 context = crc32(0, (const Bytef *)&mips3->impstate->drcoptions, sizeof(mips3->impstate->drcoptions));
+	for (int ramnum = 0; ramnum < mips3->impstate->fastram_select; ramnum++)
+	{
+		const fast_ram_info &fastram = mips3->impstate->fastram[ramnum];
+		context = crc32(context, (const Bytef *)&fastram.start, sizeof(fastram.start));
+		context = crc32(context, (const Bytef *)&fastram.end, sizeof(fastram.end));
+		context = crc32(context, (const Bytef *)&fastram.readonly, sizeof(fastram.readonly));
+	}
+	return crc32(context, (const Bytef *)mips3->impstate->hotspot, mips3->impstate->hotspot_select * sizeof(mips3->impstate->hotspot[0]));
+}
+
+
 /*-------------------------------------------------
     code_compile_block - compile a block of the
     given mode at the specified pc
@@ -766,6 +789,20 @@ static void code_compile_block(mips3_state *mips3, UINT8 mode, offs_t pc)
 
 	g_profiler.start(PROFILER_DRC_COMPILE);
 
+	/* reuse a translation from a previous session if the code hasn't changed */
+	try
+	{
+		if (drcuml->persist_restore(mode, pc, persist_context(mips3)))
+		{
+			g_profiler.stop();
+			return;
+		}
+	}
+	catch (drcuml_block::abort_compilation &)
+	{
+		code_flush_cache(mips3);
+	}
+
 	/* get a description of this sequence */
 	desclist = mips3->impstate->drcfe->describe_code(pc);
 	if (LOG_UML || LOG_NATIVE)
@@ -780,6 +817,15 @@ static void code_compile_block(mips3_state *mips3, UINT8 mode, offs_t pc)
 			/* start the block */
 			block = drcuml->begin_block(4096);
 
+			/* note the code this block is built from */
+			block->persist_begin(mode, pc, persist_context(mips3));
+			for (const opcode_desc *curdesc = desclist; curdesc != NULL; curdesc = curdesc->next())
+			{
+				block->persist_depend(curdesc->physpc, curdesc->length);
+				for (const opcode_desc *delaydesc = curdesc->delay.first(); delaydesc != NULL; delaydesc = delaydesc->next())
+					block->persist_depend(delaydesc->physpc, delaydesc->length);
+			}
+
 			/* loop until we get through all instruction sequences */
 			for (seqhead = desclist; seqhead != NULL; seqhead = seqlast->next())
 			{
@@ -1644,6 +1690,7 @@ static void generate_sequence_instruction(mips3_state *mips3, drcuml_block *bloc
 	if ((desc->flags & OPFLAG_VALIDATE_TLB) && (desc->pc < 0x80000000 || desc->pc >= 0xc0000000))
 	{
 		const vtlb_entry *tlbtable = vtlb_table(mips3->vtlb);
+		block->persist_depend_host(&tlbtable[desc->pc >> 12], sizeof(tlbtable[0]));
 
 		/* if we currently have a valid TLB read entry, we just verify */
 		if (tlbtable[desc->pc >> 12] & VTLB_FETCH_ALLOWED)
@@ -19,6 +19,7 @@
 #include "emu.h"
 #include "debugger.h"
 #include "profiler.h"
+#include <zlib.h>
 #include "ppccom.h"
 #include "ppcfe.h"
 #include "cpu/drcfe.h"
@@ -622,6 +623,8 @@ static void ppcdrc_init(powerpc_flavor flavor, UINT8 cap, int tb_divisor, legacy
 	ppc->impstate->drcuml->symbol_add(&ppc->impstate->cmp_cr_table, sizeof(ppc->impstate->cmp_cr_table), "cmp_cr_table");
 	ppc->impstate->drcuml->symbol_add(&ppc->impstate->cmpl_cr_table, sizeof(ppc->impstate->cmpl_cr_table), "cmpl_cr_table");
 	ppc->impstate->drcuml->symbol_add(&ppc->impstate->fcmp_cr_table, sizeof(ppc->impstate->fcmp_cr_table), "fcmp_cr_table");
+	const address_space_config *spaceconfig = device_get_space_config(*device, AS_PROGRAM);
+	ppc->impstate->drcuml->symbol_add((void *)vtlb_table(ppc->vtlb), sizeof(vtlb_entry) << (spaceconfig->m_logaddr_width - spaceconfig->m_page_shift), "tlb_table");
 
 	/* initialize the front-end helper */
 	ppc->impstate->drcfe = auto_alloc(device->machine(), ppc_frontend(*ppc, COMPILE_BACKWARDS_BYTES, COMPILE_FORWARDS_BYTES, SINGLE_INSTRUCTION_MODE ? 1 : COMPILE_MAX_SEQUENCE));
@@ -917,6 +920,26 @@ static void code_flush_cache(powerpc_state *ppc)
 }
 
 
+/*-------------------------------------------------
+    persist_context - compute a value describing
+    everything besides memory that affects the
+    code we generate
+-------------------------------------------------*/
+
+static UINT32 persist_context(powerpc_state *ppc)
+{
+	UINT32 context = crc32(0, (const Bytef *)&ppc->impstate->drcoptions, sizeof(ppc->impstate->drcoptions));
+	for (int ramnum = 0; ramnum < ppc->impstate->fastram_select; ramnum++)
+	{
+		const fast_ram_info &fastram = ppc->impstate->fastram[ramnum];
+		context = crc32(context, (const Bytef *)&fastram.start, sizeof(fastram.start));
+		context = crc32(context, (const Bytef *)&fastram.end, sizeof(fastram.end));
+		context = crc32(context, (const Bytef *)&fastram.readonly, sizeof(fastram.readonly));
+	}
+	return crc32(context, (const Bytef *)ppc->impstate->hotspot, ppc->impstate->hotspot_select * sizeof(ppc->impstate->hotspot[0]));
+}
+
+
 /*-------------------------------------------------
     code_compile_block - compile a block of the
     given mode at the specified pc
@@ -933,6 +956,20 @@ static void code_compile_block(powerpc_state *ppc, UINT8 mode, offs_t pc)
 logerror("Compile %08X\n", pc);
 	g_profiler.start(PROFILER_DRC_COMPILE);
 
+	/* reuse a translation from a previous session if the code hasn't changed */
+	try
+	{
+		if (drcuml->persist_restore(mode, pc, persist_context(ppc)))
+		{
+			g_profiler.stop();
+			return;
+		}
+	}
+	catch (drcuml_block::abort_compilation &)
+	{
+		code_flush_cache(ppc);
+	}
+
 	/* get a description of this sequence */
 	desclist = ppc->impstate->drcfe->describe_code(pc);
 	if (LOG_UML || LOG_NATIVE)
@@ -946,6 +983,15 @@ logerror("Compile %08X\n", pc);
 			/* start the block */
 			block = drcuml->begin_block(4096);
 
+			/* note the code this block is built from */
+			block->persist_begin(mode, pc, persist_context(ppc));
+			for (const opcode_desc *curdesc = desclist; curdesc != NULL; curdesc = curdesc->next())
+			{
+				block->persist_depend(curdesc->physpc, curdesc->length);
+				for (const opcode_desc *delaydesc = curdesc->delay.first(); delaydesc != NULL; delaydesc = delaydesc->next())
+					block->persist_depend(delaydesc->physpc, delaydesc->length);
+			}
+
 			/* loop until we get through all instruction sequences */
 			for (seqhead = desclist; seqhead != NULL; seqhead = seqlast->next())
 			{
@@ -2159,6 +2205,7 @@ static void generate_sequence_instruction(powerpc_state *ppc, drcuml_block *bloc
 	if ((desc->flags & OPFLAG_VALIDATE_TLB) && (ppc->impstate->mode & MODE_DATA_TRANSLATION))
 	{
 		const vtlb_entry *tlbtable = vtlb_table(ppc->vtlb);
+		block->persist_depend_host(&tlbtable[desc->pc >> 12], sizeof(tlbtable[0]));
 
 		/* if we currently have a valid TLB read entry, we just verify */
 		if (tlbtable[desc->pc >> 12] != 0)
@@ -20,6 +20,7 @@
 #include "sh2.h"
 #include "sh2comn.h"
 #include "profiler.h"
+#include <zlib.h>
 
 CPU_DISASSEMBLE( sh2 );
 extern unsigned DasmSH2(char *buffer, unsigned pc, UINT16 opcode);
@@ -170,6 +171,32 @@ INLINE UINT32 RL(sh2_state *sh2, offs_t A)
 	return sh2->program->read_dword(A & AM);
 }
 
+/*-------------------------------------------------
+    persist_depend_literal - note that a block
+    folded a PC-relative literal into an immediate
+-------------------------------------------------*/
+
+INLINE void persist_depend_literal(sh2_state *sh2, drcuml_block *block, offs_t A, UINT32 length)
+{
+	/* on-chip registers can't be revalidated later */
+	if (A >= 0xe0000000)
+		block->persist_abandon();
+	else
+		block->persist_depend((A >= 0xc0000000) ? A : (A & AM), length);
+}
+
+/*-------------------------------------------------
+    persist_context - compute a value describing
+    everything besides memory that affects the
+    code we generate
+-------------------------------------------------*/
+
+INLINE UINT32 persist_context(sh2_state *sh2)
+{
+	UINT32 context = crc32(0, (const Bytef *)&sh2->drcoptions, sizeof(sh2->drcoptions));
+	return crc32(context, (const Bytef *)sh2->pcflushes, sh2->pcfsel * sizeof(sh2->pcflushes[0]));
+}
+
 /*-------------------------------------------------
     epc - compute the exception PC from a
     descriptor
@@ -931,6 +958,20 @@ static void code_compile_block(sh2_state *sh2, UINT8 mode, offs_t pc)
 
 	g_profiler.start(PROFILER_DRC_COMPILE);
 
+	/* reuse a translation from a previous session if the code hasn't changed */
+	try
+	{
+		if (drcuml->persist_restore(mode, pc, persist_context(sh2)))
+		{
+			g_profiler.stop();
+			return;
+		}
+	}
+	catch (drcuml_block::abort_compilation &)
+	{
+		code_flush_cache(sh2);
+	}
+
 	/* get a description of this sequence */
 	desclist = sh2->drcfe->describe_code(pc);
 	if (LOG_UML || LOG_NATIVE)
@@ -944,6 +985,15 @@ static void code_compile_block(sh2_state *sh2, UINT8 mode, offs_t pc)
 			/* start the block */
 			block = drcuml->begin_block(4096);
 
+			/* note the code this block is built from */
+			block->persist_begin(mode, pc, persist_context(sh2));
+			for (const opcode_desc *curdesc = desclist; curdesc != NULL; curdesc = curdesc->next())
+			{
+				block->persist_depend(curdesc->physpc, curdesc->length);
+				for (const opcode_desc *delaydesc = curdesc->delay.first(); delaydesc != NULL; delaydesc = delaydesc->next())
+					block->persist_depend(delaydesc->physpc, delaydesc->length);
+			}
+
 			/* loop until we get through all instruction sequences */
 			for (seqhead = desclist; seqhead != NULL; seqhead = seqlast->next())
 			{
@@ -1726,6 +1776,7 @@ static int generate_opcode(sh2_state *sh2, drcuml_block *block, compiler_state *
 			else
 			{
 				scratch2 = (UINT32)(INT32)(INT16) RW(sh2, scratch);
+				persist_depend_literal(sh2, block, scratch, 2);
 				UML_MOV(block, R32(Rn), scratch2);			// mov Rn, scratch2
 			}
 
@@ -1779,6 +1830,7 @@ static int generate_opcode(sh2_state *sh2, drcuml_block *block, compiler_state *
 			else
 			{
 				scratch2 = RL(sh2, scratch);
+				persist_depend_literal(sh2, block, scratch, 4);
 				UML_MOV(block, R32(Rn), scratch2);			// mov Rn, scratch2
 			}
 
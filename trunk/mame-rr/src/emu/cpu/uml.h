@@ -303,6 +303,8 @@ namespace uml
 	// a parameter for a UML instructon is encoded like this
 	class parameter
 	{
+		friend class ::drcuml_state;
+
 	public:
 		// opcode parameter types
 		enum parameter_type
@@ -421,6 +423,8 @@ namespace uml
 	// a single UML instructon is encoded like this
 	class instruction
 	{
+		friend class ::drcuml_state;
+
 	public:
 		// construction/destruction
 		instruction();
@@ -106,6 +106,7 @@ static void execute_logerror(running_machine &machine, int ref, int params, cons
 static void execute_tracelog(running_machine &machine, int ref, int params, const char **param);
 static void execute_quit(running_machine &machine, int ref, int params, const char **param);
 static void execute_do(running_machine &machine, int ref, int params, const char **param);
+static void execute_exprbench(running_machine &machine, int ref, int params, const char **param);
 static void execute_step(running_machine &machine, int ref, int params, const char **param);
 static void execute_over(running_machine &machine, int ref, int params, const char **param);
 static void execute_out(running_machine &machine, int ref, int params, const char **param);
@@ -140,6 +141,7 @@ static void execute_dasm(running_machine &machine, int ref, int params, const ch
 static void execute_find(running_machine &machine, int ref, int params, const char **param);
 static void execute_trace(running_machine &machine, int ref, int params, const char **param);
 static void execute_traceover(running_machine &machine, int ref, int params, const char **param);
+static void execute_tracebin(running_machine &machine, int ref, int params, const char **param);
 static void execute_traceflush(running_machine &machine, int ref, int params, const char **param);
 static void execute_history(running_machine &machine, int ref, int params, const char **param);
 static void execute_snap(running_machine &machine, int ref, int params, const char **param);
@@ -269,6 +271,7 @@ void debug_command_init(running_machine &machine)
 	debug_console_register_command(machine, "tracelog",  CMDFLAG_NONE, 0, 1, MAX_COMMAND_PARAMS, execute_tracelog);
 	debug_console_register_command(machine, "quit",      CMDFLAG_NONE, 0, 0, 0, execute_quit);
 	debug_console_register_command(machine, "do",        CMDFLAG_NONE, 0, 1, 1, execute_do);
+	debug_console_register_command(machine, "exprbench", CMDFLAG_NONE, 0, 1, 2, execute_exprbench);
 	debug_console_register_command(machine, "step",      CMDFLAG_NONE, 0, 0, 1, execute_step);
 	debug_console_register_command(machine, "s",         CMDFLAG_NONE, 0, 0, 1, execute_step);
 	debug_console_register_command(machine, "over",      CMDFLAG_NONE, 0, 0, 1, execute_over);
@@ -353,6 +356,7 @@ void debug_command_init(running_machine &machine)
 
 	debug_console_register_command(machine, "trace",     CMDFLAG_NONE, 0, 1, 3, execute_trace);
 	debug_console_register_command(machine, "traceover", CMDFLAG_NONE, 0, 1, 3, execute_traceover);
+	debug_console_register_command(machine, "tracebin",  CMDFLAG_NONE, 0, 1, 4, execute_tracebin);
 	debug_console_register_command(machine, "traceflush",CMDFLAG_NONE, 0, 0, 0, execute_traceflush);
 
 	debug_console_register_command(machine, "history",   CMDFLAG_NONE, 0, 0, 2, execute_history);
@@ -856,6 +860,49 @@ static void execute_do(running_machine &machine, int ref, int params, const char
 }
 
 
+/*-------------------------------------------------
+    execute_exprbench - time an expression with
+    both the compiled and interpreted evaluators
+-------------------------------------------------*/
+
+static void execute_exprbench(running_machine &machine, int ref, int params, const char *param[])
+{
+	parsed_expression expression(debug_cpu_get_visible_symtable(machine));
+	UINT64 iterations = 100000;
+
+	/* validate parameters */
+	if (!debug_command_parameter_expression(machine, param[0], expression))
+		return;
+	if (!debug_command_parameter_number(machine, param[1], &iterations))
+		return;
+	if (iterations == 0)
+		iterations = 1;
+
+	try
+	{
+		/* run the interpreter first, then the compiled form */
+		osd_ticks_t start = osd_ticks();
+		for (UINT64 count = 0; count < iterations; count++)
+			expression.interpret();
+		osd_ticks_t middle = osd_ticks();
+		for (UINT64 count = 0; count < iterations; count++)
+			expression.execute();
+		osd_ticks_t end = osd_ticks();
+
+		/* report the average time per evaluation */
+		double scale = 1e9 / ((double)osd_ticks_per_second() * (double)(INT64)iterations);
+		double interpreted = (double)(middle - start) * scale;
+		double compiled = (double)(end - middle) * scale;
+		debug_console_printf(machine, "Interpreted: %.1f ns per evaluation\n", interpreted);
+		debug_console_printf(machine, "Compiled:    %.1f ns per evaluation (%.1fx)\n", compiled, (compiled > 0) ? interpreted / compiled : 0.0);
+	}
+	catch (expression_error &err)
+	{
+		debug_console_printf(machine, "Error evaluating expression: %s\n", err.code_string());
+	}
+}
+
+
 /*-------------------------------------------------
     execute_step - execute the step command
 -------------------------------------------------*/
@@ -2359,9 +2406,10 @@ static void execute_dasm(running_machine &machine, int ref, int params, const ch
     trace over and trace info
 -------------------------------------------------*/
 
-static void execute_trace_internal(running_machine &machine, int ref, int params, const char *param[], int trace_over)
+static void execute_trace_internal(running_machine &machine, int ref, int params, const char *param[], int trace_over, int binary)
 {
 	const char *action = NULL, *filename = param[0];
+	UINT64 registers = 0;
 	device_t *cpu;
 	FILE *f = NULL;
 	const char *mode;
@@ -2369,7 +2417,9 @@ static void execute_trace_internal(running_machine &machine, int ref, int params
 	/* validate parameters */
 	if (!debug_command_parameter_cpu(machine, (params > 1) ? param[1] : NULL, &cpu))
 		return;
-	if (!debug_command_parameter_command(machine, action = param[2]))
+	if (binary && !debug_command_parameter_number(machine, param[2], &registers))
+		return;
+	if (!debug_command_parameter_command(machine, action = param[binary ? 3 : 2]))
 		return;
 
 	/* further validation */
@@ -2379,11 +2429,16 @@ static void execute_trace_internal(running_machine &machine, int ref, int params
 	/* open the file */
 	if (filename)
 	{
-		mode = "w";
+		mode = binary ? "wb" : "w";
 
 		/* opening for append? */
 		if ((filename[0] == '>') && (filename[1] == '>'))
 		{
+			if (binary)
+			{
+				debug_console_printf(machine, "Binary traces cannot be appended to\n");
+				return;
+			}
 			mode = "a";
 			filename += 2;
 		}
@@ -2397,7 +2452,7 @@ static void execute_trace_internal(running_machine &machine, int ref, int params
 	}
 
 	/* do it */
-	cpu->debug()->trace(f, trace_over, action);
+	cpu->debug()->trace(f, trace_over, action, binary, registers != 0);
 	if (f)
 		debug_console_printf(machine, "Tracing CPU '%s' to file %s\n", cpu->tag(), filename);
 	else
@@ -2411,7 +2466,7 @@ static void execute_trace_internal(running_machine &machine, int ref, int params
 
 static void execute_trace(running_machine &machine, int ref, int params, const char *param[])
 {
-	execute_trace_internal(machine, ref, params, param, 0);
+	execute_trace_internal(machine, ref, params, param, 0, 0);
 }
 
 
@@ -2421,7 +2476,18 @@ static void execute_trace(running_machine &machine, int ref, int params, const c
 
 static void execute_traceover(running_machine &machine, int ref, int params, const char *param[])
 {
-	execute_trace_internal(machine, ref, params, param, 1);
+	execute_trace_internal(machine, ref, params, param, 1, 0);
+}
+
+
+/*-------------------------------------------------
+    execute_tracebin - execute the binary trace
+    command
+-------------------------------------------------*/
+
+static void execute_tracebin(running_machine &machine, int ref, int params, const char *param[])
+{
+	execute_trace_internal(machine, ref, params, param, 0, 1);
 }
 
 
@@ -41,6 +41,7 @@
 #include "emuopts.h"
 #include "osdepend.h"
 #include "debugcpu.h"
+#include "debugtrc.h"
 #include "debugcmd.h"
 #include "debugcon.h"
 #include "express.h"
@@ -1681,6 +1682,8 @@ device_debug::device_debug(device_t &device)
 {
 	memset(m_pc_history, 0, sizeof(m_pc_history));
 	memset(m_wplist, 0, sizeof(m_wplist));
+	memset(m_bpfilter, 0, sizeof(m_bpfilter));
+	memset(m_bphash, 0, sizeof(m_bphash));
 
 	// find out which interfaces we have to work with
 	device.interface(m_exec);
@@ -2719,7 +2722,7 @@ UINT32 device_debug::compute_opcode_crc32(offs_t address) const
 //  trace - trace execution of a given device
 //-------------------------------------------------
 
-void device_debug::trace(FILE *file, bool trace_over, const char *action)
+void device_debug::trace(FILE *file, bool trace_over, const char *action, bool binary, bool registers)
 {
 	// delete any existing tracers
 	auto_free(m_device.machine(), m_trace);
@@ -2727,7 +2730,7 @@ void device_debug::trace(FILE *file, bool trace_over, const char *action)
 
 	// if we have a new file, make a new tracer
 	if (file != NULL)
-		m_trace = auto_alloc(m_device.machine(), tracer(*this, *file, trace_over, action));
+		m_trace = auto_alloc(m_device.machine(), tracer(*this, *file, trace_over, action, binary, registers));
 }
 
 
@@ -2826,13 +2829,30 @@ void device_debug::prepare_for_step_overout(offs_t pc)
 
 void device_debug::breakpoint_update_flags()
 {
-	// see if there are any enabled breakpoints
+	// rebuild the address index from scratch
+	memset(m_bpfilter, 0, sizeof(m_bpfilter));
+	breakpoint **tail[BP_HASH_SIZE];
+	for (int bucket = 0; bucket < BP_HASH_SIZE; bucket++)
+	{
+		m_bphash[bucket] = NULL;
+		tail[bucket] = &m_bphash[bucket];
+	}
+
+	// add enabled breakpoints, keeping each bucket in list order so the
+	// same breakpoint wins when several share an address
 	m_flags &= ~DEBUG_FLAG_LIVE_BP;
 	for (breakpoint *bp = m_bplist; bp != NULL; bp = bp->m_next)
 		if (bp->m_enabled)
 		{
+			UINT32 bit = breakpoint_filter_bit(bp->m_address);
+			m_bpfilter[bit / 32] |= 1 << (bit % 32);
+
+			int bucket = bit % BP_HASH_SIZE;
+			bp->m_hashnext = NULL;
+			*tail[bucket] = bp;
+			tail[bucket] = &bp->m_hashnext;
+
 			m_flags |= DEBUG_FLAG_LIVE_BP;
-			break;
 		}
 
 	// push the flags out globally
@@ -2849,8 +2869,13 @@ void device_debug::breakpoint_update_flags()
 
 void device_debug::breakpoint_check(offs_t pc)
 {
+	// most addresses have no breakpoint at all; a single bit test rules them out
+	UINT32 bit = breakpoint_filter_bit(pc);
+	if ((m_bpfilter[bit / 32] & (1 << (bit % 32))) == 0)
+		return;
+
 	// see if we match
-	for (breakpoint *bp = m_bplist; bp != NULL; bp = bp->m_next)
+	for (breakpoint *bp = m_bphash[bit % BP_HASH_SIZE]; bp != NULL; bp = bp->m_hashnext)
 		if (bp->hit(pc))
 		{
 			// halt in the debugger by default
@@ -3039,18 +3064,9 @@ UINT32 device_debug::dasm_wrapped(astring &buffer, offs_t pc)
 {
 	assert(m_memory != NULL && m_disasm != NULL);
 
-	// determine the adjusted PC
-	address_space *space = m_memory->space(AS_PROGRAM);
-	offs_t pcbyte = space->address_to_byte(pc) & space->bytemask();
-
 	// fetch the bytes up to the maximum
 	UINT8 opbuf[64], argbuf[64];
-	int maxbytes = max_opcode_bytes();
-	for (int numbytes = 0; numbytes < maxbytes; numbytes++)
-	{
-		opbuf[numbytes] = debug_read_opcode(space, pcbyte + numbytes, 1, false);
-		argbuf[numbytes] = debug_read_opcode(space, pcbyte + numbytes, 1, true);
-	}
+	fetch_opcodes(pc, opbuf, argbuf, max_opcode_bytes());
 
 	// disassemble to our buffer
 	buffer.expand(200);
@@ -3058,6 +3074,28 @@ UINT32 device_debug::dasm_wrapped(astring &buffer, offs_t pc)
 }
 
 
+//-------------------------------------------------
+//  fetch_opcodes - read the opcode and argument
+//  bytes at the given PC
+//-------------------------------------------------
+
+void device_debug::fetch_opcodes(offs_t pc, UINT8 *opbuf, UINT8 *argbuf, int numbytes)
+{
+	assert(m_memory != NULL);
+
+	// determine the adjusted PC
+	address_space *space = m_memory->space(AS_PROGRAM);
+	offs_t pcbyte = space->address_to_byte(pc) & space->bytemask();
+
+	// fetch the bytes up to the requested count
+	for (int index = 0; index < numbytes; index++)
+	{
+		opbuf[index] = debug_read_opcode(space, pcbyte + index, 1, false);
+		argbuf[index] = debug_read_opcode(space, pcbyte + index, 1, true);
+	}
+}
+
+
 //-------------------------------------------------
 //  get_current_pc - getter callback for a device's
 //  current instruction pointer
@@ -3141,6 +3179,7 @@ void device_debug::set_state(symbol_table &table, void *ref, UINT64 value)
 
 device_debug::breakpoint::breakpoint(symbol_table &symbols, int index, offs_t address, const char *condition, const char *action)
 	: m_next(NULL),
+	  m_hashnext(NULL),
 	  m_index(index),
 	  m_enabled(true),
 	  m_address(address),
@@ -3247,16 +3286,36 @@ bool device_debug::watchpoint::hit(int type, offs_t address, int size)
 //  tracer - constructor
 //-------------------------------------------------
 
-device_debug::tracer::tracer(device_debug &debug, FILE &file, bool trace_over, const char *action)
+device_debug::tracer::tracer(device_debug &debug, FILE &file, bool trace_over, const char *action, bool binary, bool registers)
 	: m_debug(debug),
 	  m_file(file),
 	  m_action((action != NULL) ? action : ""),
 	  m_loops(0),
 	  m_nextdex(0),
 	  m_trace_over(trace_over),
-	  m_trace_over_target(~0)
+	  m_trace_over_target(~0),
+	  m_binary(binary),
+	  m_registers(registers),
+	  m_opbytes(0),
+	  m_lastpc(0),
+	  m_lastframe(~0),
+	  m_opcache(NULL),
+	  m_numregs(0),
+	  m_regindex(NULL),
+	  m_regvalue(NULL),
+	  m_curbuffer(0),
+	  m_bufpos(0),
+	  m_queue(NULL),
+	  m_writeitem(NULL),
+	  m_writedata(NULL),
+	  m_writelength(0)
 {
 	memset(m_history, 0, sizeof(m_history));
+	m_buffer[0] = m_buffer[1] = NULL;
+
+	// binary traces need their buffers and header set up
+	if (m_binary)
+		binary_start();
 }
 
 
@@ -3266,6 +3325,21 @@ device_debug::tracer::tracer(device_debug &debug, FILE &file, bool trace_over, c
 
 device_debug::tracer::~tracer()
 {
+	// write out anything still pending from a binary trace
+	if (m_binary)
+	{
+		if (m_loops != 0)
+			binary_loops();
+		binary_submit(true);
+		if (m_queue != NULL)
+			osd_work_queue_free(m_queue);
+		global_free(m_opcache);
+		global_free(m_regindex);
+		global_free(m_regvalue);
+		global_free(m_buffer[0]);
+		global_free(m_buffer[1]);
+	}
+
 	// make sure we close the file if we can
 	fclose(&m_file);
 }
@@ -3301,25 +3375,41 @@ void device_debug::tracer::update(offs_t pc)
 
 	// if we just finished looping, indicate as much
 	if (m_loops != 0)
-		fprintf(&m_file, "\n   (loops for %d instructions)\n\n", m_loops);
+	{
+		if (m_binary)
+			binary_loops();
+		else
+			fprintf(&m_file, "\n   (loops for %d instructions)\n\n", m_loops);
+	}
 	m_loops = 0;
 
 	// execute any trace actions first
 	if (m_action)
 		debug_console_execute_command(m_debug.m_device.machine(), m_action, 0);
 
-	// print the address
-	astring buffer;
-	int logaddrchars = m_debug.logaddrchars();
-	buffer.printf("%0*X: ", logaddrchars, pc);
-
-	// print the disassembly
+	// binary traces defer disassembly unless we need it to trace over
 	astring dasm;
-	offs_t dasmresult = m_debug.dasm_wrapped(dasm, pc);
-	buffer.cat(dasm);
+	offs_t dasmresult = 0;
+	if (m_binary)
+	{
+		binary_update(pc);
+		if (m_trace_over)
+			dasmresult = m_debug.dasm_wrapped(dasm, pc);
+	}
+	else
+	{
+		// print the address
+		astring buffer;
+		int logaddrchars = m_debug.logaddrchars();
+		buffer.printf("%0*X: ", logaddrchars, pc);
 
-	// output the result
-	fprintf(&m_file, "%s\n", buffer.cstr());
+		// print the disassembly
+		dasmresult = m_debug.dasm_wrapped(dasm, pc);
+		buffer.cat(dasm);
+
+		// output the result
+		fprintf(&m_file, "%s\n", buffer.cstr());
+	}
 
 	// do we need to step the trace over this instruction?
 	if (m_trace_over && (dasmresult & DASMFLAG_SUPPORTED) != 0 && (dasmresult & DASMFLAG_STEP_OVER) != 0)
@@ -3346,6 +3436,22 @@ void device_debug::tracer::update(offs_t pc)
 
 void device_debug::tracer::vprintf(const char *format, va_list va)
 {
+	// binary traces wrap the text in a record
+	if (m_binary)
+	{
+		astring text;
+		text.vprintf(format, va);
+		UINT32 length = MIN(text.len(), BINARY_RECORD_MAX - 16);
+
+		UINT8 *start = binary_reserve(length + 16);
+		UINT8 *dest = start;
+		*dest++ = TRACE_RECORD_TEXT;
+		dest = trace_put_varint(dest, length);
+		memcpy(dest, text.cstr(), length);
+		m_bufpos += dest + length - start;
+		return;
+	}
+
 	// pass through to the file
 	vfprintf(&m_file, format, va);
 }
@@ -3358,10 +3464,239 @@ void device_debug::tracer::vprintf(const char *format, va_list va)
 
 void device_debug::tracer::flush()
 {
+	if (m_binary)
+		binary_submit(true);
 	fflush(&m_file);
 }
 
 
+//-------------------------------------------------
+//  binary_start - allocate the binary trace
+//  state and write the file header
+//-------------------------------------------------
+
+void device_debug::tracer::binary_start()
+{
+	// allocate the output buffers and a queue to write them in the background
+	m_buffer[0] = global_alloc_array(UINT8, BINARY_BUFFER_SIZE);
+	m_buffer[1] = global_alloc_array(UINT8, BINARY_BUFFER_SIZE);
+	m_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_IO);
+
+	// set up the opcode cache
+	m_opbytes = MIN(m_debug.max_opcode_bytes(), TRACE_BINARY_MAX_BYTES);
+	m_opcache = global_alloc(trace_opcode_cache(m_opbytes));
+
+	// gather the visible registers, if requested
+	const device_state_entry *entry;
+	if (m_registers && m_debug.m_state != NULL)
+	{
+		for (entry = m_debug.m_state->state_first(); entry != NULL; entry = entry->next())
+			if (entry->visible() && entry->index() >= 0 && m_numregs < TRACE_BINARY_MAX_REGS)
+				m_numregs++;
+		m_regindex = global_alloc_array_clear(int, MAX(m_numregs, 1));
+		m_regvalue = global_alloc_array_clear(UINT64, MAX(m_numregs, 1));
+	}
+
+	// write the fixed part of the header
+	UINT8 *dest = binary_reserve(sizeof(TRACE_BINARY_MAGIC) + 4);
+	memcpy(dest, TRACE_BINARY_MAGIC, sizeof(TRACE_BINARY_MAGIC));
+	dest += sizeof(TRACE_BINARY_MAGIC);
+	*dest++ = (m_numregs != 0) ? TRACE_BINARY_FLAG_REGISTERS : 0;
+	*dest++ = m_opbytes;
+	*dest++ = m_debug.logaddrchars();
+	*dest++ = m_numregs;
+	m_bufpos += sizeof(TRACE_BINARY_MAGIC) + 4;
+
+	// followed by the CPU tag and the register names
+	int regnum = 0;
+	const char *name = m_debug.m_device.tag();
+	entry = (m_numregs != 0) ? m_debug.m_state->state_first() : NULL;
+	while (name != NULL)
+	{
+		UINT32 length = MIN(strlen(name), 255);
+		dest = binary_reserve(length + 1);
+		*dest++ = length;
+		memcpy(dest, name, length);
+		m_bufpos += length + 1;
+
+		// advance to the next tracked register
+		name = NULL;
+		for ( ; entry != NULL && regnum < m_numregs; entry = entry->next())
+			if (entry->visible() && entry->index() >= 0)
+			{
+				m_regindex[regnum++] = entry->index();
+				name = entry->symbol();
+				entry = entry->next();
+				break;
+			}
+	}
+}
+
+
+//-------------------------------------------------
+//  binary_update - append a record for the given
+//  instruction to a binary trace
+//-------------------------------------------------
+
+void device_debug::tracer::binary_update(offs_t pc)
+{
+	// note the start of each new frame
+	screen_device *screen = m_debug.m_device.machine().primary_screen;
+	if (screen != NULL && screen->frame_number() != m_lastframe)
+	{
+		m_lastframe = screen->frame_number();
+		UINT8 *start = binary_reserve(16);
+		UINT8 *dest = start;
+		*dest++ = TRACE_RECORD_FRAME;
+		dest = trace_put_varint(dest, m_lastframe);
+		m_bufpos += dest - start;
+	}
+
+	// fetch the opcode bytes
+	UINT8 opbuf[TRACE_BINARY_MAX_BYTES], argbuf[TRACE_BINARY_MAX_BYTES];
+	m_debug.fetch_opcodes(pc, opbuf, argbuf, m_opbytes);
+
+	// reserve space for the worst case and leave room for the record type
+	UINT8 *start = binary_reserve(1 + 10 + 2 * m_opbytes + 1 + 11 * m_numregs);
+	UINT8 *dest = start + 1;
+	UINT8 type = TRACE_RECORD_INSN;
+
+	// PCs are stored as deltas from the previous one
+	dest = trace_put_varint(dest, trace_zigzag(INT64(pc) - INT64(m_lastpc)));
+	m_lastpc = pc;
+
+	// only store opcode bytes that haven't been seen at this PC before
+	if (m_opcache->matches(pc, opbuf))
+		type |= TRACE_INSN_KNOWN;
+	else
+	{
+		m_opcache->update(pc, opbuf);
+		memcpy(dest, opbuf, m_opbytes);
+		dest += m_opbytes;
+	}
+
+	// argument bytes are only stored when they differ
+	if (memcmp(argbuf, opbuf, m_opbytes) != 0)
+	{
+		type |= TRACE_INSN_OPRAM;
+		memcpy(dest, argbuf, m_opbytes);
+		dest += m_opbytes;
+	}
+
+	// append any registers that changed since the last record
+	if (m_numregs != 0)
+	{
+		UINT8 *countptr = dest++;
+		int changed = 0;
+		for (int regnum = 0; regnum < m_numregs; regnum++)
+		{
+			UINT64 value = m_debug.m_state->state(m_regindex[regnum]);
+			if (value != m_regvalue[regnum])
+			{
+				*dest++ = regnum;
+				dest = trace_put_varint(dest, value ^ m_regvalue[regnum]);
+				m_regvalue[regnum] = value;
+				changed++;
+			}
+		}
+		if (changed != 0)
+		{
+			*countptr = changed;
+			type |= TRACE_INSN_REGS;
+		}
+		else
+			dest = countptr;
+	}
+
+	*start = type;
+	m_bufpos += dest - start;
+}
+
+
+//-------------------------------------------------
+//  binary_loops - record the number of looping
+//  instructions skipped in a binary trace
+//-------------------------------------------------
+
+void device_debug::tracer::binary_loops()
+{
+	UINT8 *start = binary_reserve(16);
+	UINT8 *dest = start;
+	*dest++ = TRACE_RECORD_LOOP;
+	dest = trace_put_varint(dest, m_loops);
+	m_bufpos += dest - start;
+}
+
+
+//-------------------------------------------------
+//  binary_reserve - make sure there is room for
+//  the given number of bytes in the current
+//  buffer and return a pointer to the free space
+//-------------------------------------------------
+
+UINT8 *device_debug::tracer::binary_reserve(UINT32 bytes)
+{
+	if (m_bufpos + bytes > BINARY_BUFFER_SIZE)
+		binary_submit(false);
+	return m_buffer[m_curbuffer] + m_bufpos;
+}
+
+
+//-------------------------------------------------
+//  binary_submit - hand the current buffer off to
+//  be written and switch to the other one
+//-------------------------------------------------
+
+void device_debug::tracer::binary_submit(bool synchronous)
+{
+	// wait for the previous write, since it owns the other buffer
+	binary_wait();
+	if (m_bufpos == 0)
+		return;
+
+	// write in the background unless asked not to, or if the queue fails us
+	m_writedata = m_buffer[m_curbuffer];
+	m_writelength = m_bufpos;
+	if (!synchronous && m_queue != NULL)
+		m_writeitem = osd_work_item_queue(m_queue, binary_write_callback, this, 0);
+	if (m_writeitem == NULL)
+		binary_write_callback(this, 0);
+
+	// switch buffers
+	m_curbuffer ^= 1;
+	m_bufpos = 0;
+}
+
+
+//-------------------------------------------------
+//  binary_wait - wait for any outstanding write
+//  to complete
+//-------------------------------------------------
+
+void device_debug::tracer::binary_wait()
+{
+	if (m_writeitem != NULL)
+	{
+		osd_work_item_wait(m_writeitem, 100 * osd_ticks_per_second());
+		osd_work_item_release(m_writeitem);
+		m_writeitem = NULL;
+	}
+}
+
+
+//-------------------------------------------------
+//  binary_write_callback - write a completed
+//  buffer to the trace file
+//-------------------------------------------------
+
+void *device_debug::tracer::binary_write_callback(void *param, int threadid)
+{
+	tracer *trace = reinterpret_cast<tracer *>(param);
+	fwrite(trace->m_writedata, 1, trace->m_writelength, &trace->m_file);
+	return NULL;
+}
+
+
 //-------------------------------------------------
 //  dasm_comment - constructor
 //-------------------------------------------------
@@ -65,6 +65,7 @@ typedef int (*debug_instruction_hook_func)(device_t &device, offs_t curpc);
 
 
 typedef struct _xml_data_node xml_data_node;
+class trace_opcode_cache;
 
 
 class device_debug
@@ -94,6 +95,7 @@ public:
 		bool hit(offs_t pc);
 
 		breakpoint *		m_next;						// next in the list
+		breakpoint *		m_hashnext;					// next in the same hash bucket
 		int					m_index;					// user reported index
 		UINT8				m_enabled;					// enabled?
 		offs_t				m_address;					// execution address
@@ -219,7 +221,7 @@ public:
 	offs_t history_pc(int index) const;
 
 	// tracing
-	void trace(FILE *file, bool trace_over, const char *action);
+	void trace(FILE *file, bool trace_over, const char *action, bool binary = false, bool registers = false);
 	void trace_printf(const char *fmt, ...);
 	void trace_flush() { if (m_trace != NULL) m_trace->flush(); }
 
@@ -228,14 +230,20 @@ public:
 	static const int HISTORY_SIZE = 256;
 
 private:
+	// breakpoint index sizes
+	static const int BP_FILTER_BITS = 4096;				// bits in the breakpoint address filter
+	static const int BP_HASH_SIZE = 256;				// buckets in the breakpoint hash
+
 	// internal helpers
 	void compute_debug_flags();
 	void prepare_for_step_overout(offs_t pc);
 	UINT32 dasm_wrapped(astring &buffer, offs_t pc);
+	void fetch_opcodes(offs_t pc, UINT8 *opbuf, UINT8 *argbuf, int numbytes);
 
 	// breakpoint and watchpoint helpers
 	void breakpoint_update_flags();
 	void breakpoint_check(offs_t pc);
+	static UINT32 breakpoint_filter_bit(offs_t pc) { return (pc ^ (pc >> 12)) & (BP_FILTER_BITS - 1); }
 	void watchpoint_update_flags(address_space &space);
 	void watchpoint_check(address_space &space, int type, offs_t address, UINT64 value_to_write, UINT64 mem_mask);
 	void hotspot_check(address_space &space, offs_t address);
@@ -281,13 +289,15 @@ private:
 
 	// breakpoints and watchpoints
 	breakpoint *			m_bplist;					// list of breakpoints
+	UINT32					m_bpfilter[BP_FILTER_BITS / 32]; // bitmap of addresses that may have an enabled breakpoint
+	breakpoint *			m_bphash[BP_HASH_SIZE];		// enabled breakpoints, hashed by address
 	watchpoint *			m_wplist[ADDRESS_SPACES];	// watchpoint lists for each address space
 
 	// tracing
 	class tracer
 	{
 	public:
-		tracer(device_debug &debug, FILE &file, bool trace_over, const char *action);
+		tracer(device_debug &debug, FILE &file, bool trace_over, const char *action, bool binary, bool registers);
 		~tracer();
 
 		void update(offs_t pc);
@@ -296,6 +306,17 @@ private:
 
 	private:
 		static const int TRACE_LOOPS = 64;
+		static const UINT32 BINARY_BUFFER_SIZE = 256 * 1024;
+		static const UINT32 BINARY_RECORD_MAX = 4096;
+
+		// binary trace helpers
+		void binary_start();
+		void binary_update(offs_t pc);
+		void binary_loops();
+		UINT8 *binary_reserve(UINT32 bytes);
+		void binary_submit(bool synchronous);
+		void binary_wait();
+		static void *binary_write_callback(void *param, int threadid);
 
 		device_debug &		m_debug;					// reference to our owner
 		FILE &				m_file;						// tracing file for this CPU
@@ -307,6 +328,24 @@ private:
 		offs_t				m_trace_over_target;		// target for tracing over
 	                                                	//    (0 = not tracing over,
 	                                                	//    ~0 = not currently tracing over)
+
+		// binary tracing
+		bool				m_binary;					// true if writing a binary trace
+		bool				m_registers;				// true if logging register changes
+		int					m_opbytes;					// opcode bytes stored per instruction
+		offs_t				m_lastpc;					// previous PC written
+		UINT64				m_lastframe;				// previous frame number written
+		trace_opcode_cache *m_opcache;					// cache of opcode bytes already written
+		int					m_numregs;					// number of registers tracked
+		int *				m_regindex;					// state index of each register
+		UINT64 *			m_regvalue;					// last value written for each register
+		UINT8 *				m_buffer[2];				// double-buffered output
+		int					m_curbuffer;				// buffer currently being filled
+		UINT32				m_bufpos;					// fill position within the current buffer
+		osd_work_queue *	m_queue;					// queue for background writes
+		osd_work_item *		m_writeitem;				// outstanding write, if any
+		const UINT8 *		m_writedata;				// data for the outstanding write
+		UINT32				m_writelength;				// length of the outstanding write
 	};
 	tracer *				m_trace;					// tracer state
 
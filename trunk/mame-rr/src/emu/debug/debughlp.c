@@ -80,6 +80,7 @@ static const help_item static_help_list[] =
 		"\n"
 		"  help [<topic>] -- get help on a particular topic\n"
 		"  do <expression> -- evaluates the given expression\n"
+		"  exprbench <expression>[,<count>] -- times <count> evaluations of the given expression\n"
 		"  symlist [<cpu>] -- lists registered symbols\n"
 		"  softreset -- executes a soft reset\n"
 		"  hardreset -- executes a hard reset\n"
@@ -134,6 +135,7 @@ static const help_item static_help_list[] =
 		"  observe [<cpu>[,<cpu>[,...]]] -- resumes debugging on <cpu>\n"
 		"  trace {<filename>|OFF}[,<cpu>[,<action>]] -- trace the given CPU to a file (defaults to active CPU)\n"
 		"  traceover {<filename>|OFF}[,<cpu>[,<action>]] -- trace the given CPU to a file, but skip subroutines (defaults to active CPU)\n"
+		"  tracebin {<filename>|OFF}[,<cpu>[,<registers>[,<action>]]] -- trace the given CPU to a compact binary file for unidasm\n"
 		"  traceflush -- flushes all open trace files\n"
 	},
 	{
@@ -244,6 +246,24 @@ static const help_item static_help_list[] =
 		"do pc = 0\n"
 		"  Sets the register 'pc' to 0.\n"
 	},
+	{
+		"exprbench",
+		"\n"
+		"  exprbench <expression>[,<count>]\n"
+		"\n"
+		"The exprbench command evaluates the given <expression> <count> times (100000 by default) with "
+		"the original token interpreter and again with the compiled evaluator used for breakpoint "
+		"conditions and cheats, and prints the average time taken by each. Note that any side effects "
+		"of the expression happen 2*<count> times.\n"
+		"\n"
+		"Examples:\n"
+		"\n"
+		"exprbench pc == 1234 && b@(a0+4) != 0\n"
+		"  Times a typical breakpoint condition.\n"
+		"\n"
+		"exprbench d0 == 5,1000000\n"
+		"  Times a simple comparison over one million evaluations.\n"
+	},
 	{
 		"symlist",
 		"\n"
@@ -774,6 +794,33 @@ static const help_item static_help_list[] =
 		"  Begin tracing the execution of CPU #0, logging output to asteroid.tr. Before each line, "
 		"output A=<aval> to the tracelog.\n"
 	},
+	{
+		"tracebin",
+		"\n"
+		"  tracebin {<filename>|OFF}[,<cpu>[,<registers>[,<action>]]]\n"
+		"\n"
+		"Starts or stops tracing of the execution of the specified <cpu> to a binary file. This works "
+		"like the trace command, but instead of disassembling each instruction as it executes, only the "
+		"PC and opcode bytes are recorded, which makes tracing considerably faster and the resulting "
+		"file much smaller. If <registers> is non-zero, the values of any registers that change are "
+		"recorded as well. The file can be disassembled and filtered offline with 'unidasm -trace'. "
+		"Output from 'tracelog' and the start of each new frame are included in the file. If you wish "
+		"to log additional information on each trace, you can append an <action> parameter as with the "
+		"trace command.\n"
+		"\n"
+		"Examples:\n"
+		"\n"
+		"tracebin sf2.trb,0\n"
+		"  Begin tracing the execution of CPU #0, logging output to sf2.trb.\n"
+		"\n"
+		"tracebin sf2.trb,0,1\n"
+		"  Begin tracing the execution of CPU #0, logging output and register changes to sf2.trb.\n"
+		"\n"
+		"tracebin off,0\n"
+		"  Turn off tracing on CPU #0.\n"
+		"\n"
+		"Use 'unidasm sf2.trb -arch m68000 -trace' to disassemble the resulting file.\n"
+	},
 	{
 		"traceflush",
 		"\n"
@@ -0,0 +1,183 @@
+/***************************************************************************
+
+    debugtrc.h
+
+    Binary execution trace format, shared by the debugger's tracer and
+    the offline disassembler.
+
+    Copyright Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    A binary trace starts with a header:
+
+        8 bytes     signature ("MAMETRC" plus a version byte)
+        1 byte      flags (TRACE_BINARY_FLAG_*)
+        1 byte      number of opcode bytes stored per instruction
+        1 byte      number of hex digits in a logical address
+        1 byte      number of registers tracked
+        string      tag of the traced CPU
+        string      name of each register, in index order
+
+    Strings are a length byte followed by that many characters. All
+    multi-byte values are little-endian varints (7 bits per byte, high
+    bit set on all but the last byte).
+
+    The header is followed by a stream of records. The low nibble of
+    the first byte of each record gives its type; the high nibble holds
+    type-specific flags:
+
+        TRACE_RECORD_INSN   one executed instruction:
+                              signed varint delta from the previous PC
+                              opcode bytes, unless TRACE_INSN_KNOWN
+                              argument bytes, if TRACE_INSN_OPRAM
+                              register changes, if TRACE_INSN_REGS:
+                                count byte, then for each change the
+                                register index byte and a varint of the
+                                new value XORed with the old one
+        TRACE_RECORD_LOOP   varint number of instructions executed in a
+                            loop that were not recorded individually
+        TRACE_RECORD_TEXT   varint length plus text from 'tracelog'
+        TRACE_RECORD_FRAME  varint number of the frame that just began
+
+    Opcode bytes are only stored the first time a PC is seen with a
+    given set of bytes; both writer and reader track this with an
+    identical trace_opcode_cache so that the stream stays compact.
+
+***************************************************************************/
+
+#pragma once
+
+#ifndef __DEBUGTRC_H__
+#define __DEBUGTRC_H__
+
+
+//**************************************************************************
+//  CONSTANTS
+//**************************************************************************
+
+// file signature
+const UINT8 TRACE_BINARY_MAGIC[8] = { 'M', 'A', 'M', 'E', 'T', 'R', 'C', 1 };
+
+// header flags
+const UINT8 TRACE_BINARY_FLAG_REGISTERS	= 0x01;		// instructions may carry register changes
+
+// limits
+const int TRACE_BINARY_MAX_BYTES		= 32;		// maximum opcode bytes stored per instruction
+const int TRACE_BINARY_MAX_REGS			= 255;		// maximum number of registers tracked
+const int TRACE_BINARY_CACHE_SIZE		= 4096;		// entries in the opcode cache
+
+// record types (low nibble)
+const UINT8 TRACE_RECORD_INSN			= 0x00;
+const UINT8 TRACE_RECORD_LOOP			= 0x01;
+const UINT8 TRACE_RECORD_TEXT			= 0x02;
+const UINT8 TRACE_RECORD_FRAME			= 0x03;
+const UINT8 TRACE_RECORD_TYPE_MASK		= 0x0f;
+
+// instruction record flags (high nibble)
+const UINT8 TRACE_INSN_KNOWN			= 0x10;		// opcode bytes match the cache
+const UINT8 TRACE_INSN_OPRAM			= 0x20;		// separate argument bytes follow
+const UINT8 TRACE_INSN_REGS				= 0x40;		// register changes follow
+
+
+
+//**************************************************************************
+//  TYPE DEFINITIONS
+//**************************************************************************
+
+// ======================> trace_opcode_cache
+
+// remembers the last opcode bytes recorded for a set of PCs
+class trace_opcode_cache
+{
+public:
+	// construction
+	trace_opcode_cache(int numbytes)
+		: m_numbytes(numbytes)
+	{
+		memset(m_valid, 0, sizeof(m_valid));
+	}
+
+	// return true if the bytes at this PC are the ones last recorded
+	bool matches(offs_t pc, const UINT8 *bytes) const
+	{
+		int index = pc % TRACE_BINARY_CACHE_SIZE;
+		return (m_valid[index] && m_pc[index] == pc && memcmp(m_bytes[index], bytes, m_numbytes) == 0);
+	}
+
+	// record the bytes at a PC
+	void update(offs_t pc, const UINT8 *bytes)
+	{
+		int index = pc % TRACE_BINARY_CACHE_SIZE;
+		m_valid[index] = true;
+		m_pc[index] = pc;
+		memcpy(m_bytes[index], bytes, m_numbytes);
+	}
+
+	// fetch the bytes last recorded for a PC, or NULL if none
+	const UINT8 *find(offs_t pc) const
+	{
+		int index = pc % TRACE_BINARY_CACHE_SIZE;
+		return (m_valid[index] && m_pc[index] == pc) ? m_bytes[index] : NULL;
+	}
+
+private:
+	int					m_numbytes;
+	bool				m_valid[TRACE_BINARY_CACHE_SIZE];
+	offs_t				m_pc[TRACE_BINARY_CACHE_SIZE];
+	UINT8				m_bytes[TRACE_BINARY_CACHE_SIZE][TRACE_BINARY_MAX_BYTES];
+};
+
+
+
+//**************************************************************************
+//  INLINE FUNCTIONS
+//**************************************************************************
+
+//-------------------------------------------------
+//  trace_put_varint - append a varint to a
+//  buffer, returning the new end
+//-------------------------------------------------
+
+inline UINT8 *trace_put_varint(UINT8 *dest, UINT64 value)
+{
+	while (value >= 0x80)
+	{
+		*dest++ = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	*dest++ = value;
+	return dest;
+}
+
+
+//-------------------------------------------------
+//  trace_get_varint - read a varint from a
+//  buffer; returns false if it runs off the end
+//-------------------------------------------------
+
+inline bool trace_get_varint(const UINT8 *&src, const UINT8 *end, UINT64 &value)
+{
+	value = 0;
+	for (int shift = 0; src < end && shift < 64; shift += 7)
+	{
+		UINT8 data = *src++;
+		value |= UINT64(data & 0x7f) << shift;
+		if ((data & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+
+//-------------------------------------------------
+//  trace_zigzag/trace_unzigzag - map signed
+//  deltas to small unsigned values and back
+//-------------------------------------------------
+
+inline UINT64 trace_zigzag(INT64 value) { return (UINT64(value) << 1) ^ UINT64(value >> 63); }
+inline INT64 trace_unzigzag(UINT64 value) { return INT64(value >> 1) ^ -INT64(value & 1); }
+
+
+#endif	/* __DEBUGTRC_H__ */
@@ -131,6 +131,45 @@ enum
 };
 
 
+// opcodes for compiled expressions
+enum
+{
+	EOP_CONST,
+	EOP_MOVE,
+	EOP_LOAD,
+	EOP_GETTER,
+	EOP_SYMBOL,
+	EOP_SETSYMBOL,
+	EOP_READ,
+	EOP_WRITE,
+	EOP_ADDIMM,
+	EOP_LNOT,
+	EOP_BNOT,
+	EOP_NEGATE,
+	EOP_MULTIPLY,
+	EOP_DIVIDE,
+	EOP_MODULO,
+	EOP_ADD,
+	EOP_SUBTRACT,
+	EOP_LSHIFT,
+	EOP_RSHIFT,
+	EOP_LESS,
+	EOP_LESSOREQUAL,
+	EOP_GREATER,
+	EOP_GREATEROREQUAL,
+	EOP_EQUAL,
+	EOP_NOTEQUAL,
+	EOP_BAND,
+	EOP_BXOR,
+	EOP_BOR,
+	EOP_LAND,
+	EOP_LOR,
+	EOP_CHECKZERO,
+	EOP_CALL,
+	EOP_RETURN
+};
+
+
 
 //**************************************************************************
 //  TYPE DEFINITIONS
@@ -150,6 +189,12 @@ public:
 	virtual UINT64 value() const;
 	virtual void set_value(UINT64 newvalue);
 
+	// direct access for compiled expressions
+	symbol_table &table() const { return m_table; }
+	void *ref() const { return m_ref; }
+	symbol_table::getter_func getter() const { return m_getter; }
+	bool is_variable() const { return (m_getter == internal_getter); }
+
 private:
 	// internal helpers
 	static UINT64 internal_getter(symbol_table &table, void *symref);
@@ -588,7 +633,9 @@ void symbol_table::set_memory_value(const char *name, expression_space space, UI
 //-------------------------------------------------
 
 parsed_expression::parsed_expression(symbol_table *symtable, const char *expression, UINT64 *result)
-	: m_symtable(symtable)
+	: m_symtable(symtable),
+	  m_program(NULL),
+	  m_program_state(PROGRAM_PENDING)
 {
 	// if we got an expression parse it
 	if (expression != NULL)
@@ -600,6 +647,16 @@ parsed_expression::parsed_expression(symbol_table *symtable, const char *express
 }
 
 
+//-------------------------------------------------
+//  ~parsed_expression - destructor
+//-------------------------------------------------
+
+parsed_expression::~parsed_expression()
+{
+	reset_program();
+}
+
+
 //-------------------------------------------------
 //  parse - parse an expression into tokens
 //-------------------------------------------------
@@ -610,6 +667,7 @@ void parsed_expression::parse(const char *expression)
 	m_original_string.cpy(expression);
 	m_tokenlist.reset();
 	m_stringlist.reset();
+	reset_program();
 
 	// first parse the tokens into the token array in order
 	parse_string_into_tokens();
@@ -627,6 +685,7 @@ void parsed_expression::copy(const parsed_expression &src)
 {
 	m_symtable = src.m_symtable;
 	m_original_string.cpy(src.m_original_string);
+	reset_program();
 	if (m_original_string)
 		parse_string_into_tokens();
 }
@@ -1411,6 +1470,21 @@ inline void parsed_expression::pop_token_rval(parse_token &token)
 }
 
 
+//-------------------------------------------------
+//  execute - execute the expression, compiling
+//  it first if we haven't tried yet
+//-------------------------------------------------
+
+UINT64 parsed_expression::execute()
+{
+	if (m_program_state == PROGRAM_PENDING)
+		compile();
+	if (m_program_state == PROGRAM_COMPILED)
+		return execute_program();
+	return execute_tokens();
+}
+
+
 //-------------------------------------------------
 //  execute_tokens - execute a postfix sequence
 //  of tokens
@@ -1779,3 +1853,670 @@ void parsed_expression::execute_function(parse_token &token)
 	result.configure_number(function->execute(paramcount, &funcparams[MAX_FUNCTION_PARAMS - paramcount]));
 	push_token(result);
 }
+
+
+//**************************************************************************
+//  EXPRESSION COMPILER
+//**************************************************************************
+
+//-------------------------------------------------
+//  binary_opcode - map a binary or compound
+//  assignment operator to its compiled opcode
+//-------------------------------------------------
+
+static UINT8 binary_opcode(UINT8 optype)
+{
+	switch (optype)
+	{
+		case TVL_MULTIPLY:		case TVL_ASSIGNMULTIPLY:	return EOP_MULTIPLY;
+		case TVL_DIVIDE:		case TVL_ASSIGNDIVIDE:		return EOP_DIVIDE;
+		case TVL_MODULO:		case TVL_ASSIGNMODULO:		return EOP_MODULO;
+		case TVL_ADD:			case TVL_ASSIGNADD:			return EOP_ADD;
+		case TVL_SUBTRACT:		case TVL_ASSIGNSUBTRACT:	return EOP_SUBTRACT;
+		case TVL_LSHIFT:		case TVL_ASSIGNLSHIFT:		return EOP_LSHIFT;
+		case TVL_RSHIFT:		case TVL_ASSIGNRSHIFT:		return EOP_RSHIFT;
+		case TVL_BAND:			case TVL_ASSIGNBAND:		return EOP_BAND;
+		case TVL_BXOR:			case TVL_ASSIGNBXOR:		return EOP_BXOR;
+		case TVL_BOR:			case TVL_ASSIGNBOR:			return EOP_BOR;
+		case TVL_LESS:										return EOP_LESS;
+		case TVL_LESSOREQUAL:								return EOP_LESSOREQUAL;
+		case TVL_GREATER:									return EOP_GREATER;
+		case TVL_GREATEROREQUAL:							return EOP_GREATEROREQUAL;
+		case TVL_EQUAL:										return EOP_EQUAL;
+		case TVL_NOTEQUAL:									return EOP_NOTEQUAL;
+		case TVL_LAND:										return EOP_LAND;
+		case TVL_LOR:										return EOP_LOR;
+	}
+	throw expression_error(expression_error::SYNTAX);
+}
+
+
+//-------------------------------------------------
+//  fold_binary - evaluate a binary opcode on
+//  constant operands at compile time
+//-------------------------------------------------
+
+static UINT64 fold_binary(UINT8 opcode, UINT64 a, UINT64 b)
+{
+	switch (opcode)
+	{
+		case EOP_MULTIPLY:		return a * b;
+		case EOP_DIVIDE:		return a / b;
+		case EOP_MODULO:		return a % b;
+		case EOP_ADD:			return a + b;
+		case EOP_SUBTRACT:		return a - b;
+		case EOP_LSHIFT:		return a << b;
+		case EOP_RSHIFT:		return a >> b;
+		case EOP_LESS:			return a < b;
+		case EOP_LESSOREQUAL:	return a <= b;
+		case EOP_GREATER:		return a > b;
+		case EOP_GREATEROREQUAL:return a >= b;
+		case EOP_EQUAL:			return a == b;
+		case EOP_NOTEQUAL:		return a != b;
+		case EOP_BAND:			return a & b;
+		case EOP_BXOR:			return a ^ b;
+		case EOP_BOR:			return a | b;
+		case EOP_LAND:			return a && b;
+		case EOP_LOR:			return a || b;
+	}
+	throw expression_error(expression_error::SYNTAX);
+}
+
+
+// the compiler walks the postfix token list once, tracking at compile time
+// what each entry of the execution stack would hold; each stack position
+// becomes a register, so the compiled form needs no runtime stack checks.
+// Any condition that would make the interpreter throw is instead thrown
+// here, and the expression is left to the interpreter so that errors are
+// reported exactly as before.
+class parsed_expression::compiler
+{
+public:
+	// construction
+	compiler(parsed_expression &expression)
+		: m_expression(expression),
+		  m_depth(0),
+		  m_numops(0) { }
+
+	// compile the token list; throws an expression_error on failure
+	void compile();
+
+	// getters
+	int count() const { return m_numops; }
+	const compiled_op *ops() const { return m_ops; }
+
+private:
+	// what a stack entry holds at compile time
+	enum entry_kind
+	{
+		KIND_CONSTANT,							// a known value
+		KIND_REGISTER,							// a value computed into this entry's register
+		KIND_SYMBOL,							// an unresolved symbol
+		KIND_MEMORY,							// an unresolved memory reference
+		KIND_STRING								// a string
+	};
+
+	struct stack_entry
+	{
+		entry_kind				kind;				// what this entry holds
+		bool					constaddr;			// for memory, true if the address is in 'value'
+		UINT64					value;				// constant value or address
+		symbol_entry *			symbol;				// symbol, for KIND_SYMBOL
+		const parse_token *		memory;				// memory operator token, for KIND_MEMORY
+		int						offset;				// offset within the string, for errors
+	};
+
+	// stack helpers
+	stack_entry &push(entry_kind kind, int offset);
+	stack_entry pop(int offset);
+	stack_entry pop_lval(int offset);
+	stack_entry pop_rval(int offset);
+	stack_entry *peek() { return (m_depth > 0) ? &m_stack[m_depth - 1] : NULL; }
+
+	// code generation helpers
+	compiled_op &emit(UINT8 opcode, int dest, int src1 = 0, int src2 = 0, int offset = 0);
+	int load(stack_entry &entry, int reg);
+	void load_lval(const stack_entry &entry, int reg, int addrreg);
+	void store_lval(const stack_entry &entry, int reg, int addrreg);
+	void compile_operator(const parse_token &token);
+	void compile_function(const parse_token &token);
+
+	// constants
+	static const int MAX_OPS = 256;
+
+	// internal state
+	parsed_expression &		m_expression;			// expression being compiled
+	stack_entry				m_stack[MAX_STACK_DEPTH]; // compile-time stack
+	int						m_depth;				// current stack depth
+	compiled_op				m_ops[MAX_OPS];			// generated operations
+	int						m_numops;				// number of operations generated
+};
+
+
+//-------------------------------------------------
+//  push - push a new entry onto the compile-time
+//  stack
+//-------------------------------------------------
+
+inline parsed_expression::compiler::stack_entry &parsed_expression::compiler::push(entry_kind kind, int offset)
+{
+	// check for overflow
+	if (m_depth >= MAX_STACK_DEPTH)
+		throw expression_error(expression_error::STACK_OVERFLOW, offset);
+
+	stack_entry &entry = m_stack[m_depth++];
+	memset(&entry, 0, sizeof(entry));
+	entry.kind = kind;
+	entry.offset = offset;
+	return entry;
+}
+
+
+//-------------------------------------------------
+//  pop - pop an entry off the compile-time stack
+//-------------------------------------------------
+
+inline parsed_expression::compiler::stack_entry parsed_expression::compiler::pop(int offset)
+{
+	// check for underflow
+	if (m_depth == 0)
+		throw expression_error(expression_error::STACK_UNDERFLOW, offset);
+	return m_stack[--m_depth];
+}
+
+
+//-------------------------------------------------
+//  pop_lval - pop an entry and ensure that it is
+//  a proper lval
+//-------------------------------------------------
+
+parsed_expression::compiler::stack_entry parsed_expression::compiler::pop_lval(int offset)
+{
+	stack_entry entry = pop(offset);
+	if (!(entry.kind == KIND_MEMORY || (entry.kind == KIND_SYMBOL && entry.symbol->is_lval())))
+		throw expression_error(expression_error::NOT_LVAL, entry.offset);
+	return entry;
+}
+
+
+//-------------------------------------------------
+//  pop_rval - pop an entry, emitting code to
+//  resolve symbols and memory into its register
+//-------------------------------------------------
+
+parsed_expression::compiler::stack_entry parsed_expression::compiler::pop_rval(int offset)
+{
+	stack_entry entry = pop(offset);
+	int reg = m_depth;
+
+	// symbols and memory are resolved at the point the interpreter would
+	if (entry.kind == KIND_SYMBOL || entry.kind == KIND_MEMORY)
+	{
+		load_lval(entry, reg, reg);
+		entry.kind = KIND_REGISTER;
+	}
+
+	// to be an rval, the final entry must be a number
+	if (entry.kind != KIND_CONSTANT && entry.kind != KIND_REGISTER)
+		throw expression_error(expression_error::NOT_RVAL, entry.offset);
+	return entry;
+}
+
+
+//-------------------------------------------------
+//  emit - append a new operation
+//-------------------------------------------------
+
+parsed_expression::compiled_op &parsed_expression::compiler::emit(UINT8 opcode, int dest, int src1, int src2, int offset)
+{
+	if (m_numops >= MAX_OPS)
+		throw expression_error(expression_error::OUT_OF_MEMORY, offset);
+
+	compiled_op &op = m_ops[m_numops++];
+	memset(&op, 0, sizeof(op));
+	op.opcode = opcode;
+	op.dest = dest;
+	op.src1 = src1;
+	op.src2 = src2;
+	op.offset = offset;
+	return op;
+}
+
+
+//-------------------------------------------------
+//  load - make sure an rval lives in a register,
+//  returning the register
+//-------------------------------------------------
+
+int parsed_expression::compiler::load(stack_entry &entry, int reg)
+{
+	if (entry.kind == KIND_CONSTANT)
+	{
+		emit(EOP_CONST, reg).value = entry.value;
+		entry.kind = KIND_REGISTER;
+	}
+	return reg;
+}
+
+
+//-------------------------------------------------
+//  load_lval - emit code to read the value of a
+//  symbol or memory entry into a register
+//-------------------------------------------------
+
+void parsed_expression::compiler::load_lval(const stack_entry &entry, int reg, int addrreg)
+{
+	// bind integer symbols directly to their storage or getter
+	if (entry.kind == KIND_SYMBOL && !entry.symbol->is_function())
+	{
+		integer_symbol_entry *integer = downcast<integer_symbol_entry *>(entry.symbol);
+		compiled_op &op = emit(integer->is_variable() ? EOP_LOAD : EOP_GETTER, reg);
+		op.symbol = entry.symbol;
+		op.ref = integer->ref();
+		op.getter = integer->getter();
+	}
+	else if (entry.kind == KIND_SYMBOL)
+		emit(EOP_SYMBOL, reg).symbol = entry.symbol;
+	else
+	{
+		compiled_op &op = emit(EOP_READ, reg, entry.constaddr ? REG_IMMEDIATE : addrreg);
+		op.value = entry.value;
+		op.name = entry.memory->memory_source();
+		op.space = entry.memory->memory_space();
+		op.size = 1 << entry.memory->memory_size();
+	}
+}
+
+
+//-------------------------------------------------
+//  store_lval - emit code to write a register to
+//  a symbol or memory entry
+//-------------------------------------------------
+
+void parsed_expression::compiler::store_lval(const stack_entry &entry, int reg, int addrreg)
+{
+	if (entry.kind == KIND_SYMBOL)
+		emit(EOP_SETSYMBOL, 0, reg).symbol = entry.symbol;
+	else
+	{
+		compiled_op &op = emit(EOP_WRITE, 0, entry.constaddr ? REG_IMMEDIATE : addrreg, reg);
+		op.value = entry.value;
+		op.name = entry.memory->memory_source();
+		op.space = entry.memory->memory_space();
+		op.size = 1 << entry.memory->memory_size();
+	}
+}
+
+
+//-------------------------------------------------
+//  compile - compile the whole token list
+//-------------------------------------------------
+
+void parsed_expression::compiler::compile()
+{
+	for (parse_token *token = m_expression.m_tokenlist.first(); token != NULL; token = token->next())
+	{
+		// numbers become constants; symbols and strings are resolved when popped
+		if (token->is_number())
+			push(KIND_CONSTANT, token->offset()).value = token->value();
+		else if (token->is_symbol())
+			push(KIND_SYMBOL, token->offset()).symbol = token->symbol();
+		else if (token->is_operator())
+			compile_operator(*token);
+		else
+			push(KIND_STRING, token->offset());
+	}
+
+	// pop the final result
+	stack_entry result = pop_rval(0);
+
+	// error if our stack isn't empty
+	if (m_depth != 0)
+		throw expression_error(expression_error::SYNTAX, 0);
+
+	if (result.kind == KIND_CONSTANT)
+		emit(EOP_RETURN, 0, REG_IMMEDIATE).value = result.value;
+	else
+		emit(EOP_RETURN, 0, 0);
+}
+
+
+//-------------------------------------------------
+//  compile_operator - compile a single operator
+//-------------------------------------------------
+
+void parsed_expression::compiler::compile_operator(const parse_token &token)
+{
+	UINT8 optype = token.optype();
+	switch (optype)
+	{
+		// increment/decrement operate on lvals through the scratch registers
+		case TVL_PREINCREMENT:
+		case TVL_PREDECREMENT:
+		case TVL_POSTINCREMENT:
+		case TVL_POSTDECREMENT:
+		{
+			stack_entry t1 = pop_lval(token.offset());
+			int reg = m_depth;
+			bool post = (optype == TVL_POSTINCREMENT || optype == TVL_POSTDECREMENT);
+			bool increment = (optype == TVL_PREINCREMENT || optype == TVL_POSTINCREMENT);
+			load_lval(t1, REG_SCRATCH, reg);
+			emit(EOP_ADDIMM, REG_SCRATCH + 1, REG_SCRATCH).value = increment ? 1 : ~(UINT64)0;
+			store_lval(t1, REG_SCRATCH + 1, reg);
+			emit(EOP_MOVE, reg, post ? REG_SCRATCH : REG_SCRATCH + 1);
+			push(KIND_REGISTER, t1.offset);
+			break;
+		}
+
+		// unary operators
+		case TVL_COMPLEMENT:
+		case TVL_NOT:
+		case TVL_UPLUS:
+		case TVL_UMINUS:
+		{
+			stack_entry t1 = pop_rval(token.offset());
+			int reg = m_depth;
+			if (t1.kind == KIND_CONSTANT)
+			{
+				UINT64 value = t1.value;
+				switch (optype)
+				{
+					case TVL_COMPLEMENT:	value = !value;		break;
+					case TVL_NOT:			value = ~value;		break;
+					case TVL_UMINUS:		value = -value;		break;
+				}
+				push(KIND_CONSTANT, t1.offset).value = value;
+			}
+			else
+			{
+				if (optype == TVL_COMPLEMENT)
+					emit(EOP_LNOT, reg, reg);
+				else if (optype == TVL_NOT)
+					emit(EOP_BNOT, reg, reg);
+				else if (optype == TVL_UMINUS)
+					emit(EOP_NEGATE, reg, reg);
+				push(KIND_REGISTER, t1.offset);
+			}
+			break;
+		}
+
+		// binary operators
+		case TVL_MULTIPLY:
+		case TVL_DIVIDE:
+		case TVL_MODULO:
+		case TVL_ADD:
+		case TVL_SUBTRACT:
+		case TVL_LSHIFT:
+		case TVL_RSHIFT:
+		case TVL_LESS:
+		case TVL_LESSOREQUAL:
+		case TVL_GREATER:
+		case TVL_GREATEROREQUAL:
+		case TVL_EQUAL:
+		case TVL_NOTEQUAL:
+		case TVL_BAND:
+		case TVL_BXOR:
+		case TVL_BOR:
+		case TVL_LAND:
+		case TVL_LOR:
+		{
+			stack_entry t2 = pop_rval(token.offset());
+			stack_entry t1 = pop_rval(token.offset());
+			int reg = m_depth;
+			int offset = MIN(t1.offset, t2.offset);
+
+			// fold constants, leaving division by zero for runtime
+			if (t1.kind == KIND_CONSTANT && t2.kind == KIND_CONSTANT && !((optype == TVL_DIVIDE || optype == TVL_MODULO) && t2.value == 0))
+			{
+				push(KIND_CONSTANT, offset).value = fold_binary(binary_opcode(optype), t1.value, t2.value);
+				break;
+			}
+			load(t1, reg);
+			load(t2, reg + 1);
+			emit(binary_opcode(optype), reg, reg, reg + 1, t2.offset);
+			push(KIND_REGISTER, offset);
+			break;
+		}
+
+		// assignment
+		case TVL_ASSIGN:
+		{
+			stack_entry t2 = pop_rval(token.offset());
+			stack_entry t1 = pop_lval(token.offset());
+			int reg = m_depth;
+			store_lval(t1, load(t2, reg + 1), reg);
+			if (t2.kind == KIND_CONSTANT)
+				push(KIND_CONSTANT, t2.offset).value = t2.value;
+			else
+			{
+				emit(EOP_MOVE, reg, reg + 1);
+				push(KIND_REGISTER, t2.offset);
+			}
+			break;
+		}
+
+		// compound assignment
+		case TVL_ASSIGNMULTIPLY:
+		case TVL_ASSIGNDIVIDE:
+		case TVL_ASSIGNMODULO:
+		case TVL_ASSIGNADD:
+		case TVL_ASSIGNSUBTRACT:
+		case TVL_ASSIGNLSHIFT:
+		case TVL_ASSIGNRSHIFT:
+		case TVL_ASSIGNBAND:
+		case TVL_ASSIGNBXOR:
+		case TVL_ASSIGNBOR:
+		{
+			stack_entry t2 = pop_rval(token.offset());
+			stack_entry t1 = pop_lval(token.offset());
+			int reg = m_depth;
+			load(t2, reg + 1);
+			if (optype == TVL_ASSIGNDIVIDE || optype == TVL_ASSIGNMODULO)
+				emit(EOP_CHECKZERO, 0, reg + 1, 0, t2.offset);
+			load_lval(t1, REG_SCRATCH, reg);
+			emit(binary_opcode(optype), REG_SCRATCH, REG_SCRATCH, reg + 1, t2.offset);
+			store_lval(t1, REG_SCRATCH, reg);
+			emit(EOP_MOVE, reg, REG_SCRATCH);
+			push(KIND_REGISTER, MIN(t1.offset, t2.offset));
+			break;
+		}
+
+		// commas separating function parameters are no-ops
+		case TVL_COMMA:
+			if (!token.is_function_separator())
+			{
+				stack_entry t2 = pop_rval(token.offset());
+				pop_rval(token.offset());
+				int reg = m_depth;
+				if (t2.kind == KIND_CONSTANT)
+					push(KIND_CONSTANT, t2.offset).value = t2.value;
+				else
+				{
+					emit(EOP_MOVE, reg, reg + 1);
+					push(KIND_REGISTER, t2.offset);
+				}
+			}
+			break;
+
+		// memory references keep their address in their own register
+		case TVL_MEMORYAT:
+		{
+			stack_entry t1 = pop_rval(token.offset());
+			stack_entry &entry = push(KIND_MEMORY, t1.offset);
+			entry.constaddr = (t1.kind == KIND_CONSTANT);
+			entry.value = t1.value;
+			entry.memory = &token;
+			break;
+		}
+
+		case TVL_EXECUTEFUNC:
+			compile_function(token);
+			break;
+
+		default:
+			throw expression_error(expression_error::SYNTAX, token.offset());
+	}
+}
+
+
+//-------------------------------------------------
+//  compile_function - compile a function call,
+//  whose parameters are left in consecutive
+//  registers above the function symbol
+//-------------------------------------------------
+
+void parsed_expression::compiler::compile_function(const parse_token &token)
+{
+	symbol_entry *symbol = NULL;
+	int paramcount = 0;
+	while (paramcount < MAX_FUNCTION_PARAMS)
+	{
+		// peek at the next entry on the stack
+		stack_entry *peek = this->peek();
+		if (peek == NULL)
+			throw expression_error(expression_error::INVALID_PARAM_COUNT, token.offset());
+
+		// if it is a function symbol, break out of the loop
+		if (peek->kind == KIND_SYMBOL)
+		{
+			symbol = peek->symbol;
+			if (symbol->is_function())
+			{
+				pop(token.offset());
+				break;
+			}
+		}
+
+		// otherwise, resolve as a standard rval
+		stack_entry param = pop_rval(token.offset());
+		load(param, m_depth);
+		paramcount++;
+	}
+
+	// if we didn't find the symbol, fail
+	if (paramcount == MAX_FUNCTION_PARAMS)
+		throw expression_error(expression_error::INVALID_PARAM_COUNT, token.offset());
+
+	// call with the parameters in place and push the result
+	int reg = m_depth;
+	emit(EOP_CALL, reg, reg + 1, paramcount, token.offset()).symbol = symbol;
+	push(KIND_REGISTER, token.offset());
+}
+
+
+//-------------------------------------------------
+//  compile - compile the token list, or mark the
+//  expression as interpreted if we can't
+//-------------------------------------------------
+
+void parsed_expression::compile()
+{
+	reset_program();
+	m_program_state = PROGRAM_INTERPRET;
+
+	// the compiler is large, so keep it off the stack
+	compiler *comp = global_alloc(compiler(*this));
+	try
+	{
+		comp->compile();
+		m_program = global_alloc_array(compiled_op, comp->count());
+		memcpy(m_program, comp->ops(), comp->count() * sizeof(m_program[0]));
+		m_program_state = PROGRAM_COMPILED;
+	}
+	catch (expression_error &)
+	{
+		// leave errors to the interpreter, which reports them in context
+	}
+	global_free(comp);
+}
+
+
+//-------------------------------------------------
+//  reset_program - discard any compiled form
+//-------------------------------------------------
+
+void parsed_expression::reset_program()
+{
+	global_free(m_program);
+	m_program = NULL;
+	m_program_state = PROGRAM_PENDING;
+}
+
+
+//-------------------------------------------------
+//  execute_program - run the compiled form
+//-------------------------------------------------
+
+UINT64 parsed_expression::execute_program()
+{
+	UINT64 reg[REG_COUNT];
+	for (const compiled_op *op = m_program; ; op++)
+		switch (op->opcode)
+		{
+			case EOP_CONST:			reg[op->dest] = op->value;												break;
+			case EOP_MOVE:			reg[op->dest] = reg[op->src1];											break;
+			case EOP_LOAD:			reg[op->dest] = *(UINT64 *)op->ref;										break;
+			case EOP_GETTER:		reg[op->dest] = (*op->getter)(downcast<integer_symbol_entry *>(op->symbol)->table(), op->ref); break;
+			case EOP_SYMBOL:		reg[op->dest] = op->symbol->value();									break;
+			case EOP_SETSYMBOL:		op->symbol->set_value(reg[op->src1]);									break;
+			case EOP_ADDIMM:		reg[op->dest] = reg[op->src1] + op->value;								break;
+			case EOP_LNOT:			reg[op->dest] = !reg[op->src1];											break;
+			case EOP_BNOT:			reg[op->dest] = ~reg[op->src1];											break;
+			case EOP_NEGATE:		reg[op->dest] = -reg[op->src1];											break;
+			case EOP_MULTIPLY:		reg[op->dest] = reg[op->src1] * reg[op->src2];							break;
+			case EOP_ADD:			reg[op->dest] = reg[op->src1] + reg[op->src2];							break;
+			case EOP_SUBTRACT:		reg[op->dest] = reg[op->src1] - reg[op->src2];							break;
+			case EOP_LSHIFT:		reg[op->dest] = reg[op->src1] << reg[op->src2];							break;
+			case EOP_RSHIFT:		reg[op->dest] = reg[op->src1] >> reg[op->src2];							break;
+			case EOP_LESS:			reg[op->dest] = reg[op->src1] < reg[op->src2];							break;
+			case EOP_LESSOREQUAL:	reg[op->dest] = reg[op->src1] <= reg[op->src2];							break;
+			case EOP_GREATER:		reg[op->dest] = reg[op->src1] > reg[op->src2];							break;
+			case EOP_GREATEROREQUAL:reg[op->dest] = reg[op->src1] >= reg[op->src2];							break;
+			case EOP_EQUAL:			reg[op->dest] = reg[op->src1] == reg[op->src2];							break;
+			case EOP_NOTEQUAL:		reg[op->dest] = reg[op->src1] != reg[op->src2];							break;
+			case EOP_BAND:			reg[op->dest] = reg[op->src1] & reg[op->src2];							break;
+			case EOP_BXOR:			reg[op->dest] = reg[op->src1] ^ reg[op->src2];							break;
+			case EOP_BOR:			reg[op->dest] = reg[op->src1] | reg[op->src2];							break;
+			case EOP_LAND:			reg[op->dest] = reg[op->src1] && reg[op->src2];							break;
+			case EOP_LOR:			reg[op->dest] = reg[op->src1] || reg[op->src2];							break;
+
+			case EOP_DIVIDE:
+				if (reg[op->src2] == 0)
+					throw expression_error(expression_error::DIVIDE_BY_ZERO, op->offset);
+				reg[op->dest] = reg[op->src1] / reg[op->src2];
+				break;
+
+			case EOP_MODULO:
+				if (reg[op->src2] == 0)
+					throw expression_error(expression_error::DIVIDE_BY_ZERO, op->offset);
+				reg[op->dest] = reg[op->src1] % reg[op->src2];
+				break;
+
+			case EOP_CHECKZERO:
+				if (reg[op->src1] == 0)
+					throw expression_error(expression_error::DIVIDE_BY_ZERO, op->offset);
+				break;
+
+			case EOP_READ:
+			{
+				UINT32 address = (op->src1 == REG_IMMEDIATE) ? op->value : reg[op->src1];
+				reg[op->dest] = (m_symtable != NULL) ? m_symtable->memory_value(op->name, expression_space(op->space), address, op->size) : 0;
+				break;
+			}
+
+			case EOP_WRITE:
+				if (m_symtable != NULL)
+				{
+					UINT32 address = (op->src1 == REG_IMMEDIATE) ? op->value : reg[op->src1];
+					m_symtable->set_memory_value(op->name, expression_space(op->space), address, op->size, reg[op->src2]);
+				}
+				break;
+
+			case EOP_CALL:
+				reg[op->dest] = downcast<function_symbol_entry *>(op->symbol)->execute(op->src2, &reg[op->src1]);
+				break;
+
+			case EOP_RETURN:
+				return (op->src1 == REG_IMMEDIATE) ? op->value : reg[op->src1];
+		}
+}
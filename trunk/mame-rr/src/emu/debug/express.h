@@ -242,8 +242,9 @@ class parsed_expression
 {
 public:
 	// construction/destruction
-	parsed_expression(const parsed_expression &src) { copy(src); }
+	parsed_expression(const parsed_expression &src) : m_program(NULL), m_program_state(PROGRAM_PENDING) { copy(src); }
 	parsed_expression(symbol_table *symtable = NULL, const char *expression = NULL, UINT64 *result = NULL);
+	~parsed_expression();
 
 	// operators
 	parsed_expression &operator=(const parsed_expression &src) { copy(src); return *this; }
@@ -258,9 +259,39 @@ public:
 
 	// execution
 	void parse(const char *string);
-	UINT64 execute() { return execute_tokens(); }
+	UINT64 execute();
+	UINT64 interpret() { return execute_tokens(); }
 
 private:
+	// compilation states
+	enum program_state
+	{
+		PROGRAM_PENDING,						// not yet compiled
+		PROGRAM_COMPILED,						// compiled; execute m_program
+		PROGRAM_INTERPRET						// could not be compiled; interpret the tokens
+	};
+
+	// a single operation in a compiled expression
+	struct compiled_op
+	{
+		UINT8					opcode;				// operation to perform
+		UINT8					dest;				// destination register
+		UINT8					src1;				// first source register, or REG_IMMEDIATE
+		UINT8					src2;				// second source register (or parameter count)
+		UINT8					space;				// memory space for reads/writes
+		UINT8					size;				// memory access size in bytes
+		int						offset;				// offset within the string, for errors
+		UINT64					value;				// immediate value
+		symbol_entry *			symbol;				// bound symbol
+		void *					ref;				// symbol reference, for direct access
+		symbol_table::getter_func getter;			// symbol getter, for direct access
+		const char *			name;				// memory source name
+	};
+
+	// the compiler is a helper that lives in express.c
+	class compiler;
+	friend class compiler;
+
 	// a single token
 	class parse_token
 	{
@@ -318,6 +349,7 @@ private:
 		bool is_function_separator() const { assert(m_type == OPERATOR); return ((m_flags & TIN_FUNCTION_MASK) != 0); }
 		bool right_to_left() const { assert(m_type == OPERATOR); return ((m_flags & TIN_RIGHT_TO_LEFT_MASK) != 0); }
 		expression_space memory_space() const { assert(m_type == OPERATOR || m_type == MEMORY); return expression_space((m_flags & TIN_MEMORY_SPACE_MASK) >> TIN_MEMORY_SPACE_SHIFT); }
+		const char *memory_source() const { assert(m_type == OPERATOR || m_type == MEMORY); return m_string; }
 		int memory_size() const { assert(m_type == OPERATOR || m_type == MEMORY); return (m_flags & TIN_MEMORY_SIZE_MASK) >> TIN_MEMORY_SIZE_SHIFT; }
 
 		// setters
@@ -396,9 +428,17 @@ private:
 	UINT64 execute_tokens();
 	void execute_function(parse_token &token);
 
+	// compilation helpers
+	void compile();
+	void reset_program();
+	UINT64 execute_program();
+
 	// constants
 	static const int MAX_FUNCTION_PARAMS = 16;
 	static const int MAX_STACK_DEPTH = 16;
+	static const int REG_SCRATCH = MAX_STACK_DEPTH;		// first of two scratch registers
+	static const int REG_COUNT = MAX_STACK_DEPTH + 2;	// registers used by compiled code
+	static const UINT8 REG_IMMEDIATE = 0xff;			// source is the immediate value
 
 	// internal state
 	symbol_table *		m_symtable;						// symbol table
@@ -407,6 +447,8 @@ private:
 	simple_list<expression_string> m_stringlist;		// string list
 	int					m_token_stack_ptr;				// stack pointer (used during execution)
 	parse_token			m_token_stack[MAX_STACK_DEPTH];	// token stack (used during execution)
+	compiled_op *		m_program;						// compiled form of the token list
+	program_state		m_program_state;				// state of the compiled form
 };
 
 
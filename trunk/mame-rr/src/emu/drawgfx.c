@@ -12,6 +12,10 @@
 #include "emu.h"
 #include "drawgfxm.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 
 /***************************************************************************
     GLOBAL VARIABLES
@@ -27,6 +31,9 @@ UINT8 no_priority_size_is_wrong[2 * (sizeof(NO_PRIORITY) == 3) - 1];
 ***************************************************************************/
 
 static void decodechar(const gfx_element *gfx, UINT32 code, const UINT8 *src);
+INLINE int drawgfx_vector(bitmap_t *dest, const rectangle *cliprect, const gfx_element *gfx,
+		UINT32 code, UINT32 color, int flipx, int flipy, INT32 destx, INT32 desty,
+		bitmap_t *priority, UINT32 pmask, UINT32 transmask);
 
 
 
@@ -280,9 +287,14 @@ gfx_element *gfx_element_alloc(running_machine &machine, const gfx_layout *gl, c
 	if (gfx->color_depth <= 32)
 		gfx->pen_usage = auto_alloc_array(machine, UINT32, gfx->total_elements);
 
+	/* and a per-row one for entries with 16 pens or less */
+	if (gfx->color_depth <= 16)
+		gfx->row_usage = auto_alloc_array(machine, UINT16, gfx->total_elements * gfx->origheight);
+
 	/* allocate a dirty array */
 	gfx->dirty = auto_alloc_array(machine, UINT8, gfx->total_elements);
 	memset(gfx->dirty, 1, gfx->total_elements * sizeof(*gfx->dirty));
+	gfx->decodelock = osd_lock_alloc();
 
 	/* raw graphics case */
 	if (israw)
@@ -326,6 +338,30 @@ void gfx_element_decode(const gfx_element *gfx, UINT32 code)
 }
 
 
+/*-------------------------------------------------
+    gfx_element_decode_dirty - update a single
+    code in a gfx_element if nobody else has
+    already done so; drivers that draw in bands
+    can reach here from several threads at once
+-------------------------------------------------*/
+
+void gfx_element_decode_dirty(const gfx_element *gfx, UINT32 code)
+{
+	/* temporary elements have no lock, but are never dirty either */
+	if (gfx->decodelock == NULL)
+	{
+		decodechar(gfx, code, gfx->srcdata);
+		return;
+	}
+
+	/* decoding zaps the data first, so a second decode would briefly expose it to other readers */
+	osd_lock_acquire(gfx->decodelock);
+	if (gfx->dirty[code])
+		decodechar(gfx, code, gfx->srcdata);
+	osd_lock_release(gfx->decodelock);
+}
+
+
 /*-------------------------------------------------
     gfx_element_free - free a gfx_element
 -------------------------------------------------*/
@@ -337,8 +373,11 @@ void gfx_element_free(gfx_element *gfx)
 		return;
 
 	/* free our data */
+	if (gfx->decodelock != NULL)
+		osd_lock_free(gfx->decodelock);
 	auto_free(gfx->machine(), gfx->layout.extyoffs);
 	auto_free(gfx->machine(), gfx->layout.extxoffs);
+	auto_free(gfx->machine(), gfx->row_usage);
 	auto_free(gfx->machine(), gfx->pen_usage);
 	auto_free(gfx->machine(), gfx->dirty);
 	auto_free(gfx->machine(), gfx->gfxdata);
@@ -371,6 +410,7 @@ void gfx_element_build_temporary(gfx_element *gfx, running_machine &machine, UIN
 	gfx->total_colors = (machine.total_colors() - color_base) / color_granularity;
 
 	gfx->pen_usage = NULL;
+	gfx->row_usage = NULL;
 
 	gfx->gfxdata = base;
 	gfx->line_modulo = rowbytes;
@@ -378,6 +418,7 @@ void gfx_element_build_temporary(gfx_element *gfx, running_machine &machine, UIN
 	gfx->srcdata = base;
 	gfx->dirty = &not_dirty;
 	gfx->dirtyseq = 0;
+	gfx->decodelock = NULL;
 }
 
 
@@ -389,6 +430,7 @@ void gfx_element_build_temporary(gfx_element *gfx, running_machine &machine, UIN
 static void calc_penusage(const gfx_element *gfx, UINT32 code)
 {
 	const UINT8 *dp = gfx->gfxdata + code * gfx->char_modulo;
+	UINT16 *rowusage = (gfx->row_usage != NULL) ? &gfx->row_usage[code * gfx->origheight] : NULL;
 	UINT32 usage = 0;
 	int x, y;
 
@@ -400,9 +442,13 @@ static void calc_penusage(const gfx_element *gfx, UINT32 code)
 	if (gfx->flags & GFX_ELEMENT_PACKED)
 		for (y = 0; y < gfx->origheight; y++)
 		{
+			UINT32 rowbits = 0;
 			for (x = 0; x < gfx->origwidth/2; x++)
-				usage |= (1 << (dp[x] & 0x0f)) | (1 << (dp[x] >> 4));
+				rowbits |= (1 << (dp[x] & 0x0f)) | (1 << (dp[x] >> 4));
 
+			if (rowusage != NULL)
+				rowusage[y] = rowbits;
+			usage |= rowbits;
 			dp += gfx->line_modulo;
 		}
 
@@ -410,9 +456,13 @@ static void calc_penusage(const gfx_element *gfx, UINT32 code)
 	else
 		for (y = 0; y < gfx->origheight; y++)
 		{
+			UINT32 rowbits = 0;
 			for (x = 0; x < gfx->origwidth; x++)
-				usage |= 1 << dp[x];
+				rowbits |= 1 << dp[x];
 
+			if (rowusage != NULL)
+				rowusage[y] = rowbits;
+			usage |= rowbits;
 			dp += gfx->line_modulo;
 		}
 
@@ -492,6 +542,285 @@ static void decodechar(const gfx_element *gfx, UINT32 code, const UINT8 *src)
 }
 
 
+/***************************************************************************
+    VECTOR SPAN KERNELS
+***************************************************************************/
+
+#ifdef __SSE2__
+
+/* a set of byte values to compare against; whichever of the members or
+   non-members is the shorter list is stored */
+typedef struct _sse2_value_set sse2_value_set;
+struct _sse2_value_set
+{
+	__m128i			value[16];			/* values, replicated across all lanes */
+	int				count;				/* number of values */
+	int				invert;				/* TRUE if the values are the non-members */
+};
+
+
+/* everything needed to draw one row of a gfx element */
+typedef struct _sse2_span_params sse2_span_params;
+struct _sse2_span_params
+{
+	sse2_value_set	trans;				/* transparent pens */
+	sse2_value_set	block;				/* priorities that block drawing */
+	UINT32			transmask;			/* transparent pens, for the leftover pixels */
+	UINT32			pmask;				/* blocking priorities, for the leftover pixels */
+	__m128i			base;				/* pen base, replicated across all lanes */
+	UINT16			basepen;			/* pen base */
+	int				flipx;				/* TRUE if the source runs backwards */
+};
+
+
+/*-------------------------------------------------
+    sse2_build_set - describe the set of values
+    below 'limit' whose bits are set in 'bits'
+-------------------------------------------------*/
+
+static void sse2_build_set(sse2_value_set *set, UINT32 bits, int limit)
+{
+	int members = 0;
+	int value;
+
+	for (value = 0; value < limit; value++)
+		if ((bits >> value) & 1)
+			members++;
+
+	set->invert = (members > limit / 2);
+	set->count = 0;
+	for (value = 0; value < limit; value++)
+		if (((bits >> value) & 1) != set->invert)
+			set->value[set->count++] = _mm_set1_epi8(value);
+}
+
+
+/*-------------------------------------------------
+    sse2_match - return 0xff in each byte lane of
+    'data' that is a member of the set
+-------------------------------------------------*/
+
+INLINE __m128i sse2_match(__m128i data, const sse2_value_set *set)
+{
+	__m128i result = _mm_setzero_si128();
+	int index;
+
+	for (index = 0; index < set->count; index++)
+		result = _mm_or_si128(result, _mm_cmpeq_epi8(data, set->value[index]));
+	return set->invert ? _mm_xor_si128(result, _mm_set1_epi8(-1)) : result;
+}
+
+
+/*-------------------------------------------------
+    sse2_reverse_bytes - reverse the order of the
+    16 bytes in a vector
+-------------------------------------------------*/
+
+INLINE __m128i sse2_reverse_bytes(__m128i data)
+{
+	data = _mm_shuffle_epi32(data, _MM_SHUFFLE(0, 1, 2, 3));
+	data = _mm_shufflehi_epi16(_mm_shufflelo_epi16(data, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm_or_si128(_mm_slli_epi16(data, 8), _mm_srli_epi16(data, 8));
+}
+
+
+/*-------------------------------------------------
+    sse2_draw_span - draw one row of 8bpp source
+    pixels to a 16bpp destination, adding the pen
+    base; 'opaque' says the row has no
+    transparent pens at all
+-------------------------------------------------*/
+
+static void sse2_draw_span(UINT16 *dest, UINT8 *pri, const UINT8 *src, int count, const sse2_span_params *params, int opaque)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi8(-1);
+	const __m128i primask = _mm_set1_epi8(0x1f);
+	const __m128i pritop = _mm_set1_epi8(31);
+
+	/* 16 pixels at a time */
+	for ( ; count >= 16; count -= 16)
+	{
+		__m128i srcbytes, drawbytes;
+		int drawbits;
+
+		/* fetch the source in destination order */
+		if (!params->flipx)
+		{
+			srcbytes = _mm_loadu_si128((const __m128i *)src);
+			src += 16;
+		}
+		else
+		{
+			srcbytes = sse2_reverse_bytes(_mm_loadu_si128((const __m128i *)(src - 15)));
+			src -= 16;
+		}
+
+		/* work out which pixels are opaque */
+		drawbytes = opaque ? ones : _mm_xor_si128(sse2_match(srcbytes, &params->trans), ones);
+
+		/* drop those that are blocked by the priority bitmap, and mark the rest */
+		if (pri != NULL)
+		{
+			__m128i pribytes = _mm_loadu_si128((const __m128i *)pri);
+			__m128i blocked = sse2_match(_mm_and_si128(pribytes, primask), &params->block);
+			_mm_storeu_si128((__m128i *)pri, _mm_or_si128(_mm_and_si128(drawbytes, pritop), _mm_andnot_si128(drawbytes, pribytes)));
+			drawbytes = _mm_andnot_si128(blocked, drawbytes);
+			pri += 16;
+		}
+
+		/* write whatever is left, merging with the destination only if we must */
+		drawbits = _mm_movemask_epi8(drawbytes);
+		if (drawbits != 0)
+		{
+			__m128i pixlo = _mm_add_epi16(_mm_unpacklo_epi8(srcbytes, zero), params->base);
+			__m128i pixhi = _mm_add_epi16(_mm_unpackhi_epi8(srcbytes, zero), params->base);
+
+			if (drawbits != 0xffff)
+			{
+				__m128i drawlo = _mm_unpacklo_epi8(drawbytes, drawbytes);
+				__m128i drawhi = _mm_unpackhi_epi8(drawbytes, drawbytes);
+				pixlo = _mm_or_si128(_mm_and_si128(drawlo, pixlo), _mm_andnot_si128(drawlo, _mm_loadu_si128((const __m128i *)&dest[0])));
+				pixhi = _mm_or_si128(_mm_and_si128(drawhi, pixhi), _mm_andnot_si128(drawhi, _mm_loadu_si128((const __m128i *)&dest[8])));
+			}
+			_mm_storeu_si128((__m128i *)&dest[0], pixlo);
+			_mm_storeu_si128((__m128i *)&dest[8], pixhi);
+		}
+		dest += 16;
+	}
+
+	/* leftover pixels one at a time */
+	for ( ; count > 0; count--)
+	{
+		UINT32 pen = *src;
+		src += params->flipx ? -1 : 1;
+
+		if (opaque || ((params->transmask >> pen) & 1) == 0)
+		{
+			if (pri == NULL || ((1 << (*pri & 0x1f)) & params->pmask) == 0)
+				*dest = params->basepen + pen;
+			if (pri != NULL)
+				*pri = 31;
+		}
+		dest++;
+		if (pri != NULL)
+			pri++;
+	}
+}
+
+#endif
+
+
+/*-------------------------------------------------
+    drawgfx_vector - draw an unpacked gfx element
+    with up to 16 pens to a 16bpp bitmap using the
+    vector kernels, where the pens are an identity
+    mapping; returns FALSE if it can't
+-------------------------------------------------*/
+
+INLINE int drawgfx_vector(bitmap_t *dest, const rectangle *cliprect, const gfx_element *gfx,
+		UINT32 code, UINT32 color, int flipx, int flipy, INT32 destx, INT32 desty,
+		bitmap_t *priority, UINT32 pmask, UINT32 transmask)
+{
+#ifdef __SSE2__
+	screen_device *screen = gfx->machine().primary_screen;
+	sse2_span_params params;
+	const UINT16 *rowusage;
+	const UINT8 *srcdata;
+	INT32 destendx, destendy;
+	INT32 srcx, srcy;
+	INT32 cury, dy, dsrcy;
+
+	/* only indexed palettes map pens 1:1; only 4bpp elements have row usage */
+	if (dest->bpp != 16 || (gfx->flags & GFX_ELEMENT_PACKED) || gfx->row_usage == NULL)
+		return FALSE;
+	if (screen == NULL || screen->format() != BITMAP_FORMAT_INDEXED16)
+		return FALSE;
+
+	g_profiler.start(PROFILER_DRAWGFX);
+	do
+	{
+		/* NULL clip means use the full bitmap */
+		if (cliprect == NULL)
+			cliprect = &dest->cliprect;
+
+		/* ignore empty/invalid cliprects */
+		if (cliprect->min_x > cliprect->max_x || cliprect->min_y > cliprect->max_y)
+			break;
+
+		/* clip in X */
+		destendx = destx + gfx->width - 1;
+		if (destx > cliprect->max_x || destendx < cliprect->min_x)
+			break;
+		srcx = 0;
+		if (destx < cliprect->min_x)
+		{
+			srcx = cliprect->min_x - destx;
+			destx = cliprect->min_x;
+		}
+		if (destendx > cliprect->max_x)
+			destendx = cliprect->max_x;
+
+		/* clip in Y */
+		destendy = desty + gfx->height - 1;
+		if (desty > cliprect->max_y || destendy < cliprect->min_y)
+			break;
+		srcy = 0;
+		if (desty < cliprect->min_y)
+		{
+			srcy = cliprect->min_y - desty;
+			desty = cliprect->min_y;
+		}
+		if (destendy > cliprect->max_y)
+			destendy = cliprect->max_y;
+
+		/* apply flipping */
+		if (flipx)
+			srcx = gfx->width - 1 - srcx;
+		dy = gfx->line_modulo;
+		dsrcy = 1;
+		if (flipy)
+		{
+			srcy = gfx->height - 1 - srcy;
+			dy = -dy;
+			dsrcy = -1;
+		}
+
+		/* fetch the source data; this decodes it and its row usage if needed */
+		srcdata = gfx_element_get_data(gfx, code) + srcy * gfx->line_modulo + srcx;
+		rowusage = &gfx->row_usage[code * gfx->origheight + gfx->starty];
+
+		/* set up the kernel; pens above 15 never appear */
+		transmask &= 0xffff;
+		sse2_build_set(&params.trans, transmask, 16);
+		if (priority != NULL)
+			sse2_build_set(&params.block, pmask, 32);
+		params.transmask = transmask;
+		params.pmask = pmask;
+		params.basepen = gfx->color_base + gfx->color_granularity * color;
+		params.base = _mm_set1_epi16(params.basepen);
+		params.flipx = flipx;
+
+		/* draw each row, skipping rows that are wholly transparent */
+		for (cury = desty; cury <= destendy; cury++)
+		{
+			UINT32 usage = rowusage[srcy];
+			if ((usage & ~transmask) != 0)
+				sse2_draw_span(BITMAP_ADDR16(dest, cury, destx), (priority != NULL) ? BITMAP_ADDR8(priority, cury, destx) : NULL,
+						srcdata, destendx + 1 - destx, &params, (usage & transmask) == 0);
+			srcdata += dy;
+			srcy += dsrcy;
+		}
+	} while (0);
+	g_profiler.stop();
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+
+
 /***************************************************************************
     DRAWGFX IMPLEMENTATIONS
 ***************************************************************************/
@@ -516,6 +845,10 @@ void drawgfx_opaque(bitmap_t *dest, const rectangle *cliprect, const gfx_element
 	color %= gfx->total_colors;
 	paldata = &gfx->machine().pens[gfx->color_base + gfx->color_granularity * color];
 
+	/* use the vector kernels where they apply */
+	if (drawgfx_vector(dest, cliprect, gfx, code, color, flipx, flipy, destx, desty, NULL, 0, 0))
+		return;
+
 	/* render based on dest bitmap depth */
 	if (dest->bpp == 16)
 		DRAWGFX_CORE(UINT16, PIXEL_OP_REMAP_OPAQUE, NO_PRIORITY);
@@ -569,6 +902,10 @@ void drawgfx_transpen(bitmap_t *dest, const rectangle *cliprect, const gfx_eleme
 		}
 	}
 
+	/* use the vector kernels where they apply */
+	if (drawgfx_vector(dest, cliprect, gfx, code, color, flipx, flipy, destx, desty, NULL, 0, (transpen < 16) ? (1 << transpen) : 0))
+		return;
+
 	/* render based on dest bitmap depth */
 	if (dest->bpp == 16)
 		DRAWGFX_CORE(UINT16, PIXEL_OP_REMAP_TRANSPEN, NO_PRIORITY);
@@ -654,6 +991,10 @@ void drawgfx_transmask(bitmap_t *dest, const rectangle *cliprect, const gfx_elem
 		}
 	}
 
+	/* use the vector kernels where they apply */
+	if (drawgfx_vector(dest, cliprect, gfx, code, color, flipx, flipy, destx, desty, NULL, 0, transmask))
+		return;
+
 	/* render based on dest bitmap depth */
 	if (dest->bpp == 16)
 		DRAWGFX_CORE(UINT16, PIXEL_OP_REMAP_TRANSMASK, NO_PRIORITY);
@@ -1049,6 +1390,10 @@ void pdrawgfx_opaque(bitmap_t *dest, const rectangle *cliprect, const gfx_elemen
 	/* high bit of the mask is implicitly on */
 	pmask |= 1 << 31;
 
+	/* use the vector kernels where they apply */
+	if (drawgfx_vector(dest, cliprect, gfx, code, color, flipx, flipy, destx, desty, priority, pmask, 0))
+		return;
+
 	/* render based on dest bitmap depth */
 	if (dest->bpp == 16)
 		DRAWGFX_CORE(UINT16, PIXEL_OP_REMAP_OPAQUE_PRIORITY, UINT8);
@@ -1105,6 +1450,10 @@ void pdrawgfx_transpen(bitmap_t *dest, const rectangle *cliprect, const gfx_elem
 	/* high bit of the mask is implicitly on */
 	pmask |= 1 << 31;
 
+	/* use the vector kernels where they apply */
+	if (drawgfx_vector(dest, cliprect, gfx, code, color, flipx, flipy, destx, desty, priority, pmask, (transpen < 16) ? (1 << transpen) : 0))
+		return;
+
 	/* render based on dest bitmap depth */
 	if (dest->bpp == 16)
 		DRAWGFX_CORE(UINT16, PIXEL_OP_REMAP_TRANSPEN_PRIORITY, UINT8);
@@ -1193,6 +1542,10 @@ void pdrawgfx_transmask(bitmap_t *dest, const rectangle *cliprect, const gfx_ele
 	/* high bit of the mask is implicitly on */
 	pmask |= 1 << 31;
 
+	/* use the vector kernels where they apply */
+	if (drawgfx_vector(dest, cliprect, gfx, code, color, flipx, flipy, destx, desty, priority, pmask, transmask))
+		return;
+
 	/* render based on dest bitmap depth */
 	if (dest->bpp == 16)
 		DRAWGFX_CORE(UINT16, PIXEL_OP_REMAP_TRANSMASK_PRIORITY, UINT8);
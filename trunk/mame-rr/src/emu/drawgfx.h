@@ -141,6 +141,7 @@ public:
 	UINT32			total_colors;		/* number of color codes */
 
 	UINT32 *		pen_usage;			/* bitmask of pens that are used (pens 0-31 only) */
+	UINT16 *		row_usage;			/* bitmask of pens used in each row (pens 0-15 only) */
 
 	UINT8 *			gfxdata;			/* pixel data, 8bpp or 4bpp (if GFX_ELEMENT_PACKED) */
 	UINT32			line_modulo;		/* bytes between each row of data */
@@ -148,6 +149,7 @@ public:
 	const UINT8 *	srcdata;			/* pointer to the source data for decoding */
 	UINT8 *			dirty;				/* dirty array for detecting tiles that need decoding */
 	UINT32			dirtyseq;			/* sequence number; incremented each time a tile is dirtied */
+	osd_lock *		decodelock;			/* lock for decoding while drawing from several threads */
 
 	gfx_layout		layout;				/* copy of the original layout */
 
@@ -185,6 +187,9 @@ gfx_element *gfx_element_alloc(running_machine &machine, const gfx_layout *gl, c
 /* update a single code in a gfx_element */
 void gfx_element_decode(const gfx_element *gfx, UINT32 code);
 
+/* update a single code in a gfx_element if it is still dirty; safe to call from several threads at once */
+void gfx_element_decode_dirty(const gfx_element *gfx, UINT32 code);
+
 /* free a gfx_element */
 void gfx_element_free(gfx_element *gfx);
 
@@ -356,7 +361,7 @@ INLINE const UINT8 *gfx_element_get_data(const gfx_element *gfx, UINT32 code)
 {
 	assert(code < gfx->total_elements);
 	if (gfx->dirty[code])
-		gfx_element_decode(gfx, code);
+		gfx_element_decode_dirty(gfx, code);
 	return gfx->gfxdata + code * gfx->char_modulo + gfx->starty * gfx->line_modulo + gfx->startx;
 }
 
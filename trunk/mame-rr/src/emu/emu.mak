@@ -79,6 +79,7 @@ EMUOBJS = \
 	$(EMUOBJ)/emupal.o \
 	$(EMUOBJ)/fileio.o \
 	$(EMUOBJ)/hash.o \
+	$(EMUOBJ)/hashcache.o \
 	$(EMUOBJ)/image.o \
 	$(EMUOBJ)/info.o \
 	$(EMUOBJ)/input.o \
@@ -95,6 +96,7 @@ EMUOBJS = \
 	$(EMUOBJ)/rendfont.o \
 	$(EMUOBJ)/rendlay.o \
 	$(EMUOBJ)/rendutil.o \
+	$(EMUOBJ)/romcache.o \
 	$(EMUOBJ)/romload.o \
 	$(EMUOBJ)/save.o \
 	$(EMUOBJ)/schedule.o \
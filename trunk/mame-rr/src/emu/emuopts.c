@@ -81,6 +81,7 @@ const options_entry emu_options::s_option_entries[] =
 	{ OPTION_SNAPSHOT_DIRECTORY,                         "snap",      OPTION_STRING,     "directory to save screenshots" },
 	{ OPTION_DIFF_DIRECTORY,                             "diff",      OPTION_STRING,     "directory to save hard drive image difference files" },
 	{ OPTION_COMMENT_DIRECTORY,                          "comments",  OPTION_STRING,     "directory to save debugger comments" },
+	{ OPTION_CACHE_DIRECTORY,                            "cache",     OPTION_STRING,     "directory to save persistent caches" },
 
 	// state/playback options
 	{ NULL,                                              NULL,        OPTION_HEADER,     "CORE STATE/PLAYBACK OPTIONS" },
@@ -105,6 +106,15 @@ const options_entry emu_options::s_option_entries[] =
 	{ OPTION_SLEEP,                                      "1",         OPTION_BOOLEAN,    "enable sleeping, which gives time back to other applications when idle" },
 	{ OPTION_SPEED "(0.01-100)",                         "1.0",       OPTION_FLOAT,      "controls the speed of gameplay, relative to realtime; smaller numbers are slower" },
 	{ OPTION_REFRESHSPEED ";rs",                         "0",         OPTION_BOOLEAN,    "automatically adjusts the speed of gameplay to keep the refresh rate lower than the screen" },
+	{ OPTION_DRC_CACHE,                                  "0",         OPTION_BOOLEAN,    "keep recompiled code in the cache directory and reuse it in later sessions" },
+	{ OPTION_DRC_PROFILE,                                "0",         OPTION_BOOLEAN,    "count executions and host cycles per recompiled block and report them on exit" },
+	{ OPTION_ZIP_CACHE,                                  "8",         OPTION_INTEGER,    "number of ZIP file directories to keep in memory after closing them" },
+	{ OPTION_ZIP_MMAP,                                   "0",         OPTION_BOOLEAN,    "map uncompressed files in ZIPs into memory instead of reading them" },
+	{ OPTION_HASH_CACHE,                                 "1",         OPTION_BOOLEAN,    "reuse ROM hashes from earlier sessions for files that have not changed; disable to force full verification" },
+	{ OPTION_ROM_CACHE,                                  "1",         OPTION_BOOLEAN,    "keep decrypted and preprocessed ROM data in the cache directory and reuse it in later sessions" },
+	{ OPTION_WARM_BOOT,                                  "0",         OPTION_BOOLEAN,    "keep loaded ROM regions in the cache directory and restore them instead of reloading unchanged ROMs" },
+	{ OPTION_SHARE_ROMS,                                 "0",         OPTION_BOOLEAN,    "map ROM regions and cached ROM data from the cache directory copy-on-write, so that instances running the same game share memory; implies -warm_boot" },
+	{ OPTION_VALIDITY_CACHE,                             "1",         OPTION_BOOLEAN,    "skip the validity checks for games whose driver passed them before with this build; disable to force them" },
 
 	// rotation options
 	{ NULL,                                              NULL,        OPTION_HEADER,     "CORE ROTATION OPTIONS" },
@@ -95,6 +95,7 @@ enum
 #define OPTION_SNAPSHOT_DIRECTORY	"snapshot_directory"
 #define OPTION_DIFF_DIRECTORY		"diff_directory"
 #define OPTION_COMMENT_DIRECTORY	"comment_directory"
+#define OPTION_CACHE_DIRECTORY		"cache_directory"
 
 // core state/playback options
 #define OPTION_STATE				"state"
@@ -117,6 +118,15 @@ enum
 #define OPTION_SLEEP				"sleep"
 #define OPTION_SPEED				"speed"
 #define OPTION_REFRESHSPEED			"refreshspeed"
+#define OPTION_DRC_CACHE			"drc_cache"
+#define OPTION_DRC_PROFILE			"drc_profile"
+#define OPTION_ZIP_CACHE			"zip_cache"
+#define OPTION_ZIP_MMAP				"zip_mmap"
+#define OPTION_HASH_CACHE			"hash_cache"
+#define OPTION_ROM_CACHE			"rom_cache"
+#define OPTION_WARM_BOOT			"warm_boot"
+#define OPTION_SHARE_ROMS			"share_roms"
+#define OPTION_VALIDITY_CACHE		"validity_cache"
 
 // core rotation options
 #define OPTION_ROTATE				"rotate"
@@ -250,6 +260,7 @@ public:
 	const char *snapshot_directory() const { return value(OPTION_SNAPSHOT_DIRECTORY); }
 	const char *diff_directory() const { return value(OPTION_DIFF_DIRECTORY); }
 	const char *comment_directory() const { return value(OPTION_COMMENT_DIRECTORY); }
+	const char *cache_directory() const { return value(OPTION_CACHE_DIRECTORY); }
 
 	// core state/playback options
 	const char *state() const { return value(OPTION_STATE); }
@@ -272,6 +283,15 @@ public:
 	bool sleep() const { return bool_value(OPTION_SLEEP); }
 	float speed() const { return float_value(OPTION_SPEED); }
 	bool refresh_speed() const { return bool_value(OPTION_REFRESHSPEED); }
+	bool drc_cache() const { return bool_value(OPTION_DRC_CACHE); }
+	bool drc_profile() const { return bool_value(OPTION_DRC_PROFILE); }
+	int zip_cache() const { return int_value(OPTION_ZIP_CACHE); }
+	bool zip_mmap() const { return bool_value(OPTION_ZIP_MMAP); }
+	bool hash_cache() const { return bool_value(OPTION_HASH_CACHE); }
+	bool rom_cache() const { return bool_value(OPTION_ROM_CACHE); }
+	bool warm_boot() const { return bool_value(OPTION_WARM_BOOT); }
+	bool share_roms() const { return bool_value(OPTION_SHARE_ROMS); }
+	bool validity_cache() const { return bool_value(OPTION_VALIDITY_CACHE); }
 
 	// core rotation options
 	bool rotate() const { return bool_value(OPTION_ROTATE); }
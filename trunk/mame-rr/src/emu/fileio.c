@@ -174,7 +174,9 @@ emu_file::emu_file(UINT32 openflags)
 	  m_openflags(openflags),
 	  m_zipfile(NULL),
 	  m_zipdata(NULL),
+	  m_zipmapping(NULL),
 	  m_ziplength(0),
+	  m_archivecrc(0),
 	  m_remove_on_close(false)
 {
 	// sanity check the open flags
@@ -189,7 +191,9 @@ emu_file::emu_file(const char *searchpath, UINT32 openflags)
 	  m_openflags(openflags),
 	  m_zipfile(NULL),
 	  m_zipdata(NULL),
+	  m_zipmapping(NULL),
 	  m_ziplength(0),
+	  m_archivecrc(0),
 	  m_remove_on_close(false)
 {
 	// sanity check the open flags
@@ -410,9 +414,12 @@ void emu_file::close()
 		core_fclose(m_file);
 	m_file = NULL;
 
-	if (m_zipdata != NULL)
+	if (m_zipmapping != NULL)
+		osd_unmap(m_zipmapping);
+	else if (m_zipdata != NULL)
 		global_free(m_zipdata);
 	m_zipdata = NULL;
+	m_zipmapping = NULL;
 
 	if (m_remove_on_close)
 		osd_rmfile(m_fullpath);
@@ -421,6 +428,8 @@ void emu_file::close()
 	// reset our hashes and path as well
 	m_hashes.reset();
 	m_fullpath.reset();
+	m_archivepath.reset();
+	m_archivecrc = 0;
 }
 
 
@@ -526,6 +535,19 @@ UINT32 emu_file::read(void *buffer, UINT32 length)
 }
 
 
+//-------------------------------------------------
+//  map - map part of the file into memory; only
+//  works for files on disk outside of ZIPs
+//-------------------------------------------------
+
+file_error emu_file::map(UINT64 offset, UINT32 length, UINT32 flags, void **base, osd_mapping **mapping)
+{
+	if (m_zipfile != NULL || m_file == NULL)
+		return FILERR_FAILURE;
+	return core_fmap(m_file, offset, length, flags, base, mapping);
+}
+
+
 //-------------------------------------------------
 //  getc - read a character from a file
 //-------------------------------------------------
@@ -672,28 +694,28 @@ file_error emu_file::attempt_zipped()
 
 		// see if we can find a file with the right name and (if available) crc
 		const zip_file_header *header;
-		for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-			if (zip_filename_match(*header, filename) && (!(m_openflags & OPEN_FLAG_HAS_CRC) || header->crc == m_crc))
+		for (header = zip_file_find_name(zip, filename); header != NULL; header = zip_file_find_next(zip))
+			if (!(m_openflags & OPEN_FLAG_HAS_CRC) || header->crc == m_crc)
 				break;
 
 		// if that failed, look for a file with the right crc, but the wrong filename
 		if (header == NULL && (m_openflags & OPEN_FLAG_HAS_CRC))
-			for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-				if (header->crc == m_crc && !zip_header_is_path(*header))
+			for (header = zip_file_find_crc(zip, m_crc); header != NULL; header = zip_file_find_next(zip))
+				if (!zip_header_is_path(*header))
 					break;
 
 		// if that failed, look for a file with the right name; reporting a bad checksum
 		// is more helpful and less confusing than reporting "rom not found"
 		if (header == NULL)
-			for (header = zip_file_first_file(zip); header != NULL; header = zip_file_next_file(zip))
-				if (zip_filename_match(*header, filename))
-					break;
+			header = zip_file_find_name(zip, filename);
 
 		// if we got it, read the data
 		if (header != NULL)
 		{
 			m_zipfile = zip;
 			m_ziplength = header->uncompressed_length;
+			m_archivepath.cpy(zip->filename);
+			m_archivecrc = header->crc;
 
 			// build a hash with just the CRC
 			m_hashes.reset();
@@ -717,24 +739,36 @@ file_error emu_file::load_zipped_file()
 	assert(m_zipdata == NULL);
 	assert(m_zipfile != NULL);
 
-	// allocate some memory
-	m_zipdata = global_alloc_array(UINT8, m_ziplength);
-
-	// read the data into our buffer and return
-	zip_error ziperr = zip_file_decompress(m_zipfile, m_zipdata, m_ziplength);
-	if (ziperr != ZIPERR_NONE)
+	// stored files can be used in place if mapping is enabled
+	const void *mapped;
+	if (zip_file_map(m_zipfile, &mapped, &m_zipmapping) == ZIPERR_NONE)
+		m_zipdata = reinterpret_cast<UINT8 *>(const_cast<void *>(mapped));
+	else
 	{
-		global_free(m_zipdata);
-		m_zipdata = NULL;
-		return FILERR_FAILURE;
+		// allocate some memory
+		m_zipdata = global_alloc_array(UINT8, m_ziplength);
+		m_zipmapping = NULL;
+
+		// read the data into our buffer and return
+		zip_error ziperr = zip_file_decompress(m_zipfile, m_zipdata, m_ziplength);
+		if (ziperr != ZIPERR_NONE)
+		{
+			global_free(m_zipdata);
+			m_zipdata = NULL;
+			return FILERR_FAILURE;
+		}
 	}
 
 	// convert to RAM file
 	file_error filerr = core_fopen_ram(m_zipdata, m_ziplength, m_openflags, &m_file);
 	if (filerr != FILERR_NONE)
 	{
-		global_free(m_zipdata);
+		if (m_zipmapping != NULL)
+			osd_unmap(m_zipmapping);
+		else
+			global_free(m_zipdata);
 		m_zipdata = NULL;
+		m_zipmapping = NULL;
 		return FILERR_FAILURE;
 	}
 
@@ -745,18 +779,6 @@ file_error emu_file::load_zipped_file()
 }
 
 
-//-------------------------------------------------
-//  zip_filename_match - compare zip filename
-//  to expected filename, ignoring any directory
-//-------------------------------------------------
-
-bool emu_file::zip_filename_match(const zip_file_header &header, const astring &filename)
-{
-	const char *zipfile = header.filename + header.filename_length - filename.len();
-	return (zipfile >= header.filename && filename.icmp(zipfile) == 0 && (zipfile == header.filename || zipfile[-1] == '/'));
-}
-
-
 //-------------------------------------------------
 //  zip_header_is_path - check whether filename
 //  in header is a path
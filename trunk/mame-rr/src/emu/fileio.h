@@ -125,6 +125,10 @@ public:
 	UINT32 openflags() const { return m_openflags; }
 	hash_collection &hashes(const char *types);
 
+	// identification of the data on disk, for caching
+	const char *archive_path() const { return (m_archivepath.len() != 0) ? m_archivepath.cstr() : m_fullpath.cstr(); }
+	bool archive_crc(UINT32 &crc) const { crc = m_archivecrc; return (m_archivepath.len() != 0); }
+
 	// setters
 	void remove_on_close() { m_remove_on_close = true; }
 	void set_openflags(UINT32 openflags) { assert(m_file == NULL); m_openflags = openflags; }
@@ -151,6 +155,7 @@ public:
 
 	// reading
 	UINT32 read(void *buffer, UINT32 length);
+	file_error map(UINT64 offset, UINT32 length, UINT32 flags, void **base, osd_mapping **mapping);
 	int getc();
 	int ungetc(int c);
 	char *gets(char *s, int n);
@@ -165,7 +170,6 @@ private:
 	// internal helpers
 	file_error attempt_zipped();
 	file_error load_zipped_file();
-	bool zip_filename_match(const zip_file_header &header, const astring &filename);
 	bool zip_header_is_path(const zip_file_header &header);
 
 	// internal state
@@ -178,7 +182,10 @@ private:
 	hash_collection m_hashes;						// collection of hashes
 	zip_file *		m_zipfile;						// ZIP file pointer
 	UINT8 *			m_zipdata;						// ZIP file data
+	osd_mapping *	m_zipmapping;					// mapping of the ZIP data, if mapped
 	UINT64			m_ziplength;					// ZIP file length
+	astring			m_archivepath;					// path of the ZIP we came from, if any
+	UINT32			m_archivecrc;					// CRC from the ZIP directory
 	bool			m_remove_on_close;				// flag: remove the file when closing
 };
 
@@ -0,0 +1,209 @@
+/***************************************************************************
+
+    hashcache.c
+
+    Persistent cache of hashes computed for unchanged files.
+
+    Copyright Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    The cache is a text file in the cache directory. The first line is
+    a signature; each following line describes one file:
+
+        size modified hashes key
+
+    where size and modified are 16 hex digits each, hashes is the hash
+    collection in internal string form, and key is the path of the file
+    on disk, followed by "|" and the member CRC for files inside a ZIP.
+
+***************************************************************************/
+
+#include "emu.h"
+#include "emuopts.h"
+#include "hashcache.h"
+
+
+
+//**************************************************************************
+//  CONSTANTS
+//**************************************************************************
+
+static const char HASH_CACHE_FILENAME[] = "hashes.txt";
+static const char HASH_CACHE_SIGNATURE[] = "MAMEHASHCACHE 1";
+
+
+
+//**************************************************************************
+//  FILE HASH CACHE
+//**************************************************************************
+
+//-------------------------------------------------
+//  file_hash_cache - constructor
+//-------------------------------------------------
+
+file_hash_cache::file_hash_cache(const emu_options &options)
+	: m_options(options),
+	  m_lock(osd_lock_alloc()),
+	  m_loaded(false),
+	  m_dirty(false)
+{
+}
+
+
+//-------------------------------------------------
+//  ~file_hash_cache - destructor
+//-------------------------------------------------
+
+file_hash_cache::~file_hash_cache()
+{
+	save();
+	osd_lock_free(m_lock);
+}
+
+
+//-------------------------------------------------
+//  hashes - return the hashes of an open file,
+//  using the cached values if the file on disk
+//  has not changed
+//-------------------------------------------------
+
+hash_collection &file_hash_cache::hashes(emu_file &file, const char *types)
+{
+	// identify the data on disk; if we can't, just compute everything
+	osd_directory_entry *diskentry = osd_stat(file.archive_path());
+	if (diskentry == NULL)
+		return file.hashes(types);
+	UINT64 size = diskentry->size;
+	UINT64 modified = diskentry->last_modified;
+	osd_free(diskentry);
+
+	astring key;
+	make_key(file, key);
+
+	// merge in whatever we remember about this exact file
+	hash_collection &result = file.hashes("");
+	osd_lock_acquire(m_lock);
+	if (!m_loaded)
+		load();
+	entry *cached = m_map.find(key);
+	if (m_options.hash_cache() && cached != NULL && cached->m_size == size && cached->m_modified == modified)
+	{
+		hash_collection known(cached->m_hashes);
+		for (hash_base *hash = known.first(); hash != NULL; hash = hash->next())
+			if (result.hash(hash->id()) == NULL)
+				result.add_from_buffer(hash->id(), hash->buffer(), hash->length());
+	}
+	osd_lock_release(m_lock);
+
+	// compute whatever is still missing outside of the lock
+	astring before, after;
+	result.internal_string(before);
+	file.hashes(types);
+	result.internal_string(after);
+	if (after == before)
+		return result;
+
+	// remember the result for next time
+	osd_lock_acquire(m_lock);
+	cached = m_map.find(key);
+	if (cached == NULL)
+	{
+		cached = &m_list.append(*global_alloc(entry));
+		cached->m_key.cpy(key);
+		m_map.add(cached->m_key, cached);
+	}
+	cached->m_size = size;
+	cached->m_modified = modified;
+	cached->m_hashes.cpy(after);
+	m_dirty = true;
+	osd_lock_release(m_lock);
+	return result;
+}
+
+
+//-------------------------------------------------
+//  save - write out the cache if anything has
+//  changed since it was loaded
+//-------------------------------------------------
+
+void file_hash_cache::save()
+{
+	osd_lock_acquire(m_lock);
+	if (m_dirty)
+	{
+		emu_file file(m_options.cache_directory(), OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS);
+		if (file.open(HASH_CACHE_FILENAME) == FILERR_NONE)
+		{
+			file.printf("%s\n", HASH_CACHE_SIGNATURE);
+			for (entry *cached = m_list.first(); cached != NULL; cached = cached->next())
+				file.printf("%08X%08X %08X%08X %s %s\n",
+						(UINT32)(cached->m_size >> 32), (UINT32)cached->m_size,
+						(UINT32)(cached->m_modified >> 32), (UINT32)cached->m_modified,
+						cached->m_hashes.cstr(), cached->m_key.cstr());
+			m_dirty = false;
+		}
+	}
+	osd_lock_release(m_lock);
+}
+
+
+//-------------------------------------------------
+//  make_key - build the key for an open file
+//-------------------------------------------------
+
+const char *file_hash_cache::make_key(emu_file &file, astring &key)
+{
+	UINT32 crc;
+	key.cpy(file.archive_path());
+	if (file.archive_crc(crc))
+		key.catprintf("|%08x", crc);
+	return key;
+}
+
+
+//-------------------------------------------------
+//  load - read the cache written by an earlier
+//  session; called with the lock held
+//-------------------------------------------------
+
+void file_hash_cache::load()
+{
+	m_loaded = true;
+
+	emu_file file(m_options.cache_directory(), OPEN_FLAG_READ);
+	if (file.open(HASH_CACHE_FILENAME) != FILERR_NONE)
+		return;
+
+	// anything with the wrong signature is ignored and later replaced
+	char line[1024];
+	if (file.gets(line, sizeof(line)) == NULL || strncmp(line, HASH_CACHE_SIGNATURE, strlen(HASH_CACHE_SIGNATURE)) != 0)
+		return;
+
+	while (file.gets(line, sizeof(line)) != NULL)
+	{
+		// parse the fixed fields, skipping anything malformed
+		UINT32 sizehi, sizelo, modhi, modlo;
+		char hashes[256];
+		int keystart = 0;
+		if (sscanf(line, "%8x%8x %8x%8x %255s %n", &sizehi, &sizelo, &modhi, &modlo, hashes, &keystart) != 5 || keystart == 0)
+			continue;
+
+		// the key is the rest of the line
+		int keyend = strlen(line);
+		while (keyend > keystart && (line[keyend - 1] == '\r' || line[keyend - 1] == '\n'))
+			line[--keyend] = 0;
+		astring key(&line[keystart]);
+		if (key.len() == 0 || m_map.find(key) != NULL)
+			continue;
+
+		entry &cached = m_list.append(*global_alloc(entry));
+		cached.m_key.cpy(key);
+		cached.m_size = ((UINT64)sizehi << 32) | sizelo;
+		cached.m_modified = ((UINT64)modhi << 32) | modlo;
+		cached.m_hashes.cpy(hashes);
+		m_map.add(cached.m_key, &cached);
+	}
+	m_dirty = false;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+
+    hashcache.h
+
+    Persistent cache of hashes computed for unchanged files.
+
+    Copyright Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#pragma once
+
+#ifndef __HASHCACHE_H__
+#define __HASHCACHE_H__
+
+#include "hash.h"
+
+
+//**************************************************************************
+//  TYPE DEFINITIONS
+//**************************************************************************
+
+// forward references
+class emu_options;
+class emu_file;
+
+
+// ======================> file_hash_cache
+
+// remembers the hashes of files on disk, keyed by the path of the file (or
+// the ZIP containing it), its size and modification time, and the member
+// CRC from the ZIP directory; safe to use from multiple threads
+class file_hash_cache
+{
+public:
+	// construction/destruction
+	file_hash_cache(const emu_options &options);
+	~file_hash_cache();
+
+	// return the hashes of an open file, computing only those we don't know
+	hash_collection &hashes(emu_file &file, const char *types);
+
+	// write out the cache if anything changed
+	void save();
+
+private:
+	// an entry in the cache
+	class entry
+	{
+		friend class simple_list<entry>;
+
+	public:
+		entry *next() const { return m_next; }
+
+		entry *			m_next;
+		astring			m_key;					// path and member CRC
+		UINT64			m_size;					// size of the file on disk
+		UINT64			m_modified;				// modification time of the file on disk
+		astring			m_hashes;				// hashes in internal string form
+	};
+
+	// internal helpers
+	static const char *make_key(emu_file &file, astring &key);
+	void load();
+
+	// internal state
+	const emu_options &	m_options;
+	osd_lock *			m_lock;					// lock for access from worker threads
+	simple_list<entry>	m_list;					// list of all entries, for saving
+	tagmap_t<entry *>	m_map;					// map from key to entry
+	bool				m_loaded;				// have we read the file yet?
+	bool				m_dirty;				// has anything changed since?
+};
+
+
+#endif	/* __HASHCACHE_H__ */
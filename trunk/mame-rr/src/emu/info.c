@@ -47,6 +47,15 @@
 
 #include <ctype.h>
 
+//**************************************************************************
+//  CONSTANTS
+//**************************************************************************
+
+// drivers are written in this many pieces, each to its own temporary file
+static const int INFO_XML_CHUNKS = 64;
+
+
+
 //**************************************************************************
 //  GLOBAL VARIABLES
 //**************************************************************************
@@ -198,7 +207,11 @@ extern int m_device_count;
 
 info_xml_creator::info_xml_creator(driver_enumerator &drivlist)
 	: m_output(NULL),
-	  m_drivlist(drivlist)
+	  m_drivlist(drivlist),
+	  m_device_used(NULL),
+	  m_device_lock(NULL),
+	  m_chunkfiles(NULL),
+	  m_chunksize(0)
 {
 }
 
@@ -224,15 +237,17 @@ void info_xml_creator::output(FILE *out)
 		"no"
 #endif
 		"\" mameconfig=\"%d\">\n",
-		xml_normalize_string(build_version),
+		normalize(build_version),
 		CONFIG_VERSION
 	);
 
 	m_device_used = global_alloc_array_clear(UINT8, m_device_count);
 
-	// iterate through the drivers, outputting one at a time
-	while (m_drivlist.next())
-		output_one();
+	// output the drivers in pieces on all processors if we can, or one at
+	// a time if not
+	if (!output_parallel())
+		while (m_drivlist.next())
+			output_one();
 
 	// iterate through the devices, and output their roms
 	output_devices();
@@ -244,6 +259,94 @@ void info_xml_creator::output(FILE *out)
 }
 
 
+//-------------------------------------------------
+//  output_parallel - write the drivers in pieces
+//  on a work queue, each to a temporary file,
+//  then copy the files out in driver order;
+//  returns false if nothing could be written
+//  this way
+//-------------------------------------------------
+
+bool info_xml_creator::output_parallel()
+{
+	// one temporary file per piece
+	FILE *chunkfiles[INFO_XML_CHUNKS];
+	int chunk;
+	for (chunk = 0; chunk < INFO_XML_CHUNKS; chunk++)
+		if ((chunkfiles[chunk] = tmpfile()) == NULL)
+			break;
+
+	osd_work_queue *queue = NULL;
+	if (chunk == INFO_XML_CHUNKS)
+		queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	if (queue == NULL)
+	{
+		while (chunk > 0)
+			fclose(chunkfiles[--chunk]);
+		return false;
+	}
+
+	// each piece gets its own enumerator and configuration cache
+	m_chunkfiles = chunkfiles;
+	m_chunksize = (driver_list::total() + INFO_XML_CHUNKS - 1) / INFO_XML_CHUNKS;
+	m_device_lock = osd_lock_alloc();
+	osd_work_queue_parallel_for(queue, &info_xml_creator::output_chunk, this, INFO_XML_CHUNKS, 1);
+	osd_work_queue_free(queue);
+	osd_lock_free(m_device_lock);
+	m_device_lock = NULL;
+	m_chunkfiles = NULL;
+
+	// stitch the pieces together
+	for (chunk = 0; chunk < INFO_XML_CHUNKS; chunk++)
+	{
+		char buffer[16384];
+		size_t bytes;
+
+		rewind(chunkfiles[chunk]);
+		while ((bytes = fread(buffer, 1, sizeof(buffer), chunkfiles[chunk])) > 0)
+			fwrite(buffer, 1, bytes, m_output);
+		fclose(chunkfiles[chunk]);
+	}
+	return true;
+}
+
+
+//-------------------------------------------------
+//  output_chunk - write a range of pieces; called
+//  from worker threads
+//-------------------------------------------------
+
+void info_xml_creator::output_chunk(void *param, INT32 start, INT32 end, int threadid)
+{
+	info_xml_creator &parent = *reinterpret_cast<info_xml_creator *>(param);
+
+	for (int chunk = start; chunk < end; chunk++)
+	{
+		// enumerate just the drivers in this piece that the parent would
+		driver_enumerator drivlist(parent.m_drivlist.options());
+		drivlist.exclude_all();
+		int first = chunk * parent.m_chunksize;
+		int last = MIN(first + parent.m_chunksize, driver_list::total());
+		for (int drvindex = first; drvindex < last; drvindex++)
+			if (parent.m_drivlist.included(drvindex))
+				drivlist.include(drvindex);
+
+		info_xml_creator creator(drivlist);
+		creator.m_output = parent.m_chunkfiles[chunk];
+		creator.m_device_used = global_alloc_array_clear(UINT8, m_device_count);
+		while (drivlist.next())
+			creator.output_one();
+
+		// merge the devices we referenced
+		osd_lock_acquire(parent.m_device_lock);
+		for (int devnum = 0; devnum < m_device_count; devnum++)
+			parent.m_device_used[devnum] |= creator.m_device_used[devnum];
+		osd_lock_release(parent.m_device_lock);
+		global_free(creator.m_device_used);
+	}
+}
+
+
 //-------------------------------------------------
 //  output_devices - print the XML information
 //  for one particular game driver
@@ -265,14 +368,14 @@ void info_xml_creator::output_devices()
 
 			// print the header and the game name
 			fprintf(m_output, "\t<" XML_TOP);
-			fprintf(m_output, " name=\"%s\"", xml_normalize_string(dev->shortname()));
+			fprintf(m_output, " name=\"%s\"", normalize(dev->shortname()));
 			fprintf(m_output, " isdevice=\"yes\"");
 			fprintf(m_output, " runnable=\"no\"");
 			fprintf(m_output, ">\n");
 
 			// output device description
 			if (dev->name() != NULL)
-				fprintf(m_output, "\t\t<description>%s</description>\n", xml_normalize_string(dev->name()));
+				fprintf(m_output, "\t\t<description>%s</description>\n", normalize(dev->name()));
 
 			output_rom(dev);
 
@@ -304,7 +407,7 @@ void info_xml_creator::output_one()
 
 	// print the header and the game name
 	fprintf(m_output, "\t<" XML_TOP);
-	fprintf(m_output, " name=\"%s\"", xml_normalize_string(driver.name));
+	fprintf(m_output, " name=\"%s\"", normalize(driver.name));
 
 	// strip away any path information from the source_file and output it
 	const char *start = strrchr(driver.source_file, '/');
@@ -312,7 +415,7 @@ void info_xml_creator::output_one()
 		start = strrchr(driver.source_file, '\\');
 	if (start == NULL)
 		start = driver.source_file - 1;
-	fprintf(m_output, " sourcefile=\"%s\"", xml_normalize_string(start + 1));
+	fprintf(m_output, " sourcefile=\"%s\"", normalize(start + 1));
 
 	// append bios and runnable flags
 	if (driver.flags & GAME_IS_BIOS_ROOT)
@@ -325,9 +428,9 @@ void info_xml_creator::output_one()
 	// display clone information
 	int clone_of = m_drivlist.find(driver.parent);
 	if (clone_of != -1 && !(m_drivlist.driver(clone_of).flags & GAME_IS_BIOS_ROOT))
-		fprintf(m_output, " cloneof=\"%s\"", xml_normalize_string(m_drivlist.driver(clone_of).name));
+		fprintf(m_output, " cloneof=\"%s\"", normalize(m_drivlist.driver(clone_of).name));
 	if (clone_of != -1)
-		fprintf(m_output, " romof=\"%s\"", xml_normalize_string(m_drivlist.driver(clone_of).name));
+		fprintf(m_output, " romof=\"%s\"", normalize(m_drivlist.driver(clone_of).name));
 
 	// display sample information and close the game tag
 	output_sampleof();
@@ -335,15 +438,15 @@ void info_xml_creator::output_one()
 
 	// output game description
 	if (driver.description != NULL)
-		fprintf(m_output, "\t\t<description>%s</description>\n", xml_normalize_string(driver.description));
+		fprintf(m_output, "\t\t<description>%s</description>\n", normalize(driver.description));
 
 	// print the year only if is a number or another allowed character (? or +)
 	if (driver.year != NULL && strspn(driver.year, "0123456789?+") == strlen(driver.year))
-		fprintf(m_output, "\t\t<year>%s</year>\n", xml_normalize_string(driver.year));
+		fprintf(m_output, "\t\t<year>%s</year>\n", normalize(driver.year));
 
 	// print the manufacturer information
 	if (driver.manufacturer != NULL)
-		fprintf(m_output, "\t\t<manufacturer>%s</manufacturer>\n", xml_normalize_string(driver.manufacturer));
+		fprintf(m_output, "\t\t<manufacturer>%s</manufacturer>\n", normalize(driver.manufacturer));
 
 	// now print various additional information
 	output_bios();
@@ -378,7 +481,7 @@ void info_xml_creator::output_device_roms()
 	for (const rom_source *source = rom_first_source(m_drivlist.config()); source != NULL; source = rom_next_source(*source))
 	{
 		if (cnt!=0) {
-			fprintf(m_output, "\t\t<device_ref name=\"%s\"/>\n", xml_normalize_string(source->shortname()));
+			fprintf(m_output, "\t\t<device_ref name=\"%s\"/>\n", normalize(source->shortname()));
 			for(int i=0;i<m_device_count;i++) {
 				if (source->type() == *s_devices_sorted[i]) m_device_used[i] = 1;
 			}
@@ -406,7 +509,7 @@ void info_xml_creator::output_sampleof()
 				// only output sampleof if different from the game name
 				const char *cursampname = samplenames[sampnum];
 				if (cursampname[0] == '*' && strcmp(cursampname + 1, m_drivlist.driver().name) != 0)
-					fprintf(m_output, " sampleof=\"%s\"", xml_normalize_string(cursampname + 1));
+					fprintf(m_output, " sampleof=\"%s\"", normalize(cursampname + 1));
 
 				// must stop here, as there can only be one attribute of the same name
 				return;
@@ -432,8 +535,8 @@ void info_xml_creator::output_bios()
 		{
 			// output extracted name and descriptions
 			fprintf(m_output, "\t\t<biosset");
-			fprintf(m_output, " name=\"%s\"", xml_normalize_string(ROM_GETNAME(rom)));
-			fprintf(m_output, " description=\"%s\"", xml_normalize_string(ROM_GETHASHDATA(rom)));
+			fprintf(m_output, " name=\"%s\"", normalize(ROM_GETNAME(rom)));
+			fprintf(m_output, " description=\"%s\"", normalize(ROM_GETHASHDATA(rom)));
 			if (ROM_GETBIOSFLAGS(rom) == 1)
 				fprintf(m_output, " default=\"yes\"");
 			fprintf(m_output, "/>\n");
@@ -498,11 +601,11 @@ void info_xml_creator::output_rom(const rom_source *source)
 
 					// add name, merge, bios, and size tags */
 					if (name != NULL && name[0] != 0)
-						fprintf(m_output, " name=\"%s\"", xml_normalize_string(name));
+						fprintf(m_output, " name=\"%s\"", normalize(name));
 					if (merge_name != NULL)
-						fprintf(m_output, " merge=\"%s\"", xml_normalize_string(merge_name));
+						fprintf(m_output, " merge=\"%s\"", normalize(merge_name));
 					if (bios_name[0] != 0)
-						fprintf(m_output, " bios=\"%s\"", xml_normalize_string(bios_name));
+						fprintf(m_output, " bios=\"%s\"", normalize(bios_name));
 					if (!is_disk)
 						fprintf(m_output, " size=\"%d\"", rom_file_size(rom));
 
@@ -576,7 +679,7 @@ void info_xml_creator::output_sample()
 					continue;
 
 				// output the sample name
-				fprintf(m_output, "\t\t<sample name=\"%s\"/>\n", xml_normalize_string(cursampname));
+				fprintf(m_output, "\t\t<sample name=\"%s\"/>\n", normalize(cursampname));
 			}
 	}
 }
@@ -595,8 +698,8 @@ void info_xml_creator::output_chips()
 	{
 		fprintf(m_output, "\t\t<chip");
 		fprintf(m_output, " type=\"cpu\"");
-		fprintf(m_output, " tag=\"%s\"", xml_normalize_string(exec->device().tag()));
-		fprintf(m_output, " name=\"%s\"", xml_normalize_string(exec->device().name()));
+		fprintf(m_output, " tag=\"%s\"", normalize(exec->device().tag()));
+		fprintf(m_output, " name=\"%s\"", normalize(exec->device().name()));
 		fprintf(m_output, " clock=\"%d\"", exec->device().clock());
 		fprintf(m_output, "/>\n");
 	}
@@ -607,8 +710,8 @@ void info_xml_creator::output_chips()
 	{
 		fprintf(m_output, "\t\t<chip");
 		fprintf(m_output, " type=\"audio\"");
-		fprintf(m_output, " tag=\"%s\"", xml_normalize_string(sound->device().tag()));
-		fprintf(m_output, " name=\"%s\"", xml_normalize_string(sound->device().name()));
+		fprintf(m_output, " tag=\"%s\"", normalize(sound->device().tag()));
+		fprintf(m_output, " name=\"%s\"", normalize(sound->device().name()));
 		if (sound->device().clock() != 0)
 			fprintf(m_output, " clock=\"%d\"", sound->device().clock());
 		fprintf(m_output, "/>\n");
@@ -978,7 +1081,7 @@ void info_xml_creator::output_input(const ioport_list &portlist)
 	for (int type = 0; type < ANALOG_TYPE_COUNT; type++)
 		if (control_info[type].type != NULL)
 		{
-			fprintf(m_output, "\t\t\t<control type=\"%s\"", xml_normalize_string(control_info[type].type));
+			fprintf(m_output, "\t\t\t<control type=\"%s\"", normalize(control_info[type].type));
 			if (control_info[type].min != 0 || control_info[type].max != 0)
 			{
 				fprintf(m_output, " minimum=\"%d\"", control_info[type].min);
@@ -1025,15 +1128,15 @@ void info_xml_creator::output_switches(const ioport_list &portlist, int type, co
 			if (field->type == type)
 			{
 				// output the switch name information
-				fprintf(m_output, "\t\t<%s name=\"%s\"", outertag, xml_normalize_string(input_field_name(field)));
-				fprintf(m_output, " tag=\"%s\"", xml_normalize_string(field->port().tag()));
+				fprintf(m_output, "\t\t<%s name=\"%s\"", outertag, normalize(input_field_name(field)));
+				fprintf(m_output, " tag=\"%s\"", normalize(field->port().tag()));
 				fprintf(m_output, " mask=\"%u\"", field->mask);
 				fprintf(m_output, ">\n");
 
 				// loop over settings
 				for (input_setting_config *setting = field->settinglist().first(); setting != NULL; setting = setting->next())
 				{
-					fprintf(m_output, "\t\t\t<%s name=\"%s\"", innertag, xml_normalize_string(setting->name));
+					fprintf(m_output, "\t\t\t<%s name=\"%s\"", innertag, normalize(setting->name));
 					fprintf(m_output, " value=\"%u\"", setting->value);
 					if (setting->value == field->defvalue)
 						fprintf(m_output, " default=\"yes\"");
@@ -1057,7 +1160,7 @@ void info_xml_creator::output_adjusters(const ioport_list &portlist)
 	for (input_port_config *port = portlist.first(); port != NULL; port = port->next())
 		for (input_field_config *field = port->fieldlist().first(); field != NULL; field = field->next())
 			if (field->type == IPT_ADJUSTER)
-				fprintf(m_output, "\t\t<adjuster name=\"%s\" default=\"%d\"/>\n", xml_normalize_string(input_field_name(field)), field->defvalue);
+				fprintf(m_output, "\t\t<adjuster name=\"%s\" default=\"%d\"/>\n", normalize(input_field_name(field)), field->defvalue);
 }
 
 
@@ -1136,18 +1239,18 @@ void info_xml_creator::output_images()
 	for (bool gotone = m_drivlist.config().devicelist().first(dev); gotone; gotone = dev->next(dev))
 	{
 		// print m_output device type
-		fprintf(m_output, "\t\t<device type=\"%s\"", xml_normalize_string(dev->image_type_name()));
+		fprintf(m_output, "\t\t<device type=\"%s\"", normalize(dev->image_type_name()));
 
 		// does this device have a tag?
 		if (dev->device().tag())
-			fprintf(m_output, " tag=\"%s\"", xml_normalize_string(dev->device().tag()));
+			fprintf(m_output, " tag=\"%s\"", normalize(dev->device().tag()));
 
 		// is this device mandatory?
 		if (dev->must_be_loaded())
 			fprintf(m_output, " mandatory=\"1\"");
 
 		if (dev->image_interface() && dev->image_interface()[0])
-			fprintf(m_output, " interface=\"%s\"", xml_normalize_string(dev->image_interface()));
+			fprintf(m_output, " interface=\"%s\"", normalize(dev->image_interface()));
 
 		// close the XML tag
 		fprintf(m_output, ">\n");
@@ -1156,19 +1259,24 @@ void info_xml_creator::output_images()
 		const char *shortname = dev->brief_instance_name();
 
 		fprintf(m_output, "\t\t\t<instance");
-		fprintf(m_output, " name=\"%s\"", xml_normalize_string(name));
-		fprintf(m_output, " briefname=\"%s\"", xml_normalize_string(shortname));
+		fprintf(m_output, " name=\"%s\"", normalize(name));
+		fprintf(m_output, " briefname=\"%s\"", normalize(shortname));
 		fprintf(m_output, "/>\n");
 
+		// strtok isn't safe with other threads writing other drivers
 		astring extensions(dev->file_extensions());
-
-		char *ext = strtok((char *)extensions.cstr(), ",");
-		while (ext != NULL)
+		for (int start = 0, end = extensions.chr(0, ','); start < extensions.len(); start = end + 1, end = extensions.chr(start, ','))
 		{
-			fprintf(m_output, "\t\t\t<extension");
-			fprintf(m_output, " name=\"%s\"", xml_normalize_string(ext));
-			fprintf(m_output, "/>\n");
-			ext = strtok(NULL, ",");
+			astring ext;
+			ext.cpysubstr(extensions, start, (end == -1) ? -1 : end - start);
+			if (ext.len() != 0)
+			{
+				fprintf(m_output, "\t\t\t<extension");
+				fprintf(m_output, " name=\"%s\"", normalize(ext));
+				fprintf(m_output, "/>\n");
+			}
+			if (end == -1)
+				break;
 		}
 
 		fprintf(m_output, "\t\t</device>\n");
@@ -1186,18 +1294,18 @@ void info_xml_creator::output_slots()
 	for (bool gotone = m_drivlist.config().devicelist().first(slot); gotone; gotone = slot->next(slot))
 	{
 		// print m_output device type
-		fprintf(m_output, "\t\t<slot name=\"%s\">\n", xml_normalize_string(slot->device().tag()));
+		fprintf(m_output, "\t\t<slot name=\"%s\">\n", normalize(slot->device().tag()));
 
 		/*
         if (slot->slot_interface()[0])
-            fprintf(m_output, " interface=\"%s\"", xml_normalize_string(slot->slot_interface()));
+            fprintf(m_output, " interface=\"%s\"", normalize(slot->slot_interface()));
          */
 
 		const slot_interface* intf = slot->get_slot_interfaces();
 		for (int i = 0; intf[i].name != NULL; i++)
 		{
 			fprintf(m_output, "\t\t\t<slotoption");
-			fprintf(m_output, " name=\"%s\"", xml_normalize_string(intf[i].name));
+			fprintf(m_output, " name=\"%s\"", normalize(intf[i].name));
 			if (slot->get_default_card(m_drivlist.config().devicelist(), m_drivlist.options()))
 			{
 				if (slot->get_default_card(m_drivlist.config().devicelist(), m_drivlist.options()) == intf[i].name)
@@ -1261,6 +1369,18 @@ void info_xml_creator::output_ramoptions()
 }
 
 
+//-------------------------------------------------
+//  normalize - normalize a string for XML into
+//  our own buffer, so other threads writing
+//  other drivers don't trample it
+//-------------------------------------------------
+
+const char *info_xml_creator::normalize(const char *string)
+{
+	return xml_normalize_string_buffer(string, m_normalized, sizeof(m_normalized));
+}
+
+
 //-------------------------------------------------
 //  get_merge_name - get the rom name from a
 //  parent set
@@ -59,6 +59,8 @@ public:
 
 private:
 	// internal helper
+	bool output_parallel();
+	static void output_chunk(void *param, INT32 start, INT32 end, int threadid);
 	void output_one();
 	void output_sampleof();
 	void output_bios();
@@ -80,12 +82,17 @@ private:
 
 	void output_devices();
 
+	const char *normalize(const char *string);
 	const char *get_merge_name(const hash_collection &romhashes);
 
 	// internal state
 	FILE *					m_output;
 	driver_enumerator &		m_drivlist;
 	UINT8 * 				m_device_used;
+	osd_lock *				m_device_lock;			// guards m_device_used while writing in parallel
+	FILE **					m_chunkfiles;			// temporary file for each piece
+	int						m_chunksize;			// number of drivers per piece
+	char					m_normalized[1024];		// buffer for normalize()
 
 	static const char s_dtd_string[];
 };
@@ -232,6 +232,8 @@ struct _input_port_state
 	input_port_value			digital;			/* current value from all digital inputs */
 	input_port_value			vblank;				/* value of all IPT_VBLANK bits */
 	input_port_value			outputvalue;		/* current value for outputs */
+	input_port_value			luamask;			/* digital bits forced by joypad.set */
+	input_port_value			luavalue;			/* values of the forced bits */
 };
 
 
@@ -297,10 +299,25 @@ struct _input_port_private
 	attotime current_rate;
 };
 
+struct movie_index_entry {
+	UINT32 offset;          // offset in the stream of the run starting this block
+	attotime prevtime;      // time of the frame before the block
+};
+
 struct movie_type {
 	UINT8* buffer;    // full movie input buffer
 	UINT32 size;      // movie input buffer size
 	UINT8* pointer;   // pointer to the full movie input buffer
+
+	// version 2 playback; frames are unpacked into the buffer as they are reached
+	UINT8* stream;                  // encoded frames, or NULL for version 1 files
+	UINT32 stream_size;             // size of the encoded frames
+	movie_index_entry* index;       // one entry every INP_INDEX_INTERVAL frames
+	UINT32 index_count;             // number of index entries
+	UINT32* masks;                  // bits recorded for each port
+	UINT32 interval;                // frames between index entries
+	UINT32 decoded_start;           // first frame unpacked into the buffer
+	UINT32 decoded_end;             // one past the last frame unpacked
 };
 static struct movie_type movie;
 static char scheduled_record_file[_MAX_PATH];
@@ -2586,8 +2603,6 @@ g_profiler.start(PROFILER_INPUT);
 	for (port = machine.m_portlist.first(); port != NULL; port = port->next())
 	{
 		const input_field_config *field;
-		device_field_info *device_field;
-		input_port_value newvalue;
 
 		/* start with 0 values for the digital and VBLANK bits */
 		port->state->digital = 0;
@@ -2613,10 +2628,29 @@ g_profiler.start(PROFILER_INPUT);
 		/* hook for MESS's natural keyboard support */
 		input_port_update_hook(machine, port, &port->state->digital);
 
-		/* handle playback/record */
+		/* handle playback */
 		playback_port(port);
-		CallRegisteredLuaFunctions(LUACALL_BEFOREEMULATION);
-		MAME_LuaReadJoypad();
+	}
+
+	/* let Lua see this frame's inputs and override them, once for all ports */
+	CallRegisteredLuaFunctions(LUACALL_BEFOREEMULATION);
+	MAME_LuaReadJoypad();
+
+	/* loop again to apply the overrides, record, and notify devices */
+	for (port = machine.m_portlist.first(); port != NULL; port = port->next())
+	{
+		device_field_info *device_field;
+		input_port_value newvalue;
+
+		/* apply anything joypad.set asked for; it lasts a single frame */
+		if (port->state->luamask != 0)
+		{
+			port->state->digital = (port->state->digital & ~port->state->luamask) | port->state->luavalue;
+			port->state->luamask = 0;
+			port->state->luavalue = 0;
+		}
+
+		/* handle record */
 		record_port(port);
 
 		/* call device line write handlers */
@@ -3763,6 +3797,467 @@ void movie_postload(running_machine &machine, emu_file *file)
 	movie.pointer = movie.buffer+(portdata->bytes_per_frame * portdata->current_frame);
 }
 
+
+/***************************************************************************
+    VERSION 2 MOVIE FORMAT
+
+    In memory, frames always use the fixed-size version 1 layout, so that
+    savestates and rerecording can index them directly. On disk, version
+    2 follows the header, frame count and rerecord count with:
+
+        4 bytes     frames between seek index entries
+        4 bytes     number of ports
+        4 bytes     per port, mask of the bits that are recorded
+        4 bytes     length of the encoded frames
+        n bytes     encoded frames
+        4 bytes     number of index entries
+       16 bytes     per entry, stream offset and the time of the frame
+                    before it (4 bytes seconds, 8 bytes attoseconds)
+
+    The encoded frames are runs: a varint count followed by one frame
+    that repeats count times. A frame holds the time since the previous
+    frame as two zigzag varints, then per port the default and digital
+    values packed down to the recorded bits, then per analog field the
+    accum, previous and sensitivity as zigzag varints and the reverse
+    flag as a byte. Runs never cross an index entry, so playback can
+    start decoding at any entry. All values are little-endian.
+***************************************************************************/
+
+static UINT32 movie_get_uint32(const UINT8 *src)
+{
+	return (UINT32)src[0] | ((UINT32)src[1] << 8) | ((UINT32)src[2] << 16) | ((UINT32)src[3] << 24);
+}
+
+static void movie_put_uint32(UINT8 *dest, UINT32 data)
+{
+	dest[0] = data;
+	dest[1] = data >> 8;
+	dest[2] = data >> 16;
+	dest[3] = data >> 24;
+}
+
+static UINT32 movie_fread_uint32(FILE *file)
+{
+	UINT8 buffer[4];
+	if (fread(buffer, 1, sizeof(buffer), file) != sizeof(buffer))
+		fatalerror("Input file is corrupt or invalid (truncated)");
+	return movie_get_uint32(buffer);
+}
+
+static void movie_fwrite_uint32(FILE *file, UINT32 data)
+{
+	UINT8 buffer[4];
+	movie_put_uint32(buffer, data);
+	fwrite(buffer, 1, sizeof(buffer), file);
+}
+
+static void movie_put_varint(UINT8 *&dest, UINT64 data)
+{
+	while (data >= 0x80)
+	{
+		*dest++ = (data & 0x7f) | 0x80;
+		data >>= 7;
+	}
+	*dest++ = data;
+}
+
+static UINT64 movie_get_varint(const UINT8 *&src, const UINT8 *end)
+{
+	UINT64 result = 0;
+	int shift;
+	for (shift = 0; shift < 64; shift += 7)
+	{
+		if (src >= end)
+			break;
+		UINT8 data = *src++;
+		result |= (UINT64)(data & 0x7f) << shift;
+		if (!(data & 0x80))
+			return result;
+	}
+	fatalerror("Input file is corrupt or invalid (bad frame data)");
+	return 0;
+}
+
+static UINT64 movie_zigzag(INT64 data)
+{
+	return ((UINT64)data << 1) ^ (UINT64)(data >> 63);
+}
+
+static INT64 movie_unzigzag(UINT64 data)
+{
+	return (INT64)(data >> 1) ^ -(INT64)(data & 1);
+}
+
+static UINT32 movie_pack_bits(UINT32 data, UINT32 mask)
+{
+	UINT32 result = 0, outbit = 1, bit;
+	for (bit = 1; bit != 0; bit <<= 1)
+		if (mask & bit)
+		{
+			if (data & bit)
+				result |= outbit;
+			outbit <<= 1;
+		}
+	return result;
+}
+
+static UINT32 movie_unpack_bits(UINT32 data, UINT32 mask)
+{
+	UINT32 result = 0, inbit = 1, bit;
+	for (bit = 1; bit != 0; bit <<= 1)
+		if (mask & bit)
+		{
+			if (data & inbit)
+				result |= bit;
+			inbit <<= 1;
+		}
+	return result;
+}
+
+
+/*-------------------------------------------------
+    movie_pack_frame - encode a version 1 frame,
+    returning its length and time
+-------------------------------------------------*/
+
+static UINT32 movie_pack_frame(running_machine &machine, const UINT8 *frame, const UINT32 *masks, attotime prevtime, attotime &time, UINT8 *dest)
+{
+	const input_port_config *port;
+	UINT8 *start = dest;
+	int portnum = 0;
+
+	/* time since the previous frame */
+	time.seconds = movie_get_uint32(&frame[0]);
+	time.attoseconds = ((UINT64)movie_get_uint32(&frame[8]) << 32) | movie_get_uint32(&frame[4]);
+	movie_put_varint(dest, movie_zigzag((INT64)time.seconds - (INT64)prevtime.seconds));
+	movie_put_varint(dest, movie_zigzag(time.attoseconds - prevtime.attoseconds));
+	frame += 12;
+
+	for (port = machine.m_portlist.first(); port != NULL; port = port->next(), portnum++)
+	{
+		int bytes = (popcount(masks[portnum]) + 7) / 8;
+		UINT32 defvalue = movie_pack_bits(movie_get_uint32(&frame[0]), masks[portnum]);
+		UINT32 digital = movie_pack_bits(movie_get_uint32(&frame[4]), masks[portnum]);
+		analog_field_state *analog;
+		int byte;
+
+		/* only the bits that belong to fields */
+		for (byte = 0; byte < bytes; byte++)
+			*dest++ = defvalue >> (8 * byte);
+		for (byte = 0; byte < bytes; byte++)
+			*dest++ = digital >> (8 * byte);
+		frame += 8;
+
+		for (analog = port->state->analoglist; analog != NULL; analog = analog->next)
+		{
+			movie_put_varint(dest, movie_zigzag((INT32)movie_get_uint32(&frame[0])));
+			movie_put_varint(dest, movie_zigzag((INT32)movie_get_uint32(&frame[4])));
+			movie_put_varint(dest, movie_zigzag((INT32)movie_get_uint32(&frame[8])));
+			*dest++ = frame[12];
+			frame += 13;
+		}
+	}
+	return dest - start;
+}
+
+
+/*-------------------------------------------------
+    movie_unpack_frame - decode one frame into the
+    version 1 layout; with a NULL frame, just
+    skip over it and advance the time
+-------------------------------------------------*/
+
+static void movie_unpack_frame(running_machine &machine, const UINT8 *&src, const UINT8 *end, const UINT32 *masks, attotime &time, UINT8 *frame)
+{
+	const input_port_config *port;
+	int portnum = 0;
+
+	/* time since the previous frame */
+	time.seconds += movie_unzigzag(movie_get_varint(src, end));
+	time.attoseconds += movie_unzigzag(movie_get_varint(src, end));
+	if (frame != NULL)
+	{
+		movie_put_uint32(&frame[0], time.seconds);
+		movie_put_uint32(&frame[4], time.attoseconds);
+		movie_put_uint32(&frame[8], (UINT64)time.attoseconds >> 32);
+		frame += 12;
+	}
+
+	for (port = machine.m_portlist.first(); port != NULL; port = port->next(), portnum++)
+	{
+		int bytes = (popcount(masks[portnum]) + 7) / 8;
+		UINT32 defvalue = 0, digital = 0;
+		analog_field_state *analog;
+		int byte;
+
+		if (src + 2 * bytes > end)
+			fatalerror("Input file is corrupt or invalid (bad frame data)");
+		for (byte = 0; byte < bytes; byte++)
+			defvalue |= (UINT32)*src++ << (8 * byte);
+		for (byte = 0; byte < bytes; byte++)
+			digital |= (UINT32)*src++ << (8 * byte);
+		if (frame != NULL)
+		{
+			movie_put_uint32(&frame[0], movie_unpack_bits(defvalue, masks[portnum]));
+			movie_put_uint32(&frame[4], movie_unpack_bits(digital, masks[portnum]));
+			frame += 8;
+		}
+
+		for (analog = port->state->analoglist; analog != NULL; analog = analog->next)
+		{
+			INT32 accum = movie_unzigzag(movie_get_varint(src, end));
+			INT32 previous = movie_unzigzag(movie_get_varint(src, end));
+			INT32 sensitivity = movie_unzigzag(movie_get_varint(src, end));
+			if (src >= end)
+				fatalerror("Input file is corrupt or invalid (bad frame data)");
+			UINT8 reverse = *src++;
+			if (frame != NULL)
+			{
+				movie_put_uint32(&frame[0], accum);
+				movie_put_uint32(&frame[4], previous);
+				movie_put_uint32(&frame[8], sensitivity);
+				frame[12] = reverse;
+				frame += 13;
+			}
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+    movie_write_v2 - write the frames in the movie
+    buffer to a file in the version 2 format
+-------------------------------------------------*/
+
+static void movie_write_v2(running_machine &machine, FILE *file, UINT32 frames)
+{
+	input_port_private *portdata = machine.input_port_data;
+	UINT32 bpf = portdata->bytes_per_frame;
+	UINT32 maxpacked = bpf * 3 + 32;
+	UINT32 index_count = (frames + INP_INDEX_INTERVAL - 1) / INP_INDEX_INTERVAL;
+	const input_port_config *port;
+	UINT32 portcount = 0, portnum, offset, frame, run = 0, prevlen = 0, stream_size = 0;
+	attotime prevtime = attotime::zero;
+	long sizepos, endpos;
+
+	/* the last frame has not been recorded yet; make sure it exists and is blank */
+	if (frames * bpf > (UINT32)(movie.pointer - movie.buffer))
+		reserve_movie_buffer_space(frames * bpf - (movie.pointer - movie.buffer));
+	memset(movie.buffer + (frames - 1) * bpf, 0, bpf);
+
+	/* record the bits that belong to fields, plus any others that were ever set */
+	for (port = machine.m_portlist.first(); port != NULL; port = port->next())
+		portcount++;
+	UINT32 *masks = global_alloc_array(UINT32, portcount);
+	for (port = machine.m_portlist.first(), portnum = 0, offset = 12; port != NULL; port = port->next(), portnum++)
+	{
+		const input_field_config *field;
+		analog_field_state *analog;
+
+		masks[portnum] = 0;
+		for (field = port->first_field(); field != NULL; field = field->next())
+			masks[portnum] |= field->mask;
+		for (frame = 0; frame < frames; frame++)
+		{
+			const UINT8 *data = movie.buffer + frame * bpf + offset;
+			masks[portnum] |= movie_get_uint32(&data[0]) | movie_get_uint32(&data[4]);
+		}
+
+		offset += 8;
+		for (analog = port->state->analoglist; analog != NULL; analog = analog->next)
+			offset += 13;
+	}
+
+	movie_fwrite_uint32(file, INP_INDEX_INTERVAL);
+	movie_fwrite_uint32(file, portcount);
+	for (portnum = 0; portnum < portcount; portnum++)
+		movie_fwrite_uint32(file, masks[portnum]);
+	sizepos = ftell(file);
+	movie_fwrite_uint32(file, 0);
+
+	/* encode the frames, collapsing runs of identical ones */
+	UINT8 *packed = global_alloc_array(UINT8, maxpacked);
+	UINT8 *prevpacked = global_alloc_array(UINT8, maxpacked + 10);
+	movie_index_entry *index = global_alloc_array(movie_index_entry, index_count);
+	for (frame = 0; frame <= frames; frame++)
+	{
+		attotime time;
+		UINT32 curlen = 0;
+
+		if (frame < frames)
+		{
+			curlen = movie_pack_frame(machine, movie.buffer + frame * bpf, masks, prevtime, time, packed);
+
+			/* extend the current run if nothing changed and we're not at an index entry */
+			if (run != 0 && frame % INP_INDEX_INTERVAL != 0 && curlen == prevlen && memcmp(packed, prevpacked, curlen) == 0)
+			{
+				run++;
+				prevtime = time;
+				continue;
+			}
+		}
+
+		/* write out the previous run */
+		if (run != 0)
+		{
+			UINT8 count[10], *dest = count;
+			movie_put_varint(dest, run);
+			fwrite(count, 1, dest - count, file);
+			fwrite(prevpacked, 1, prevlen, file);
+			stream_size += (dest - count) + prevlen;
+		}
+		if (frame == frames)
+			break;
+
+		/* index entries mark where decoding can start */
+		if (frame % INP_INDEX_INTERVAL == 0)
+		{
+			index[frame / INP_INDEX_INTERVAL].offset = stream_size;
+			index[frame / INP_INDEX_INTERVAL].prevtime = prevtime;
+		}
+
+		/* start a new run */
+		memcpy(prevpacked, packed, curlen);
+		prevlen = curlen;
+		run = 1;
+		prevtime = time;
+	}
+
+	/* write the index, then go back and fill in the stream length */
+	movie_fwrite_uint32(file, index_count);
+	for (UINT32 entry = 0; entry < index_count; entry++)
+	{
+		UINT8 buffer[16];
+		movie_put_uint32(&buffer[0], index[entry].offset);
+		movie_put_uint32(&buffer[4], index[entry].prevtime.seconds);
+		movie_put_uint32(&buffer[8], index[entry].prevtime.attoseconds);
+		movie_put_uint32(&buffer[12], (UINT64)index[entry].prevtime.attoseconds >> 32);
+		fwrite(buffer, 1, sizeof(buffer), file);
+	}
+	endpos = ftell(file);
+	fseek(file, sizepos, SEEK_SET);
+	movie_fwrite_uint32(file, stream_size);
+	fseek(file, endpos, SEEK_SET);
+
+	global_free(index);
+	global_free(prevpacked);
+	global_free(packed);
+	global_free(masks);
+}
+
+
+/*-------------------------------------------------
+    movie_read_v2 - read the encoded frames and
+    index of a version 2 file for playback
+-------------------------------------------------*/
+
+static void movie_read_v2(running_machine &machine, FILE *file)
+{
+	input_port_private *portdata = machine.input_port_data;
+	const input_port_config *port;
+	UINT32 portcount = 0, portnum, entry;
+
+	/* the ports must match the ones we recorded */
+	movie.interval = movie_fread_uint32(file);
+	for (port = machine.m_portlist.first(); port != NULL; port = port->next())
+		portcount++;
+	if (movie.interval == 0 || movie_fread_uint32(file) != portcount)
+		fatalerror("Input file does not match the inputs of this " GAMENOUN);
+	movie.masks = global_alloc_array(UINT32, portcount);
+	for (portnum = 0; portnum < portcount; portnum++)
+		movie.masks[portnum] = movie_fread_uint32(file);
+
+	/* read the encoded frames */
+	movie.stream_size = movie_fread_uint32(file);
+	movie.stream = global_alloc_array(UINT8, movie.stream_size + 1);
+	if (fread(movie.stream, 1, movie.stream_size, file) != movie.stream_size)
+		fatalerror("Input file is corrupt or invalid (truncated)");
+
+	/* read the index */
+	movie.index_count = movie_fread_uint32(file);
+	if (movie.index_count != (portdata->total_frames + 1 + movie.interval - 1) / movie.interval)
+		fatalerror("Input file is corrupt or invalid (bad index)");
+	movie.index = global_alloc_array(movie_index_entry, movie.index_count);
+	for (entry = 0; entry < movie.index_count; entry++)
+	{
+		UINT8 buffer[16];
+		if (fread(buffer, 1, sizeof(buffer), file) != sizeof(buffer))
+			fatalerror("Input file is corrupt or invalid (truncated)");
+		movie.index[entry].offset = movie_get_uint32(&buffer[0]);
+		movie.index[entry].prevtime.seconds = movie_get_uint32(&buffer[4]);
+		movie.index[entry].prevtime.attoseconds = ((UINT64)movie_get_uint32(&buffer[12]) << 32) | movie_get_uint32(&buffer[8]);
+		if (movie.index[entry].offset > movie.stream_size)
+			fatalerror("Input file is corrupt or invalid (bad index)");
+	}
+
+	movie.decoded_start = movie.decoded_end = 0;
+}
+
+
+/*-------------------------------------------------
+    movie_decode_frames - make sure a frame is
+    unpacked into the movie buffer; decoding
+    starts from the nearest index entry, so any
+    frame can be reached without a full scan
+-------------------------------------------------*/
+
+static void movie_decode_frames(running_machine &machine, UINT32 frame)
+{
+	input_port_private *portdata = machine.input_port_data;
+	UINT32 bpf = portdata->bytes_per_frame;
+
+	/* nothing to do for version 1 files or frames already unpacked */
+	if (movie.stream == NULL || (frame >= movie.decoded_start && frame < movie.decoded_end))
+		return;
+	UINT32 block = frame / movie.interval;
+	if (block >= movie.index_count)
+		return;
+
+	/* a jump (e.g. loading a state) starts a new range */
+	if (frame != movie.decoded_end)
+		movie.decoded_start = frame;
+
+	/* decode the rest of the block holding this frame */
+	const UINT8 *src = movie.stream + movie.index[block].offset;
+	const UINT8 *end = movie.stream + ((block + 1 < movie.index_count) ? movie.index[block + 1].offset : movie.stream_size);
+	UINT32 last = MIN((block + 1) * movie.interval, portdata->total_frames + 1);
+	attotime time = movie.index[block].prevtime;
+	UINT32 cur = block * movie.interval;
+	while (cur < last)
+	{
+		UINT64 run = movie_get_varint(src, end);
+		const UINT8 *runstart = src;
+		if (run == 0)
+			fatalerror("Input file is corrupt or invalid (bad frame data)");
+		for ( ; run > 0 && cur < last; run--, cur++)
+		{
+			src = runstart;
+			movie_unpack_frame(machine, src, end, movie.masks, time, (cur >= frame) ? movie.buffer + cur * bpf : NULL);
+		}
+	}
+	movie.decoded_end = last;
+}
+
+
+/*-------------------------------------------------
+    movie_free_v2 - release version 2 playback
+    data
+-------------------------------------------------*/
+
+static void movie_free_v2()
+{
+	if (movie.stream != NULL)
+		global_free(movie.stream);
+	if (movie.index != NULL)
+		global_free(movie.index);
+	if (movie.masks != NULL)
+		global_free(movie.masks);
+	movie.stream = NULL;
+	movie.index = NULL;
+	movie.masks = NULL;
+	movie.stream_size = movie.index_count = 0;
+}
+
 /*-------------------------------------------------
     playback_read_uint8 - read an 8-bit value
     from the playback file
@@ -3829,7 +4324,7 @@ static void playback_open_file(running_machine &machine,const char* filename)
 		fatalerror("Input file is corrupt or invalid (missing header)");
 	if (memcmp(portdata->movie_header, "MAMETAS\0", 8) != 0)
 		fatalerror("Input file invalid or in an older, unsupported format");
-	if (portdata->movie_header[0x08] != INP_HEADER_MAJVERSION)
+	if (portdata->movie_header[0x08] != INP_HEADER_MAJVERSION && portdata->movie_header[0x08] != INP_HEADER_V1VERSION)
 		fatalerror("Input file format version mismatch");
 
 	// read movie lenght and rerecord count
@@ -3851,10 +4346,13 @@ static void playback_open_file(running_machine &machine,const char* filename)
 	movie.pointer = movie.buffer;
 	movie.size = 0;
 
-	// fill buffer
+	// fill buffer; version 2 frames are unpacked as playback reaches them
 	bytes_to_read = portdata->bytes_per_frame*(portdata->total_frames+1);
 	reserve_movie_buffer_space(bytes_to_read);
-	fread(movie.buffer, 1, bytes_to_read, portdata->playback_file);
+	if (portdata->movie_header[0x08] == INP_HEADER_V1VERSION)
+		fread(movie.buffer, 1, bytes_to_read, portdata->playback_file);
+	else
+		movie_read_v2(machine, portdata->playback_file);
 }
 
 
@@ -3894,6 +4392,7 @@ static void playback_end(running_machine &machine, const char *message)
 		/* close the file */
 		fclose(portdata->playback_file);
 		portdata->playback_file = NULL;
+		movie_free_v2();
 
 		/* pop a message */
 		if (message != NULL)
@@ -3916,6 +4415,9 @@ static void playback_frame(running_machine &machine, attotime curtime)
 	{
 		attotime readtime;
 
+		/* make sure this frame has been unpacked */
+		movie_decode_frames(machine, portdata->current_frame);
+
 		/* just the absolute time */
 		readtime.seconds = playback_read_uint32();
 		readtime.attoseconds = playback_read_uint64();
@@ -4077,7 +4579,7 @@ static void record_end(running_machine &machine, const char *message)
 		fwrite(portdata->movie_header, 1, sizeof(portdata->movie_header), portdata->record_file);
 		fwrite(&portdata->current_frame, 1, sizeof(portdata->current_frame), portdata->record_file);
 		fwrite(&portdata->rerecord_count, 1, sizeof(portdata->rerecord_count), portdata->record_file);
-		fwrite(movie.buffer, 1, portdata->bytes_per_frame*(portdata->current_frame+1), portdata->record_file);
+		movie_write_v2(machine, portdata->record_file, portdata->current_frame+1);
 
 		/* close the file */
 		fclose(portdata->record_file);
@@ -5112,6 +5614,12 @@ void set_port_digital(input_port_config &port, UINT32 new_digital)
 	port.state->digital = new_digital;
 }
 
+void set_port_override(input_port_config &port, UINT32 mask, UINT32 value)
+{
+	port.state->luamask = mask;
+	port.state->luavalue = value & mask;
+}
+
 void schedule_record(char * choice) {
 	strcpy(scheduled_record_file, choice);
 }
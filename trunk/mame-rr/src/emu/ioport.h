@@ -45,8 +45,10 @@
 
 /* INP file information */
 #define INP_HEADER_SIZE			56
-#define INP_HEADER_MAJVERSION	1
+#define INP_HEADER_MAJVERSION	2		/* bit-packed, run-length encoded frames with a seek index */
 #define INP_HEADER_MINVERSION	0
+#define INP_HEADER_V1VERSION	1		/* fixed-size frames; still played back */
+#define INP_INDEX_INTERVAL		600		/* frames between seek index entries */
 
 
 /* sequence types for input_port_seq() call */
@@ -1468,6 +1470,7 @@ FILE* get_playback_file(running_machine &machine);
 UINT32 get_current_frame(running_machine &machine);
 UINT32 get_port_digital(input_port_config &port);
 void set_port_digital(input_port_config &port, UINT32 new_digital);
+void set_port_override(input_port_config &port, UINT32 mask, UINT32 value);
 void movie_postsave(running_machine &machine, emu_file *file);
 void movie_postload(running_machine &machine, emu_file *file);
 void schedule_record(char *choice);
@@ -91,8 +91,7 @@ static int frameAdvanceWaiting = FALSE;
 // Transparency strength. 255=opaque, 0=so transparent it's invisible
 static int transparencyModifier = 255;
 
-// Our joypads.
-static short lua_joypads[0x0100];
+// Our joypads; the buttons themselves are held by the input ports.
 static UINT8 lua_joypads_used;
 
 static UINT8 gui_enabled = TRUE;
@@ -1006,21 +1005,19 @@ static int joypad_getup(lua_State *L)
 //   frame advance. The table should have the right 
 //   keys (no pun intended) set.
 static int joypad_set(lua_State *L) {
-	unsigned int i = 0;
-
 	// table of buttons.
 	luaL_checktype(L,1,LUA_TTABLE);
 
 	// Set up for taking control of the indicated controller
 	lua_joypads_used = 1;
-	memset(lua_joypads,0,0x0100);
 
 	// Update the values of all the inputs
 	input_field_config *field;
 	input_port_config *port;
 
-	// iterate over the input ports and add menu items
-	for (port = machine->m_portlist.first(); port != NULL; port = port->next())
+	// build one mask/value pair per port; the next frame update applies them
+	for (port = machine->m_portlist.first(); port != NULL; port = port->next()) {
+		UINT32 mask = 0, value = 0;
 		for (field = port->fieldlist().first(); field != NULL; field = field->next()) {
 			const char *name = input_field_name(field);
 
@@ -1032,16 +1029,15 @@ static int joypad_set(lua_State *L) {
 				((field->type == IPT_OTHER && field->name != NULL) || input_type_group(*machine, field->type, field->player) != IPG_INVALID)) {
 					lua_getfield(L, 1, name);
 					if (!lua_isnil(L,-1)) {
+						mask |= field->mask;
 						if (lua_toboolean(L,-1))
-							lua_joypads[i] = 1; // pressed
-						else
-							lua_joypads[i] = 2; // unpressed
-//						mame_printf_info("*JOYPAD*: '%s' : %d\n",name,lua_joypads[i]);
+							value |= field->mask; // pressed
 					}
 					lua_pop(L,1);
-					i++;
 			}
 		}
+		set_port_override(*port, mask, value);
+	}
 
 	return 0;
 }
@@ -3665,46 +3661,18 @@ int MAME_LuaUsingJoypad() {
 
 
 /**
- * Reads the buttons Lua is feeding for the given joypad, in the same
- * format as the OS-specific code.
+ * Marks the buttons set by joypad.set as consumed. The buttons themselves
+ * were handed to the input ports, which apply them in their next update.
  *
- * This function must not be called more than once per frame. Ideally exactly once
- * per frame (if MAME_LuaUsingJoypad says it's safe to do so)
+ * This function must be called exactly once per frame, after the
+ * before-emulation callbacks.
  */
 UINT32 MAME_LuaReadJoypad() {
 	if (!MAME_LuaRunning())
 		return 1;
 
 	if (lua_joypads_used) {
-		// Update the values of all the inputs
-		unsigned int i = 0;
-	input_field_config *field;
-	input_port_config *port;
-
-	// iterate over the input ports and add menu items
-		for (port = machine->m_portlist.first(); port != NULL; port = port->next())
-			for (field = port->fieldlist().first(); field != NULL; field = field->next()) {
-				const char *name = input_field_name(field);
-	
-				// add if we match the group and we have a valid name
-				if (name != NULL && input_condition_true(*machine, &field->condition, port->owner()) &&
-	#ifdef MESS
-					(field->category == 0 || input_category_active(*machine, field->category)) &&
-	#endif // MESS
-					((field->type == IPT_OTHER && field->name != NULL) || input_type_group(*machine, field->type, field->player) != IPG_INVALID)) {
-						if(lua_joypads[i] == 1) {
-							set_port_digital(*port, get_port_digital(*port) | field->mask);
-						}
-						if(lua_joypads[i] == 2) {
-							set_port_digital(*port, get_port_digital(*port) & (~field->mask));
-						}
-//						mame_printf_info("*READ_JOY*: '%s' %d (%X:%X:%X:%X)\n",name,lua_joypads[i],caca,field->mask,(caca ^ field->mask),(caca & field->mask));
-						i++;
-				}
-			}
-
 		lua_joypads_used = 0;
-		memset(lua_joypads,0,0x0100);
 		return 0;
 	}
 	else
@@ -654,6 +654,23 @@ memory_region *running_machine::region_alloc(const char *name, UINT32 length, UI
 }
 
 
+//-------------------------------------------------
+//  region_map - creates a region backed by a
+//  file mapping, which it takes ownership of
+//-------------------------------------------------
+
+memory_region *running_machine::region_map(const char *name, UINT32 length, UINT8 width, endianness_t endian, void *base, osd_mapping *mapping)
+{
+    // make sure we don't have a region of the same name
+    memory_region *info = m_regionlist.find(name);
+    if (info != NULL)
+		fatalerror("region_map called with duplicate region name \"%s\"\n", name);
+
+	// wrap the mapping in a region
+	return &m_regionlist.append(name, *auto_alloc(*this, memory_region(*this, name, length, width, endian, base, mapping)));
+}
+
+
 //-------------------------------------------------
 //  region_free - releases memory for a region
 //-------------------------------------------------
@@ -917,16 +934,17 @@ void running_machine::logfile_callback(running_machine &machine, const char *buf
 //  memory_region - constructor
 //-------------------------------------------------
 
-memory_region::memory_region(running_machine &machine, const char *name, UINT32 length, UINT8 width, endianness_t endian)
+memory_region::memory_region(running_machine &machine, const char *name, UINT32 length, UINT8 width, endianness_t endian, void *base, osd_mapping *mapping)
 	: m_machine(machine),
 	  m_next(NULL),
 	  m_name(name),
+	  m_mapping(mapping),
 	  m_length(length),
 	  m_width(width),
 	  m_endianness(endian)
 {
 	assert(width == 1 || width == 2 || width == 4 || width == 8);
-	m_base.u8 = auto_alloc_array(machine, UINT8, length);
+	m_base.v = (mapping != NULL) ? base : auto_alloc_array(machine, UINT8, length);
 }
 
 
@@ -936,7 +954,10 @@ memory_region::memory_region(running_machine &machine, const char *name, UINT32
 
 memory_region::~memory_region()
 {
-	auto_free(machine(), m_base.v);
+	if (m_mapping != NULL)
+		osd_unmap(m_mapping);
+	else
+		auto_free(machine(), m_base.v);
 }
 
 
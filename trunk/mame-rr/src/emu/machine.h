@@ -209,7 +209,7 @@ class memory_region
 	friend resource_pool_object<memory_region>::~resource_pool_object();
 
 	// construction/destruction
-	memory_region(running_machine &machine, const char *name, UINT32 length, UINT8 width, endianness_t endian);
+	memory_region(running_machine &machine, const char *name, UINT32 length, UINT8 width, endianness_t endian, void *base = NULL, osd_mapping *mapping = NULL);
 	~memory_region();
 
 public:
@@ -248,6 +248,7 @@ private:
 	memory_region *			m_next;
 	astring					m_name;
 	generic_ptr				m_base;
+	osd_mapping *			m_mapping;				// file mapping backing the data, if any
 	UINT32					m_length;
 	UINT8					m_width;
 	endianness_t			m_endianness;
@@ -392,6 +393,7 @@ public:
 
 	// regions
 	memory_region *region_alloc(const char *name, UINT32 length, UINT8 width, endianness_t endian);
+	memory_region *region_map(const char *name, UINT32 length, UINT8 width, endianness_t endian, void *base, osd_mapping *mapping);
 	void region_free(const char *name);
 
 	// misc
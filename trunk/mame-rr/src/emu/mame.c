@@ -86,6 +86,7 @@
 #include "uiinput.h"
 #include "crsshair.h"
 #include "validity.h"
+#include "unzip.h"
 #include "debug/debugcon.h"
 
 #include <time.h>
@@ -162,6 +163,7 @@ int mame_execute(emu_options &options, osd_interface &osd)
 			astring errors;
 			options.parse_standard_inis(errors);
 		}
+		zip_file_cache_configure(options.zip_cache(), options.zip_mmap());
 
 		// create the machine configuration
 		machine_config config(*system, options);
@@ -112,6 +112,7 @@ typedef void (*output_callback_func)(void *param, const char *format, va_list ar
 //**************************************************************************
 
 extern const char build_version[];
+extern const char build_id[];
 
 
 
@@ -0,0 +1,279 @@
+/***************************************************************************
+
+    romcache.c
+
+    Persistent cache of data derived from ROMs at startup.
+
+    Copyright Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    Each entry is a file <kind>/<sha1>.bin in the cache directory, where
+    sha1 covers the kind and all of the inputs. The file starts with a
+    header:
+
+        8 bytes     signature ("MAMEXFR" plus a version byte)
+        4 bytes     length of the data, little-endian
+
+    zero padded to ROM_CACHE_DATA_OFFSET and followed by the data exactly
+    as it was handed to save(). The padding keeps mapped data page
+    aligned, so it can stand in for a region.
+
+***************************************************************************/
+
+#include "emu.h"
+#include "emuopts.h"
+#include "romcache.h"
+
+
+
+//**************************************************************************
+//  CONSTANTS
+//**************************************************************************
+
+static const UINT8 ROM_CACHE_SIGNATURE[8] = { 'M', 'A', 'M', 'E', 'X', 'F', 'R', 2 };
+static const int ROM_CACHE_HEADER_SIZE = 12;
+static const int ROM_CACHE_DATA_OFFSET = 4096;
+
+
+
+//**************************************************************************
+//  TYPE DEFINITIONS
+//**************************************************************************
+
+// ======================> rom_cache_mapping
+
+// owns a mapped cache entry for the lifetime of the machine
+class rom_cache_mapping
+{
+public:
+	rom_cache_mapping(osd_mapping *mapping)
+		: m_mapping(mapping) { }
+	~rom_cache_mapping() { osd_unmap(m_mapping); }
+
+private:
+	osd_mapping *		m_mapping;
+};
+
+
+
+//**************************************************************************
+//  ROM TRANSFORM CACHE
+//**************************************************************************
+
+//-------------------------------------------------
+//  rom_transform_cache - constructor
+//-------------------------------------------------
+
+rom_transform_cache::rom_transform_cache(running_machine &machine, const char *kind)
+	: m_machine(machine),
+	  m_kind(kind),
+	  m_enabled(machine.options().rom_cache())
+{
+	static const char types[] = { hash_collection::HASH_SHA1, 0 };
+	m_hashes.begin(types);
+	m_hashes.buffer((const UINT8 *)kind, strlen(kind) + 1);
+}
+
+
+//-------------------------------------------------
+//  add_input - feed a block of input data into
+//  the key
+//-------------------------------------------------
+
+void rom_transform_cache::add_input(const void *data, UINT32 length)
+{
+	assert(m_filename.len() == 0);
+	if (m_enabled)
+		m_hashes.buffer((const UINT8 *)data, length);
+}
+
+
+//-------------------------------------------------
+//  add_input - feed a single value into the key,
+//  in a byte order independent of the host
+//-------------------------------------------------
+
+void rom_transform_cache::add_input(UINT32 value)
+{
+	UINT8 bytes[4] = { value, value >> 8, value >> 16, value >> 24 };
+	add_input(bytes, sizeof(bytes));
+}
+
+
+//-------------------------------------------------
+//  load - read the output of an earlier session,
+//  returning false if there is none
+//-------------------------------------------------
+
+bool rom_transform_cache::load(void *dest, UINT32 length)
+{
+	if (!m_enabled)
+		return false;
+
+	emu_file file(m_machine.options().cache_directory(), OPEN_FLAG_READ);
+	if (file.open(filename()) != FILERR_NONE)
+		return false;
+	if (!read_header(file, length) || file.seek(ROM_CACHE_DATA_OFFSET, SEEK_SET) != 0 || file.read(dest, length) != length)
+		return false;
+
+	mame_printf_verbose("Loaded %s data from cache %s\n", m_kind.cstr(), file.fullpath());
+	return true;
+}
+
+
+//-------------------------------------------------
+//  save - store the output for later sessions
+//-------------------------------------------------
+
+void rom_transform_cache::save(const void *src, UINT32 length)
+{
+	if (!m_enabled)
+		return;
+
+	rom_cache_remove(m_machine.options(), filename());
+	emu_file file(m_machine.options().cache_directory(), OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS);
+	if (file.open(filename()) != FILERR_NONE)
+		return;
+
+	UINT8 header[ROM_CACHE_DATA_OFFSET] = { 0 };
+	memcpy(header, ROM_CACHE_SIGNATURE, sizeof(ROM_CACHE_SIGNATURE));
+	header[8] = length;
+	header[9] = length >> 8;
+	header[10] = length >> 16;
+	header[11] = length >> 24;
+
+	// a short write leaves a file that load() will reject
+	if (file.write(header, sizeof(header)) == sizeof(header))
+		file.write(src, length);
+}
+
+
+//-------------------------------------------------
+//  map - map the output of an earlier session so
+//  that every instance using it shares one copy
+//  until it writes to it
+//-------------------------------------------------
+
+void *rom_transform_cache::map(UINT32 length)
+{
+	void *base;
+	osd_mapping *mapping;
+	if (!map_output(length, &base, &mapping))
+		return NULL;
+
+	// the mapping outlives the file and is released with the machine
+	auto_alloc(m_machine, rom_cache_mapping(mapping));
+	return base;
+}
+
+
+//-------------------------------------------------
+//  map_region - replace a region with a mapping
+//  of the output of an earlier session, so that
+//  every instance shares the transformed data
+//  instead of each writing its own copy
+//-------------------------------------------------
+
+bool rom_transform_cache::map_region(const char *tag)
+{
+	const memory_region *region = m_machine.region(tag);
+	if (region == NULL)
+		return false;
+
+	void *base;
+	osd_mapping *mapping;
+	if (!map_output(region->bytes(), &base, &mapping))
+		return false;
+
+	// the new region owns the mapping
+	UINT32 length = region->bytes();
+	UINT8 width = region->width();
+	endianness_t endianness = region->endianness();
+	m_machine.region_free(tag);
+	m_machine.region_map(tag, length, width, endianness, base, mapping);
+	return true;
+}
+
+
+//-------------------------------------------------
+//  read_header - check that an open cache entry
+//  holds exactly the expected amount of data;
+//  anything else is ignored and later replaced
+//-------------------------------------------------
+
+bool rom_transform_cache::read_header(emu_file &file, UINT32 length)
+{
+	UINT8 header[ROM_CACHE_HEADER_SIZE];
+	if (file.size() != ROM_CACHE_DATA_OFFSET + length || file.read(header, sizeof(header)) != sizeof(header))
+		return false;
+	if (memcmp(header, ROM_CACHE_SIGNATURE, sizeof(ROM_CACHE_SIGNATURE)) != 0)
+		return false;
+	return ((header[8] | (header[9] << 8) | (header[10] << 16) | (header[11] << 24)) == length);
+}
+
+
+//-------------------------------------------------
+//  map_output - map the output of an earlier
+//  session copy-on-write, if sharing is enabled
+//-------------------------------------------------
+
+bool rom_transform_cache::map_output(UINT32 length, void **base, osd_mapping **mapping)
+{
+	if (!m_enabled || !m_machine.options().share_roms())
+		return false;
+
+	emu_file file(m_machine.options().cache_directory(), OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
+	if (file.open(filename()) != FILERR_NONE)
+		return false;
+	if (!read_header(file, length))
+		return false;
+	if (file.map(ROM_CACHE_DATA_OFFSET, length, MAP_FLAG_COPY_ON_WRITE, base, mapping) != FILERR_NONE)
+		return false;
+
+	mame_printf_verbose("Mapped %s data from cache %s\n", m_kind.cstr(), file.fullpath());
+	return true;
+}
+
+
+//-------------------------------------------------
+//  filename - finish the key and return the name
+//  of the cache entry
+//-------------------------------------------------
+
+const char *rom_transform_cache::filename()
+{
+	if (m_filename.len() == 0)
+	{
+		astring sha1;
+		m_hashes.end();
+		m_hashes.hash(hash_collection::HASH_SHA1)->string(sha1);
+		m_filename.printf("%s" PATH_SEPARATOR "%s.bin", m_kind.cstr(), sha1.cstr());
+	}
+	return m_filename;
+}
+
+
+
+//**************************************************************************
+//  CACHE FILES
+//**************************************************************************
+
+//-------------------------------------------------
+//  rom_cache_remove - delete a file in the cache
+//  directory before it is rewritten
+//-------------------------------------------------
+
+void rom_cache_remove(emu_options &options, const char *filename)
+{
+	// rewriting in place would truncate the file under anyone mapping it;
+	// a fresh file leaves their copy intact
+	emu_file file(options.cache_directory(), OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
+	if (file.open(filename) == FILERR_NONE)
+	{
+		astring fullpath(file.fullpath());
+		file.close();
+		osd_rmfile(fullpath);
+	}
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+
+    romcache.h
+
+    Persistent cache of data derived from ROMs at startup.
+
+    Copyright Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+***************************************************************************/
+
+#pragma once
+
+#ifndef __ROMCACHE_H__
+#define __ROMCACHE_H__
+
+#include "hash.h"
+
+
+//**************************************************************************
+//  TYPE DEFINITIONS
+//**************************************************************************
+
+// forward references
+class emu_options;
+
+
+// ======================> rom_transform_cache
+
+// stores the output of an expensive, deterministic transform of ROM data
+// (decryption, reformatting) in the cache directory; the entry is named by
+// the SHA-1 of everything fed to add_input(), so any change to the ROMs or
+// keys simply selects a different file
+class rom_transform_cache
+{
+public:
+	// construction/destruction
+	rom_transform_cache(running_machine &machine, const char *kind);
+
+	// describe the inputs; must all be added before load() or save()
+	void add_input(const void *data, UINT32 length);
+	void add_input(UINT32 value);
+
+	// fetch or store the output; load() returns false if not cached
+	bool load(void *dest, UINT32 length);
+	void save(const void *src, UINT32 length);
+
+	// map the output copy-on-write for the life of the machine, if sharing
+	// is enabled; returns NULL if not cached or not shared
+	void *map(UINT32 length);
+
+	// replace a region with a copy-on-write mapping of the output, which
+	// must be the region's new contents; returns false if not cached or
+	// not shared, leaving the region alone
+	bool map_region(const char *tag);
+
+private:
+	// internal helpers
+	const char *filename();
+	bool read_header(emu_file &file, UINT32 length);
+	bool map_output(UINT32 length, void **base, osd_mapping **mapping);
+
+	// internal state
+	running_machine &	m_machine;
+	astring				m_kind;					// name of the transform, used as a subdirectory
+	bool				m_enabled;				// is the cache enabled?
+	hash_collection		m_hashes;				// SHA-1 of the inputs
+	astring				m_filename;				// name of the entry, once the inputs are complete
+};
+
+
+
+//**************************************************************************
+//  FUNCTION PROTOTYPES
+//**************************************************************************
+
+// delete a file in the cache directory before rewriting it, so that other
+// processes mapping the old file keep a valid copy
+void rom_cache_remove(emu_options &options, const char *filename);
+
+
+#endif	/* __ROMCACHE_H__ */
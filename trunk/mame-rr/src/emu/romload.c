@@ -12,6 +12,8 @@
 #include "emu.h"
 #include "emuopts.h"
 #include "hash.h"
+#include "hashcache.h"
+#include "romcache.h"
 #include "png.h"
 #include "harddisk.h"
 #include "config.h"
@@ -28,6 +30,16 @@
 
 #define TEMPBUFFER_MAX_SIZE		(1024 * 1024 * 1024)
 
+/* limits on how much loading can be in flight at once */
+#define LOADBATCH_MAX_FILES		(32)
+#define LOADBATCH_MAX_SIZE		(64 * 1024 * 1024)
+
+/* signature at the start of a warm boot image */
+static const UINT8 WARMBOOT_SIGNATURE[8] = { 'M', 'A', 'M', 'E', 'W', 'B', 'I', 4 };
+
+/* alignment of each region's data in a warm boot image */
+#define WARMBOOT_DATA_ALIGN		(4096)
+
 
 
 /***************************************************************************
@@ -47,6 +59,45 @@ struct _open_chd
 
 
 typedef struct _romload_private rom_load_data;
+
+
+/* a file we loaded ROMs from, remembered for the warm boot image */
+typedef struct _rom_source_file rom_source_file;
+struct _rom_source_file
+{
+	rom_source_file *	next;					/* next file in the list */
+	astring				path;					/* path of the file, or the ZIP containing it */
+};
+
+
+/* a single ROM_LOAD/ROM_CONTINUE/ROM_RELOAD entry with its flags resolved */
+typedef struct _rom_load_piece rom_load_piece;
+struct _rom_load_piece
+{
+	rom_entry			entry;					/* entry with inherited flags applied */
+	bool				reseek;					/* seek back to the start before reading */
+};
+
+
+/* all the reading for one file, which can be done on a worker thread */
+typedef struct _rom_load_job rom_load_job;
+struct _rom_load_job
+{
+	rom_load_job *		next;					/* next job in the batch */
+	rom_load_data *		romdata;				/* pointer back to the load data */
+	const rom_entry *	parent_region;			/* region entry we are loading into */
+	memory_region *		region;					/* region we are loading into */
+	const rom_entry *	baserom;				/* entry that opened the file */
+	emu_file *			file;					/* file to read, or NULL if missing */
+	bool				missing;				/* true if we need to report the file missing */
+	UINT32				explength;				/* expected length of the file */
+	astring				hashtypes;				/* hashes we need to compute */
+	rom_load_piece *	piece;					/* array of entries to read */
+	int					pieces;					/* number of entries */
+	osd_work_item *		item;					/* work item, if queued */
+};
+
+
 struct _romload_private
 {
 	running_machine &machine() const { assert(m_machine != NULL); return *m_machine; }
@@ -70,6 +121,14 @@ struct _romload_private
 
 	memory_region *	region;				/* info about current region */
 
+	osd_work_queue *queue;				/* queue for reading, inflating and hashing */
+	rom_load_job *	batch;				/* jobs in flight, in ROM order */
+	rom_load_job **	batch_tailptr;
+	int				batchfiles;			/* number of jobs in flight */
+	UINT32			batchsize;			/* total size of the files in flight */
+	file_hash_cache *hashcache;			/* hashes of files verified in earlier sessions */
+	rom_source_file *sourcefiles;		/* files we loaded from, for the warm boot image */
+
 	astring			errorstring;		/* error string */
 };
 
@@ -79,6 +138,7 @@ struct _romload_private
 ***************************************************************************/
 
 static void rom_exit(running_machine &machine);
+static file_error find_rom_file(running_machine &machine, const char *regiontag, const rom_entry *romp, emu_file **file);
 
 /***************************************************************************
     HELPERS (also used by devimage.c)
@@ -102,9 +162,9 @@ file_error common_process_file(emu_options &options, const char *location, const
 	return filerr;
 }
 
-file_error common_process_file(emu_options &options, const char *location, bool has_crc, UINT32 crc, const rom_entry *romp, emu_file **image_file)
+file_error common_process_file(emu_options &options, const char *location, bool has_crc, UINT32 crc, const rom_entry *romp, emu_file **image_file, UINT32 openflags)
 {
-	*image_file = global_alloc(emu_file(options.media_path(), OPEN_FLAG_READ));
+	*image_file = global_alloc(emu_file(options.media_path(), openflags));
 	file_error filerr;
 
 	if (has_crc)
@@ -176,6 +236,439 @@ void set_disk_handle(running_machine &machine, const char *region, emu_file &fil
 
 
 
+/***************************************************************************
+    WARM BOOT IMAGES
+****************************************************************************
+
+    A warm boot image holds the contents of every ROM region as it
+    stood after loading, so that later boots of the same game can skip
+    opening, reading and verifying the ROM files. It lives in the cache
+    directory as warmboot/<system>.img and contains:
+
+        8 bytes     signature ("MAMEWBI" plus a version byte)
+        string      name of the system
+        UINT32      index of the system BIOS
+        string      build_version of the emulator that wrote it
+        string      build_id of the emulator that wrote it
+        string      SHA-1 of the ROM entries of every source
+        string      SHA-1 of the path each ROM was found at (and its
+                    CRC, for ROMs in a ZIP)
+        UINT32      number of source files, then for each one:
+                      string    path of the file or ZIP
+                      UINT64    size of the file
+                      UINT64    modification time of the file
+        UINT32      number of regions, then for each one:
+                      string    tag of the region
+                      UINT32    length of the region
+                      UINT64    offset of the region's data in the image
+        the data of each region, in the same order, each starting at
+        the next multiple of WARMBOOT_DATA_ALIGN bytes (zero padded)
+
+    Strings are a UINT32 length followed by the characters, and all
+    values are little-endian. The image is only used if it was written
+    by this very build, the ROM entries are unchanged, searching the
+    current media path still finds every ROM in the same place, every
+    source file still has the recorded size and modification time and
+    the regions match those the system asks for.
+
+    With -share_roms the regions are mapped from the image copy-on-write
+    instead of read, so every instance running the same game shares one
+    copy of each region in the page cache until it writes to it; the
+    padding keeps each mapped region page aligned, as the memory system
+    and the CPU cores expect of region data.
+
+***************************************************************************/
+
+/*-------------------------------------------------
+    note_source_file - remember a file we loaded
+    ROMs from
+-------------------------------------------------*/
+
+static void note_source_file(rom_load_data *romdata, const char *path)
+{
+	rom_source_file **fileptr;
+
+	for (fileptr = &romdata->sourcefiles; *fileptr != NULL; fileptr = &(*fileptr)->next)
+		if ((*fileptr)->path == path)
+			return;
+
+	*fileptr = auto_alloc(romdata->machine(), rom_source_file);
+	(*fileptr)->next = NULL;
+	(*fileptr)->path.cpy(path);
+}
+
+
+/*-------------------------------------------------
+    warmboot_write_* - write values to a warm
+    boot image
+-------------------------------------------------*/
+
+static void warmboot_write_u32(emu_file &file, UINT32 value)
+{
+	UINT8 bytes[4] = { value, value >> 8, value >> 16, value >> 24 };
+	file.write(bytes, sizeof(bytes));
+}
+
+static void warmboot_write_u64(emu_file &file, UINT64 value)
+{
+	warmboot_write_u32(file, value);
+	warmboot_write_u32(file, value >> 32);
+}
+
+static void warmboot_write_string(emu_file &file, const char *string)
+{
+	UINT32 length = strlen(string);
+	warmboot_write_u32(file, length);
+	file.write(string, length);
+}
+
+
+/*-------------------------------------------------
+    warmboot_read_* - read values from a warm
+    boot image, returning false if the file is
+    truncated
+-------------------------------------------------*/
+
+static bool warmboot_read_u32(emu_file &file, UINT32 &value)
+{
+	UINT8 bytes[4];
+	if (file.read(bytes, sizeof(bytes)) != sizeof(bytes))
+		return false;
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+	return true;
+}
+
+static bool warmboot_read_u64(emu_file &file, UINT64 &value)
+{
+	UINT32 lo, hi;
+	if (!warmboot_read_u32(file, lo) || !warmboot_read_u32(file, hi))
+		return false;
+	value = ((UINT64)hi << 32) | lo;
+	return true;
+}
+
+static bool warmboot_read_string(emu_file &file, astring &string)
+{
+	char buffer[1024];
+	UINT32 length;
+	if (!warmboot_read_u32(file, length) || length >= sizeof(buffer) || file.read(buffer, length) != length)
+		return false;
+	buffer[length] = 0;
+	string.cpy(buffer);
+	return true;
+}
+
+
+/*-------------------------------------------------
+    warmboot_align - round an offset in a warm
+    boot image up to where region data may start
+-------------------------------------------------*/
+
+static UINT64 warmboot_align(UINT64 offset)
+{
+	return (offset + WARMBOOT_DATA_ALIGN - 1) & ~(UINT64)(WARMBOOT_DATA_ALIGN - 1);
+}
+
+
+/*-------------------------------------------------
+    warmboot_rom_digest - compute the SHA-1 of the
+    ROM entries of every source, so that changing
+    how a system loads its ROMs invalidates the
+    image
+-------------------------------------------------*/
+
+static void warmboot_rom_digest(running_machine &machine, astring &digest)
+{
+	static const char types[] = { hash_collection::HASH_SHA1, 0 };
+	hash_collection hashes;
+	const rom_source *source;
+
+	hashes.begin(types);
+	for (source = rom_first_source(machine.config()); source != NULL; source = rom_next_source(*source))
+	{
+		const rom_entry *romp = rom_first_region(*source);
+		if (romp == NULL)
+			continue;
+
+		for ( ; !ROMENTRY_ISEND(romp); romp++)
+		{
+			/* FILL and COPY keep a number in the hash data field */
+			bool numeric = (ROMENTRY_ISFILL(romp) || ROMENTRY_ISCOPY(romp));
+			UINT32 values[4] = { romp->_offset, romp->_length, romp->_flags, numeric ? (UINT32)(FPTR)romp->_hashdata : 0 };
+			const char *name = (romp->_name != NULL) ? romp->_name : "";
+			const char *hashdata = (!numeric && romp->_hashdata != NULL) ? romp->_hashdata : "";
+			UINT8 bytes[16];
+
+			for (int index = 0; index < ARRAY_LENGTH(bytes); index++)
+				bytes[index] = values[index / 4] >> (8 * (index % 4));
+			hashes.buffer(bytes, sizeof(bytes));
+			hashes.buffer((const UINT8 *)name, strlen(name) + 1);
+			hashes.buffer((const UINT8 *)hashdata, strlen(hashdata) + 1);
+		}
+	}
+	hashes.end();
+	hashes.hash(hash_collection::HASH_SHA1)->string(digest);
+}
+
+
+/*-------------------------------------------------
+    warmboot_rom_locations - search for every ROM
+    the system loads and compute the SHA-1 of the
+    paths they were found at, so that a different
+    media path or a file that now wins the search
+    invalidates the image
+-------------------------------------------------*/
+
+static void warmboot_rom_locations(rom_load_data *romdata, astring &digest)
+{
+	static const char types[] = { hash_collection::HASH_SHA1, 0 };
+	running_machine &machine = romdata->machine();
+	hash_collection hashes;
+	const rom_source *source;
+	const rom_entry *region, *romp;
+
+	hashes.begin(types);
+	for (source = rom_first_source(machine.config()); source != NULL; source = rom_next_source(*source))
+		for (region = rom_first_region(*source); region != NULL; region = rom_next_region(region))
+			if (ROMREGION_ISROMDATA(region))
+				for (romp = region + 1; !ROMENTRY_ISREGIONEND(romp); romp++)
+				{
+					/* only the files process_rom_entries would open */
+					if (!ROMENTRY_ISFILE(romp) || (ROM_GETBIOSFLAGS(romp) != 0 && ROM_GETBIOSFLAGS(romp) != romdata->system_bios))
+						continue;
+
+					/* ZIP members also contribute their CRC, which the directory gives us for free */
+					emu_file *file;
+					find_rom_file(machine, source->shortname(), romp, &file);
+					const char *path = (file != NULL) ? file->archive_path() : "";
+					hashes.buffer((const UINT8 *)path, strlen(path) + 1);
+					if (file != NULL)
+					{
+						UINT32 crc;
+						if (file->archive_crc(crc))
+						{
+							UINT8 bytes[4] = { (UINT8)crc, (UINT8)(crc >> 8), (UINT8)(crc >> 16), (UINT8)(crc >> 24) };
+							hashes.buffer(bytes, sizeof(bytes));
+						}
+						global_free(file);
+					}
+				}
+	hashes.end();
+	hashes.hash(hash_collection::HASH_SHA1)->string(digest);
+}
+
+
+/*-------------------------------------------------
+    open_warmboot_image - open the warm boot image
+    for this system and check that it is still
+    current; on success the file is positioned
+    at the end of the region table
+-------------------------------------------------*/
+
+static bool open_warmboot_image(rom_load_data *romdata, emu_file &file)
+{
+	running_machine &machine = romdata->machine();
+	const rom_source *source;
+	const rom_entry *region;
+	astring regiontag, string;
+	UINT8 signature[8];
+	UINT32 count, value;
+	UINT64 offset, first = 0, end = 0;
+
+	if (!machine.options().warm_boot() && !machine.options().share_roms())
+		return false;
+	if (file.open("warmboot", PATH_SEPARATOR, machine.system().name, ".img") != FILERR_NONE)
+		return false;
+
+	/* check the signature and the system */
+	if (file.read(signature, sizeof(signature)) != sizeof(signature) || memcmp(signature, WARMBOOT_SIGNATURE, sizeof(signature)) != 0)
+		return false;
+	if (!warmboot_read_string(file, string) || string != machine.system().name)
+		return false;
+	if (!warmboot_read_u32(file, value) || value != romdata->system_bios)
+		return false;
+
+	/* a different build may load the same files differently */
+	if (!warmboot_read_string(file, string) || string != build_version)
+		return false;
+	if (!warmboot_read_string(file, string) || string != build_id)
+		return false;
+	astring digest;
+	warmboot_rom_digest(machine, digest);
+	if (!warmboot_read_string(file, string) || string != digest)
+		return false;
+
+	/* the search must still find every ROM where it did before */
+	warmboot_rom_locations(romdata, digest);
+	if (!warmboot_read_string(file, string) || string != digest)
+		return false;
+
+	/* every source file must be unchanged */
+	if (!warmboot_read_u32(file, count))
+		return false;
+	while (count-- != 0)
+	{
+		UINT64 size, modified;
+		if (!warmboot_read_string(file, string) || !warmboot_read_u64(file, size) || !warmboot_read_u64(file, modified))
+			return false;
+
+		osd_directory_entry *entry = osd_stat(string);
+		if (entry == NULL)
+			return false;
+		bool unchanged = (entry->size == size && entry->last_modified == modified);
+		osd_free(entry);
+		if (!unchanged)
+			return false;
+	}
+
+	/* the regions must be exactly the ones we are about to allocate */
+	if (!warmboot_read_u32(file, count))
+		return false;
+	for (source = rom_first_source(machine.config()); source != NULL; source = rom_next_source(*source))
+		for (region = rom_first_region(*source); region != NULL; region = rom_next_region(region))
+			if (ROMREGION_ISROMDATA(region))
+			{
+				rom_region_name(regiontag, &machine.system(), source, region);
+				if (count-- == 0 || !warmboot_read_string(file, string) || string != regiontag)
+					return false;
+				if (!warmboot_read_u32(file, value) || value != ROMREGION_GETLENGTH(region))
+					return false;
+
+				/* each region's data follows the last one, aligned */
+				if (!warmboot_read_u64(file, offset) || (end != 0 && offset != warmboot_align(end)))
+					return false;
+				if (end == 0)
+					first = offset;
+				end = offset + value;
+			}
+	if (count != 0)
+		return false;
+
+	/* the first region follows the table, and the image ends with the last */
+	if (end != 0 && first != warmboot_align(file.tell()))
+		return false;
+	return (file.size() == ((end != 0) ? end : file.tell()));
+}
+
+
+/*-------------------------------------------------
+    restore_warmboot_region - create a region from
+    the next block of data in a warm boot image
+-------------------------------------------------*/
+
+static memory_region *restore_warmboot_region(rom_load_data *romdata, emu_file &file, const char *regiontag, UINT32 length, UINT8 width, endianness_t endianness)
+{
+	running_machine &machine = romdata->machine();
+	UINT64 offset = warmboot_align(file.tell());
+
+	file.seek(offset, SEEK_SET);
+
+	/* share the image between instances if we can */
+	if (machine.options().share_roms())
+	{
+		osd_mapping *mapping;
+		void *base;
+
+		if (file.map(offset, length, MAP_FLAG_COPY_ON_WRITE, &base, &mapping) == FILERR_NONE)
+		{
+			file.seek(offset + length, SEEK_SET);
+			return machine.region_map(regiontag, length, width, endianness, base, mapping);
+		}
+	}
+
+	/* otherwise just read it */
+	memory_region *region = machine.region_alloc(regiontag, length, width, endianness);
+	file.read(region->base(), length);
+	return region;
+}
+
+
+/*-------------------------------------------------
+    save_warmboot_image - write a warm boot image
+    after a successful load
+-------------------------------------------------*/
+
+static void save_warmboot_image(rom_load_data *romdata)
+{
+	running_machine &machine = romdata->machine();
+	const rom_source *source;
+	const rom_entry *region;
+	rom_source_file *sourcefile;
+	astring regiontag;
+	UINT32 count;
+	UINT64 offset;
+
+	astring filename("warmboot", PATH_SEPARATOR, machine.system().name, ".img");
+	rom_cache_remove(machine.options(), filename);
+	emu_file file(machine.options().cache_directory(), OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS);
+	if (file.open(filename) != FILERR_NONE)
+		return;
+
+	file.write(WARMBOOT_SIGNATURE, sizeof(WARMBOOT_SIGNATURE));
+	warmboot_write_string(file, machine.system().name);
+	warmboot_write_u32(file, romdata->system_bios);
+	warmboot_write_string(file, build_version);
+	warmboot_write_string(file, build_id);
+	astring digest;
+	warmboot_rom_digest(machine, digest);
+	warmboot_write_string(file, digest);
+	warmboot_rom_locations(romdata, digest);
+	warmboot_write_string(file, digest);
+
+	/* the source files; an unreadable one leaves a truncated, unusable image */
+	for (count = 0, sourcefile = romdata->sourcefiles; sourcefile != NULL; sourcefile = sourcefile->next)
+		count++;
+	warmboot_write_u32(file, count);
+	for (sourcefile = romdata->sourcefiles; sourcefile != NULL; sourcefile = sourcefile->next)
+	{
+		osd_directory_entry *entry = osd_stat(sourcefile->path);
+		if (entry == NULL)
+			return;
+		warmboot_write_string(file, sourcefile->path);
+		warmboot_write_u64(file, entry->size);
+		warmboot_write_u64(file, entry->last_modified);
+		osd_free(entry);
+	}
+
+	/* the region table; size it first, so we know where the data starts */
+	count = 0;
+	offset = file.tell() + 4;
+	for (source = rom_first_source(machine.config()); source != NULL; source = rom_next_source(*source))
+		for (region = rom_first_region(*source); region != NULL; region = rom_next_region(region))
+			if (ROMREGION_ISROMDATA(region))
+			{
+				rom_region_name(regiontag, &machine.system(), source, region);
+				offset += 4 + regiontag.len() + 4 + 8;
+				count++;
+			}
+	warmboot_write_u32(file, count);
+	for (source = rom_first_source(machine.config()); source != NULL; source = rom_next_source(*source))
+		for (region = rom_first_region(*source); region != NULL; region = rom_next_region(region))
+			if (ROMREGION_ISROMDATA(region))
+			{
+				rom_region_name(regiontag, &machine.system(), source, region);
+				offset = warmboot_align(offset);
+				warmboot_write_string(file, regiontag);
+				warmboot_write_u32(file, ROMREGION_GETLENGTH(region));
+				warmboot_write_u64(file, offset);
+				offset += ROMREGION_GETLENGTH(region);
+			}
+
+	/* and the data, each region padded out to its aligned offset */
+	for (source = rom_first_source(machine.config()); source != NULL; source = rom_next_source(*source))
+		for (region = rom_first_region(*source); region != NULL; region = rom_next_region(region))
+			if (ROMREGION_ISROMDATA(region))
+			{
+				static const UINT8 padding[WARMBOOT_DATA_ALIGN] = { 0 };
+				rom_region_name(regiontag, &machine.system(), source, region);
+				const memory_region *memregion = machine.region(regiontag);
+				file.write(padding, warmboot_align(file.tell()) - file.tell());
+				file.write(memregion->base(), memregion->bytes());
+			}
+}
+
+
+
 /***************************************************************************
     ROM LOADING
 ***************************************************************************/
@@ -479,14 +972,14 @@ static void dump_wrong_and_correct_checksums(rom_load_data *romdata, const hash_
     and hash signatures of a file
 -------------------------------------------------*/
 
-static void verify_length_and_hash(rom_load_data *romdata, const char *name, UINT32 explength, const hash_collection &hashes)
+static void verify_length_and_hash(rom_load_data *romdata, emu_file *file, const char *name, UINT32 explength, const hash_collection &hashes)
 {
 	/* we've already complained if there is no file */
-	if (romdata->file == NULL)
+	if (file == NULL)
 		return;
 
 	/* verify length */
-	UINT32 actlength = romdata->file->size();
+	UINT32 actlength = file->size();
 	if (explength != actlength)
 	{
 		romdata->errorstring.catprintf("%s WRONG LENGTH (expected: %08x found: %08x)\n", name, explength, actlength);
@@ -495,7 +988,7 @@ static void verify_length_and_hash(rom_load_data *romdata, const char *name, UIN
 
 	/* If there is no good dump known, write it */
 	astring tempstr;
-	hash_collection &acthashes = romdata->file->hashes(hashes.hash_types(tempstr));
+	hash_collection &acthashes = romdata->hashcache->hashes(*file, hashes.hash_types(tempstr));
 	if (hashes.flag(hash_collection::FLAG_NO_DUMP))
 	{
 		romdata->errorstring.catprintf("%s NO GOOD DUMP KNOWN\n", name);
@@ -607,17 +1100,14 @@ static void region_post_process(rom_load_data *romdata, const char *rgntag, bool
 
 
 /*-------------------------------------------------
-    open_rom_file - open a ROM file, searching
-    up the parent and loading by checksum
+    find_rom_file - search the media path for a
+    ROM, up the parent chain and by checksum; on
+    success *file is the open file
 -------------------------------------------------*/
 
-static int open_rom_file(rom_load_data *romdata, const char *regiontag, const rom_entry *romp)
+static file_error find_rom_file(running_machine &machine, const char *regiontag, const rom_entry *romp, emu_file **file)
 {
 	file_error filerr = FILERR_NOT_FOUND;
-	UINT32 romsize = rom_file_size(romp);
-
-	/* update status display */
-	display_loading_rom_message(romdata, ROM_GETNAME(romp));
 
 	/* extract CRC to use for searching */
 	UINT32 crc = 0;
@@ -625,12 +1115,12 @@ static int open_rom_file(rom_load_data *romdata, const char *regiontag, const ro
 
 	/* attempt reading up the chain through the parents. It automatically also
      attempts any kind of load by checksum supported by the archives. */
-	romdata->file = NULL;
-	for (int drv = driver_list::find(romdata->machine().system()); romdata->file == NULL && drv != -1; drv = driver_list::clone(drv))
-		filerr = common_process_file(romdata->machine().options(), driver_list::driver(drv).name, has_crc, crc, romp, &romdata->file);
+	*file = NULL;
+	for (int drv = driver_list::find(machine.system()); *file == NULL && drv != -1; drv = driver_list::clone(drv))
+		filerr = common_process_file(machine.options(), driver_list::driver(drv).name, has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 
 	/* if the region is load by name, load the ROM from there */
-	if (romdata->file == NULL && regiontag != NULL)
+	if (*file == NULL && regiontag != NULL)
 	{
 		// check if we are dealing with softwarelists. if so, locationtag
 		// is actually a concatenation of: listname + setname + parentname
@@ -677,24 +1167,47 @@ static int open_rom_file(rom_load_data *romdata, const char *regiontag, const ro
 		// - if we are not using lists, we have regiontag only;
 		// - if we are using lists, we have: list/clonename, list/parentname, clonename, parentname
 		if (!is_list)
-			filerr = common_process_file(romdata->machine().options(), tag1.cstr(), has_crc, crc, romp, &romdata->file);
+			filerr = common_process_file(machine.options(), tag1.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 		else
 		{
 			// try to load from list/setname
-			if ((romdata->file == NULL) && (tag2.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag2.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && (tag2.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag2.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 			// try to load from list/parentname
-			if ((romdata->file == NULL) && has_parent && (tag3.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag3.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && has_parent && (tag3.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag3.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 			// try to load from setname
-			if ((romdata->file == NULL) && (tag4.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag4.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && (tag4.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag4.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 			// try to load from parentname
-			if ((romdata->file == NULL) && has_parent && (tag5.cstr() != NULL))
-				filerr = common_process_file(romdata->machine().options(), tag5.cstr(), has_crc, crc, romp, &romdata->file);
+			if ((*file == NULL) && has_parent && (tag5.cstr() != NULL))
+				filerr = common_process_file(machine.options(), tag5.cstr(), has_crc, crc, romp, file, OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
 		}
 	}
 
+	return filerr;
+}
+
+
+/*-------------------------------------------------
+    open_rom_file - open a ROM file, searching
+    up the parent and loading by checksum
+-------------------------------------------------*/
+
+static int open_rom_file(rom_load_data *romdata, const char *regiontag, const rom_entry *romp)
+{
+	UINT32 romsize = rom_file_size(romp);
+
+	/* update status display */
+	display_loading_rom_message(romdata, ROM_GETNAME(romp));
+
+	/* find it */
+	file_error filerr = find_rom_file(romdata->machine(), regiontag, romp, &romdata->file);
+
+	/* remember where it came from for the warm boot image */
+	if (romdata->file != NULL)
+		note_source_file(romdata, romdata->file->archive_path());
+
 	/* update counters */
 	romdata->romsloaded++;
 	romdata->romsloadedsize += romsize;
@@ -709,11 +1222,11 @@ static int open_rom_file(rom_load_data *romdata, const char *regiontag, const ro
     random data for a NULL file
 -------------------------------------------------*/
 
-static int rom_fread(rom_load_data *romdata, UINT8 *buffer, int length, const rom_entry *parent_region)
+static int rom_fread(rom_load_data *romdata, emu_file *file, UINT8 *buffer, int length, const rom_entry *parent_region)
 {
 	/* files just pass through */
-	if (romdata->file != NULL)
-		return romdata->file->read(buffer, length);
+	if (file != NULL)
+		return file->read(buffer, length);
 
 	/* otherwise, fill with randomness unless it was already specifically erased */
 	else if (!ROMREGION_ISERASE(parent_region))
@@ -724,25 +1237,16 @@ static int rom_fread(rom_load_data *romdata, UINT8 *buffer, int length, const ro
 
 
 /*-------------------------------------------------
-    read_rom_data - read ROM data for a single
-    entry
+    validate_rom_data - check that a ROM entry
+    fits in its region before reading it
 -------------------------------------------------*/
 
-static int read_rom_data(rom_load_data *romdata, const rom_entry *parent_region, const rom_entry *romp)
+static void validate_rom_data(rom_load_data *romdata, const rom_entry *romp)
 {
-	int datashift = ROM_GETBITSHIFT(romp);
-	int datamask = ((1 << ROM_GETBITWIDTH(romp)) - 1) << datashift;
 	int numbytes = ROM_GETLENGTH(romp);
 	int groupsize = ROM_GETGROUPSIZE(romp);
 	int skip = ROM_GETSKIPCOUNT(romp);
-	int reversed = ROM_ISREVERSED(romp);
 	int numgroups = (numbytes + groupsize - 1) / groupsize;
-	UINT8 *base = romdata->region->base() + ROM_GETOFFSET(romp);
-	UINT32 tempbufsize;
-	UINT8 *tempbuf;
-	int i;
-
-	LOG(("Loading ROM data: offs=%X len=%X mask=%02X group=%d skip=%d reverse=%d\n", ROM_GETOFFSET(romp), numbytes, datamask, groupsize, skip, reversed));
 
 	/* make sure the length was an even multiple of the group size */
 	if (numbytes % groupsize != 0)
@@ -755,14 +1259,38 @@ static int read_rom_data(rom_load_data *romdata, const rom_entry *parent_region,
 	/* make sure the length was valid */
 	if (numbytes == 0)
 		fatalerror("Error in RomModule definition: %s has an invalid length\n", ROM_GETNAME(romp));
+}
+
+
+/*-------------------------------------------------
+    read_rom_data - read ROM data for a single
+    entry; this can be called from a worker
+    thread, so the entry must already have been
+    checked by validate_rom_data
+-------------------------------------------------*/
+
+static int read_rom_data(rom_load_data *romdata, emu_file *file, memory_region *region, const rom_entry *parent_region, const rom_entry *romp)
+{
+	int datashift = ROM_GETBITSHIFT(romp);
+	int datamask = ((1 << ROM_GETBITWIDTH(romp)) - 1) << datashift;
+	int numbytes = ROM_GETLENGTH(romp);
+	int groupsize = ROM_GETGROUPSIZE(romp);
+	int skip = ROM_GETSKIPCOUNT(romp);
+	int reversed = ROM_ISREVERSED(romp);
+	UINT8 *base = region->base() + ROM_GETOFFSET(romp);
+	UINT32 tempbufsize;
+	UINT8 *tempbuf;
+	int i;
+
+	LOG(("Loading ROM data: offs=%X len=%X mask=%02X group=%d skip=%d reverse=%d\n", ROM_GETOFFSET(romp), numbytes, datamask, groupsize, skip, reversed));
 
 	/* special case for simple loads */
 	if (datamask == 0xff && (groupsize == 1 || !reversed) && skip == 0)
-		return rom_fread(romdata, base, numbytes, parent_region);
+		return rom_fread(romdata, file, base, numbytes, parent_region);
 
 	/* use a temporary buffer for complex loads */
 	tempbufsize = MIN(TEMPBUFFER_MAX_SIZE, numbytes);
-	tempbuf = auto_alloc_array(romdata->machine(), UINT8, tempbufsize);
+	tempbuf = global_alloc_array(UINT8, tempbufsize);
 
 	/* chunky reads for complex loads */
 	skip += groupsize;
@@ -774,9 +1302,9 @@ static int read_rom_data(rom_load_data *romdata, const rom_entry *parent_region,
 
 		/* read as much as we can */
 		LOG(("  Reading %X bytes into buffer\n", bytesleft));
-		if (rom_fread(romdata, bufptr, bytesleft, parent_region) != bytesleft)
+		if (rom_fread(romdata, file, bufptr, bytesleft, parent_region) != bytesleft)
 		{
-			auto_free(romdata->machine(), tempbuf);
+			global_free(tempbuf);
 			return 0;
 		}
 		numbytes -= bytesleft;
@@ -837,7 +1365,7 @@ static int read_rom_data(rom_load_data *romdata, const rom_entry *parent_region,
 				}
 		}
 	}
-	auto_free(romdata->machine(), tempbuf);
+	global_free(tempbuf);
 
 	LOG(("  All done\n"));
 	return ROM_GETLENGTH(romp);
@@ -899,6 +1427,164 @@ static void copy_rom_data(rom_load_data *romdata, const rom_entry *romp)
 }
 
 
+/*-------------------------------------------------
+    rom_pieces_overlap - return true if two ROM
+    entries might write the same bytes of their
+    region
+-------------------------------------------------*/
+
+static bool rom_pieces_overlap(const rom_entry *a, const rom_entry *b)
+{
+	UINT32 agroup = ROM_GETGROUPSIZE(a), bgroup = ROM_GETGROUPSIZE(b);
+	UINT32 astride = agroup + ROM_GETSKIPCOUNT(a), bstride = bgroup + ROM_GETSKIPCOUNT(b);
+	UINT32 astart = ROM_GETOFFSET(a), bstart = ROM_GETOFFSET(b);
+	UINT32 aend = astart + ((ROM_GETLENGTH(a) + agroup - 1) / agroup - 1) * astride + agroup;
+	UINT32 bend = bstart + ((ROM_GETLENGTH(b) + bgroup - 1) / bgroup - 1) * bstride + bgroup;
+
+	/* disjoint address ranges never collide; note that masked loads
+       read-modify-write whole bytes, so differing masks do not help */
+	if (aend <= bstart || bend <= astart)
+		return false;
+
+	/* interleaved loads with the same stride collide only if their byte lanes do */
+	if (astride == bstride && astride > agroup && astride > bgroup)
+	{
+		UINT32 alane = astart % astride, blane = bstart % astride;
+		return ((blane + astride - alane) % astride < agroup || (alane + astride - blane) % astride < bgroup);
+	}
+	return true;
+}
+
+
+/*-------------------------------------------------
+    rom_jobs_overlap - return true if two jobs
+    must be run in order
+-------------------------------------------------*/
+
+static bool rom_jobs_overlap(const rom_load_job *a, const rom_load_job *b)
+{
+	if (a->region != b->region)
+		return false;
+	for (int apiece = 0; apiece < a->pieces; apiece++)
+		if (!ROMENTRY_ISIGNORE(&a->piece[apiece].entry))
+			for (int bpiece = 0; bpiece < b->pieces; bpiece++)
+				if (!ROMENTRY_ISIGNORE(&b->piece[bpiece].entry) && rom_pieces_overlap(&a->piece[apiece].entry, &b->piece[bpiece].entry))
+					return true;
+	return false;
+}
+
+
+/*-------------------------------------------------
+    execute_rom_load_job - read all the pieces of
+    a file into the region and compute its hashes;
+    runs on a worker thread unless the file is
+    missing
+-------------------------------------------------*/
+
+static void *execute_rom_load_job(void *param, int threadid)
+{
+	rom_load_job *job = (rom_load_job *)param;
+
+	for (int piecenum = 0; piecenum < job->pieces; piecenum++)
+	{
+		const rom_load_piece &piece = job->piece[piecenum];
+
+		/* reloads start again from the beginning of the file */
+		if (piece.reseek && job->file != NULL)
+			job->file->seek(0, SEEK_SET);
+
+		/* attempt to read using the modified entry */
+		if (!ROMENTRY_ISIGNORE(&piece.entry))
+			read_rom_data(job->romdata, job->file, job->region, job->parent_region, &piece.entry);
+	}
+
+	/* compute the hashes now so that verification is just a comparison */
+	if (job->file != NULL)
+		job->romdata->hashcache->hashes(*job->file, job->hashtypes);
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    flush_rom_load_jobs - wait for all jobs in
+    flight, then report on and close their files
+    in ROM order
+-------------------------------------------------*/
+
+static void flush_rom_load_jobs(rom_load_data *romdata)
+{
+	rom_load_job *job, *next;
+
+	for (job = romdata->batch; job != NULL; job = next)
+	{
+		next = job->next;
+
+		/* wait for the reading to complete */
+		if (job->item != NULL)
+		{
+			while (!osd_work_item_wait(job->item, osd_ticks_per_second())) ;
+			osd_work_item_release(job->item);
+		}
+
+		/* report exactly as we would have when reading serially */
+		if (job->missing)
+			handle_missing_file(romdata, job->baserom);
+		else
+		{
+			LOG(("Verifying length (%X) and checksums\n", job->explength));
+			verify_length_and_hash(romdata, job->file, ROM_GETNAME(job->baserom), job->explength, hash_collection(ROM_GETHASHDATA(job->baserom)));
+			LOG(("Verify finished\n"));
+		}
+
+		/* close the file */
+		if (job->file != NULL)
+		{
+			LOG(("Closing ROM file\n"));
+			global_free(job->file);
+		}
+		global_free(job->piece);
+		global_free(job);
+	}
+
+	romdata->batch = NULL;
+	romdata->batch_tailptr = &romdata->batch;
+	romdata->batchfiles = 0;
+	romdata->batchsize = 0;
+}
+
+
+/*-------------------------------------------------
+    schedule_rom_load_job - add a job to the batch
+    in flight, waiting for any earlier job that
+    writes the same data
+-------------------------------------------------*/
+
+static void schedule_rom_load_job(rom_load_data *romdata, rom_load_job *job)
+{
+	UINT32 size = rom_file_size(job->baserom);
+	bool flush = (romdata->batchfiles >= LOADBATCH_MAX_FILES || romdata->batchsize + size > LOADBATCH_MAX_SIZE);
+
+	/* later entries overwrite earlier ones, so keep overlapping jobs in order */
+	for (rom_load_job *other = romdata->batch; other != NULL && !flush; other = other->next)
+		flush = rom_jobs_overlap(job, other);
+	if (flush)
+		flush_rom_load_jobs(romdata);
+
+	/* add us to the batch */
+	*romdata->batch_tailptr = job;
+	romdata->batch_tailptr = &job->next;
+	romdata->batchfiles++;
+	romdata->batchsize += size;
+
+	/* missing files are filled with random data, which must happen on this
+       thread and in order to be reproducible */
+	if (job->file != NULL && romdata->queue != NULL)
+		job->item = osd_work_item_queue(romdata->queue, execute_rom_load_job, job, 0);
+	if (job->item == NULL)
+		execute_rom_load_job(job, 0);
+}
+
+
 /*-------------------------------------------------
     process_rom_entries - process all ROM entries
     for a region
@@ -925,23 +1611,52 @@ static void process_rom_entries(rom_load_data *romdata, const char *regiontag, c
 
 		/* handle fills */
 		if (ROMENTRY_ISFILL(romp))
+		{
+			flush_rom_load_jobs(romdata);
 			fill_rom_data(romdata, romp++);
+		}
 
 		/* handle copies */
 		else if (ROMENTRY_ISCOPY(romp))
+		{
+			flush_rom_load_jobs(romdata);
 			copy_rom_data(romdata, romp++);
+		}
 
 		/* handle files */
 		else if (ROMENTRY_ISFILE(romp))
 		{
 			int irrelevantbios = (ROM_GETBIOSFLAGS(romp) != 0 && ROM_GETBIOSFLAGS(romp) != romdata->system_bios);
 			const rom_entry *baserom = romp;
-			int explength = 0;
+			const rom_entry *scan = romp;
+			bool missing = false;
+			int pieces = 0;
 
 			/* open the file if it is a non-BIOS or matches the current BIOS */
 			LOG(("Opening ROM file: %s\n", ROM_GETNAME(romp)));
 			if (!irrelevantbios && !open_rom_file(romdata, regiontag, romp))
-				handle_missing_file(romdata, romp);
+				missing = true;
+
+			/* count the entries that belong to this file */
+			do
+			{
+				do
+					scan++, pieces++;
+				while (ROMENTRY_ISCONTINUE(scan) || ROMENTRY_ISIGNORE(scan));
+			}
+			while (ROMENTRY_ISRELOAD(scan));
+
+			/* build a job to read the file */
+			rom_load_job *job = global_alloc_clear(rom_load_job);
+			job->romdata = romdata;
+			job->parent_region = parent_region;
+			job->region = romdata->region;
+			job->baserom = baserom;
+			job->file = romdata->file;
+			job->missing = missing;
+			job->piece = global_alloc_array_clear(rom_load_piece, pieces);
+			hash_collection(ROM_GETHASHDATA(baserom)).hash_types(job->hashtypes);
+			romdata->file = NULL;
 
 			/* loop until we run out of reloads */
 			do
@@ -949,52 +1664,48 @@ static void process_rom_entries(rom_load_data *romdata, const char *regiontag, c
 				/* loop until we run out of continues/ignores */
 				do
 				{
-					rom_entry modified_romp = *romp++;
-					//int readresult;
+					rom_load_piece &piece = job->piece[job->pieces++];
+					piece.entry = *romp++;
+					piece.reseek = (job->pieces > 1 && !ROMENTRY_ISCONTINUE(&piece.entry) && !ROMENTRY_ISIGNORE(&piece.entry));
 
 					/* handle flag inheritance */
-					if (!ROM_INHERITSFLAGS(&modified_romp))
-						lastflags = modified_romp._flags;
+					if (!ROM_INHERITSFLAGS(&piece.entry))
+						lastflags = piece.entry._flags;
 					else
-						modified_romp._flags = (modified_romp._flags & ~ROM_INHERITEDFLAGS) | lastflags;
+						piece.entry._flags = (piece.entry._flags & ~ROM_INHERITEDFLAGS) | lastflags;
 
-					explength += ROM_GETLENGTH(&modified_romp);
+					/* only the first pass through the file counts towards its length */
+					if (baserom != NULL)
+						job->explength += ROM_GETLENGTH(&piece.entry);
 
-					/* attempt to read using the modified entry */
-					if (!ROMENTRY_ISIGNORE(&modified_romp) && !irrelevantbios)
-						/*readresult = */read_rom_data(romdata, parent_region, &modified_romp);
+					/* check the entry now so that errors are reported from this thread */
+					if (!ROMENTRY_ISIGNORE(&piece.entry) && !irrelevantbios)
+						validate_rom_data(romdata, &piece.entry);
 				}
 				while (ROMENTRY_ISCONTINUE(romp) || ROMENTRY_ISIGNORE(romp));
 
-				/* if this was the first use of this file, verify the length and CRC */
-				if (baserom)
-				{
-					LOG(("Verifying length (%X) and checksums\n", explength));
-					verify_length_and_hash(romdata, ROM_GETNAME(baserom), explength, hash_collection(ROM_GETHASHDATA(baserom)));
-					LOG(("Verify finished\n"));
-				}
-
-				/* reseek to the start and clear the baserom so we don't reverify */
-				if (romdata->file != NULL)
-					romdata->file->seek(0, SEEK_SET);
+				/* clear the baserom so we don't count the reloads */
 				baserom = NULL;
-				explength = 0;
 			}
 			while (ROMENTRY_ISRELOAD(romp));
 
-			/* close the file */
-			if (romdata->file != NULL)
+			/* files for other BIOSes are skipped entirely */
+			if (irrelevantbios)
 			{
-				LOG(("Closing ROM file\n"));
-				global_free(romdata->file);
-				romdata->file = NULL;
+				global_free(job->piece);
+				global_free(job);
 			}
+			else
+				schedule_rom_load_job(romdata, job);
 		}
 		else
 		{
 			romp++;	/* something else; skip */
 		}
 	}
+
+	/* everything must be in place before the region is post-processed */
+	flush_rom_load_jobs(romdata);
 }
 
 
@@ -1441,10 +2152,12 @@ void load_software_part_region(device_t *device, char *swlist, char *swname, rom
 
 
 /*-------------------------------------------------
-    process_region_list - process a region list
+    process_region_list - process a region list,
+    taking the ROM data from a warm boot image if
+    we were given one
 -------------------------------------------------*/
 
-static void process_region_list(rom_load_data *romdata)
+static void process_region_list(rom_load_data *romdata, emu_file *warmimage)
 {
 	astring regiontag;
 	const rom_source *source;
@@ -1470,6 +2183,13 @@ static void process_region_list(rom_load_data *romdata)
 				if (romdata->machine().device(regiontag) != NULL)
 					normalize_flags_for_device(romdata->machine(), regiontag, width, endianness);
 
+				/* a warm boot image supplies the finished contents */
+				if (warmimage != NULL)
+				{
+					romdata->region = restore_warmboot_region(romdata, *warmimage, regiontag, regionlength, width, endianness);
+					continue;
+				}
+
 				/* remember the base and length */
 				romdata->region = romdata->machine().region_alloc(regiontag, regionlength, width, endianness);
 				LOG(("Allocated %X bytes @ %p\n", romdata->region->bytes(), romdata->region->base()));
@@ -1495,7 +2215,9 @@ static void process_region_list(rom_load_data *romdata)
 				process_disk_entries(romdata, ROMREGION_GETTAG(region), region, region + 1, NULL);
 		}
 
-	/* now go back and post-process all the regions */
+	/* now go back and post-process all the regions; an image holds them already processed */
+	if (warmimage != NULL)
+		return;
 	for (source = rom_first_source(romdata->machine().config()); source != NULL; source = rom_next_source(*source))
 		for (region = rom_first_region(*source); region != NULL; region = rom_next_region(region)) {
 			rom_region_name(regiontag, &romdata->machine().system(), source, region);
@@ -1532,8 +2254,26 @@ void rom_init(running_machine &machine)
 	romdata->chd_list = NULL;
 	romdata->chd_list_tailptr = &machine.romload_data->chd_list;
 
-	/* process the ROM entries we were passed */
-	process_region_list(romdata);
+	/* set up for reading files in parallel */
+	romdata->queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	romdata->batch = NULL;
+	romdata->batch_tailptr = &romdata->batch;
+	romdata->hashcache = auto_alloc(machine, file_hash_cache(machine.options()));
+
+	/* process the ROM entries we were passed, restoring them from a warm
+       boot image if there is a current one */
+	emu_file warmimage(machine.options().cache_directory(), OPEN_FLAG_READ | OPEN_FLAG_NO_PRELOAD);
+	if (open_warmboot_image(romdata, warmimage))
+		process_region_list(romdata, &warmimage);
+	else
+	{
+		process_region_list(romdata, NULL);
+		romdata->hashcache->save();
+
+		/* only a clean load is worth keeping */
+		if ((machine.options().warm_boot() || machine.options().share_roms()) && romdata->errors == 0 && romdata->warnings == 0)
+			save_warmboot_image(romdata);
+	}
 
 	/* display the results and exit */
 	display_rom_load_results(romdata);
@@ -1548,9 +2288,19 @@ static void rom_exit(running_machine &machine)
 {
 	open_chd *curchd;
 
+	/* free the loading queue */
+	if (machine.romload_data->queue != NULL)
+		osd_work_queue_free(machine.romload_data->queue);
+
 	/* close all hard drives */
 	for (curchd = machine.romload_data->chd_list; curchd != NULL; curchd = curchd->next)
 	{
+		chd_cache_stats stats;
+		if (curchd->origchd != NULL && chd_get_cache_stats(curchd->origchd, &stats) == CHDERR_NONE && stats.reads != 0)
+			mame_printf_verbose("CHD %s: %d reads, %d hits, %d prefetched, %d prefetch hits, %.3f seconds stalled\n", curchd->region,
+					(int)stats.reads, (int)stats.hits, (int)stats.prefetches, (int)stats.prefetchhits,
+					(double)stats.stallticks / (double)osd_ticks_per_second());
+
 		if (curchd->diffchd != NULL)
 			chd_close(curchd->diffchd);
 		if (curchd->difffile != NULL)
@@ -278,7 +278,7 @@ int rom_default_bios(running_machine &machine);
 /* ----- Helpers ----- */
 
 file_error common_process_file(emu_options &options, const char *location, const char *ext, const rom_entry *romp, emu_file **image_file);
-file_error common_process_file(emu_options &options, const char *location, bool has_crc, UINT32 crc, const rom_entry *romp, emu_file **image_file);
+file_error common_process_file(emu_options &options, const char *location, bool has_crc, UINT32 crc, const rom_entry *romp, emu_file **image_file, UINT32 openflags = OPEN_FLAG_READ);
 
 
 /* ----- ROM iteration ----- */
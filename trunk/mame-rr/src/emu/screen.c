@@ -53,6 +53,16 @@
 
 
 
+//**************************************************************************
+//  CONSTANTS
+//**************************************************************************
+
+// height of each band drawn by a reentrant update; every band repeats the
+// driver's per-update overhead, so they should not be too thin
+const int SCREEN_BAND_HEIGHT = 32;
+
+
+
 //**************************************************************************
 //  GLOBAL VARIABLES
 //**************************************************************************
@@ -84,7 +94,9 @@ screen_device::screen_device(const machine_config &mconfig, const char *tag, dev
 	  m_xscale(1.0f),
 	  m_yscale(1.0f),
 	  m_screen_update(NULL),
+	  m_screen_prepare(NULL),
 	  m_screen_eof(NULL),
+	  m_reentrant(false),
 	  m_container(NULL),
 	  m_width(100),
 	  m_height(100),
@@ -106,7 +118,10 @@ screen_device::screen_device(const machine_config &mconfig, const char *tag, dev
 	  m_scanline0_timer(NULL),
 	  m_scanline_timer(NULL),
 	  m_frame_number(0),
-	  m_partial_updates_this_frame(0)
+	  m_partial_updates_this_frame(0),
+	  m_band_queue(NULL),
+	  m_band_bitmap(NULL),
+	  m_band_changed(0)
 {
 	m_visarea.min_x = m_visarea.min_y = 0;
 	m_visarea.max_x = m_width - 1;
@@ -249,6 +264,18 @@ void screen_device::static_set_screen_update(device_t &device, screen_update_fun
 }
 
 
+//-------------------------------------------------
+//  static_set_screen_prepare - set the legacy
+//  screen prepare callback in the device
+//  configuration
+//-------------------------------------------------
+
+void screen_device::static_set_screen_prepare(device_t &device, screen_prepare_func callback)
+{
+	downcast<screen_device &>(device).m_screen_prepare = callback;
+}
+
+
 //-------------------------------------------------
 //  static_set_screen_eof - set the legacy
 //  screen eof callback in the device
@@ -261,6 +288,18 @@ void screen_device::static_set_screen_eof(device_t &device, screen_eof_func call
 }
 
 
+//-------------------------------------------------
+//  static_set_reentrant - configuration helper
+//  to declare that the screen update can draw
+//  several bands concurrently
+//-------------------------------------------------
+
+void screen_device::static_set_reentrant(device_t &device, bool reentrant)
+{
+	downcast<screen_device &>(device).m_reentrant = reentrant;
+}
+
+
 //-------------------------------------------------
 //  device_validity_check - verify device
 //  configuration
@@ -346,6 +385,10 @@ void screen_device::device_start()
 	if ((machine().config().m_video_attributes & VIDEO_UPDATE_SCANLINE) != 0)
 		m_scanline_timer->adjust(time_until_pos(0));
 
+	// allocate a work queue for drawing bands
+	if (m_reentrant)
+		m_band_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+
 	// create burn-in bitmap
 	if (machine().options().burnin())
 	{
@@ -393,6 +436,9 @@ void screen_device::device_stop()
 	if (m_burnin != NULL)
 		finalize_burnin();
 	global_free(m_screen_overlay_bitmap);
+	if (m_band_queue != NULL)
+		osd_work_queue_free(m_band_queue);
+	m_band_queue = NULL;
 }
 
 
@@ -618,7 +664,9 @@ bool screen_device::update_partial(int scanline)
 		g_profiler.start(PROFILER_VIDEO);
 		LOG_PARTIAL_UPDATES(("updating %d-%d\n", clip.min_y, clip.max_y));
 
-		flags = screen_update(*m_bitmap[m_curbitmap], clip);
+		if (m_screen_prepare != NULL)
+			(*m_screen_prepare)(this, &clip);
+		flags = update_bands(*m_bitmap[m_curbitmap], clip);
 		m_partial_updates_this_frame++;
 		g_profiler.stop();
 
@@ -633,6 +681,43 @@ bool screen_device::update_partial(int scanline)
 }
 
 
+//-------------------------------------------------
+//  update_bands - call the screen update, split
+//  into horizontal bands drawn concurrently if
+//  the update is reentrant
+//-------------------------------------------------
+
+UINT32 screen_device::update_bands(bitmap_t &bitmap, const rectangle &cliprect)
+{
+	// the profiler can only follow one thread, so it forces a single call
+	if (m_band_queue == NULL || g_profiler.enabled() || cliprect.max_y - cliprect.min_y + 1 < 2 * SCREEN_BAND_HEIGHT)
+		return screen_update(bitmap, cliprect);
+
+	// each band gets its own slice of the bitmap and priority bitmap
+	m_band_bitmap = &bitmap;
+	m_band_clip = cliprect;
+	m_band_changed = 0;
+	osd_work_queue_parallel_for(m_band_queue, static_update_band, this, cliprect.max_y - cliprect.min_y + 1, SCREEN_BAND_HEIGHT);
+	return m_band_changed ? 0 : UPDATE_HAS_NOT_CHANGED;
+}
+
+
+//-------------------------------------------------
+//  update_band - draw one band of a reentrant
+//  update; may be called on any thread
+//-------------------------------------------------
+
+void screen_device::update_band(INT32 start, INT32 end)
+{
+	rectangle band = m_band_clip;
+	band.min_y = m_band_clip.min_y + start;
+	band.max_y = m_band_clip.min_y + end - 1;
+
+	if (!(screen_update(*m_band_bitmap, band) & UPDATE_HAS_NOT_CHANGED))
+		atomic_exchange32(&m_band_changed, 1);
+}
+
+
 //-------------------------------------------------
 //  update_now - perform an update from the last
 //  beam position up to the current beam position
@@ -75,6 +75,7 @@ class screen_device;
 typedef delegate<void (screen_device &, bool)> vblank_state_delegate;
 
 typedef UINT32 (*screen_update_func)(screen_device *screen, bitmap_t *bitmap, const rectangle *cliprect);
+typedef void (*screen_prepare_func)(screen_device *screen, const rectangle *cliprect);
 typedef void (*screen_eof_func)(screen_device *screen, running_machine &machine);
 
 
@@ -103,6 +104,7 @@ public:
 	float xscale() const { return m_xscale; }
 	float yscale() const { return m_yscale; }
 	bool have_screen_update() const { return m_screen_update != NULL; }
+	bool reentrant() const { return m_reentrant; }
 
 	// inline configuration helpers
 	static void static_set_format(device_t &device, bitmap_format format);
@@ -114,7 +116,9 @@ public:
 	static void static_set_visarea(device_t &device, INT16 minx, INT16 maxx, INT16 miny, INT16 maxy);
 	static void static_set_default_position(device_t &device, double xscale, double xoffs, double yscale, double yoffs);
 	static void static_set_screen_update(device_t &device, screen_update_func callback);
+	static void static_set_screen_prepare(device_t &device, screen_prepare_func callback);
 	static void static_set_screen_eof(device_t &device, screen_eof_func callback);
+	static void static_set_reentrant(device_t &device, bool reentrant);
 
 	// information getters
 	screen_device *next_screen() const { return downcast<screen_device *>(typenext()); }
@@ -184,6 +188,10 @@ private:
 	static TIMER_CALLBACK( static_scanline_update_callback ) { reinterpret_cast<screen_device *>(ptr)->scanline_update_callback(param); }
 	void scanline_update_callback(int scanline);
 
+	UINT32 update_bands(bitmap_t &bitmap, const rectangle &cliprect);
+	static void static_update_band(void *param, INT32 start, INT32 end, int threadid) { reinterpret_cast<screen_device *>(param)->update_band(start, end); }
+	void update_band(INT32 start, INT32 end);
+
 	void finalize_burnin();
 	void load_effect_overlay(const char *filename);
 
@@ -196,7 +204,9 @@ private:
 	float				m_xoffset, m_yoffset;		// default X/Y offsets
 	float				m_xscale, m_yscale;			// default X/Y scale factor
 	screen_update_func	m_screen_update;			// screen update callback
+	screen_prepare_func	m_screen_prepare;			// screen prepare callback
 	screen_eof_func		m_screen_eof;				// screen eof callback
+	bool				m_reentrant;				// can the update draw several bands at once?
 
 	// internal state
 	render_container *	m_container;				// pointer to our container
@@ -231,6 +241,12 @@ private:
 	UINT64				m_frame_number;				// the current frame number
 	UINT32				m_partial_updates_this_frame;// partial update counter this frame
 
+	// banded updates
+	osd_work_queue *	m_band_queue;				// work queue for drawing bands
+	bitmap_t *			m_band_bitmap;				// bitmap being drawn
+	rectangle			m_band_clip;				// full area being drawn
+	INT32 volatile		m_band_changed;				// did any band change the bitmap?
+
 	class callback_item
 	{
 	public:
@@ -258,6 +274,10 @@ extern const device_type SCREEN;
 #define SCREEN_UPDATE(name)				UINT32 SCREEN_UPDATE_NAME(name)(screen_device *screen, bitmap_t *bitmap, const rectangle *cliprect)
 #define SCREEN_UPDATE_CALL(name)		SCREEN_UPDATE_NAME(name)(screen, bitmap, cliprect)
 
+#define SCREEN_PREPARE_NAME(name)		screen_prepare_##name
+#define SCREEN_PREPARE(name)			void SCREEN_PREPARE_NAME(name)(screen_device *screen, const rectangle *cliprect)
+#define SCREEN_PREPARE_CALL(name)		SCREEN_PREPARE_NAME(name)(screen, cliprect)
+
 #define SCREEN_EOF_NAME(name)			screen_eof_##name
 #define SCREEN_EOF(name)				void SCREEN_EOF_NAME(name)(screen_device *screen, running_machine &machine)
 #define SCREEN_EOF_CALL(name)			SCREEN_EOF_NAME(name)(screen, machine)
@@ -301,5 +321,19 @@ extern const device_type SCREEN;
 #define MCFG_SCREEN_EOF(_func) \
 	screen_device::static_set_screen_eof(*device, SCREEN_EOF_NAME(_func)); \
 
+// the prepare callback runs on the emulation thread just before each update;
+// a reentrant update may then be called on several threads at once, each
+// with a horizontal band of the area being updated, so it must draw only
+// within its cliprect and leave any shared state to the prepare callback;
+// tilemap_draw serializes its own tile updates per tilemap, but the tile
+// get_info callbacks may then run on any band's thread, so they must not
+// touch driver state the update changes (or prepare should bring the
+// tilemaps up to date with tilemap_get_pixmap first)
+#define MCFG_SCREEN_PREPARE(_func) \
+	screen_device::static_set_screen_prepare(*device, SCREEN_PREPARE_NAME(_func)); \
+
+#define MCFG_SCREEN_REENTRANT \
+	screen_device::static_set_reentrant(*device, true); \
+
 
 #endif	/* __SCREEN_H__ */
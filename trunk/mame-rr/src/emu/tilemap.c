@@ -12,6 +12,19 @@
 #include "emu.h"
 #include "profiler.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/***************************************************************************
+    DEBUGGING
+***************************************************************************/
+
+/* time the scalar and vector rasterizers against each other at startup */
+#define TILEMAP_BENCHMARK				(0)
+
+
 
 /***************************************************************************
     CONSTANTS
@@ -26,6 +39,9 @@
 /* maximum index in each array */
 #define MAX_PEN_TO_FLAGS				256
 
+/* fewest dirty tiles worth rendering on the work queue */
+#define PARALLEL_TILE_THRESHOLD			256
+
 
 /***************************************************************************
     TYPE DEFINITIONS
@@ -64,6 +80,22 @@ struct _blit_parameters
 };
 
 
+/* a dirty tile whose info has been fetched, waiting to be rendered */
+typedef struct _tile_job tile_job;
+struct _tile_job
+{
+	const UINT8 *		pen_data;			/* pen data, including the pen data offset */
+	const UINT8 *		mask_data;			/* optional bitmask */
+	tilemap_logical_index logindex;			/* logical index of the tile */
+	UINT32				x0, y0;				/* top-left corner in the pixmap */
+	pen_t				palette_base;		/* palette base for the tile */
+	UINT8				category;			/* category from the tile info */
+	UINT8				group;				/* group from the tile info */
+	UINT8				flags;				/* tile flags, with the global flip applied */
+	UINT8				pen_mask;			/* mask to apply to the pen data */
+};
+
+
 /* core tilemap structure */
 class tilemap_t
 {
@@ -124,6 +156,11 @@ public:
 	UINT8 *						tileflags;			/* per-tile flags */
 	UINT8 *						pen_to_flags;		/* mapping of pens to flags */
 
+	/* deferred tile rendering */
+	tile_job *					jobs;				/* dirty tiles waiting to be rendered */
+	UINT32 *					jobrows;			/* index of the first job in each tile row */
+	osd_lock *					lock;				/* lock for updating while drawing from several threads */
+
 private:
 	running_machine &			m_machine;			/* pointer back to the owning machine */
 };
@@ -134,6 +171,7 @@ struct _tilemap_private
 	tilemap_t *		list;
 	tilemap_t **		tailptr;
 	int				instance;
+	osd_work_queue *	queue;
 };
 
 
@@ -154,7 +192,11 @@ static void mappings_update(tilemap_t *tmap);
 
 /* tile rendering */
 static void pixmap_update(tilemap_t *tmap, const rectangle *cliprect);
+static void pixmap_update_visible(tilemap_t *tmap, const rectangle *cliprect, int scrollx, int scrolly);
 static void tile_update(tilemap_t *tmap, tilemap_logical_index logindex, UINT32 cached_col, UINT32 cached_row);
+static void tile_prepare(tilemap_t *tmap, tilemap_logical_index logindex, UINT32 col, UINT32 row, tile_job *job);
+static void tile_render(tilemap_t *tmap, const tile_job *job);
+static void pixmap_render_rows(void *param, INT32 start, INT32 end, int threadid);
 static UINT8 tile_draw(tilemap_t *tmap, const UINT8 *pendata, UINT32 x0, UINT32 y0, UINT32 palette_base, UINT8 category, UINT8 group, UINT8 flags, UINT8 pen_mask);
 static UINT8 tile_apply_bitmask(tilemap_t *tmap, const UINT8 *maskdata, UINT32 x0, UINT32 y0, UINT8 category, UINT8 flags);
 
@@ -178,6 +220,25 @@ static void scanline_draw_masked_rgb32(void *dest, const UINT16 *source, const U
 static void scanline_draw_opaque_rgb32_alpha(void *dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
 static void scanline_draw_masked_rgb32_alpha(void *dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
 
+/* vector versions of the scanline rasterizers; the scalar ones above are the reference */
+static void select_vector_rasterizers(blit_parameters *blit);
+#ifdef __SSE2__
+static void scanline_draw_opaque_null_sse2(void *dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_masked_null_sse2(void *dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_opaque_ind16_sse2(void *dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_masked_ind16_sse2(void *dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_opaque_rgb16_sse2(void *dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_masked_rgb16_sse2(void *dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_opaque_rgb32_sse2(void *dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_masked_rgb32_sse2(void *dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_opaque_rgb32_alpha_sse2(void *dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+static void scanline_draw_masked_rgb32_alpha_sse2(void *dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha);
+#endif
+
+#if TILEMAP_BENCHMARK
+static void tilemap_benchmark(void);
+#endif
+
 
 
 /***************************************************************************
@@ -303,10 +364,11 @@ void tilemap_init(running_machine &machine)
 	screen_height = machine.primary_screen->height();
 
 	if (screen_width != 0 && screen_height != 0)
-	{
 		machine.priority_bitmap = auto_bitmap_alloc(machine, screen_width, screen_height, BITMAP_FORMAT_INDEXED8);
-		machine.add_notifier(MACHINE_NOTIFY_EXIT, machine_notify_delegate(FUNC(tilemap_exit), &machine));
-	}
+
+#if TILEMAP_BENCHMARK
+	tilemap_benchmark();
+#endif
 }
 
 
@@ -352,6 +414,8 @@ static tilemap_t *tilemap_create_common(running_machine &machine, void *get_info
 	{
 		machine.tilemap_data = auto_alloc_clear(machine, tilemap_private);
 		machine.tilemap_data->tailptr = &machine.tilemap_data->list;
+		machine.tilemap_data->queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+		machine.add_notifier(MACHINE_NOTIFY_EXIT, machine_notify_delegate(FUNC(tilemap_exit), &machine));
 	}
 	tilemap_instance = machine.tilemap_data->instance;
 
@@ -398,6 +462,11 @@ static tilemap_t *tilemap_create_common(running_machine &machine, void *get_info
 	for (group = 0; group < TILEMAP_NUM_GROUPS; group++)
 		tilemap_map_pens_to_layer(tmap, group, 0, 0, TILEMAP_PIXEL_LAYER0);
 
+	/* allocate space to queue up every tile for rendering */
+	tmap->jobs = auto_alloc_array(machine, tile_job, tmap->max_logical_index);
+	tmap->jobrows = auto_alloc_array(machine, UINT32, tmap->rows + 1);
+	tmap->lock = osd_lock_alloc();
+
 	/* add us to the end of the list of tilemaps */
 	*machine.tilemap_data->tailptr = tmap;
 	machine.tilemap_data->tailptr = &tmap->next;
@@ -834,18 +903,26 @@ void tilemap_draw_primask(bitmap_t *dest, const rectangle *cliprect, tilemap_t *
 g_profiler.start(PROFILER_TILEMAP_DRAW);
 	/* configure the blit parameters based on the input parameters */
 	configure_blit_parameters(&blit, tmap, dest, cliprect, flags, priority, priority_mask);
+	select_vector_rasterizers(&blit);
 
-	/* if the whole map is dirty, mark it as such */
+	/* if the whole map is dirty, mark it as such; bands of a reentrant screen may race to do this */
+	osd_lock_acquire(tmap->lock);
 	if (tmap->all_tiles_dirty || gfx_elements_changed(tmap))
 	{
 		memset(tmap->tileflags, TILE_FLAG_DIRTY, tmap->max_logical_index);
 		tmap->all_tiles_dirty = FALSE;
 		tmap->gfx_used = 0;
 	}
+	osd_lock_release(tmap->lock);
 
 	width  = tmap->machine().primary_screen->width();
 	height = tmap->machine().primary_screen->height();
 
+	/* render the dirty tiles this draw can reach before the blit, so they go to the work queue together */
+	pixmap_update_visible(tmap, &blit.cliprect,
+			(tmap->scrollrows == 1) ? effective_rowscroll(tmap, 0, width) : -1,
+			(tmap->scrollcols == 1) ? effective_colscroll(tmap, 0, height) : -1);
+
 	/* XY scrolling playfield */
 	if (tmap->scrollrows == 1 && tmap->scrollcols == 1)
 	{
@@ -1033,18 +1110,21 @@ void tilemap_draw_by_index(running_machine &machine, bitmap_t *dest, int number,
 
 	/* set up for the blit, using hard-coded parameters (no priority, etc) */
 	configure_blit_parameters(&blit, tmap, dest, NULL, TILEMAP_DRAW_OPAQUE | TILEMAP_DRAW_ALL_CATEGORIES, 0, 0xff);
+	select_vector_rasterizers(&blit);
 
 	/* compute the effective scroll positions */
 	scrollx = tmap->width  - scrollx % tmap->width;
 	scrolly = tmap->height - scrolly % tmap->height;
 
-	/* if the whole map is dirty, mark it as such */
+	/* if the whole map is dirty, mark it as such; bands of a reentrant screen may race to do this */
+	osd_lock_acquire(tmap->lock);
 	if (tmap->all_tiles_dirty || gfx_elements_changed(tmap))
 	{
 		memset(tmap->tileflags, TILE_FLAG_DIRTY, tmap->max_logical_index);
 		tmap->all_tiles_dirty = FALSE;
 		tmap->gfx_used = 0;
 	}
+	osd_lock_release(tmap->lock);
 
 	/* iterate to handle wraparound */
 	for (ypos = scrolly - tmap->height; ypos <= blit.cliprect.max_y; ypos += tmap->height)
@@ -1132,12 +1212,19 @@ static void tilemap_exit(running_machine &machine)
 
 	/* free all the tilemaps in the list */
 	if (tilemap_data != NULL)
+	{
 		while (tilemap_data->list != NULL)
 		{
 			tilemap_t *next = tilemap_data->list->next;
 			tilemap_dispose(tilemap_data->list);
 			tilemap_data->list = next;
 		}
+
+		/* free the work queue */
+		if (tilemap_data->queue != NULL)
+			osd_work_queue_free(tilemap_data->queue);
+		tilemap_data->queue = NULL;
+	}
 }
 
 
@@ -1169,6 +1256,9 @@ static void tilemap_dispose(tilemap_t *tmap)
 		}
 
 	/* free allocated memory */
+	osd_lock_free(tmap->lock);
+	auto_free(tmap->machine(), tmap->jobrows);
+	auto_free(tmap->machine(), tmap->jobs);
 	auto_free(tmap->machine(), tmap->pen_to_flags);
 	auto_free(tmap->machine(), tmap->tileflags);
 	auto_free(tmap->machine(), tmap->flagsmap);
@@ -1268,8 +1358,13 @@ static void mappings_update(tilemap_t *tmap)
 
 static void pixmap_update(tilemap_t *tmap, const rectangle *cliprect)
 {
+	osd_work_queue *queue = tmap->machine().tilemap_data->queue;
 	int mincol, maxcol, minrow, maxrow;
 	int row, col;
+	UINT32 jobs, job;
+
+	/* screens that draw in bands may get here from several threads at once */
+	osd_lock_acquire(tmap->lock);
 
 	/* if the graphics changed, we need to mark everything dirty */
 	if (gfx_elements_changed(tmap))
@@ -1277,7 +1372,10 @@ static void pixmap_update(tilemap_t *tmap, const rectangle *cliprect)
 
 	/* if everything is clean, do nothing */
 	if (tmap->all_tiles_clean)
+	{
+		osd_lock_release(tmap->lock);
 		return;
+	}
 
 g_profiler.start(PROFILER_TILEMAP_DRAW);
 
@@ -1304,22 +1402,112 @@ g_profiler.start(PROFILER_TILEMAP_DRAW);
 		tmap->gfx_used = 0;
 	}
 
-	/* iterate over rows */
+	/* fetch the info for each dirty tile; the callbacks are always called serially and in order */
+	jobs = 0;
 	for (row = minrow; row <= maxrow; row++)
 	{
 		tilemap_logical_index logindex = row * tmap->cols;
 
 		/* iterate over colums */
+		tmap->jobrows[row - minrow] = jobs;
 		for (col = mincol; col <= maxcol; col++)
 			if (tmap->tileflags[logindex + col] == TILE_FLAG_DIRTY)
-				tile_update(tmap, logindex + col, col, row);
+				tile_prepare(tmap, logindex + col, col, row, &tmap->jobs[jobs++]);
 	}
+	tmap->jobrows[maxrow + 1 - minrow] = jobs;
+
+	/* render them; each tile row owns a separate band of the pixmap and flagsmap, so rows can be split across threads */
+	if (queue != NULL && jobs >= PARALLEL_TILE_THRESHOLD && maxrow > minrow)
+		osd_work_queue_parallel_for(queue, pixmap_render_rows, tmap, maxrow + 1 - minrow, 0);
+	else
+		for (job = 0; job < jobs; job++)
+			tile_render(tmap, &tmap->jobs[job]);
 
 	/* mark it all clean */
-	if (mincol == 0 && minrow == 0 && maxcol == tmap->cols - 1 && maxcol == tmap->rows - 1)
+	if (mincol == 0 && minrow == 0 && maxcol == tmap->cols - 1 && maxrow == tmap->rows - 1)
 		tmap->all_tiles_clean = TRUE;
 
 g_profiler.stop();
+	osd_lock_release(tmap->lock);
+}
+
+
+/*-------------------------------------------------
+    visible_source_ranges - compute the range(s)
+    of tilemap pixels along one axis that a draw
+    from min to max with the given scroll reaches,
+    allowing for wraparound; a scroll of -1 means
+    the whole axis
+-------------------------------------------------*/
+
+static int visible_source_ranges(int min, int max, int scroll, int size, int *start, int *end)
+{
+	int first;
+
+	/* the whole axis */
+	if (scroll < 0 || max - min + 1 >= size)
+	{
+		start[0] = 0;
+		end[0] = size - 1;
+		return 1;
+	}
+
+	/* one range, or two if it wraps past the edge */
+	first = ((min - scroll) % size + size) % size;
+	start[0] = first;
+	end[0] = first + (max - min);
+	if (end[0] < size)
+		return 1;
+	start[1] = 0;
+	end[1] = end[0] - size;
+	end[0] = size - 1;
+	return 2;
+}
+
+
+/*-------------------------------------------------
+    pixmap_update_visible - update the part of the
+    pixmap a draw through cliprect will read, given
+    the scroll of the whole map along each axis
+    (-1 if the lines scroll separately)
+-------------------------------------------------*/
+
+static void pixmap_update_visible(tilemap_t *tmap, const rectangle *cliprect, int scrollx, int scrolly)
+{
+	int xstart[2], xend[2], ystart[2], yend[2];
+	int xranges, yranges, x, y;
+
+	if (tmap->all_tiles_clean || cliprect->min_x > cliprect->max_x || cliprect->min_y > cliprect->max_y)
+		return;
+
+	xranges = visible_source_ranges(cliprect->min_x, cliprect->max_x, scrollx, tmap->width, xstart, xend);
+	yranges = visible_source_ranges(cliprect->min_y, cliprect->max_y, scrolly, tmap->height, ystart, yend);
+	for (y = 0; y < yranges; y++)
+		for (x = 0; x < xranges; x++)
+		{
+			rectangle visible;
+
+			visible.min_x = xstart[x];
+			visible.max_x = xend[x];
+			visible.min_y = ystart[y];
+			visible.max_y = yend[y];
+			pixmap_update(tmap, &visible);
+		}
+}
+
+
+/*-------------------------------------------------
+    pixmap_render_rows - work queue callback to
+    render the queued tiles in a range of rows
+-------------------------------------------------*/
+
+static void pixmap_render_rows(void *param, INT32 start, INT32 end, int threadid)
+{
+	tilemap_t *tmap = (tilemap_t *)param;
+	UINT32 job;
+
+	for (job = tmap->jobrows[start]; job < tmap->jobrows[end]; job++)
+		tile_render(tmap, &tmap->jobs[job]);
 }
 
 
@@ -1329,10 +1517,21 @@ g_profiler.stop();
 
 static void tile_update(tilemap_t *tmap, tilemap_logical_index logindex, UINT32 col, UINT32 row)
 {
-	UINT32 x0 = tmap->tilewidth * col;
-	UINT32 y0 = tmap->tileheight * row;
+	tile_job job;
+
+	tile_prepare(tmap, logindex, col, row, &job);
+	tile_render(tmap, &job);
+}
+
+
+/*-------------------------------------------------
+    tile_prepare - fetch the info for a dirty tile
+    and describe how to render it
+-------------------------------------------------*/
+
+static void tile_prepare(tilemap_t *tmap, tilemap_logical_index logindex, UINT32 col, UINT32 row, tile_job *job)
+{
 	tilemap_memory_index memindex;
-	UINT32 flags;
 
 g_profiler.start(PROFILER_TILEMAP_UPDATE);
 
@@ -1340,16 +1539,19 @@ g_profiler.start(PROFILER_TILEMAP_UPDATE);
 	memindex = tmap->logical_to_memory[logindex];
 	(*tmap->tile_get_info)(*(running_machine *)tmap->tile_get_info_object, &tmap->tileinfo, memindex, tmap->user_data);
 
-	/* apply the global tilemap flip to the returned flip flags */
-	flags = tmap->tileinfo.flags ^ (tmap->attributes & 0x03);
+	/* copy out everything needed to draw it */
+	job->pen_data = tmap->tileinfo.pen_data + tmap->pen_data_offset;
+	job->mask_data = tmap->tileinfo.mask_data;
+	job->logindex = logindex;
+	job->x0 = tmap->tilewidth * col;
+	job->y0 = tmap->tileheight * row;
+	job->palette_base = tmap->tileinfo.palette_base;
+	job->category = tmap->tileinfo.category;
+	job->group = tmap->tileinfo.group;
+	job->pen_mask = tmap->tileinfo.pen_mask;
 
-	/* draw the tile, using either direct or transparent */
-	tmap->tileflags[logindex] = tile_draw(tmap, tmap->tileinfo.pen_data + tmap->pen_data_offset, x0, y0,
-		tmap->tileinfo.palette_base, tmap->tileinfo.category, tmap->tileinfo.group, flags, tmap->tileinfo.pen_mask);
-
-	/* if mask data is specified, apply it */
-	if ((flags & (TILE_FORCE_LAYER0 | TILE_FORCE_LAYER1 | TILE_FORCE_LAYER2)) == 0 && tmap->tileinfo.mask_data != NULL)
-		tmap->tileflags[logindex] = tile_apply_bitmask(tmap, tmap->tileinfo.mask_data, x0, y0, tmap->tileinfo.category, flags);
+	/* apply the global tilemap flip to the returned flip flags */
+	job->flags = tmap->tileinfo.flags ^ (tmap->attributes & 0x03);
 
 	/* track which gfx have been used for this tilemap */
 	if (tmap->tileinfo.gfxnum != 0xff && (tmap->gfx_used & (1 << tmap->tileinfo.gfxnum)) == 0)
@@ -1362,6 +1564,27 @@ g_profiler.stop();
 }
 
 
+/*-------------------------------------------------
+    tile_render - draw a prepared tile into the
+    pixmap and flagsmap; touches nothing outside
+    the tile, so may be called from any thread
+-------------------------------------------------*/
+
+static void tile_render(tilemap_t *tmap, const tile_job *job)
+{
+	UINT8 tileflags;
+
+	/* draw the tile, using either direct or transparent */
+	tileflags = tile_draw(tmap, job->pen_data, job->x0, job->y0, job->palette_base, job->category, job->group, job->flags, job->pen_mask);
+
+	/* if mask data is specified, apply it */
+	if ((job->flags & (TILE_FORCE_LAYER0 | TILE_FORCE_LAYER1 | TILE_FORCE_LAYER2)) == 0 && job->mask_data != NULL)
+		tileflags = tile_apply_bitmask(tmap, job->mask_data, job->x0, job->y0, job->category, job->flags);
+
+	tmap->tileflags[job->logindex] = tileflags;
+}
+
+
 /*-------------------------------------------------
     tile_draw - draw a single tile to the
     tilemap's internal pixmap, using the pen as
@@ -1694,9 +1917,14 @@ static void tilemap_draw_instance(tilemap_t *tmap, const blit_parameters *blit,
 			{
 				tilemap_logical_index logindex = row * tmap->cols + column;
 
-				/* if the current tile is dirty, fix it */
+				/* if the current tile is dirty, fix it; another band may be doing the same, so check again under the lock */
 				if (tmap->tileflags[logindex] == TILE_FLAG_DIRTY)
-					tile_update(tmap, logindex, column, row);
+				{
+					osd_lock_acquire(tmap->lock);
+					if (tmap->tileflags[logindex] == TILE_FLAG_DIRTY)
+						tile_update(tmap, logindex, column, row);
+					osd_lock_release(tmap->lock);
+				}
 
 				/* if the current summary data is non-zero, we must draw masked */
 				if ((tmap->tileflags[logindex] & blit->mask) != 0)
@@ -2340,3 +2568,610 @@ static void scanline_draw_masked_rgb32_alpha(void *_dest, const UINT16 *source,
 				dest[i] = alpha_blend_r32(dest[i], clut[source[i]], alpha);
 	}
 }
+
+
+
+/***************************************************************************
+    VECTOR SCANLINE RASTERIZERS
+***************************************************************************/
+
+/*-------------------------------------------------
+    select_vector_rasterizers - replace the
+    scalar rasterizers chosen by
+    configure_blit_parameters with vector
+    versions, where we have them; the roz path
+    keeps the scalar ones, since it identifies
+    the destination by them
+-------------------------------------------------*/
+
+static void select_vector_rasterizers(blit_parameters *blit)
+{
+#ifdef __SSE2__
+	static const struct
+	{
+		blitopaque_func		opaque;
+		blitmask_func		masked;
+		blitopaque_func		opaque_vector;
+		blitmask_func		masked_vector;
+	} s_vector_rasterizers[] =
+	{
+		{ scanline_draw_opaque_null,		scanline_draw_masked_null,			scanline_draw_opaque_null_sse2,			scanline_draw_masked_null_sse2 },
+		{ scanline_draw_opaque_ind16,		scanline_draw_masked_ind16,			scanline_draw_opaque_ind16_sse2,		scanline_draw_masked_ind16_sse2 },
+		{ scanline_draw_opaque_rgb16,		scanline_draw_masked_rgb16,			scanline_draw_opaque_rgb16_sse2,		scanline_draw_masked_rgb16_sse2 },
+		{ scanline_draw_opaque_rgb32,		scanline_draw_masked_rgb32,			scanline_draw_opaque_rgb32_sse2,		scanline_draw_masked_rgb32_sse2 },
+		{ scanline_draw_opaque_rgb32_alpha,	scanline_draw_masked_rgb32_alpha,	scanline_draw_opaque_rgb32_alpha_sse2,	scanline_draw_masked_rgb32_alpha_sse2 }
+	};
+
+	for (int index = 0; index < ARRAY_LENGTH(s_vector_rasterizers); index++)
+		if (blit->draw_opaque == s_vector_rasterizers[index].opaque && blit->draw_masked == s_vector_rasterizers[index].masked)
+		{
+			blit->draw_opaque = s_vector_rasterizers[index].opaque_vector;
+			blit->draw_masked = s_vector_rasterizers[index].masked_vector;
+			break;
+		}
+#endif
+}
+
+
+#ifdef __SSE2__
+
+/*-------------------------------------------------
+    select_sse2 - merge two vectors, taking bytes
+    from ifset where select is set and from
+    ifclear elsewhere
+-------------------------------------------------*/
+
+INLINE __m128i select_sse2(__m128i select, __m128i ifset, __m128i ifclear)
+{
+	return _mm_or_si128(_mm_and_si128(select, ifset), _mm_andnot_si128(select, ifclear));
+}
+
+
+/*-------------------------------------------------
+    mask_test_sse2 - test 16 pixels of the flags
+    map, returning 0xff in each byte that passes
+-------------------------------------------------*/
+
+INLINE __m128i mask_test_sse2(const UINT8 *maskptr, __m128i mask, __m128i value)
+{
+	return _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i *)maskptr), mask), value);
+}
+
+
+/*-------------------------------------------------
+    priority_sse2 - apply the priority code to a
+    run of the priority bitmap
+-------------------------------------------------*/
+
+INLINE void priority_sse2(UINT8 *pri, int count, UINT32 pcode)
+{
+	__m128i keep = _mm_set1_epi8((char)(pcode >> 8));
+	__m128i code = _mm_set1_epi8((char)pcode);
+	int i;
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		__m128i p = _mm_loadu_si128((const __m128i *)&pri[i]);
+		_mm_storeu_si128((__m128i *)&pri[i], _mm_or_si128(_mm_and_si128(p, keep), code));
+	}
+	for ( ; i < count; i++)
+		pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+}
+
+
+/*-------------------------------------------------
+    masked_priority_sse2 - apply the priority code
+    to the 16 pixels of the priority bitmap that
+    passed the mask test
+-------------------------------------------------*/
+
+INLINE void masked_priority_sse2(UINT8 *pri, __m128i select, UINT32 pcode)
+{
+	__m128i p = _mm_loadu_si128((const __m128i *)pri);
+	__m128i updated = _mm_or_si128(_mm_and_si128(p, _mm_set1_epi8((char)(pcode >> 8))), _mm_set1_epi8((char)pcode));
+	_mm_storeu_si128((__m128i *)pri, select_sse2(select, updated, p));
+}
+
+
+/*-------------------------------------------------
+    alpha_blend_r32_sse2 - alpha blend four 32-bit
+    8-8-8 RGB pixels, exactly as alpha_blend_r32
+-------------------------------------------------*/
+
+INLINE __m128i alpha_blend_r32_sse2(__m128i d, __m128i s, __m128i level, __m128i alphad)
+{
+	__m128i zero = _mm_setzero_si128();
+
+	/* each channel sum is at most 255 * 256, so 16 bits suffice */
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), level), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), alphad));
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), level), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), alphad));
+	__m128i result = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+	return _mm_and_si128(result, _mm_set1_epi32(0x00ffffff));
+}
+
+
+/*-------------------------------------------------
+    clut_gather_sse2 - look up four pixels in the
+    color table
+-------------------------------------------------*/
+
+INLINE __m128i clut_gather_sse2(const pen_t *clut, const UINT16 *source)
+{
+	return _mm_set_epi32(clut[source[3]], clut[source[2]], clut[source[1]], clut[source[0]]);
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_opaque_null_sse2 - draw to a
+    NULL bitmap, setting priority only
+-------------------------------------------------*/
+
+static void scanline_draw_opaque_null_sse2(void *dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	/* skip entirely if not changing priority */
+	if (pcode != 0xff00)
+		priority_sse2(pri, count, pcode);
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_masked_null_sse2 - draw to a
+    NULL bitmap using a mask, setting priority
+    only
+-------------------------------------------------*/
+
+static void scanline_draw_masked_null_sse2(void *dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	__m128i maskv = _mm_set1_epi8((char)mask);
+	__m128i valuev = _mm_set1_epi8((char)value);
+	int i;
+
+	/* skip entirely if not changing priority */
+	if (pcode == 0xff00)
+		return;
+
+	for (i = 0; i + 16 <= count; i += 16)
+		masked_priority_sse2(&pri[i], mask_test_sse2(&maskptr[i], maskv, valuev), pcode);
+	for ( ; i < count; i++)
+		if ((maskptr[i] & mask) == value)
+			pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_opaque_ind16_sse2 - draw to a
+    16bpp indexed bitmap
+-------------------------------------------------*/
+
+static void scanline_draw_opaque_ind16_sse2(void *_dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	UINT16 *dest = (UINT16 *)_dest;
+	int pal = pcode >> 16;
+	int i;
+
+	/* special case for no palette offset */
+	if (pal == 0)
+		memcpy(dest, source, count * 2);
+
+	/* otherwise add it 8 pixels at a time */
+	else
+	{
+		__m128i palv = _mm_set1_epi16((short)pal);
+		for (i = 0; i + 8 <= count; i += 8)
+			_mm_storeu_si128((__m128i *)&dest[i], _mm_add_epi16(_mm_loadu_si128((const __m128i *)&source[i]), palv));
+		for ( ; i < count; i++)
+			dest[i] = source[i] + pal;
+	}
+
+	/* priority if necessary */
+	if ((pcode & 0xffff) != 0xff00)
+		priority_sse2(pri, count, pcode);
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_masked_ind16_sse2 - draw to a
+    16bpp indexed bitmap using a mask
+-------------------------------------------------*/
+
+static void scanline_draw_masked_ind16_sse2(void *_dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	UINT16 *dest = (UINT16 *)_dest;
+	int pal = pcode >> 16;
+	int priority = ((pcode & 0xffff) != 0xff00);
+	__m128i maskv = _mm_set1_epi8((char)mask);
+	__m128i valuev = _mm_set1_epi8((char)value);
+	__m128i palv = _mm_set1_epi16((short)pal);
+	int i;
+
+	/* 16 pixels at a time, skipping groups where nothing passes */
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		__m128i select = mask_test_sse2(&maskptr[i], maskv, valuev);
+		if (_mm_movemask_epi8(select) == 0)
+			continue;
+
+		__m128i select0 = _mm_unpacklo_epi8(select, select);
+		__m128i select1 = _mm_unpackhi_epi8(select, select);
+		__m128i src0 = _mm_add_epi16(_mm_loadu_si128((const __m128i *)&source[i]), palv);
+		__m128i src1 = _mm_add_epi16(_mm_loadu_si128((const __m128i *)&source[i + 8]), palv);
+		_mm_storeu_si128((__m128i *)&dest[i], select_sse2(select0, src0, _mm_loadu_si128((const __m128i *)&dest[i])));
+		_mm_storeu_si128((__m128i *)&dest[i + 8], select_sse2(select1, src1, _mm_loadu_si128((const __m128i *)&dest[i + 8])));
+		if (priority)
+			masked_priority_sse2(&pri[i], select, pcode);
+	}
+
+	/* then the remainder */
+	for ( ; i < count; i++)
+		if ((maskptr[i] & mask) == value)
+		{
+			dest[i] = source[i] + pal;
+			if (priority)
+				pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+		}
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_opaque_rgb16_sse2 - draw to a
+    16bpp RGB bitmap
+-------------------------------------------------*/
+
+static void scanline_draw_opaque_rgb16_sse2(void *_dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	const pen_t *clut = &pens[pcode >> 16];
+	UINT16 *dest = (UINT16 *)_dest;
+	int i;
+
+	/* the lookups are scalar; the priority is not */
+	for (i = 0; i < count; i++)
+		dest[i] = clut[source[i]];
+	if ((pcode & 0xffff) != 0xff00)
+		priority_sse2(pri, count, pcode);
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_masked_rgb16_sse2 - draw to a
+    16bpp RGB bitmap using a mask
+-------------------------------------------------*/
+
+static void scanline_draw_masked_rgb16_sse2(void *_dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	const pen_t *clut = &pens[pcode >> 16];
+	UINT16 *dest = (UINT16 *)_dest;
+	int priority = ((pcode & 0xffff) != 0xff00);
+	__m128i maskv = _mm_set1_epi8((char)mask);
+	__m128i valuev = _mm_set1_epi8((char)value);
+	int i, j;
+
+	/* test 16 pixels at a time, skipping groups where nothing passes */
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		__m128i select = mask_test_sse2(&maskptr[i], maskv, valuev);
+		int bits = _mm_movemask_epi8(select);
+		if (bits == 0)
+			continue;
+
+		if (bits == 0xffff)
+			for (j = 0; j < 16; j++)
+				dest[i + j] = clut[source[i + j]];
+		else
+			for (j = 0; j < 16; j++)
+				if (bits & (1 << j))
+					dest[i + j] = clut[source[i + j]];
+		if (priority)
+			masked_priority_sse2(&pri[i], select, pcode);
+	}
+
+	/* then the remainder */
+	for ( ; i < count; i++)
+		if ((maskptr[i] & mask) == value)
+		{
+			dest[i] = clut[source[i]];
+			if (priority)
+				pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+		}
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_opaque_rgb32_sse2 - draw to a
+    32bpp RGB bitmap
+-------------------------------------------------*/
+
+static void scanline_draw_opaque_rgb32_sse2(void *_dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	const pen_t *clut = &pens[pcode >> 16];
+	UINT32 *dest = (UINT32 *)_dest;
+	int i;
+
+	/* the lookups are scalar; the priority is not */
+	for (i = 0; i < count; i++)
+		dest[i] = clut[source[i]];
+	if ((pcode & 0xffff) != 0xff00)
+		priority_sse2(pri, count, pcode);
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_masked_rgb32_sse2 - draw to a
+    32bpp RGB bitmap using a mask
+-------------------------------------------------*/
+
+static void scanline_draw_masked_rgb32_sse2(void *_dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	const pen_t *clut = &pens[pcode >> 16];
+	UINT32 *dest = (UINT32 *)_dest;
+	int priority = ((pcode & 0xffff) != 0xff00);
+	__m128i maskv = _mm_set1_epi8((char)mask);
+	__m128i valuev = _mm_set1_epi8((char)value);
+	int i, j;
+
+	/* test 16 pixels at a time, skipping groups where nothing passes */
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		__m128i select = mask_test_sse2(&maskptr[i], maskv, valuev);
+		int bits = _mm_movemask_epi8(select);
+		if (bits == 0)
+			continue;
+
+		if (bits == 0xffff)
+			for (j = 0; j < 16; j++)
+				dest[i + j] = clut[source[i + j]];
+		else
+			for (j = 0; j < 16; j++)
+				if (bits & (1 << j))
+					dest[i + j] = clut[source[i + j]];
+		if (priority)
+			masked_priority_sse2(&pri[i], select, pcode);
+	}
+
+	/* then the remainder */
+	for ( ; i < count; i++)
+		if ((maskptr[i] & mask) == value)
+		{
+			dest[i] = clut[source[i]];
+			if (priority)
+				pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+		}
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_opaque_rgb32_alpha_sse2 - draw
+    to a 32bpp RGB bitmap with alpha blending
+-------------------------------------------------*/
+
+static void scanline_draw_opaque_rgb32_alpha_sse2(void *_dest, const UINT16 *source, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	const pen_t *clut = &pens[pcode >> 16];
+	UINT32 *dest = (UINT32 *)_dest;
+	__m128i level = _mm_set1_epi16(alpha);
+	__m128i alphad = _mm_set1_epi16(256 - alpha);
+	int i;
+
+	/* blend 4 pixels at a time */
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		__m128i d = _mm_loadu_si128((const __m128i *)&dest[i]);
+		_mm_storeu_si128((__m128i *)&dest[i], alpha_blend_r32_sse2(d, clut_gather_sse2(clut, &source[i]), level, alphad));
+	}
+	for ( ; i < count; i++)
+		dest[i] = alpha_blend_r32(dest[i], clut[source[i]], alpha);
+
+	/* priority if necessary */
+	if ((pcode & 0xffff) != 0xff00)
+		priority_sse2(pri, count, pcode);
+}
+
+
+/*-------------------------------------------------
+    scanline_draw_masked_rgb32_alpha_sse2 - draw
+    to a 32bpp RGB bitmap using a mask and alpha
+    blending
+-------------------------------------------------*/
+
+static void scanline_draw_masked_rgb32_alpha_sse2(void *_dest, const UINT16 *source, const UINT8 *maskptr, int mask, int value, int count, const pen_t *pens, UINT8 *pri, UINT32 pcode, UINT8 alpha)
+{
+	const pen_t *clut = &pens[pcode >> 16];
+	UINT32 *dest = (UINT32 *)_dest;
+	int priority = ((pcode & 0xffff) != 0xff00);
+	__m128i maskv = _mm_set1_epi8((char)mask);
+	__m128i valuev = _mm_set1_epi8((char)value);
+	__m128i level = _mm_set1_epi16(alpha);
+	__m128i alphad = _mm_set1_epi16(256 - alpha);
+	int i, group;
+
+	/* test 16 pixels at a time, then blend the 4-pixel groups where any pass */
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		__m128i select = mask_test_sse2(&maskptr[i], maskv, valuev);
+		int bits = _mm_movemask_epi8(select);
+		if (bits == 0)
+			continue;
+
+		/* widen the test results to one per 32-bit pixel */
+		__m128i select16[2], select32[4];
+		select16[0] = _mm_unpacklo_epi8(select, select);
+		select16[1] = _mm_unpackhi_epi8(select, select);
+		select32[0] = _mm_unpacklo_epi16(select16[0], select16[0]);
+		select32[1] = _mm_unpackhi_epi16(select16[0], select16[0]);
+		select32[2] = _mm_unpacklo_epi16(select16[1], select16[1]);
+		select32[3] = _mm_unpackhi_epi16(select16[1], select16[1]);
+
+		for (group = 0; group < 4; group++)
+			if ((bits >> (group * 4)) & 0x0f)
+			{
+				UINT32 *groupdest = &dest[i + group * 4];
+				__m128i d = _mm_loadu_si128((const __m128i *)groupdest);
+				__m128i blended = alpha_blend_r32_sse2(d, clut_gather_sse2(clut, &source[i + group * 4]), level, alphad);
+				_mm_storeu_si128((__m128i *)groupdest, select_sse2(select32[group], blended, d));
+			}
+		if (priority)
+			masked_priority_sse2(&pri[i], select, pcode);
+	}
+
+	/* then the remainder */
+	for ( ; i < count; i++)
+		if ((maskptr[i] & mask) == value)
+		{
+			dest[i] = alpha_blend_r32(dest[i], clut[source[i]], alpha);
+			if (priority)
+				pri[i] = (pri[i] & (pcode >> 8)) | pcode;
+		}
+}
+
+#endif	/* __SSE2__ */
+
+
+
+/***************************************************************************
+    BENCHMARK
+***************************************************************************/
+
+#if TILEMAP_BENCHMARK
+
+/*-------------------------------------------------
+    benchmark_draw_frame - draw one frame of a
+    synthetic 1024x512 pixmap made of 16x16 tiles,
+    with per-line row scroll and, optionally,
+    per-16-pixel column scroll, the way
+    tilemap_draw_instance breaks it into runs
+-------------------------------------------------*/
+
+static void benchmark_draw_frame(const blit_parameters *blit, UINT8 *dest, int bpp, UINT8 *pri, int width, int height,
+		const UINT16 *pixmap, const UINT8 *flagsmap, const UINT8 *tiletype, const pen_t *pens, int frame, int colscroll)
+{
+	const int pixwidth = 1024, pixheight = 512;
+
+	for (int y = 0; y < height; y++)
+	{
+		int rowscroll = (y * 3 + frame * 2) & (pixwidth - 1);
+		int x = 0;
+
+		while (x < width)
+		{
+			/* find the source row for this column and the end of the run */
+			int sy = colscroll ? ((y + (x / 16) * 5 + frame) & (pixheight - 1)) : ((y + frame) & (pixheight - 1));
+			int sx = (x + rowscroll) & (pixwidth - 1);
+			int type = tiletype[(sy / 16) * (pixwidth / 16) + sx / 16];
+			int end = x + 16 - (sx & 15);
+			while (!colscroll && end < width && ((sx + end - x) & (pixwidth - 1)) != 0 &&
+					tiletype[(sy / 16) * (pixwidth / 16) + ((sx + end - x) & (pixwidth - 1)) / 16] == type)
+				end += 16;
+			if (colscroll && (end - 1) / 16 != x / 16)
+				end = (x / 16 + 1) * 16;
+			end = MIN(end, width);
+
+			/* draw it as tilemap_draw_instance would */
+			const UINT16 *source = &pixmap[sy * pixwidth + sx];
+			const UINT8 *mask = &flagsmap[sy * pixwidth + sx];
+			if (type == WHOLLY_OPAQUE)
+				(*blit->draw_opaque)(&dest[(y * width + x) * bpp], source, end - x, pens, &pri[y * width + x], blit->tilemap_priority_code, blit->alpha);
+			else if (type == MASKED)
+				(*blit->draw_masked)(&dest[(y * width + x) * bpp], source, mask, blit->mask, blit->value, end - x, pens, &pri[y * width + x], blit->tilemap_priority_code, blit->alpha);
+			x = end;
+		}
+	}
+}
+
+
+/*-------------------------------------------------
+    tilemap_benchmark - time the scalar and vector
+    rasterizers on CPS-1 and Neo Geo sized
+    screens, checking that they agree
+-------------------------------------------------*/
+
+static void tilemap_benchmark(void)
+{
+	static const struct { const char *name; int width, height; } s_screens[] =
+	{
+		{ "CPS-1",		384, 224 },
+		{ "Neo Geo",	320, 224 }
+	};
+	static const struct { const char *name; blitopaque_func opaque; blitmask_func masked; int bpp; UINT32 pcode; UINT8 alpha; } s_kernels[] =
+	{
+		{ "ind16",			scanline_draw_opaque_ind16,			scanline_draw_masked_ind16,			2, 0x00000000 | 0xff00, 0xff },
+		{ "ind16 pri",		scanline_draw_opaque_ind16,			scanline_draw_masked_ind16,			2, 0x01000000 | 0x0002, 0xff },
+		{ "rgb32 pri",		scanline_draw_opaque_rgb32,			scanline_draw_masked_rgb32,			4, 0x01000000 | 0x0002, 0xff },
+		{ "rgb32 alpha",	scanline_draw_opaque_rgb32_alpha,	scanline_draw_masked_rgb32_alpha,	4, 0x01000000 | 0xff00, 0x80 },
+		{ "null pri",		scanline_draw_opaque_null,			scanline_draw_masked_null,			4, 0x00000000 | 0x0002, 0xff }
+	};
+	const int pixwidth = 1024, pixheight = 512, frames = 200;
+	UINT32 seed = 1;
+
+	/* build the pixmap: a quarter of the tiles transparent, a quarter with transparent pixels */
+	UINT16 *pixmap = global_alloc_array(UINT16, pixwidth * pixheight);
+	UINT8 *flagsmap = global_alloc_array(UINT8, pixwidth * pixheight);
+	UINT8 *tiletype = global_alloc_array(UINT8, (pixwidth / 16) * (pixheight / 16));
+	pen_t *pens = global_alloc_array(pen_t, 0x20000);
+	for (int index = 0; index < (pixwidth / 16) * (pixheight / 16); index++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		tiletype[index] = ((seed >> 24) & 3) == 0 ? WHOLLY_TRANSPARENT : ((seed >> 24) & 3) == 1 ? MASKED : WHOLLY_OPAQUE;
+	}
+	for (int index = 0; index < pixwidth * pixheight; index++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		int type = tiletype[((index / pixwidth) / 16) * (pixwidth / 16) + (index % pixwidth) / 16];
+		pixmap[index] = (seed >> 16) & 0xfff;
+		flagsmap[index] = (type == WHOLLY_OPAQUE || (type == MASKED && (seed & 0x300) != 0)) ? TILEMAP_PIXEL_LAYER0 : 0;
+	}
+	for (int index = 0; index < 0x20000; index++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		pens[index] = seed & 0xffffff;
+	}
+
+	mame_printf_info("Tilemap rasterizer benchmark, %d frames each:\n", frames);
+	for (int screen = 0; screen < ARRAY_LENGTH(s_screens); screen++)
+		for (int kernel = 0; kernel < ARRAY_LENGTH(s_kernels); kernel++)
+			for (int colscroll = 0; colscroll < 2; colscroll++)
+			{
+				int width = s_screens[screen].width, height = s_screens[screen].height;
+				UINT8 *dest[2], *pri[2];
+				osd_ticks_t ticks[2];
+
+				for (int pass = 0; pass < 2; pass++)
+				{
+					blit_parameters blit;
+					memset(&blit, 0, sizeof(blit));
+					blit.draw_opaque = s_kernels[kernel].opaque;
+					blit.draw_masked = s_kernels[kernel].masked;
+					blit.tilemap_priority_code = s_kernels[kernel].pcode;
+					blit.alpha = s_kernels[kernel].alpha;
+					blit.mask = TILEMAP_PIXEL_CATEGORY_MASK | TILEMAP_PIXEL_LAYER0;
+					blit.value = TILEMAP_PIXEL_LAYER0;
+					if (pass == 1)
+						select_vector_rasterizers(&blit);
+
+					dest[pass] = global_alloc_array_clear(UINT8, width * height * 4);
+					pri[pass] = global_alloc_array_clear(UINT8, width * height);
+					ticks[pass] = osd_ticks();
+					for (int frame = 0; frame < frames; frame++)
+						benchmark_draw_frame(&blit, dest[pass], s_kernels[kernel].bpp, pri[pass], width, height, pixmap, flagsmap, tiletype, pens, frame, colscroll);
+					ticks[pass] = MAX(osd_ticks() - ticks[pass], 1);
+				}
+
+				bool match = (memcmp(dest[0], dest[1], width * height * 4) == 0 && memcmp(pri[0], pri[1], width * height) == 0);
+				mame_printf_info("  %-8s %-12s %-10s scalar %7.3fms  vector %7.3fms  (%5.2fx)%s\n",
+						s_screens[screen].name, s_kernels[kernel].name, colscroll ? "colscroll" : "rowscroll",
+						(double)ticks[0] * 1000.0 / (double)osd_ticks_per_second() / frames,
+						(double)ticks[1] * 1000.0 / (double)osd_ticks_per_second() / frames,
+						(double)ticks[0] / (double)ticks[1], match ? "" : "  MISMATCH");
+
+				for (int pass = 0; pass < 2; pass++)
+				{
+					global_free(dest[pass]);
+					global_free(pri[pass]);
+				}
+			}
+
+	global_free(pixmap);
+	global_free(flagsmap);
+	global_free(tiletype);
+	global_free(pens);
+}
+
+#endif	/* TILEMAP_BENCHMARK */
@@ -10,6 +10,7 @@
 ***************************************************************************/
 
 #include "emu.h"
+#include "emuopts.h"
 #include "hash.h"
 #include "validity.h"
 
@@ -24,6 +25,19 @@
 
 
 
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+/* number of drivers whose configurations are built ahead of the checks */
+#define VALIDITY_BATCH				(128)
+
+/* file in the cache directory listing the source files that passed, one per line */
+static const char VALIDITY_CACHE_FILENAME[] = "validity.txt";
+static const char VALIDITY_CACHE_SIGNATURE[] = "MAMEVALIDITY 1";
+
+
+
 /***************************************************************************
     COMPILE-TIME VALIDATION
 ***************************************************************************/
@@ -63,6 +77,26 @@ public:
 };
 
 
+/* a driver's configuration and input ports, built on a worker thread */
+class validity_slot
+{
+public:
+	validity_slot()
+		: options(NULL),
+		  drvindex(-1),
+		  config(NULL),
+		  portsfailed(false) { }
+
+	emu_options *options;
+	int drvindex;
+	machine_config *config;
+	ioport_list portlist;
+	astring porterrors;		/* input port errors, formatted as they are printed */
+	astring fatal;			/* text of a fatal error while building */
+	bool portsfailed;		/* did the fatal error come from the input ports? */
+};
+
+
 extern const device_type *s_devices_sorted[];
 extern int m_device_count;
 
@@ -309,15 +343,107 @@ static bool validate_inlines(void)
 }
 
 
+/*-------------------------------------------------
+    build_driver - construct the configuration
+    and input ports for one driver; called from
+    worker threads, so anything that would be
+    printed is saved for the checks to print in
+    order
+-------------------------------------------------*/
+
+static void *build_driver(void *param, int threadid)
+{
+	validity_slot &slot = *reinterpret_cast<validity_slot *>(param);
+	const game_driver &driver = driver_list::driver(slot.drvindex);
+
+	try
+	{
+		slot.config = global_alloc(machine_config(driver, *slot.options));
+
+		/* allocate the input ports */
+		if (driver.ipt != NULL)
+		{
+			astring errorbuf;
+			slot.portsfailed = true;
+			for (device_t *cfg = slot.config->devicelist().first(); cfg != NULL; cfg = cfg->next())
+			{
+				input_port_list_init(*cfg, slot.portlist, errorbuf);
+				if (errorbuf)
+					slot.porterrors.catprintf("%s: %s has input port errors:\n%s\n", driver.source_file, driver.name, errorbuf.cstr());
+			}
+			slot.portsfailed = false;
+		}
+	}
+	catch (emu_fatalerror &err)
+	{
+		slot.fatal.cpy(err.string());
+	}
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    release_driver - free what build_driver
+    constructed
+-------------------------------------------------*/
+
+static void release_driver(validity_slot &slot)
+{
+	slot.portlist.reset();
+	global_free(slot.config);
+	slot.config = NULL;
+	slot.porterrors.reset();
+	slot.fatal.reset();
+	slot.portsfailed = false;
+}
+
+
+/*-------------------------------------------------
+    build_batch - start building the given
+    drivers on the work queue, or build them
+    now if there is no queue
+-------------------------------------------------*/
+
+static void build_batch(osd_work_queue *queue, emu_options &options, validity_slot *slots, const int *drivers, int count)
+{
+	for (int slotnum = 0; slotnum < count; slotnum++)
+	{
+		slots[slotnum].options = &options;
+		slots[slotnum].drvindex = drivers[slotnum];
+	}
+
+	if (queue != NULL)
+		osd_work_item_queue_multiple(queue, build_driver, count, slots, sizeof(slots[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+	else
+		for (int slotnum = 0; slotnum < count; slotnum++)
+			build_driver(&slots[slotnum], 0);
+}
+
+
+/*-------------------------------------------------
+    validity_cleanup - free the work queue and
+    everything built for the checks
+-------------------------------------------------*/
+
+static void validity_cleanup(osd_work_queue *queue, validity_slot *slots, int *drivers)
+{
+	if (queue != NULL)
+		osd_work_queue_free(queue);
+	for (int slotnum = 0; slotnum < 2 * VALIDITY_BATCH; slotnum++)
+		release_driver(slots[slotnum]);
+	global_free(slots);
+	global_free(drivers);
+}
+
+
 /*-------------------------------------------------
     validate_driver - validate basic driver
     information
 -------------------------------------------------*/
 
-static bool validate_driver(driver_enumerator &drivlist, game_driver_map &names, game_driver_map &descriptions)
+static bool validate_driver(driver_enumerator &drivlist, const machine_config &config, game_driver_map &names, game_driver_map &descriptions)
 {
 	const game_driver &driver = drivlist.driver();
-	const machine_config &config = drivlist.config();
 	const char *compatible_with;
 	bool error = FALSE, is_clone;
 	const char *s;
@@ -431,10 +557,9 @@ static bool validate_driver(driver_enumerator &drivlist, game_driver_map &names,
     validate_roms - validate ROM definitions
 -------------------------------------------------*/
 
-static bool validate_roms(driver_enumerator &drivlist, region_array *rgninfo, game_driver_map &roms)
+static bool validate_roms(driver_enumerator &drivlist, const machine_config &config, region_array *rgninfo, game_driver_map &roms)
 {
 	const game_driver &driver = drivlist.driver();
-	const machine_config &config = drivlist.config();
 	int bios_flags = 0, last_bios = 0;
 	const char *last_rgnname = "???";
 	const char *last_name = "???";
@@ -598,10 +723,9 @@ static bool validate_roms(driver_enumerator &drivlist, region_array *rgninfo, ga
     configurations
 -------------------------------------------------*/
 
-static bool validate_display(driver_enumerator &drivlist)
+static bool validate_display(driver_enumerator &drivlist, const machine_config &config)
 {
 	const game_driver &driver = drivlist.driver();
-	const machine_config &config = drivlist.config();
 	bool palette_modes = false;
 	bool error = false;
 
@@ -625,10 +749,9 @@ static bool validate_display(driver_enumerator &drivlist)
     configuration
 -------------------------------------------------*/
 
-static bool validate_gfx(driver_enumerator &drivlist, region_array *rgninfo)
+static bool validate_gfx(driver_enumerator &drivlist, const machine_config &config, region_array *rgninfo)
 {
 	const game_driver &driver = drivlist.driver();
-	const machine_config &config = drivlist.config();
 	bool error = false;
 	int gfxnum;
 
@@ -958,32 +1081,28 @@ static void validate_dip_settings(input_field_config *field, const game_driver &
 
 /*-------------------------------------------------
     validate_inputs - validate input configuration
+    built by build_driver
 -------------------------------------------------*/
 
-static bool validate_inputs(driver_enumerator &drivlist, int_map &defstr_map, ioport_list &portlist)
+static bool validate_inputs(driver_enumerator &drivlist, int_map &defstr_map, const validity_slot &slot)
 {
+	const ioport_list &portlist = slot.portlist;
 	input_port_config *scanport;
 	input_port_config *port;
 	input_field_config *field;
 	const game_driver &driver = drivlist.driver();
-	const machine_config &config = drivlist.config();
 	int empty_string_found = FALSE;
 	bool error = false;
-	astring errorbuf;
 
 	/* skip if no ports */
 	if (driver.ipt == NULL)
 		return FALSE;
 
-	/* allocate the input ports */
-	for (device_t *cfg = config.devicelist().first(); cfg != NULL; cfg = cfg->next())
+	/* report problems allocating the input ports */
+	if (slot.porterrors)
 	{
-		input_port_list_init(*cfg, portlist, errorbuf);
-		if (errorbuf)
-		{
-			mame_printf_error("%s: %s has input port errors:\n%s\n", driver.source_file, driver.name, errorbuf.cstr());
-			error = true;
-		}
+		mame_printf_error("%s", slot.porterrors.cstr());
+		error = true;
 	}
 
 	/* check for duplicate tags */
@@ -1104,11 +1223,10 @@ static bool validate_inputs(driver_enumerator &drivlist, int_map &defstr_map, io
     checks
 -------------------------------------------------*/
 
-static bool validate_devices(driver_enumerator &drivlist, const ioport_list &portlist, region_array *rgninfo)
+static bool validate_devices(driver_enumerator &drivlist, const machine_config &config, const ioport_list &portlist, region_array *rgninfo)
 {
 	bool error = false;
 	const game_driver &driver = drivlist.driver();
-	const machine_config &config = drivlist.config();
 
 	for (const device_t *device = config.devicelist().first(); device != NULL; device = device->next())
 	{
@@ -1141,10 +1259,9 @@ static bool validate_devices(driver_enumerator &drivlist, const ioport_list &por
     checks
 -------------------------------------------------*/
 
-static bool validate_slots(driver_enumerator &drivlist)
+static bool validate_slots(driver_enumerator &drivlist, const machine_config &config)
 {
 	bool error = false;
-	const machine_config &config = drivlist.config();
 
 	const device_slot_interface *slot = NULL;
 	for (bool gotone = config.devicelist().first(slot); gotone; gotone = slot->next(slot))
@@ -1186,6 +1303,73 @@ static bool validate_slots(driver_enumerator &drivlist)
 }
 
 
+/*-------------------------------------------------
+    validity_cache_read - read the list of source
+    files that passed under this build; returns
+    an empty list if the file was written by any
+    other build
+-------------------------------------------------*/
+
+static void validity_cache_read(emu_options &options, astring &passed)
+{
+	passed.reset();
+
+	emu_file file(options.cache_directory(), OPEN_FLAG_READ);
+	if (file.open(VALIDITY_CACHE_FILENAME) != FILERR_NONE)
+		return;
+
+	/* the first line identifies the build */
+	astring signature, line;
+	signature.printf("%s %s %s", VALIDITY_CACHE_SIGNATURE, build_version, build_id);
+	char buffer[1024];
+	if (file.gets(buffer, sizeof(buffer)) == NULL || signature != line.cpy(buffer).trimspace())
+		return;
+
+	/* keep the rest with each line newline-terminated, for matching */
+	while (file.gets(buffer, sizeof(buffer)) != NULL)
+	{
+		line.cpy(buffer).trimspace();
+		if (line.len() != 0)
+			passed.cat(line).cat("\n");
+	}
+}
+
+
+/*-------------------------------------------------
+    validity_cache_passed - has the given source
+    file passed before under this build?
+-------------------------------------------------*/
+
+static bool validity_cache_passed(const astring &passed, const char *source_file)
+{
+	astring line(source_file, "\n");
+	for (int start = 0; start < passed.len(); start = passed.chr(start, '\n') + 1)
+		if (strncmp(passed.cstr() + start, line, line.len()) == 0)
+			return true;
+	return false;
+}
+
+
+/*-------------------------------------------------
+    validity_cache_add - remember that a source
+    file passed; instances that race to rewrite
+    the file can lose an entry, which just means
+    checking that file again next time
+-------------------------------------------------*/
+
+static void validity_cache_add(emu_options &options, const char *source_file)
+{
+	astring passed;
+	validity_cache_read(options, passed);
+	if (validity_cache_passed(passed, source_file))
+		return;
+
+	emu_file file(options.cache_directory(), OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS);
+	if (file.open(VALIDITY_CACHE_FILENAME) == FILERR_NONE)
+		file.printf("%s %s %s\n%s%s\n", VALIDITY_CACHE_SIGNATURE, build_version, build_id, passed.cstr(), source_file);
+}
+
+
 /*-------------------------------------------------
     validate_drivers - master validity checker
 -------------------------------------------------*/
@@ -1210,6 +1394,15 @@ void validate_drivers(emu_options &options, const game_driver *curdriver)
 	game_driver_map roms;
 	int_map defstr;
 
+	/* a driver that passed before under this build will pass again */
+	astring passed;
+	if (curdriver != NULL && options.validity_cache())
+	{
+		validity_cache_read(options, passed);
+		if (validity_cache_passed(passed, curdriver->source_file))
+			return;
+	}
+
 	/* basic system checks */
 	a = 0xff;
 	b = a + 1;
@@ -1251,56 +1444,104 @@ void validate_drivers(emu_options &options, const game_driver *curdriver)
 	}
 	prep += get_profile_ticks();
 
-	/* iterate over all drivers */
+	/* gather the drivers to check; non-debug builds only care about games in the same driver */
 	driver_enumerator drivlist(options);
+	int *drivers = global_alloc_array(int, driver_list::total());
+	int drivercount = 0;
 	while (drivlist.next())
+		if (curdriver == NULL || strcmp(curdriver->source_file, drivlist.driver().source_file) == 0)
+			drivers[drivercount++] = drivlist.current();
+
+	/* worker threads build the configurations and input ports for the next batch of drivers
+       while this thread checks the current one; the checks themselves stay here, in driver
+       order, because they share state and their output must come out in the same order */
+	osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	validity_slot *slots = global_alloc_array(validity_slot, 2 * VALIDITY_BATCH);
+	build_batch(queue, options, &slots[0], &drivers[0], MIN(drivercount, VALIDITY_BATCH));
+
+	drivlist.reset();
+	try
 	{
-		const game_driver &driver = drivlist.driver();
-		ioport_list portlist;
-		region_array rgninfo;
+		for (int batchstart = 0; batchstart < drivercount; batchstart += VALIDITY_BATCH)
+		{
+			validity_slot *batch = &slots[((batchstart / VALIDITY_BATCH) & 1) * VALIDITY_BATCH];
+			int batchcount = MIN(drivercount - batchstart, VALIDITY_BATCH);
+
+			/* wait for this batch, then start on the next */
+			prep -= get_profile_ticks();
+			if (queue != NULL)
+				while (!osd_work_queue_wait(queue, osd_ticks_per_second() * 10)) ;
+			prep += get_profile_ticks();
+			int nextstart = batchstart + VALIDITY_BATCH;
+			if (nextstart < drivercount)
+				build_batch(queue, options, &slots[((nextstart / VALIDITY_BATCH) & 1) * VALIDITY_BATCH], &drivers[nextstart], MIN(drivercount - nextstart, VALIDITY_BATCH));
+
+			for (int slotnum = 0; slotnum < batchcount; slotnum++)
+			{
+				validity_slot &slot = batch[slotnum];
+				region_array rgninfo;
 
-		/* non-debug builds only care about games in the same driver */
-		if (curdriver != NULL && strcmp(curdriver->source_file, driver.source_file) != 0)
-			continue;
+				/* step the enumerator to the driver, for the checks that consult it */
+				while (drivlist.next() && drivlist.current() != slot.drvindex) ;
+				const game_driver &driver = drivlist.driver();
 
-		try
-		{
-			/* validate the driver entry */
-			driver_checks -= get_profile_ticks();
-			error = validate_driver(drivlist, names, descriptions) || error;
-			driver_checks += get_profile_ticks();
-
-			/* validate the ROM information */
-			rom_checks -= get_profile_ticks();
-			error = validate_roms(drivlist, &rgninfo, roms) || error;
-			rom_checks += get_profile_ticks();
-
-			/* validate input ports */
-			input_checks -= get_profile_ticks();
-			error = validate_inputs(drivlist, defstr, portlist) || error;
-			input_checks += get_profile_ticks();
-
-			/* validate the display */
-			display_checks -= get_profile_ticks();
-			error = validate_display(drivlist) || error;
-			display_checks += get_profile_ticks();
-
-			/* validate the graphics decoding */
-			gfx_checks -= get_profile_ticks();
-			error = validate_gfx(drivlist, &rgninfo) || error;
-			gfx_checks += get_profile_ticks();
-
-			/* validate devices */
-			device_checks -= get_profile_ticks();
-			error = validate_devices(drivlist, portlist, &rgninfo) || error;
-			error = validate_slots(drivlist) || error;
-			device_checks += get_profile_ticks();
-		}
-		catch (emu_fatalerror &err)
-		{
-			throw emu_fatalerror("Validating %s (%s): %s", driver.name, driver.source_file, err.string());
+				try
+				{
+					/* a configuration that failed to build fails before any checks */
+					if (slot.fatal && !slot.portsfailed)
+						throw emu_fatalerror("%s", slot.fatal.cstr());
+					const machine_config &config = *slot.config;
+
+					/* validate the driver entry */
+					driver_checks -= get_profile_ticks();
+					error = validate_driver(drivlist, config, names, descriptions) || error;
+					driver_checks += get_profile_ticks();
+
+					/* validate the ROM information */
+					rom_checks -= get_profile_ticks();
+					error = validate_roms(drivlist, config, &rgninfo, roms) || error;
+					rom_checks += get_profile_ticks();
+
+					/* validate input ports */
+					if (slot.fatal)
+						throw emu_fatalerror("%s", slot.fatal.cstr());
+					input_checks -= get_profile_ticks();
+					error = validate_inputs(drivlist, defstr, slot) || error;
+					input_checks += get_profile_ticks();
+
+					/* validate the display */
+					display_checks -= get_profile_ticks();
+					error = validate_display(drivlist, config) || error;
+					display_checks += get_profile_ticks();
+
+					/* validate the graphics decoding */
+					gfx_checks -= get_profile_ticks();
+					error = validate_gfx(drivlist, config, &rgninfo) || error;
+					gfx_checks += get_profile_ticks();
+
+					/* validate devices */
+					device_checks -= get_profile_ticks();
+					error = validate_devices(drivlist, config, slot.portlist, &rgninfo) || error;
+					error = validate_slots(drivlist, config) || error;
+					device_checks += get_profile_ticks();
+				}
+				catch (emu_fatalerror &err)
+				{
+					throw emu_fatalerror("Validating %s (%s): %s", driver.name, driver.source_file, err.string());
+				}
+				release_driver(slot);
+			}
 		}
 	}
+	catch (emu_fatalerror &)
+	{
+		/* let the workers finish before their slots go away */
+		if (queue != NULL)
+			while (!osd_work_queue_wait(queue, osd_ticks_per_second() * 10)) ;
+		validity_cleanup(queue, slots, drivers);
+		throw;
+	}
+	validity_cleanup(queue, slots, drivers);
 
 #if (REPORT_TIMES)
 	mame_printf_info("Prep:      %8dm\n", (int)(prep / 1000000));
@@ -1315,4 +1556,8 @@ void validate_drivers(emu_options &options, const game_driver *curdriver)
 	// on a general error, throw rather than return
 	if (error)
 		throw emu_fatalerror(MAMERR_FAILED_VALIDITY, "Validity checks failed");
+
+	// remember the success for next time
+	if (curdriver != NULL && options.validity_cache())
+		validity_cache_add(options, curdriver->source_file);
 }
@@ -86,6 +86,11 @@
 
 #define NO_MATCH					(~0)
 
+#define HUNK_CACHE_ENTRIES			16			/* decompressed hunks kept by a read-only CHD */
+#define HUNK_PREFETCH_DEPTH			4			/* hunks decompressed ahead of a sequential reader */
+#define HUNK_VERIFY_DEPTH			12			/* hunks decompressed ahead during verification */
+#define COMPRESS_SLOTS				32			/* hunks compressed in parallel */
+
 
 
 /***************************************************************************
@@ -148,6 +153,40 @@ struct _metadata_entry
 };
 
 
+/* a decompressed hunk held by a read-only CHD */
+typedef struct _hunk_cache_entry hunk_cache_entry;
+struct _hunk_cache_entry
+{
+	chd_file *				chd;			/* CHD we belong to */
+	UINT32					hunknum;		/* hunk held, or ~0 if none */
+	UINT32					lastuse;		/* LRU stamp */
+	UINT8 *					data;			/* decompressed data */
+	UINT8 *					compressed;		/* compressed data, when prefetching */
+	z_stream				inflater;		/* private inflater, when prefetching */
+	UINT8					inflaterinit;	/* has the inflater been initialized? */
+	UINT8					prefetched;		/* filled ahead of time and not yet read? */
+	osd_work_item *			item;			/* prefetch in flight, or NULL if none */
+	chd_error				err;			/* result of the prefetch */
+};
+
+
+/* a hunk being compressed on a worker thread */
+typedef struct _compress_slot compress_slot;
+struct _compress_slot
+{
+	chd_file *				chd;			/* CHD we belong to */
+	UINT32					hunknum;		/* hunk being compressed */
+	UINT8 *					data;			/* copy of the raw data */
+	UINT8 *					compressed;		/* compressed result */
+	z_stream				deflater;		/* private deflater */
+	UINT8					deflaterinit;	/* has the deflater been initialized? */
+	UINT32					crc;			/* CRC of the raw data */
+	UINT32					length;			/* length of the compressed result */
+	chd_error				err;			/* CHDERR_NONE if the data compressed */
+	osd_work_item *			item;			/* work item in flight, or NULL if none */
+};
+
+
 /* internal representation of an open CHD file */
 struct _chd_file
 {
@@ -181,6 +220,10 @@ struct _chd_file
 	struct MD5Context		compmd5;		/* running MD5 during compression */
 	struct sha1_ctx			compsha1;		/* running SHA1 during compression */
 	UINT32					comphunk;		/* next hunk we will compress */
+	compress_slot *			compslot;		/* hunks being compressed in parallel, or NULL */
+	UINT32					compnext;		/* slot holding the oldest pending hunk */
+	UINT32					comppending;	/* number of hunks not yet written */
+	osd_work_queue *		compqueue;		/* queue for parallel compression */
 
 	UINT8					verifying;		/* are we verifying? */
 	struct MD5Context		vermd5; 		/* running MD5 during verification */
@@ -191,6 +234,14 @@ struct _chd_file
 	osd_work_item *			workitem;		/* active work item, or NULL if none */
 	UINT32					async_hunknum;	/* hunk index for asynchronous operations */
 	void *					async_buffer;	/* buffer pointer for asynchronous operations */
+
+	hunk_cache_entry *		hunkcache;		/* decompressed hunks, or NULL if not cached */
+	UINT32					hunkclock;		/* LRU clock for the hunk cache */
+	UINT32					lastread;		/* last hunk read through the cache */
+	UINT32					prefetchdepth;	/* hunks to decompress ahead */
+	osd_work_queue *		prefetchqueue;	/* queue for decompressing ahead */
+	osd_lock *				filelock;		/* serializes file access while prefetching */
+	chd_cache_stats			stats;			/* hunk cache statistics */
 };
 
 
@@ -249,7 +300,23 @@ static chd_error header_write(core_file *file, const chd_header *header);
 /* internal hunk read/write */
 static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum);
 static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest);
-static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src);
+static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src, const compress_slot *slot);
+
+/* internal hunk cache */
+static chd_error hunk_cache_init(chd_file *chd);
+static void hunk_cache_free(chd_file *chd);
+static void hunk_cache_wait(chd_file *chd);
+static chd_error hunk_cache_read(chd_file *chd, UINT32 hunknum, UINT8 *dest);
+static void hunk_cache_prefetch(chd_file *chd, UINT32 hunknum);
+static void *hunk_prefetch_callback(void *param, int threadid);
+
+/* internal parallel compression */
+static void compress_pipeline_init(chd_file *chd);
+static void compress_pipeline_free(chd_file *chd);
+static chd_error compress_pipeline_flush(chd_file *chd);
+static chd_error compress_commit_oldest(chd_file *chd);
+static chd_error compress_commit_hunk(chd_file *chd, UINT32 hunknum, const UINT8 *data, const compress_slot *slot);
+static void *compress_slot_callback(void *param, int threadid);
 
 /* internal map access */
 static chd_error map_write_initial(core_file *file, chd_file *parent, const chd_header *header);
@@ -518,6 +585,43 @@ INLINE void wait_for_pending_async(chd_file *chd)
 }
 
 
+/*-------------------------------------------------
+    lock_file/unlock_file - serialize access to
+    the file against prefetching threads
+-------------------------------------------------*/
+
+INLINE void lock_file(chd_file *chd)
+{
+	if (chd->filelock != NULL)
+		osd_lock_acquire(chd->filelock);
+}
+
+INLINE void unlock_file(chd_file *chd)
+{
+	if (chd->filelock != NULL)
+		osd_lock_release(chd->filelock);
+}
+
+
+/*-------------------------------------------------
+    wait_for_compress_slot - wait for a hunk to
+    finish compressing on its worker
+-------------------------------------------------*/
+
+INLINE void wait_for_compress_slot(compress_slot *slot)
+{
+	if (slot->item != NULL)
+	{
+		/* 10 seconds should be enough for anything! */
+		int wait_successful = osd_work_item_wait(slot->item, 10 * osd_ticks_per_second());
+		if (!wait_successful)
+			osd_break_into_debugger("Pending compression never completed!");
+		osd_work_item_release(slot->item);
+		slot->item = NULL;
+	}
+}
+
+
 
 /***************************************************************************
     CHD FILE MANAGEMENT
@@ -716,6 +820,14 @@ chd_error chd_open_file(core_file *file, int mode, chd_file *parent, chd_file **
 	if (err != CHDERR_NONE)
 		EARLY_EXIT(err);
 
+	/* read-only files get a cache of decompressed hunks */
+	if (mode == CHD_OPEN_READ)
+	{
+		err = hunk_cache_init(newchd);
+		if (err != CHDERR_NONE)
+			EARLY_EXIT(err);
+	}
+
 	/* all done */
 	*chd = newchd;
 	return CHDERR_NONE;
@@ -826,6 +938,12 @@ void chd_close(chd_file *chd)
 	if (chd->workqueue != NULL)
 		osd_work_queue_free(chd->workqueue);
 
+	/* stop prefetching and free the hunk cache */
+	hunk_cache_free(chd);
+
+	/* abandon any compression in progress */
+	compress_pipeline_free(chd);
+
 	/* deinit the codec */
 	if (chd->codecintf != NULL && chd->codecintf->free != NULL)
 		(*chd->codecintf->free)(chd);
@@ -1036,6 +1154,10 @@ chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 	/* wait for any pending async operations */
 	wait_for_pending_async(chd);
 
+	/* read through the hunk cache if we have one */
+	if (chd->hunkcache != NULL && buffer != NULL)
+		return hunk_cache_read(chd, hunknum, (UINT8 *)buffer);
+
 	/* perform the read */
 	return hunk_read_into_memory(chd, hunknum, (UINT8 *)buffer);
 }
@@ -1072,6 +1194,26 @@ chd_error chd_read_async(chd_file *chd, UINT32 hunknum, void *buffer)
 }
 
 
+/*-------------------------------------------------
+    chd_get_cache_stats - return statistics about
+    the decompressed hunk cache
+-------------------------------------------------*/
+
+chd_error chd_get_cache_stats(chd_file *chd, chd_cache_stats *stats)
+{
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE)
+		return CHDERR_INVALID_PARAMETER;
+
+	/* only read-only files have a cache */
+	if (chd->hunkcache == NULL)
+		return CHDERR_NOT_SUPPORTED;
+
+	*stats = chd->stats;
+	return CHDERR_NONE;
+}
+
+
 /*-------------------------------------------------
     chd_write - write a single hunk to the CHD
     file
@@ -1091,7 +1233,7 @@ chd_error chd_write(chd_file *chd, UINT32 hunknum, const void *buffer)
 	wait_for_pending_async(chd);
 
 	/* then write out the hunk */
-	return hunk_write_from_memory(chd, hunknum, (const UINT8 *)buffer);
+	return hunk_write_from_memory(chd, hunknum, (const UINT8 *)buffer, NULL);
 }
 
 
@@ -1412,6 +1554,9 @@ chd_error chd_compress_begin(chd_file *chd)
 	chd->compressing = TRUE;
 	chd->comphunk = 0;
 
+	/* spread the compression across all processors if we can */
+	compress_pipeline_init(chd);
+
 	return CHDERR_NONE;
 }
 
@@ -1424,49 +1569,50 @@ chd_error chd_compress_begin(chd_file *chd)
 chd_error chd_compress_hunk(chd_file *chd, const void *data, double *curratio)
 {
 	UINT32 thishunk = chd->comphunk++;
-	UINT64 sourceoffset = (UINT64)thishunk * (UINT64)chd->header.hunkbytes;
-	UINT32 bytestochecksum;
-	const void *crcdata;
 	chd_error err;
 
 	/* error if in the wrong state */
 	if (!chd->compressing)
 		return CHDERR_INVALID_STATE;
 
-	/* write out the hunk */
-	err = hunk_write_from_memory(chd, thishunk, (const UINT8 *)data);
-	if (err != CHDERR_NONE)
-		return err;
+	/* hand the hunk to a worker if we can */
+	if (chd->compslot != NULL && data != NULL)
+	{
+		compress_slot *slot;
 
-	/* if we are lossy, then we need to use the decompressed version in */
-	/* the cache as our MD5/SHA1 source */
-	crcdata = (chd->codecintf->lossy || data == NULL) ? chd->cache : data;
+		/* if every slot is busy, write out the oldest to make room */
+		if (chd->comppending == COMPRESS_SLOTS)
+		{
+			err = compress_commit_oldest(chd);
+			if (err != CHDERR_NONE)
+				return err;
+		}
 
-	/* update the MD5/SHA1 */
-	bytestochecksum = chd->header.hunkbytes;
-	if (sourceoffset + chd->header.hunkbytes > chd->header.logicalbytes)
-	{
-		if (sourceoffset >= chd->header.logicalbytes)
-			bytestochecksum = 0;
-		else
-			bytestochecksum = chd->header.logicalbytes - sourceoffset;
+		/* queue this one behind the others; hunks are always written in order */
+		slot = &chd->compslot[(chd->compnext + chd->comppending) % COMPRESS_SLOTS];
+		slot->hunknum = thishunk;
+		memcpy(slot->data, data, chd->header.hunkbytes);
+		slot->item = osd_work_item_queue(chd->compqueue, compress_slot_callback, slot, 0);
+		if (slot->item == NULL)
+			compress_slot_callback(slot, 0);
+		chd->comppending++;
 	}
-	if (bytestochecksum > 0)
+
+	/* otherwise, write out anything pending and then this hunk */
+	else
 	{
-		MD5Update(&chd->compmd5, (const unsigned char *)crcdata, bytestochecksum);
-		sha1_update(&chd->compsha1, bytestochecksum, (const UINT8 *)crcdata);
+		err = compress_pipeline_flush(chd);
+		if (err == CHDERR_NONE)
+			err = compress_commit_hunk(chd, thishunk, (const UINT8 *)data, NULL);
+		if (err != CHDERR_NONE)
+			return err;
 	}
 
-	/* update our CRC map */
-	if ((chd->map[thishunk].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
-		(chd->map[thishunk].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
-		crcmap_add_entry(chd, thishunk);
-
 	/* update the ratio */
-	if (curratio != NULL)
+	if (curratio != NULL && chd->comphunk > chd->comppending)
 	{
 		UINT64 curlength = core_fsize(chd->file);
-		*curratio = 1.0 - (double)curlength / (double)((UINT64)chd->comphunk * (UINT64)chd->header.hunkbytes);
+		*curratio = 1.0 - (double)curlength / (double)((UINT64)(chd->comphunk - chd->comppending) * (UINT64)chd->header.hunkbytes);
 	}
 
 	return CHDERR_NONE;
@@ -1480,10 +1626,18 @@ chd_error chd_compress_hunk(chd_file *chd, const void *data, double *curratio)
 
 chd_error chd_compress_finish(chd_file *chd, int write_protect)
 {
+	chd_error err;
+
 	/* error if in the wrong state */
 	if (!chd->compressing)
 		return CHDERR_INVALID_STATE;
 
+	/* write out everything still being compressed */
+	err = compress_pipeline_flush(chd);
+	compress_pipeline_free(chd);
+	if (err != CHDERR_NONE)
+		return err;
+
 	/* compute the final MD5/SHA1 values */
 	MD5Final(chd->header.md5, &chd->compmd5);
 	sha1_final(&chd->compsha1);
@@ -1527,6 +1681,9 @@ chd_error chd_verify_begin(chd_file *chd)
 	chd->verifying = TRUE;
 	chd->verhunk = 0;
 
+	/* decompress further ahead, since we read every hunk in order */
+	chd->prefetchdepth = HUNK_VERIFY_DEPTH;
+
 	return CHDERR_NONE;
 }
 
@@ -1547,8 +1704,16 @@ chd_error chd_verify_hunk(chd_file *chd)
 	if (!chd->verifying)
 		return CHDERR_INVALID_STATE;
 
-	/* read the hunk into the cache */
-	err = hunk_read_into_cache(chd, thishunk);
+	/* read the hunk into the cache, letting the workers decompress ahead */
+	if (chd->hunkcache != NULL)
+	{
+		chd->cachehunk = ~0;
+		err = hunk_cache_read(chd, thishunk, chd->cache);
+		if (err == CHDERR_NONE)
+			chd->cachehunk = thishunk;
+	}
+	else
+		err = hunk_read_into_cache(chd, thishunk);
 	if (err != CHDERR_NONE)
 		return err;
 
@@ -1595,6 +1760,7 @@ chd_error chd_verify_finish(chd_file *chd, chd_verify_result *result)
 
 	/* return an error */
 	chd->verifying = FALSE;
+	chd->prefetchdepth = HUNK_PREFETCH_DEPTH;
 	return (chd->verhunk < chd->header.totalhunks) ? CHDERR_VERIFY_INCOMPLETE : CHDERR_NONE;
 }
 
@@ -1674,7 +1840,7 @@ static void *async_write_callback(void *param, int threadid)
 	chd_error err;
 
 	/* write the hunk from memory */
-	err = hunk_write_from_memory(chd, chd->async_hunknum, (const UINT8 *)chd->async_buffer);
+	err = hunk_write_from_memory(chd, chd->async_hunknum, (const UINT8 *)chd->async_buffer, NULL);
 
 	/* return the error */
 	return (void *)err;
@@ -1943,8 +2109,10 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 		case MAP_ENTRY_TYPE_COMPRESSED:
 
 			/* read it into the decompression buffer */
+			lock_file(chd);
 			core_fseek(chd->file, entry->offset, SEEK_SET);
 			bytes = core_fread(chd->file, chd->compressed, entry->length);
+			unlock_file(chd);
 			if (bytes != entry->length)
 				return CHDERR_READ_ERROR;
 
@@ -1958,8 +2126,10 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 
 		/* uncompressed data */
 		case MAP_ENTRY_TYPE_UNCOMPRESSED:
+			lock_file(chd);
 			core_fseek(chd->file, entry->offset, SEEK_SET);
 			bytes = core_fread(chd->file, dest, chd->header.hunkbytes);
+			unlock_file(chd);
 			if (bytes != chd->header.hunkbytes)
 				return CHDERR_READ_ERROR;
 			break;
@@ -1990,10 +2160,12 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 
 /*-------------------------------------------------
     hunk_write_from_memory - write a hunk from
-    memory into a CHD
+    memory into a CHD; if a compress slot is
+    given, its CRC and compressed data are used
+    instead of computing them here
 -------------------------------------------------*/
 
-static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src)
+static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src, const compress_slot *slot)
 {
 	map_entry *entry = &chd->map[hunknum];
 	map_entry newentry;
@@ -2008,7 +2180,9 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 
 	/* first compute the CRC of the original data */
 	newentry.crc = 0;
-	if (src != NULL)
+	if (slot != NULL)
+		newentry.crc = slot->crc;
+	else if (src != NULL)
 		newentry.crc = crc32(0, &src[0], chd->header.hunkbytes);
 
 	/* if we're not a lossy codec, compute the CRC and look for matches */
@@ -2056,9 +2230,14 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 		}
 	}
 
-	/* now try compressing the data */
+	/* now try compressing the data, unless a worker already has */
 	err = CHDERR_COMPRESSION_ERROR;
-	if (chd->codecintf->compress != NULL)
+	if (slot != NULL)
+	{
+		err = slot->err;
+		bytes = slot->length;
+	}
+	else if (chd->codecintf->compress != NULL)
 		err = (*chd->codecintf->compress)(chd, src, &bytes);
 
 	/* if that worked, and we're lossy, decompress and CRC the result */
@@ -2072,7 +2251,7 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 	/* if we succeeded in compressing the data, replace our data pointer and mark it so */
 	if (err == CHDERR_NONE)
 	{
-		data = chd->compressed;
+		data = (slot != NULL) ? slot->compressed : chd->compressed;
 		newentry.length = bytes;
 		newentry.flags = MAP_ENTRY_TYPE_COMPRESSED;
 	}
@@ -2111,6 +2290,543 @@ write_entry:
 
 
 
+/***************************************************************************
+    INTERNAL HUNK CACHE
+***************************************************************************/
+
+/*-------------------------------------------------
+    hunk_cache_complete - wait for a prefetch to
+    finish and discard it if it failed
+-------------------------------------------------*/
+
+INLINE void hunk_cache_complete(hunk_cache_entry *entry)
+{
+	/* 10 seconds should be enough for anything! */
+	int wait_successful = osd_work_item_wait(entry->item, 10 * osd_ticks_per_second());
+	if (!wait_successful)
+		osd_break_into_debugger("Pending prefetch never completed!");
+	osd_work_item_release(entry->item);
+	entry->item = NULL;
+
+	/* a failed prefetch is simply read again synchronously */
+	if (entry->err != CHDERR_NONE)
+	{
+		entry->hunknum = ~0;
+		entry->prefetched = FALSE;
+	}
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_init - allocate the decompressed
+    hunk cache for a read-only CHD
+-------------------------------------------------*/
+
+static chd_error hunk_cache_init(chd_file *chd)
+{
+	int entnum;
+
+	/* A/V files are read through chd_read_async and their own codec state */
+	if (chd->header.compression != CHDCOMPRESSION_NONE &&
+		chd->header.compression != CHDCOMPRESSION_ZLIB &&
+		chd->header.compression != CHDCOMPRESSION_ZLIB_PLUS)
+		return CHDERR_NONE;
+
+	/* allocate the entries */
+	chd->hunkcache = (hunk_cache_entry *)malloc(sizeof(chd->hunkcache[0]) * HUNK_CACHE_ENTRIES);
+	if (chd->hunkcache == NULL)
+		return CHDERR_OUT_OF_MEMORY;
+	memset(chd->hunkcache, 0, sizeof(chd->hunkcache[0]) * HUNK_CACHE_ENTRIES);
+	chd->lastread = ~0;
+	chd->prefetchdepth = HUNK_PREFETCH_DEPTH;
+
+	/* each entry has its own buffers so that prefetches can run in parallel */
+	for (entnum = 0; entnum < HUNK_CACHE_ENTRIES; entnum++)
+	{
+		hunk_cache_entry *entry = &chd->hunkcache[entnum];
+		entry->chd = chd;
+		entry->hunknum = ~0;
+		entry->data = (UINT8 *)malloc(chd->header.hunkbytes);
+		entry->compressed = (UINT8 *)malloc(chd->header.hunkbytes);
+		if (entry->data == NULL || entry->compressed == NULL)
+			return CHDERR_OUT_OF_MEMORY;
+	}
+
+	/* without a lock and a queue we still cache, but don't prefetch */
+	chd->filelock = osd_lock_alloc();
+	if (chd->filelock != NULL)
+		chd->prefetchqueue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	if (chd->prefetchqueue == NULL && chd->filelock != NULL)
+	{
+		osd_lock_free(chd->filelock);
+		chd->filelock = NULL;
+	}
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_free - stop prefetching and free
+    the decompressed hunk cache
+-------------------------------------------------*/
+
+static void hunk_cache_free(chd_file *chd)
+{
+	int entnum;
+
+	if (chd->hunkcache == NULL)
+		return;
+
+	/* let any prefetches finish before freeing what they use */
+	hunk_cache_wait(chd);
+	if (chd->prefetchqueue != NULL)
+		osd_work_queue_free(chd->prefetchqueue);
+	if (chd->filelock != NULL)
+		osd_lock_free(chd->filelock);
+	chd->prefetchqueue = NULL;
+	chd->filelock = NULL;
+
+	/* free the entries */
+	for (entnum = 0; entnum < HUNK_CACHE_ENTRIES; entnum++)
+	{
+		hunk_cache_entry *entry = &chd->hunkcache[entnum];
+		if (entry->inflaterinit)
+			inflateEnd(&entry->inflater);
+		if (entry->compressed != NULL)
+			free(entry->compressed);
+		if (entry->data != NULL)
+			free(entry->data);
+	}
+	free(chd->hunkcache);
+	chd->hunkcache = NULL;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_wait - wait for all outstanding
+    prefetches to complete
+-------------------------------------------------*/
+
+static void hunk_cache_wait(chd_file *chd)
+{
+	int entnum;
+
+	if (chd->hunkcache == NULL)
+		return;
+
+	for (entnum = 0; entnum < HUNK_CACHE_ENTRIES; entnum++)
+		if (chd->hunkcache[entnum].item != NULL)
+			hunk_cache_complete(&chd->hunkcache[entnum]);
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_read - read a hunk through the
+    decompressed hunk cache, prefetching ahead of
+    sequential readers
+-------------------------------------------------*/
+
+static chd_error hunk_cache_read(chd_file *chd, UINT32 hunknum, UINT8 *dest)
+{
+	hunk_cache_entry *found = NULL;
+	hunk_cache_entry *victim = NULL;
+	osd_ticks_t start;
+	chd_error err;
+	int entnum;
+
+	/* return an error if out of range */
+	if (hunknum >= chd->header.totalhunks)
+		return CHDERR_HUNK_OUT_OF_RANGE;
+	chd->stats.reads++;
+
+	/* look for the hunk, remembering the least recently used idle entry */
+	for (entnum = 0; entnum < HUNK_CACHE_ENTRIES; entnum++)
+	{
+		hunk_cache_entry *entry = &chd->hunkcache[entnum];
+		if (entry->hunknum == hunknum)
+			found = entry;
+		else if (entry->item == NULL && (victim == NULL || entry->lastuse < victim->lastuse))
+			victim = entry;
+	}
+
+	/* if it's still being prefetched, wait for it */
+	if (found != NULL && found->item != NULL)
+	{
+		start = osd_ticks();
+		hunk_cache_complete(found);
+		chd->stats.stallticks += osd_ticks() - start;
+		if (found->hunknum != hunknum)
+		{
+			victim = found;
+			found = NULL;
+		}
+	}
+
+	/* on a hit, note whether prefetching paid off */
+	if (found != NULL)
+	{
+		chd->stats.hits++;
+		if (found->prefetched)
+			chd->stats.prefetchhits++;
+	}
+
+	/* on a miss, read it ourselves */
+	else
+	{
+		/* every entry can only be busy if prefetching outran the cache */
+		if (victim == NULL)
+		{
+			victim = &chd->hunkcache[0];
+			hunk_cache_complete(victim);
+		}
+
+		victim->hunknum = ~0;
+		start = osd_ticks();
+		err = hunk_read_into_memory(chd, hunknum, victim->data);
+		chd->stats.stallticks += osd_ticks() - start;
+		if (err != CHDERR_NONE)
+			return err;
+		victim->hunknum = hunknum;
+		found = victim;
+	}
+
+	/* hand back the data */
+	found->prefetched = FALSE;
+	found->lastuse = ++chd->hunkclock;
+	memcpy(dest, found->data, chd->header.hunkbytes);
+
+	/* a sequential reader gets the next few hunks decompressed ahead */
+	if (hunknum == chd->lastread + 1)
+	{
+		UINT32 ahead;
+		for (ahead = 1; ahead <= chd->prefetchdepth; ahead++)
+			hunk_cache_prefetch(chd, hunknum + ahead);
+	}
+	chd->lastread = hunknum;
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_prefetch - start decompressing a
+    hunk on a worker thread
+-------------------------------------------------*/
+
+static void hunk_cache_prefetch(chd_file *chd, UINT32 hunknum)
+{
+	hunk_cache_entry *victim = NULL;
+	UINT32 type;
+	int entnum;
+
+	/* only hunks stored in this file are worth handing off */
+	if (chd->prefetchqueue == NULL || hunknum >= chd->header.totalhunks)
+		return;
+	type = chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK;
+	if (type != MAP_ENTRY_TYPE_COMPRESSED && type != MAP_ENTRY_TYPE_UNCOMPRESSED)
+		return;
+
+	/* skip it if we already have it; otherwise pick an idle entry */
+	for (entnum = 0; entnum < HUNK_CACHE_ENTRIES; entnum++)
+	{
+		hunk_cache_entry *entry = &chd->hunkcache[entnum];
+		if (entry->hunknum == hunknum)
+			return;
+		if (entry->item == NULL && (victim == NULL || entry->lastuse < victim->lastuse))
+			victim = entry;
+	}
+	if (victim == NULL)
+		return;
+
+	/* queue it */
+	victim->hunknum = hunknum;
+	victim->prefetched = TRUE;
+	victim->lastuse = ++chd->hunkclock;
+	victim->err = CHDERR_NONE;
+	victim->item = osd_work_item_queue(chd->prefetchqueue, hunk_prefetch_callback, victim, 0);
+	if (victim->item == NULL)
+	{
+		victim->hunknum = ~0;
+		victim->prefetched = FALSE;
+		return;
+	}
+	chd->stats.prefetches++;
+}
+
+
+/*-------------------------------------------------
+    hunk_prefetch_callback - read and decompress
+    a hunk into a cache entry; file access is
+    serialized, decompression is not
+-------------------------------------------------*/
+
+static void *hunk_prefetch_callback(void *param, int threadid)
+{
+	hunk_cache_entry *entry = (hunk_cache_entry *)param;
+	chd_file *chd = entry->chd;
+	map_entry *mapentry = &chd->map[entry->hunknum];
+	UINT32 bytes;
+	int zerr;
+
+	/* uncompressed data goes straight into the entry */
+	if ((mapentry->flags & MAP_ENTRY_FLAG_TYPE_MASK) == MAP_ENTRY_TYPE_UNCOMPRESSED)
+	{
+		lock_file(chd);
+		core_fseek(chd->file, mapentry->offset, SEEK_SET);
+		bytes = core_fread(chd->file, entry->data, chd->header.hunkbytes);
+		unlock_file(chd);
+		if (bytes != chd->header.hunkbytes)
+			entry->err = CHDERR_READ_ERROR;
+		return NULL;
+	}
+
+	/* read the compressed data */
+	lock_file(chd);
+	core_fseek(chd->file, mapentry->offset, SEEK_SET);
+	bytes = core_fread(chd->file, entry->compressed, mapentry->length);
+	unlock_file(chd);
+	if (bytes != mapentry->length)
+	{
+		entry->err = CHDERR_READ_ERROR;
+		return NULL;
+	}
+
+	/* set up our private inflater the first time through */
+	if (!entry->inflaterinit)
+	{
+		memset(&entry->inflater, 0, sizeof(entry->inflater));
+		if (inflateInit2(&entry->inflater, -MAX_WBITS) != Z_OK)
+		{
+			entry->err = CHDERR_CODEC_ERROR;
+			return NULL;
+		}
+		entry->inflaterinit = TRUE;
+	}
+
+	/* decompress exactly as zlib_codec_decompress does */
+	entry->inflater.next_in = entry->compressed;
+	entry->inflater.avail_in = mapentry->length;
+	entry->inflater.total_in = 0;
+	entry->inflater.next_out = entry->data;
+	entry->inflater.avail_out = chd->header.hunkbytes;
+	entry->inflater.total_out = 0;
+	zerr = inflateReset(&entry->inflater);
+	if (zerr == Z_OK)
+		inflate(&entry->inflater, Z_FINISH);
+	if (zerr != Z_OK || entry->inflater.total_out != chd->header.hunkbytes)
+		entry->err = CHDERR_DECOMPRESSION_ERROR;
+	return NULL;
+}
+
+
+
+/***************************************************************************
+    INTERNAL PARALLEL COMPRESSION
+***************************************************************************/
+
+/*-------------------------------------------------
+    compress_pipeline_init - set up parallel
+    compression; if anything fails, hunks are
+    simply compressed one at a time
+-------------------------------------------------*/
+
+static void compress_pipeline_init(chd_file *chd)
+{
+	int slotnum;
+
+	/* only lossless zlib compression is spread across workers */
+	if (chd->header.compression != CHDCOMPRESSION_ZLIB && chd->header.compression != CHDCOMPRESSION_ZLIB_PLUS)
+		return;
+
+	/* allocate the slots */
+	chd->compslot = (compress_slot *)malloc(sizeof(chd->compslot[0]) * COMPRESS_SLOTS);
+	if (chd->compslot == NULL)
+		return;
+	memset(chd->compslot, 0, sizeof(chd->compslot[0]) * COMPRESS_SLOTS);
+	chd->compnext = 0;
+	chd->comppending = 0;
+
+	for (slotnum = 0; slotnum < COMPRESS_SLOTS; slotnum++)
+	{
+		compress_slot *slot = &chd->compslot[slotnum];
+		slot->chd = chd;
+		slot->data = (UINT8 *)malloc(chd->header.hunkbytes);
+		slot->compressed = (UINT8 *)malloc(chd->header.hunkbytes);
+		if (slot->data == NULL || slot->compressed == NULL)
+		{
+			compress_pipeline_free(chd);
+			return;
+		}
+	}
+
+	/* allocate the queue */
+	chd->compqueue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	if (chd->compqueue == NULL)
+		compress_pipeline_free(chd);
+}
+
+
+/*-------------------------------------------------
+    compress_pipeline_free - free everything used
+    for parallel compression; pending hunks that
+    were not flushed are discarded
+-------------------------------------------------*/
+
+static void compress_pipeline_free(chd_file *chd)
+{
+	int slotnum;
+
+	if (chd->compslot == NULL)
+		return;
+
+	/* let the workers finish before freeing what they use */
+	for (slotnum = 0; slotnum < COMPRESS_SLOTS; slotnum++)
+		wait_for_compress_slot(&chd->compslot[slotnum]);
+	if (chd->compqueue != NULL)
+		osd_work_queue_free(chd->compqueue);
+	chd->compqueue = NULL;
+
+	/* free the slots */
+	for (slotnum = 0; slotnum < COMPRESS_SLOTS; slotnum++)
+	{
+		compress_slot *slot = &chd->compslot[slotnum];
+		if (slot->deflaterinit)
+			deflateEnd(&slot->deflater);
+		if (slot->compressed != NULL)
+			free(slot->compressed);
+		if (slot->data != NULL)
+			free(slot->data);
+	}
+	free(chd->compslot);
+	chd->compslot = NULL;
+	chd->comppending = 0;
+}
+
+
+/*-------------------------------------------------
+    compress_pipeline_flush - write out every hunk
+    still being compressed, in order
+-------------------------------------------------*/
+
+static chd_error compress_pipeline_flush(chd_file *chd)
+{
+	while (chd->comppending > 0)
+	{
+		chd_error err = compress_commit_oldest(chd);
+		if (err != CHDERR_NONE)
+			return err;
+	}
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    compress_commit_oldest - wait for the oldest
+    pending hunk and write it out
+-------------------------------------------------*/
+
+static chd_error compress_commit_oldest(chd_file *chd)
+{
+	compress_slot *slot = &chd->compslot[chd->compnext];
+
+	wait_for_compress_slot(slot);
+	chd->compnext = (chd->compnext + 1) % COMPRESS_SLOTS;
+	chd->comppending--;
+	return compress_commit_hunk(chd, slot->hunknum, slot->data, slot);
+}
+
+
+/*-------------------------------------------------
+    compress_commit_hunk - write a hunk and fold
+    it into the running MD5/SHA1 and CRC map;
+    this must happen in hunk order
+-------------------------------------------------*/
+
+static chd_error compress_commit_hunk(chd_file *chd, UINT32 hunknum, const UINT8 *data, const compress_slot *slot)
+{
+	UINT64 sourceoffset = (UINT64)hunknum * (UINT64)chd->header.hunkbytes;
+	UINT32 bytestochecksum;
+	const void *crcdata;
+	chd_error err;
+
+	/* write out the hunk */
+	err = hunk_write_from_memory(chd, hunknum, data, slot);
+	if (err != CHDERR_NONE)
+		return err;
+
+	/* if we are lossy, then we need to use the decompressed version in */
+	/* the cache as our MD5/SHA1 source */
+	crcdata = (chd->codecintf->lossy || data == NULL) ? chd->cache : data;
+
+	/* update the MD5/SHA1 */
+	bytestochecksum = chd->header.hunkbytes;
+	if (sourceoffset + chd->header.hunkbytes > chd->header.logicalbytes)
+	{
+		if (sourceoffset >= chd->header.logicalbytes)
+			bytestochecksum = 0;
+		else
+			bytestochecksum = chd->header.logicalbytes - sourceoffset;
+	}
+	if (bytestochecksum > 0)
+	{
+		MD5Update(&chd->compmd5, (const unsigned char *)crcdata, bytestochecksum);
+		sha1_update(&chd->compsha1, bytestochecksum, (const UINT8 *)crcdata);
+	}
+
+	/* update our CRC map */
+	if ((chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
+		(chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
+		crcmap_add_entry(chd, hunknum);
+
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    compress_slot_callback - CRC and deflate a
+    hunk on a worker thread; matching against
+    earlier hunks is left to the writer
+-------------------------------------------------*/
+
+static void *compress_slot_callback(void *param, int threadid)
+{
+	compress_slot *slot = (compress_slot *)param;
+	chd_file *chd = slot->chd;
+	int zerr;
+
+	slot->crc = crc32(0, slot->data, chd->header.hunkbytes);
+	slot->err = CHDERR_COMPRESSION_ERROR;
+
+	/* set up our private deflater the first time through */
+	if (!slot->deflaterinit)
+	{
+		memset(&slot->deflater, 0, sizeof(slot->deflater));
+		if (deflateInit2(&slot->deflater, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			return NULL;
+		slot->deflaterinit = TRUE;
+	}
+
+	/* compress exactly as zlib_codec_compress does */
+	slot->deflater.next_in = slot->data;
+	slot->deflater.avail_in = chd->header.hunkbytes;
+	slot->deflater.total_in = 0;
+	slot->deflater.next_out = slot->compressed;
+	slot->deflater.avail_out = chd->header.hunkbytes;
+	slot->deflater.total_out = 0;
+	if (deflateReset(&slot->deflater) != Z_OK)
+		return NULL;
+	zerr = deflate(&slot->deflater, Z_FINISH);
+
+	/* if we ended up with more data than we started with, store it uncompressed */
+	if (zerr != Z_STREAM_END || slot->deflater.total_out >= chd->header.hunkbytes)
+		return NULL;
+
+	slot->length = slot->deflater.total_out;
+	slot->err = CHDERR_NONE;
+	return NULL;
+}
+
+
+
 /***************************************************************************
     INTERNAL MAP ACCESS
 ***************************************************************************/
@@ -2416,6 +3132,9 @@ static UINT32 crcmap_find_hunk(chd_file *chd, UINT32 hunknum, UINT32 crc, const
 
 static chd_error metadata_find_entry(chd_file *chd, UINT32 metatag, UINT32 metaindex, metadata_entry *metaentry)
 {
+	/* prefetching moves the file pointer, so let it finish */
+	hunk_cache_wait(chd);
+
 	/* start at the beginning */
 	metaentry->offset = chd->header.metaoffset;
 	metaentry->prev = 0;
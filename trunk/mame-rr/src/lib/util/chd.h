@@ -265,6 +265,18 @@ struct _chd_header
 };
 
 
+/* structure for returning statistics about the decompressed hunk cache */
+typedef struct _chd_cache_stats chd_cache_stats;
+struct _chd_cache_stats
+{
+	UINT64		reads;						/* hunks read through chd_read */
+	UINT64		hits;						/* reads satisfied from the cache */
+	UINT64		prefetches;					/* hunks decompressed ahead of a read */
+	UINT64		prefetchhits;				/* hits on a hunk that was prefetched */
+	osd_ticks_t	stallticks;					/* time chd_read spent reading or waiting */
+};
+
+
 /* structure for returning information about a verification pass */
 typedef struct _chd_verify_result chd_verify_result;
 struct _chd_verify_result
@@ -337,6 +349,9 @@ chd_error chd_write_async(chd_file *chd, UINT32 hunknum, const void *buffer);
 /* wait for a previously issued async read/write to complete and return the error */
 chd_error chd_async_complete(chd_file *chd);
 
+/* return statistics about the decompressed hunk cache of a read-only CHD */
+chd_error chd_get_cache_stats(chd_file *chd, chd_cache_stats *stats);
+
 
 
 /* ----- metadata management ----- */
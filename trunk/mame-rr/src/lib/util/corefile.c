@@ -758,6 +758,24 @@ file_error core_fload(const char *filename, void **data, UINT32 *length)
 }
 
 
+/*-------------------------------------------------
+    core_fmap - map part of a file on disk into
+    memory; the mapping outlives the file and is
+    released with osd_unmap
+-------------------------------------------------*/
+
+file_error core_fmap(core_file *file, UINT64 offset, UINT32 length, UINT32 flags, void **base, osd_mapping **mapping)
+{
+	/* only plain files on disk can be mapped */
+	if (file->file == NULL || file->zdata != NULL)
+		return FILERR_FAILURE;
+	if (offset + length > file->length)
+		return FILERR_FAILURE;
+
+	return osd_map(file->file, offset, length, flags, base, mapping);
+}
+
+
 
 /***************************************************************************
     FILE WRITE
@@ -130,6 +130,9 @@ const void *core_fbuffer(core_file *file);
 /* open a file with the specified filename, read it into memory, and return a pointer */
 file_error core_fload(const char *filename, void **data, UINT32 *length);
 
+/* map part of a file on disk into memory; fails for RAM-based and compressed files */
+file_error core_fmap(core_file *file, UINT64 offset, UINT32 length, UINT32 flags, void **base, osd_mapping **mapping);
+
 
 
 /* ----- file write ----- */
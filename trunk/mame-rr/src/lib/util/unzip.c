@@ -50,9 +50,6 @@
     CONSTANTS
 ***************************************************************************/
 
-/* number of open files to cache */
-#define ZIP_CACHE_SIZE	8
-
 /* offsets in end of central directory structure */
 #define ZIPESIG			0x00
 #define ZIPEDSK			0x04
@@ -116,13 +113,33 @@ INLINE UINT32 read_dword(UINT8 *buf)
 	return (buf[3] << 24) | (buf[2] << 16) | (buf[1] << 8) | buf[0];
 }
 
+INLINE UINT32 hash_name(const char *name, int length)
+{
+	UINT32 hash = 0;
+	while (length-- > 0)
+		hash = hash * 31 + tolower((UINT8)*name++);
+	return hash;
+}
+
+INLINE const char *final_component(const char *name, int length)
+{
+	const char *scan;
+	for (scan = name + length; scan > name && scan[-1] != '/'; scan--) ;
+	return scan;
+}
+
 
 
 /***************************************************************************
     GLOBAL VARIABLES
 ***************************************************************************/
 
-static zip_file *zip_cache[ZIP_CACHE_SIZE];
+static zip_file *zip_cache[ZIP_CACHE_MAX];
+static int zip_cache_size = ZIP_CACHE_DEFAULT;
+static int zip_map_stored;
+
+/* files may be closed from worker threads once their data is loaded */
+static osd_lock *zip_cache_lock;
 
 
 
@@ -134,6 +151,8 @@ static zip_file *zip_cache[ZIP_CACHE_SIZE];
 static void free_zip_file(zip_file *zip);
 
 /* ZIP file parsing */
+static const zip_file_header *read_header(zip_file *zip);
+static zip_error build_index(zip_file *zip);
 static zip_error read_ecd(zip_file *zip);
 static zip_error get_compressed_data_offset(zip_file *zip, UINT64 *offset);
 
@@ -163,8 +182,13 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 	/* ensure we start with a NULL result */
 	*zip = NULL;
 
+	/* the first open always happens before any other threads are using us */
+	if (zip_cache_lock == NULL)
+		zip_cache_lock = osd_lock_alloc();
+
 	/* see if we are in the cache, and reopen if so */
-	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
+	osd_lock_acquire(zip_cache_lock);
+	for (cachenum = 0; cachenum < zip_cache_size; cachenum++)
 	{
 		zip_file *cached = zip_cache[cachenum];
 
@@ -173,9 +197,11 @@ zip_error zip_file_open(const char *filename, zip_file **zip)
 		{
 			*zip = cached;
 			zip_cache[cachenum] = NULL;
+			osd_lock_release(zip_cache_lock);
 			return ZIPERR_NONE;
 		}
 	}
+	osd_lock_release(zip_cache_lock);
 
 	/* allocate memory for the zip_file structure */
 	newzip = (zip_file *)malloc(sizeof(*newzip));
@@ -244,6 +270,7 @@ error:
 
 void zip_file_close(zip_file *zip)
 {
+	zip_file *evicted = NULL;
 	int cachenum;
 
 	/* close the open files */
@@ -252,18 +279,29 @@ void zip_file_close(zip_file *zip)
 	zip->file = NULL;
 
 	/* find the first NULL entry in the cache */
-	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
+	osd_lock_acquire(zip_cache_lock);
+	for (cachenum = 0; cachenum < zip_cache_size; cachenum++)
 		if (zip_cache[cachenum] == NULL)
 			break;
 
-	/* if no room left in the cache, free the bottommost entry */
-	if (cachenum == ARRAY_LENGTH(zip_cache))
-		free_zip_file(zip_cache[--cachenum]);
+	/* if caching is disabled, just free ourselves */
+	if (zip_cache_size == 0)
+		evicted = zip;
+	else
+	{
+		/* if no room left in the cache, free the bottommost entry */
+		if (cachenum == zip_cache_size)
+			evicted = zip_cache[--cachenum];
+
+		/* move everyone else down and place us at the top */
+		if (cachenum != 0)
+			memmove(&zip_cache[1], &zip_cache[0], cachenum * sizeof(zip_cache[0]));
+		zip_cache[0] = zip;
+	}
+	osd_lock_release(zip_cache_lock);
 
-	/* move everyone else down and place us at the top */
-	if (cachenum != 0)
-		memmove(&zip_cache[1], &zip_cache[0], cachenum * sizeof(zip_cache[0]));
-	zip_cache[0] = zip;
+	/* free the evicted entry outside of the lock */
+	free_zip_file(evicted);
 }
 
 
@@ -276,13 +314,52 @@ void zip_file_cache_clear(void)
 {
 	int cachenum;
 
+	/* nothing to do if nothing was ever opened */
+	if (zip_cache_lock == NULL)
+		return;
+
 	/* clear call cache entries */
-	for (cachenum = 0; cachenum < ARRAY_LENGTH(zip_cache); cachenum++)
+	osd_lock_acquire(zip_cache_lock);
+	for (cachenum = 0; cachenum < zip_cache_size; cachenum++)
 		if (zip_cache[cachenum] != NULL)
 		{
 			free_zip_file(zip_cache[cachenum]);
 			zip_cache[cachenum] = NULL;
 		}
+	osd_lock_release(zip_cache_lock);
+}
+
+
+/*-------------------------------------------------
+    zip_file_cache_configure - set the number of
+    closed ZIP files to keep around, and whether
+    stored files may be mapped into memory
+-------------------------------------------------*/
+
+void zip_file_cache_configure(int entries, int map_stored)
+{
+	/* clamp to what we can hold */
+	entries = MAX(entries, 0);
+	entries = MIN(entries, ZIP_CACHE_MAX);
+	zip_map_stored = map_stored;
+
+	/* if nothing was ever opened, there is nothing to evict */
+	if (zip_cache_lock == NULL)
+	{
+		zip_cache_size = entries;
+		return;
+	}
+
+	/* free anything beyond the new size */
+	osd_lock_acquire(zip_cache_lock);
+	while (zip_cache_size > entries)
+	{
+		zip_cache_size--;
+		free_zip_file(zip_cache[zip_cache_size]);
+		zip_cache[zip_cache_size] = NULL;
+	}
+	zip_cache_size = entries;
+	osd_lock_release(zip_cache_lock);
 }
 
 
@@ -321,43 +398,108 @@ const zip_file_header *zip_file_next_file(zip_file *zip)
 	/* if we're at or past the end, we're done */
 	if (zip->cd_pos >= zip->ecd.cd_size)
 		return NULL;
+	return read_header(zip);
+}
 
-	/* extract file header info */
-	zip->header.raw                 = zip->cd + zip->cd_pos;
-	zip->header.rawlength           = ZIPCFN;
-	zip->header.signature           = read_dword(zip->header.raw + ZIPCENSIG);
-	zip->header.version_created     = read_word (zip->header.raw + ZIPCVER);
-	zip->header.version_needed      = read_word (zip->header.raw + ZIPCVXT);
-	zip->header.bit_flag            = read_word (zip->header.raw + ZIPCFLG);
-	zip->header.compression         = read_word (zip->header.raw + ZIPCMTHD);
-	zip->header.file_time           = read_word (zip->header.raw + ZIPCTIM);
-	zip->header.file_date           = read_word (zip->header.raw + ZIPCDAT);
-	zip->header.crc                 = read_dword(zip->header.raw + ZIPCCRC);
-	zip->header.compressed_length   = read_dword(zip->header.raw + ZIPCSIZ);
-	zip->header.uncompressed_length = read_dword(zip->header.raw + ZIPCUNC);
-	zip->header.filename_length     = read_word (zip->header.raw + ZIPCFNL);
-	zip->header.extra_field_length  = read_word (zip->header.raw + ZIPCXTL);
-	zip->header.file_comment_length = read_word (zip->header.raw + ZIPCCML);
-	zip->header.start_disk_number   = read_word (zip->header.raw + ZIPDSK);
-	zip->header.internal_attributes = read_word (zip->header.raw + ZIPINT);
-	zip->header.external_attributes = read_dword(zip->header.raw + ZIPEXT);
-	zip->header.local_header_offset = read_dword(zip->header.raw + ZIPOFST);
-	zip->header.filename            = (char *)zip->header.raw + ZIPCFN;
 
-	/* make sure we have enough data */
-	zip->header.rawlength += zip->header.filename_length;
-	zip->header.rawlength += zip->header.extra_field_length;
-	zip->header.rawlength += zip->header.file_comment_length;
-	if (zip->cd_pos + zip->header.rawlength > zip->ecd.cd_size)
+/*-------------------------------------------------
+    zip_file_find_name - return the first entry
+    whose name ends with the given path, ignoring
+    case and any leading directories
+-------------------------------------------------*/
+
+const zip_file_header *zip_file_find_name(zip_file *zip, const char *filename)
+{
+	int length = strlen(filename);
+	const char *final = final_component(filename, length);
+
+	/* build the index if this is our first search */
+	if (zip->index == NULL && build_index(zip) != ZIPERR_NONE)
 		return NULL;
 
-	/* NULL terminate the filename */
-	zip->header.saved = zip->header.raw[ZIPCFN + zip->header.filename_length];
-	zip->header.raw[ZIPCFN + zip->header.filename_length] = 0;
+	/* start at the head of the chain for the final component */
+	zip->search_name = filename;
+	zip->search_crc = hash_name(final, filename + length - final);
+	zip->search_next = zip->name_buckets[zip->search_crc & zip->bucket_mask];
+	return zip_file_find_next(zip);
+}
 
-	/* advance the position */
-	zip->cd_pos += zip->header.rawlength;
-	return &zip->header;
+
+/*-------------------------------------------------
+    zip_file_find_crc - return the first entry
+    with the given CRC
+-------------------------------------------------*/
+
+const zip_file_header *zip_file_find_crc(zip_file *zip, UINT32 crc)
+{
+	/* build the index if this is our first search */
+	if (zip->index == NULL && build_index(zip) != ZIPERR_NONE)
+		return NULL;
+
+	zip->search_name = NULL;
+	zip->search_crc = crc;
+	zip->search_next = zip->crc_buckets[crc & zip->bucket_mask];
+	return zip_file_find_next(zip);
+}
+
+
+/*-------------------------------------------------
+    zip_file_find_next - return the next entry
+    matching the most recent search, in directory
+    order
+-------------------------------------------------*/
+
+const zip_file_header *zip_file_find_next(zip_file *zip)
+{
+	while (zip->search_next >= 0)
+	{
+		const zip_index_entry *entry = &zip->index[zip->search_next];
+		const zip_file_header *header;
+
+		/* advance along the appropriate chain and skip obvious mismatches */
+		if (zip->search_name != NULL)
+		{
+			zip->search_next = entry->next_name;
+			if (entry->name_hash != zip->search_crc)
+				continue;
+		}
+		else
+		{
+			zip->search_next = entry->next_crc;
+			if (entry->crc != zip->search_crc)
+				continue;
+		}
+
+		/* fix up any modified data and parse the header */
+		if (zip->header.raw != NULL)
+		{
+			zip->header.raw[ZIPCFN + zip->header.filename_length] = zip->header.saved;
+			zip->header.raw = NULL;
+		}
+		zip->cd_pos = entry->cd_pos;
+		header = read_header(zip);
+		if (header == NULL)
+			continue;
+
+		/* CRC matches are exact; names must match at a directory boundary */
+		if (zip->search_name == NULL)
+			return header;
+		else
+		{
+			int length = strlen(zip->search_name);
+			const char *zipname = header->filename + header->filename_length - length;
+			if (zipname >= header->filename && (zipname == header->filename || zipname[-1] == '/'))
+			{
+				int index;
+				for (index = 0; index < length; index++)
+					if (tolower((UINT8)zipname[index]) != tolower((UINT8)zip->search_name[index]))
+						break;
+				if (index == length)
+					return header;
+			}
+		}
+	}
+	return NULL;
 }
 
 
@@ -403,6 +545,39 @@ zip_error zip_file_decompress(zip_file *zip, void *buffer, UINT32 length)
 }
 
 
+/*-------------------------------------------------
+    zip_file_map - map the most recently found
+    file into memory rather than reading it, if
+    it is stored and mapping is enabled
+-------------------------------------------------*/
+
+zip_error zip_file_map(zip_file *zip, const void **data, osd_mapping **mapping)
+{
+	zip_error ziperr;
+	UINT64 offset;
+	void *base;
+
+	/* only stored data can be used in place */
+	if (!zip_map_stored || zip->header.compression != 0 || zip->header.compressed_length != zip->header.uncompressed_length)
+		return ZIPERR_UNSUPPORTED;
+	if (zip->header.start_disk_number != zip->ecd.disk_number)
+		return ZIPERR_UNSUPPORTED;
+
+	/* get the data offset */
+	ziperr = get_compressed_data_offset(zip, &offset);
+	if (ziperr != ZIPERR_NONE)
+		return ziperr;
+	if (offset + zip->header.compressed_length > zip->length)
+		return ZIPERR_FILE_TRUNCATED;
+
+	/* map it */
+	if (osd_map(zip->file, offset, zip->header.compressed_length, 0, &base, mapping) != FILERR_NONE)
+		return ZIPERR_UNSUPPORTED;
+	*data = base;
+	return ZIPERR_NONE;
+}
+
+
 
 /***************************************************************************
     CACHE MANAGEMENT
@@ -425,6 +600,8 @@ static void free_zip_file(zip_file *zip)
 			free(zip->ecd.raw);
 		if (zip->cd != NULL)
 			free(zip->cd);
+		if (zip->index != NULL)
+			free(zip->index);
 		free(zip);
 	}
 }
@@ -435,6 +612,115 @@ static void free_zip_file(zip_file *zip)
     ZIP FILE PARSING
 ***************************************************************************/
 
+/*-------------------------------------------------
+    read_header - parse the header at the current
+    position in the central directory
+-------------------------------------------------*/
+
+static const zip_file_header *read_header(zip_file *zip)
+{
+	/* extract file header info */
+	zip->header.raw                 = zip->cd + zip->cd_pos;
+	zip->header.rawlength           = ZIPCFN;
+	zip->header.signature           = read_dword(zip->header.raw + ZIPCENSIG);
+	zip->header.version_created     = read_word (zip->header.raw + ZIPCVER);
+	zip->header.version_needed      = read_word (zip->header.raw + ZIPCVXT);
+	zip->header.bit_flag            = read_word (zip->header.raw + ZIPCFLG);
+	zip->header.compression         = read_word (zip->header.raw + ZIPCMTHD);
+	zip->header.file_time           = read_word (zip->header.raw + ZIPCTIM);
+	zip->header.file_date           = read_word (zip->header.raw + ZIPCDAT);
+	zip->header.crc                 = read_dword(zip->header.raw + ZIPCCRC);
+	zip->header.compressed_length   = read_dword(zip->header.raw + ZIPCSIZ);
+	zip->header.uncompressed_length = read_dword(zip->header.raw + ZIPCUNC);
+	zip->header.filename_length     = read_word (zip->header.raw + ZIPCFNL);
+	zip->header.extra_field_length  = read_word (zip->header.raw + ZIPCXTL);
+	zip->header.file_comment_length = read_word (zip->header.raw + ZIPCCML);
+	zip->header.start_disk_number   = read_word (zip->header.raw + ZIPDSK);
+	zip->header.internal_attributes = read_word (zip->header.raw + ZIPINT);
+	zip->header.external_attributes = read_dword(zip->header.raw + ZIPEXT);
+	zip->header.local_header_offset = read_dword(zip->header.raw + ZIPOFST);
+	zip->header.filename            = (char *)zip->header.raw + ZIPCFN;
+
+	/* make sure we have enough data */
+	zip->header.rawlength += zip->header.filename_length;
+	zip->header.rawlength += zip->header.extra_field_length;
+	zip->header.rawlength += zip->header.file_comment_length;
+	if (zip->cd_pos + zip->header.rawlength > zip->ecd.cd_size)
+	{
+		zip->header.raw = NULL;
+		return NULL;
+	}
+
+	/* NULL terminate the filename */
+	zip->header.saved = zip->header.raw[ZIPCFN + zip->header.filename_length];
+	zip->header.raw[ZIPCFN + zip->header.filename_length] = 0;
+
+	/* advance the position */
+	zip->cd_pos += zip->header.rawlength;
+	return &zip->header;
+}
+
+
+/*-------------------------------------------------
+    build_index - build hash chains by name and
+    CRC over the central directory
+-------------------------------------------------*/
+
+static zip_error build_index(zip_file *zip)
+{
+	UINT32 pos, count, buckets, entrynum;
+	zip_index_entry *index;
+
+	/* count the entries; we can't trust the ECD for this */
+	count = 0;
+	for (pos = 0; pos + ZIPCFN <= zip->ecd.cd_size; count++)
+		pos += ZIPCFN + read_word(zip->cd + pos + ZIPCFNL) + read_word(zip->cd + pos + ZIPCXTL) + read_word(zip->cd + pos + ZIPCCML);
+
+	/* one allocation holds the entries and both sets of buckets */
+	for (buckets = 16; buckets < count; buckets *= 2) ;
+	index = (zip_index_entry *)malloc(count * sizeof(*index) + 2 * buckets * sizeof(INT32));
+	if (index == NULL)
+		return ZIPERR_OUT_OF_MEMORY;
+	zip->name_buckets = (INT32 *)&index[count];
+	zip->crc_buckets = zip->name_buckets + buckets;
+	zip->bucket_mask = buckets - 1;
+	memset(zip->name_buckets, 0xff, 2 * buckets * sizeof(INT32));
+
+	/* fill in the entries */
+	for (pos = 0, entrynum = 0; entrynum < count; entrynum++)
+	{
+		UINT8 *raw = zip->cd + pos;
+		const char *name = (const char *)raw + ZIPCFN;
+		int namelength = read_word(raw + ZIPCFNL);
+		const char *final;
+
+		/* the last entry may run off the end; clamp its name */
+		if (pos + ZIPCFN + namelength > zip->ecd.cd_size)
+			namelength = zip->ecd.cd_size - pos - ZIPCFN;
+		final = final_component(name, namelength);
+
+		index[entrynum].cd_pos = pos;
+		index[entrynum].crc = read_dword(raw + ZIPCCRC);
+		index[entrynum].name_hash = hash_name(final, name + namelength - final);
+		pos += ZIPCFN + read_word(raw + ZIPCFNL) + read_word(raw + ZIPCXTL) + read_word(raw + ZIPCCML);
+	}
+
+	/* link the chains back to front so that they are in directory order */
+	for (entrynum = count; entrynum-- > 0; )
+	{
+		INT32 *namehead = &zip->name_buckets[index[entrynum].name_hash & zip->bucket_mask];
+		INT32 *crchead = &zip->crc_buckets[index[entrynum].crc & zip->bucket_mask];
+		index[entrynum].next_name = *namehead;
+		index[entrynum].next_crc = *crchead;
+		*namehead = entrynum;
+		*crchead = entrynum;
+	}
+
+	zip->index = index;
+	return ZIPERR_NONE;
+}
+
+
 /*-------------------------------------------------
     read_ecd - read the ECD data
 -------------------------------------------------*/
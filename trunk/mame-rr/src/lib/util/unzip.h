@@ -51,6 +51,10 @@
 
 #define ZIP_DECOMPRESS_BUFSIZE	16384
 
+/* limits on the number of ZIP directories kept open */
+#define ZIP_CACHE_DEFAULT		8
+#define ZIP_CACHE_MAX			256
+
 /* Error types */
 enum _zip_error
 {
@@ -120,6 +124,18 @@ struct _zip_ecd
 };
 
 
+/* an entry in the lookup index for a central directory */
+typedef struct _zip_index_entry zip_index_entry;
+struct _zip_index_entry
+{
+	UINT32			cd_pos;					/* position of the header in the central directory */
+	UINT32			crc;					/* crc-32 */
+	UINT32			name_hash;				/* hash of the final component of the filename */
+	INT32			next_name;				/* next entry in the same name bucket, or -1 */
+	INT32			next_crc;				/* next entry in the same CRC bucket, or -1 */
+};
+
+
 /* describes an open ZIP file */
 typedef struct _zip_file zip_file;
 struct _zip_file
@@ -134,6 +150,14 @@ struct _zip_file
 	UINT32			cd_pos;					/* position in central directory */
 	zip_file_header	header;					/* current file header */
 
+	zip_index_entry *index;					/* index of the central directory, built on first search */
+	INT32 *			name_buckets;			/* heads of the name hash chains */
+	INT32 *			crc_buckets;			/* heads of the CRC hash chains */
+	UINT32			bucket_mask;			/* number of buckets minus 1 */
+	const char *	search_name;			/* filename of the current search, or NULL for a CRC search */
+	UINT32			search_crc;				/* CRC of the current search */
+	INT32			search_next;			/* next index entry to consider */
+
 	UINT8			buffer[ZIP_DECOMPRESS_BUFSIZE];	/* buffer for decompression */
 };
 
@@ -155,6 +179,9 @@ void zip_file_close(zip_file *zip);
 /* clear out all open ZIP files from the cache */
 void zip_file_cache_clear(void);
 
+/* set the number of closed ZIP files to keep cached, and whether stored files may be mapped */
+void zip_file_cache_configure(int entries, int map_stored);
+
 
 /* ----- contained file access ----- */
 
@@ -164,8 +191,20 @@ const zip_file_header *zip_file_first_file(zip_file *zip);
 /* find the next file in the ZIP */
 const zip_file_header *zip_file_next_file(zip_file *zip);
 
+/* find the first file whose name ends with the given path, ignoring case; the name must remain valid while searching */
+const zip_file_header *zip_file_find_name(zip_file *zip, const char *filename);
+
+/* find the first file with the given CRC */
+const zip_file_header *zip_file_find_crc(zip_file *zip, UINT32 crc);
+
+/* find the next file matching the most recent search */
+const zip_file_header *zip_file_find_next(zip_file *zip);
+
 /* decompress the most recently found file in the ZIP */
 zip_error zip_file_decompress(zip_file *zip, void *buffer, UINT32 length);
 
+/* map the most recently found file into memory if it is stored uncompressed */
+zip_error zip_file_map(zip_file *zip, const void **data, osd_mapping **mapping);
+
 
 #endif	/* __UNZIP_H__ */
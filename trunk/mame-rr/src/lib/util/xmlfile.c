@@ -557,21 +557,45 @@ xml_attribute_node *xml_set_attribute_float(xml_data_node *node, const char *nam
 const char *xml_normalize_string(const char *string)
 {
 	static char buffer[1024];
+	return xml_normalize_string_buffer(string, buffer, sizeof(buffer));
+}
+
+
+/*-------------------------------------------------
+    xml_normalize_string_buffer - normalize a
+    string into the given buffer, truncating it
+    if it does not fit
+-------------------------------------------------*/
+
+const char *xml_normalize_string_buffer(const char *string, char *buffer, int length)
+{
 	char *d = &buffer[0];
+	char *end = &buffer[length - 1];
 
 	if (string != NULL)
 	{
 		while (*string)
 		{
+			const char *entity;
+			int entlength;
+
 			switch (*string)
 			{
-				case '\"' : d += sprintf(d, "&quot;"); break;
-				case '&'  : d += sprintf(d, "&amp;"); break;
-				case '<'  : d += sprintf(d, "&lt;"); break;
-				case '>'  : d += sprintf(d, "&gt;"); break;
-				default:
-					*d++ = *string;
+				case '\"' : entity = "&quot;"; break;
+				case '&'  : entity = "&amp;"; break;
+				case '<'  : entity = "&lt;"; break;
+				case '>'  : entity = "&gt;"; break;
+				default:	entity = NULL; break;
 			}
+
+			/* never split an entity */
+			entlength = (entity != NULL) ? strlen(entity) : 1;
+			if (end - d < entlength)
+				break;
+			if (entity != NULL)
+				d += sprintf(d, "%s", entity);
+			else
+				*d++ = *string;
 			++string;
 		}
 	}
@@ -198,4 +198,7 @@ xml_attribute_node *xml_set_attribute_float(xml_data_node *node, const char *nam
 /* normalize a string into something that can be written to an XML file */
 const char *xml_normalize_string(const char *string);
 
+/* normalize a string into a caller-supplied buffer, for use from multiple threads */
+const char *xml_normalize_string_buffer(const char *string, char *buffer, int length);
+
 #endif	/* __XMLFILE_H__ */
@@ -3056,8 +3056,10 @@ static MACHINE_CONFIG_START( cps1_10MHz, cps_state )
 	MCFG_SCREEN_FORMAT(BITMAP_FORMAT_INDEXED16)
 	MCFG_SCREEN_SIZE(64*8, 32*8)
 	MCFG_SCREEN_VISIBLE_AREA(8*8, (64-8)*8-1, 2*8, 30*8-1 )
+	MCFG_SCREEN_PREPARE(cps1)
 	MCFG_SCREEN_UPDATE(cps1)
 	MCFG_SCREEN_EOF(cps1)
+	MCFG_SCREEN_REENTRANT
 
 	MCFG_GFXDECODE(cps1)
 	MCFG_PALETTE_LENGTH(0xc00)
@@ -3141,8 +3143,10 @@ static MACHINE_CONFIG_START( cpspicb, cps_state )
 	MCFG_SCREEN_FORMAT(BITMAP_FORMAT_INDEXED16)
 	MCFG_SCREEN_SIZE(64*8, 32*8)
 	MCFG_SCREEN_VISIBLE_AREA(8*8, (64-8)*8-1, 2*8, 30*8-1 )
+	MCFG_SCREEN_PREPARE(cps1)
 	MCFG_SCREEN_UPDATE(cps1)
 	MCFG_SCREEN_EOF(cps1)
+	MCFG_SCREEN_REENTRANT
 
 	MCFG_GFXDECODE(cps1)
 	MCFG_PALETTE_LENGTH(0xc00)
@@ -3216,8 +3220,10 @@ static MACHINE_CONFIG_START( sf2mdt, cps_state )
 	MCFG_SCREEN_FORMAT(BITMAP_FORMAT_INDEXED16)
 	MCFG_SCREEN_SIZE(64*8, 32*8)
 	MCFG_SCREEN_VISIBLE_AREA(8*8, (64-8)*8-1, 2*8, 30*8-1 )
+	MCFG_SCREEN_PREPARE(cps1)
 	MCFG_SCREEN_UPDATE(cps1)
 	MCFG_SCREEN_EOF(cps1)
+	MCFG_SCREEN_REENTRANT
 
 	MCFG_GFXDECODE(cps1)
 	MCFG_PALETTE_LENGTH(0xc00)
@@ -3301,8 +3307,10 @@ static MACHINE_CONFIG_START( knightsb, cps_state )
 	MCFG_SCREEN_FORMAT(BITMAP_FORMAT_INDEXED16)
 	MCFG_SCREEN_SIZE(64*8, 32*8)
 	MCFG_SCREEN_VISIBLE_AREA(8*8, (64-8)*8-1, 2*8, 30*8-1 )
+	MCFG_SCREEN_PREPARE(cps1)
 	MCFG_SCREEN_UPDATE(cps1)
 	MCFG_SCREEN_EOF(cps1)
+	MCFG_SCREEN_REENTRANT
 
 	MCFG_GFXDECODE(cps1)
 	MCFG_PALETTE_LENGTH(0xc00)
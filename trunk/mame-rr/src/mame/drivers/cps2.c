@@ -1234,8 +1234,10 @@ static MACHINE_CONFIG_START( cps2, cps_state )
 	MCFG_SCREEN_ADD("screen", RASTER)
 	MCFG_SCREEN_FORMAT(BITMAP_FORMAT_INDEXED16)
 	MCFG_SCREEN_RAW_PARAMS(XTAL_8MHz, 518, 64, 448, 259, 16, 240)
+	MCFG_SCREEN_PREPARE(cps1)
 	MCFG_SCREEN_UPDATE(cps1)
 	MCFG_SCREEN_EOF(cps1)
+	MCFG_SCREEN_REENTRANT
 /*
     Measured clocks:
         V = 59.6376Hz
@@ -378,6 +378,7 @@ Notes:
 #include "machine/nvram.h"
 #include "includes/cps3.h"
 #include "machine/wd33c93.h"
+#include "romcache.h"
 
 #define MASTER_CLOCK	42954500
 
@@ -713,14 +714,16 @@ static void init_common(running_machine &machine, UINT32 key1, UINT32 key2, int
 	state->m_user4region = machine.region("user4")->base();
 	state->m_user5region = machine.region("user5")->base();
 
-	if (!state->m_user4region) state->m_user4region = auto_alloc_array(machine, UINT8, USER4REGION_LENGTH);
+	if (!state->m_user4region) state->m_user4region = auto_alloc_array_clear(machine, UINT8, USER4REGION_LENGTH);
 	if (!state->m_user5region) state->m_user5region = auto_alloc_array(machine, UINT8, USER5REGION_LENGTH);
 
 	// set strict verify
 	sh2drc_set_options(machine.device("maincpu"), SH2DRC_STRICT_VERIFY);
 
 	cps3_decrypt_bios(machine);
-	state->m_decrypted_gamerom = auto_alloc_array(machine, UINT32, 0x1000000/4);
+
+	/* decrypted from the flash contents on the first reset */
+	state->m_decrypted_gamerom = NULL;
 
 	/* just some NOPs for the game to execute if it crashes and starts executing unmapped addresses
      - this prevents MAME from crashing */
@@ -2361,28 +2364,68 @@ static MACHINE_RESET( cps3 )
 
 
 
+// decrypt the program copied from the flashroms into the region we execute from
+static void decrypt_gamerom(running_machine &machine)
+{
+	cps3_state *state = machine.driver_data<cps3_state>();
+	const UINT32* romdata = (const UINT32*)state->m_user4region;
+	UINT32* romdata2 = state->m_decrypted_gamerom;
+	int i;
+
+	/* the first time through, use a copy decrypted by an earlier session if there is one */
+	if (romdata2 == NULL)
+	{
+		/* the result depends only on the program and the keys */
+		rom_transform_cache cache(machine, "cps3");
+		cache.add_input(romdata, USER4REGION_LENGTH);
+		cache.add_input(state->m_key1);
+		cache.add_input(state->m_key2);
+
+		/* with sharing on, every instance maps the one decrypted copy */
+		state->m_decrypted_gamerom = (UINT32*)cache.map(USER4REGION_LENGTH);
+		if (state->m_decrypted_gamerom != NULL)
+			return;
+
+		romdata2 = auto_alloc_array(machine, UINT32, USER4REGION_LENGTH/4);
+		for (i=0;i<USER4REGION_LENGTH;i+=4)
+			romdata2[i/4] = romdata[i/4] ^ cps3_mask(i+0x6000000, state->m_key1, state->m_key2);
+		cache.save(romdata2, USER4REGION_LENGTH);
+
+		/* and swap our private copy for the shared one just saved */
+		state->m_decrypted_gamerom = (UINT32*)cache.map(USER4REGION_LENGTH);
+		if (state->m_decrypted_gamerom != NULL)
+			auto_free(machine, romdata2);
+		else
+			state->m_decrypted_gamerom = romdata2;
+		return;
+	}
+
+	/* on later resets only write what changed, so shared pages stay shared */
+	for (i=0;i<USER4REGION_LENGTH;i+=4)
+	{
+		UINT32 data = romdata[i/4] ^ cps3_mask(i+0x6000000, state->m_key1, state->m_key2);
+		if (romdata2[i/4] != data)
+			romdata2[i/4] = data;
+	}
+}
+
 // make a copy in the regions we execute code / draw gfx from
 static void copy_from_nvram(running_machine &machine)
 {
 	cps3_state *state = machine.driver_data<cps3_state>();
 	UINT32* romdata = (UINT32*)state->m_user4region;
-	UINT32* romdata2 = (UINT32*)state->m_decrypted_gamerom;
 	int i;
-	/* copy + decrypt program roms which have been loaded from flashroms/nvram */
+	/* copy program roms which have been loaded from flashroms/nvram */
 	for (i=0;i<0x800000;i+=4)
 	{
 		UINT32 data;
 
 		data = ((state->m_simm[0][0]->read_raw(i/4)<<24) | (state->m_simm[0][1]->read_raw(i/4)<<16) | (state->m_simm[0][2]->read_raw(i/4)<<8) | (state->m_simm[0][3]->read_raw(i/4)<<0));
 
-	//  printf("%08x %08x %08x %08x\n",romdata[i/4],data, romdata2[i/4], data ^ cps3_mask(i+0x6000000, state->m_key1, state->m_key2));
 		romdata[i/4] = data;
-		romdata2[i/4] = data ^ cps3_mask(i+0x6000000, state->m_key1, state->m_key2);
-
 	}
 
 	romdata  += 0x800000/4;
-	romdata2 += 0x800000/4;
 
 	if (state->m_simm[1][0] != NULL)
 		for (i=0;i<0x800000;i+=4)
@@ -2391,11 +2434,12 @@ static void copy_from_nvram(running_machine &machine)
 
 			data = ((state->m_simm[1][0]->read_raw(i/4)<<24) | (state->m_simm[1][1]->read_raw(i/4)<<16) | (state->m_simm[1][2]->read_raw(i/4)<<8) | (state->m_simm[1][3]->read_raw(i/4)<<0));
 
-		//  printf("%08x %08x %08x %08x\n",romdata[i/4],data, romdata2[i/4],  data ^ cps3_mask(i+0x6800000, state->m_key1, state->m_key2) );
 			romdata[i/4] = data;
-			romdata2[i/4] = data ^ cps3_mask(i+0x6800000, state->m_key1, state->m_key2);
 		}
 
+	/* and decrypt them into the copy we execute from */
+	decrypt_gamerom(machine);
+
 	/* copy gfx from loaded flashroms to user reigon 5, where it's used */
 	{
 		UINT32 thebase, len = USER5REGION_LENGTH;
@@ -58,6 +58,16 @@ struct CPS1config
 	int bootleg_kludge;
 };
 
+/* one 16x16 tile of the sprite list, positioned on screen */
+struct cps_sprite_tile
+{
+	UINT32 code;
+	INT16 sx, sy;
+	UINT8 color;
+	UINT8 flipx, flipy;
+	UINT8 priority;		/* CPS2 only, index into primasks */
+};
+
 
 class cps_state : public driver_device
 {
@@ -112,6 +122,14 @@ public:
 	int          m_pri_ctrl;				/* Sprite layer priorities */
 	int          m_objram_bank;
 
+	/* sprite tiles visible in the current update, binned by scanline (see SCREEN_PREPARE) */
+	struct cps_sprite_tile *m_sprite_tiles;
+	int          m_sprite_tile_count;
+	int          m_sprite_tile_max;
+	UINT32 *     m_sprite_bin_list;			/* tile indexes of each bin, in drawing order */
+	int *        m_sprite_bin_start;		/* start of each bin in m_sprite_bin_list */
+	int          m_sprite_bins;
+
 	/* misc */
 	int          m_dial[2];		// forgottn
 	int          m_readpaddle;	// pzloop2
@@ -175,6 +193,7 @@ WRITE16_HANDLER( cps2_objram2_w );
 
 VIDEO_START( cps1 );
 VIDEO_START( cps2 );
+SCREEN_PREPARE( cps1 );
 SCREEN_UPDATE( cps1 );
 SCREEN_EOF( cps1 );
 
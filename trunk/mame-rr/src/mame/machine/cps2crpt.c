@@ -113,6 +113,7 @@ the decryption keys.
 #include "emu.h"
 #include "cpu/m68000/m68000.h"
 #include "ui.h"
+#include "romcache.h"
 #include "includes/cps1.h"
 
 
@@ -630,54 +631,41 @@ static void optimise_sboxes(struct optimised_sbox* out, const struct sbox* in)
 
 
 
-static void cps2_decrypt(running_machine &machine, const UINT32 *master_key, UINT32 upper_limit)
+// everything the workers need to decrypt a range of key subsets
+struct cps2_decrypt_state
 {
-	address_space *space = machine.device("maincpu")->memory().space(AS_PROGRAM);
-	UINT16 *rom = (UINT16 *)machine.region("maincpu")->base();
-	int length = machine.region("maincpu")->bytes();
-	UINT16 *dec = auto_alloc_array(machine, UINT16, length/2);
-	int i;
+	const UINT16 *rom;
+	UINT16 *dec;
+	int length;
+	UINT32 upper_limit;
+	const UINT32 *master_key;
 	UINT32 key1[4];
 	struct optimised_sbox sboxes1[4*4];
 	struct optimised_sbox sboxes2[4*4];
+	int base;                     /* first key subset of the current pass */
+};
+
+
+static void cps2_decrypt_range(void *param, INT32 start, INT32 end, int threadid)
+{
+	const cps2_decrypt_state *state = (const cps2_decrypt_state *)param;
+	const UINT16 *rom = state->rom;
+	UINT16 *dec = state->dec;
+	int length = state->length;
+	UINT32 upper_limit = state->upper_limit;
+	const UINT32 *key1 = state->key1;
+	const struct optimised_sbox *sboxes1 = state->sboxes1;
+	const struct optimised_sbox *sboxes2 = state->sboxes2;
+	int i;
 
-	optimise_sboxes(&sboxes1[0*4], fn1_r1_boxes);
-	optimise_sboxes(&sboxes1[1*4], fn1_r2_boxes);
-	optimise_sboxes(&sboxes1[2*4], fn1_r3_boxes);
-	optimise_sboxes(&sboxes1[3*4], fn1_r4_boxes);
-	optimise_sboxes(&sboxes2[0*4], fn2_r1_boxes);
-	optimise_sboxes(&sboxes2[1*4], fn2_r2_boxes);
-	optimise_sboxes(&sboxes2[2*4], fn2_r3_boxes);
-	optimise_sboxes(&sboxes2[3*4], fn2_r4_boxes);
-
-
-	// expand master key to 1st FN 96-bit key
-	expand_1st_key(key1, master_key);
-
-	// add extra bits for s-boxes with less than 6 inputs
-	key1[0] ^= BIT(key1[0], 1) <<  4;
-	key1[0] ^= BIT(key1[0], 2) <<  5;
-	key1[0] ^= BIT(key1[0], 8) << 11;
-	key1[1] ^= BIT(key1[1], 0) <<  5;
-	key1[1] ^= BIT(key1[1], 8) << 11;
-	key1[2] ^= BIT(key1[2], 1) <<  5;
-	key1[2] ^= BIT(key1[2], 8) << 11;
-
-	for (i = 0; i < 0x10000; ++i)
+	// each key subset touches only the words at i, i+0x10000, ... so ranges never overlap
+	for (i = state->base + start; i < state->base + end; ++i)
 	{
 		int a;
 		UINT16 seed;
 		UINT32 subkey[2];
 		UINT32 key2[4];
 
-		if ((i & 0xff) == 0)
-		{
-			char loadingMessage[256]; // for displaying with UI
-			sprintf(loadingMessage, "Decrypting %d%%", i*100/0x10000);
-			ui_set_startup_text(machine, loadingMessage,FALSE);
-		}
-
-
 		// pass the address through FN1
 		seed = feistel(i, fn1_groupA, fn1_groupB,
 				&sboxes1[0*4], &sboxes1[1*4], &sboxes1[2*4], &sboxes1[3*4],
@@ -688,8 +676,8 @@ static void cps2_decrypt(running_machine &machine, const UINT32 *master_key, UIN
 		expand_subkey(subkey, seed);
 
 		// XOR with the master key
-		subkey[0] ^= master_key[0];
-		subkey[1] ^= master_key[1];
+		subkey[0] ^= state->master_key[0];
+		subkey[1] ^= state->master_key[1];
 
 		// expand key to 2nd FN 96-bit key
 		expand_2nd_key(key2, subkey);
@@ -719,6 +707,89 @@ static void cps2_decrypt(running_machine &machine, const UINT32 *master_key, UIN
 			a += 0x10000;
 		}
 	}
+}
+
+
+static void cps2_decrypt(running_machine &machine, const UINT32 *master_key, UINT32 upper_limit)
+{
+	address_space *space = machine.device("maincpu")->memory().space(AS_PROGRAM);
+	UINT16 *rom = (UINT16 *)machine.region("maincpu")->base();
+	int length = machine.region("maincpu")->bytes();
+	UINT16 *dec;
+	bool cached;
+
+	// the decrypted image depends only on the ROM contents and the key
+	rom_transform_cache cache(machine, "cps2");
+	cache.add_input(rom, length);
+	cache.add_input(master_key[0]);
+	cache.add_input(master_key[1]);
+	cache.add_input(upper_limit);
+
+	// share a cached image between instances if we can, else make our own
+	dec = (UINT16 *)cache.map(length);
+	cached = (dec != NULL);
+	if (!cached)
+	{
+		dec = auto_alloc_array(machine, UINT16, length/2);
+		cached = cache.load(dec, length);
+	}
+
+	if (!cached)
+	{
+		cps2_decrypt_state *state = auto_alloc(machine, cps2_decrypt_state);
+		UINT32 *key1 = state->key1;
+		osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+		int pass;
+
+		state->rom = rom;
+		state->dec = dec;
+		state->length = length;
+		state->upper_limit = upper_limit;
+		state->master_key = master_key;
+
+		optimise_sboxes(&state->sboxes1[0*4], fn1_r1_boxes);
+		optimise_sboxes(&state->sboxes1[1*4], fn1_r2_boxes);
+		optimise_sboxes(&state->sboxes1[2*4], fn1_r3_boxes);
+		optimise_sboxes(&state->sboxes1[3*4], fn1_r4_boxes);
+		optimise_sboxes(&state->sboxes2[0*4], fn2_r1_boxes);
+		optimise_sboxes(&state->sboxes2[1*4], fn2_r2_boxes);
+		optimise_sboxes(&state->sboxes2[2*4], fn2_r3_boxes);
+		optimise_sboxes(&state->sboxes2[3*4], fn2_r4_boxes);
+
+
+		// expand master key to 1st FN 96-bit key
+		expand_1st_key(key1, master_key);
+
+		// add extra bits for s-boxes with less than 6 inputs
+		key1[0] ^= BIT(key1[0], 1) <<  4;
+		key1[0] ^= BIT(key1[0], 2) <<  5;
+		key1[0] ^= BIT(key1[0], 8) << 11;
+		key1[1] ^= BIT(key1[1], 0) <<  5;
+		key1[1] ^= BIT(key1[1], 8) << 11;
+		key1[2] ^= BIT(key1[2], 1) <<  5;
+		key1[2] ^= BIT(key1[2], 8) << 11;
+
+		// spread the key subsets across the work queue, a slice at a time
+		// so that the progress message still advances
+		for (pass = 0; pass < 16; pass++)
+		{
+			char loadingMessage[256]; // for displaying with UI
+			sprintf(loadingMessage, "Decrypting %d%%", pass*100/16);
+			ui_set_startup_text(machine, loadingMessage,FALSE);
+
+			state->base = pass * 0x1000;
+			if (queue != NULL)
+				osd_work_queue_parallel_for(queue, cps2_decrypt_range, state, 0x1000, 0x100);
+			else
+				cps2_decrypt_range(state, 0, 0x1000, 0);
+		}
+
+		if (queue != NULL)
+			osd_work_queue_free(queue);
+		auto_free(machine, state);
+
+		cache.save(dec, length);
+	}
 
 	space->set_decrypted_region(0x000000, length - 1, dec);
 	m68k_set_encrypted_opcode_range(machine.device("maincpu"), 0, length);
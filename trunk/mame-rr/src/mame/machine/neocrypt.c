@@ -48,6 +48,7 @@
 
 #include "emu.h"
 #include "includes/neogeo.h"
+#include "romcache.h"
 
 
 /***************************************************************************
@@ -528,34 +529,57 @@ static void decrypt(UINT8 *r0, UINT8 *r1,
 }
 
 
-static void neogeo_gfx_decrypt(running_machine &machine, int extra_xor)
+/* run a transform over [0, count) on the work queue, or inline if there is none */
+static void run_parallel(osd_work_queue *queue, osd_work_range_callback callback, void *param, INT32 count)
 {
-	int rom_size;
-	UINT8 *buf;
-	UINT8 *rom;
-	int rpos;
+	if (queue != NULL)
+		osd_work_queue_parallel_for(queue, callback, param, count, 0);
+	else
+		(*callback)(param, 0, count, 0);
+}
 
-	rom_size = machine.region("sprites")->bytes();
 
-	buf = auto_alloc_array(machine, UINT8, rom_size);
+struct gfx_decrypt_state
+{
+	UINT8 *rom;
+	UINT8 *buf;
+	int rom_size;
+	int extra_xor;
+};
 
-	rom = machine.region("sprites")->base();
+
+static void gfx_decrypt_data_range(void *param, INT32 start, INT32 end, int threadid)
+{
+	const gfx_decrypt_state *state = (const gfx_decrypt_state *)param;
+	const UINT8 *rom = state->rom;
+	UINT8 *buf = state->buf;
+	int rpos;
 
 	// Data xor
-	for (rpos = 0;rpos < rom_size/4;rpos++)
+	for (rpos = start;rpos < end;rpos++)
 	{
 		decrypt(buf+4*rpos+0, buf+4*rpos+3, rom[4*rpos+0], rom[4*rpos+3], type0_t03, type0_t12, type1_t03, rpos, (rpos>>8) & 1);
 		decrypt(buf+4*rpos+1, buf+4*rpos+2, rom[4*rpos+1], rom[4*rpos+2], type0_t12, type0_t03, type1_t12, rpos, ((rpos>>16) ^ address_16_23_xor2[(rpos>>8) & 0xff]) & 1);
 	}
+}
+
+
+static void gfx_decrypt_address_range(void *param, INT32 start, INT32 end, int threadid)
+{
+	const gfx_decrypt_state *state = (const gfx_decrypt_state *)param;
+	UINT8 *rom = state->rom;
+	const UINT8 *buf = state->buf;
+	int rom_size = state->rom_size;
+	int rpos;
 
 	// Address xor
-	for (rpos = 0;rpos < rom_size/4;rpos++)
+	for (rpos = start;rpos < end;rpos++)
 	{
 		int baser;
 
 		baser = rpos;
 
-		baser ^= extra_xor;
+		baser ^= state->extra_xor;
 
 		baser ^= address_8_15_xor1[(baser >> 16) & 0xff] << 8;
 		baser ^= address_8_15_xor2[baser & 0xff] << 8;
@@ -586,8 +610,67 @@ static void neogeo_gfx_decrypt(running_machine &machine, int extra_xor)
 		rom[4*rpos+2] = buf[4*baser+2];
 		rom[4*rpos+3] = buf[4*baser+3];
 	}
+}
+
+
+static void neogeo_gfx_decrypt(running_machine &machine, int extra_xor)
+{
+	gfx_decrypt_state state;
+	int rom_size;
+	UINT8 *buf;
+	UINT8 *rom;
+
+	rom_size = machine.region("sprites")->bytes();
+
+	rom = machine.region("sprites")->base();
+
+	// the result depends on the encrypted data, the chip's tables and the per-game xor
+	rom_transform_cache cache(machine, "neocmc");
+	cache.add_input(rom, rom_size);
+	cache.add_input(extra_xor);
+	cache.add_input(type0_t03, 256);
+	cache.add_input(type0_t12, 256);
+	cache.add_input(type1_t03, 256);
+	cache.add_input(type1_t12, 256);
+	cache.add_input(address_8_15_xor1, 256);
+	cache.add_input(address_8_15_xor2, 256);
+	cache.add_input(address_16_23_xor1, 256);
+	cache.add_input(address_16_23_xor2, 256);
+	cache.add_input(address_0_7_xor, 256);
+
+	// with sharing on, map the decrypted copy in place of the region, so every
+	// instance shares it rather than each writing its own tens of megabytes
+	if (cache.map_region("sprites"))
+		return;
+
+	// load into the scratch buffer so a bad cache file can't damage the region
+	buf = auto_alloc_array(machine, UINT8, rom_size);
+	if (cache.load(buf, rom_size))
+		memcpy(rom, buf, rom_size);
+	else
+	{
+		osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+
+		state.rom = rom;
+		state.buf = buf;
+		state.rom_size = rom_size;
+		state.extra_xor = extra_xor;
+
+		// each pass writes only the entries it is given, but the address
+		// pass reads from anywhere in the output of the data pass
+		run_parallel(queue, gfx_decrypt_data_range, &state, rom_size/4);
+		run_parallel(queue, gfx_decrypt_address_range, &state, rom_size/4);
+
+		if (queue != NULL)
+			osd_work_queue_free(queue);
+
+		cache.save(rom, rom_size);
+	}
 
 	auto_free(machine, buf);
+
+	// and swap our private copy for the shared one just saved
+	cache.map_region("sprites");
 }
 
 
@@ -1467,31 +1550,57 @@ NeoGeo 'V' (PCM) ROM encryption
 ***************************************************************************/
 
 /* Neo-Pcm2 Drivers for Encrypted V Roms */
+struct pcm2_state
+{
+	UINT8 *src;
+	const UINT8 *buf;
+	int value;
+};
+
+
+static void pcm2_snk_1999_range(void *param, INT32 start, INT32 end, int threadid)
+{
+	const pcm2_state *state = (const pcm2_state *)param;
+	UINT16 *rom = (UINT16 *)state->src;
+	int value = state->value;
+	int i, j;
+
+	/* each block swaps its two halves, so blocks are independent */
+	for( i = start * ( value / 2 ); i < end * ( value / 2 ); i += ( value / 2 ) )
+	{
+		for( j = 0; j < (value / 4); j++ )
+		{
+			UINT16 temp = rom[ i + j ];
+			rom[ i + j ] = rom[ i + j + (value / 4) ];
+			rom[ i + j + (value / 4) ] = temp;
+		}
+	}
+}
+
+
 void neo_pcm2_snk_1999(running_machine &machine, int value)
 {	/* thanks to Elsemi for the NEO-PCM2 info */
-	UINT16 *rom = (UINT16 *)machine.region("ymsnd")->base();
+	UINT8 *rom = machine.region("ymsnd")->base();
 	int size = machine.region("ymsnd")->bytes();
-	int i, j;
 
 	if( rom != NULL )
 	{	/* swap address lines on the whole ROMs */
-		UINT16 *buffer = auto_alloc_array(machine, UINT16, value / 2);
+		osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+		pcm2_state state;
 
-		for( i = 0; i < size / 2; i += ( value / 2 ) )
-		{
-			memcpy( buffer, &rom[ i ], value );
-			for( j = 0; j < (value / 2); j++ )
-			{
-				rom[ i + j ] = buffer[ j ^ (value/4) ];
-			}
-		}
-		auto_free(machine, buffer);
+		state.src = rom;
+		state.buf = NULL;
+		state.value = value;
+		run_parallel(queue, pcm2_snk_1999_range, &state, size / value);
+
+		if (queue != NULL)
+			osd_work_queue_free(queue);
 	}
 }
 
 
 /* the later PCM2 games have additional scrambling */
-void neo_pcm2_swap(running_machine &machine, int value)
+static void pcm2_swap_range(void *param, INT32 start, INT32 end, int threadid)
 {
 	static const UINT32 addrs[7][2]={
 		{0x000000,0xa5000},
@@ -1509,18 +1618,38 @@ void neo_pcm2_swap(running_machine &machine, int value)
 		{0xcb,0x29,0x7d,0x43,0xd2,0x3a,0xc2,0xb4},
 		{0x4b,0xa4,0x63,0x46,0xf0,0x91,0xea,0x62},
 		{0x4b,0xa4,0x63,0x46,0xf0,0x91,0xea,0x62}};
-	UINT8 *src = machine.region("ymsnd")->base();
-	UINT8 *buf = auto_alloc_array(machine, UINT8, 0x1000000);
+	const pcm2_state *state = (const pcm2_state *)param;
+	UINT8 *src = state->src;
+	const UINT8 *buf = state->buf;
+	int value = state->value;
 	int i, j, d;
 
-	memcpy(buf,src,0x1000000);
-	for (i=0;i<0x1000000;i++)
+	/* the address scramble is a permutation, so every i writes a different byte */
+	for (i=start;i<end;i++)
 	{
 		j=BITSWAP24(i,23,22,21,20,19,18,17,0,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,16);
 		j=j^addrs[value][1];
 		d=((i+addrs[value][0])&0xffffff);
 		src[j]=buf[d]^xordata[value][j&0x7];
 	}
+}
+
+
+void neo_pcm2_swap(running_machine &machine, int value)
+{
+	UINT8 *src = machine.region("ymsnd")->base();
+	UINT8 *buf = auto_alloc_array(machine, UINT8, 0x1000000);
+	osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	pcm2_state state;
+
+	memcpy(buf,src,0x1000000);
+	state.src = src;
+	state.buf = buf;
+	state.value = value;
+	run_parallel(queue, pcm2_swap_range, &state, 0x1000000);
+
+	if (queue != NULL)
+		osd_work_queue_free(queue);
 	auto_free(machine, buf);
 }
 
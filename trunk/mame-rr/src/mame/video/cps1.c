@@ -407,6 +407,12 @@ The games seem to use them to mark platforms, kill zones and no-go areas.
 
 #define VERBOSE 0
 
+/* DEBUGGING */
+#define CPS_SPRITE_RECORD		(0)		/* append the sprite list of every frame to <game>.obj */
+#define CPS_SPRITE_BENCHMARK	(0)		/* at startup, time the sprite drawing on the frames in <game>.obj */
+
+#define CPS_SPRITE_BIN_HEIGHT	16		/* scanlines per sprite bin */
+
 /********************************************************************
 
             Configuration table:
@@ -1469,6 +1475,12 @@ CPS1 VIDEO RENDERER
 
 
 static void cps1_build_palette(running_machine &machine, const UINT16* const palette_base);
+#if CPS_SPRITE_RECORD
+static void cps_record_sprites(running_machine &machine);
+#endif
+#if CPS_SPRITE_BENCHMARK
+static void cps_sprite_benchmark(running_machine &machine);
+#endif
 
 
 static MACHINE_RESET( cps )
@@ -2110,6 +2122,14 @@ static VIDEO_START( cps )
 	if (state->m_cps_version == 2)
 		state->m_cps2_buffered_obj = auto_alloc_array_clear(machine, UINT16, state->m_cps2_obj_size / 2);
 
+	/* the sprite tile list grows as needed */
+	state->m_sprite_tile_count = 0;
+	state->m_sprite_tile_max = 0x400;
+	state->m_sprite_tiles = auto_alloc_array(machine, struct cps_sprite_tile, state->m_sprite_tile_max);
+	state->m_sprite_bin_list = auto_alloc_array(machine, UINT32, 2 * state->m_sprite_tile_max);
+	state->m_sprite_bins = (machine.primary_screen->height() + CPS_SPRITE_BIN_HEIGHT - 1) / CPS_SPRITE_BIN_HEIGHT;
+	state->m_sprite_bin_start = auto_alloc_array_clear(machine, int, state->m_sprite_bins + 1);
+
 	/* clear RAM regions */
 	memset(state->m_gfxram, 0, state->m_gfxram_size);   /* Clear GFX RAM */
 	memset(state->m_cps_a_regs, 0, 0x40);   /* Clear CPS-A registers */
@@ -2171,6 +2191,10 @@ static VIDEO_START( cps )
 	}
 
 	machine.save().register_postload(save_prepost_delegate(FUNC(cps1_get_video_base), &machine));
+
+#if CPS_SPRITE_BENCHMARK
+	cps_sprite_benchmark(machine);
+#endif
 }
 
 VIDEO_START( cps1 )
@@ -2297,32 +2321,66 @@ static void cps1_find_last_sprite( running_machine &machine )    /* Find the off
 }
 
 
-static void cps1_render_sprites( running_machine &machine, bitmap_t *bitmap, const rectangle *cliprect )
+static void cps_grow_sprite_tiles( cps_state *state )
+{
+	running_machine &machine = state->machine();
+	int newmax = state->m_sprite_tile_max * 2;
+	struct cps_sprite_tile *tiles = auto_alloc_array(machine, struct cps_sprite_tile, newmax);
+
+	memcpy(tiles, state->m_sprite_tiles, state->m_sprite_tile_count * sizeof(*tiles));
+	auto_free(machine, state->m_sprite_tiles);
+	state->m_sprite_tiles = tiles;
+
+	/* a tile is in at most two bins */
+	auto_free(machine, state->m_sprite_bin_list);
+	state->m_sprite_bin_list = auto_alloc_array(machine, UINT32, 2 * newmax);
+	state->m_sprite_tile_max = newmax;
+}
+
+/* add a tile to the sprite list, unless it is entirely outside cliprect */
+INLINE void cps_add_sprite_tile( cps_state *state, const rectangle *cliprect, int flip, int code, int color, int flipx, int flipy, int sx, int sy, int priority )
+{
+	struct cps_sprite_tile *tile;
+
+	if (flip)
+	{
+		flipx = !flipx;
+		flipy = !flipy;
+		sx = 511 - 16 - sx;
+		sy = 255 - 16 - sy;
+	}
+
+	if (cliprect != NULL && (sx > cliprect->max_x || sx + 15 < cliprect->min_x || sy > cliprect->max_y || sy + 15 < cliprect->min_y))
+		return;
+
+	if (state->m_sprite_tile_count == state->m_sprite_tile_max)
+		cps_grow_sprite_tiles(state);
+
+	tile = &state->m_sprite_tiles[state->m_sprite_tile_count++];
+	tile->code = code;
+	tile->color = color;
+	tile->flipx = (flipx != 0);
+	tile->flipy = (flipy != 0);
+	tile->sx = sx;
+	tile->sy = sy;
+	tile->priority = priority;
+}
+
+/* expand the sprite list into tiles; cliprect is NULL to keep the ones outside the screen */
+static void cps1_build_sprite_tiles( running_machine &machine, const rectangle *cliprect )
 {
 	cps_state *state = machine.driver_data<cps_state>();
+	int flip = flip_screen_get(machine);
 
 #define DRAWSPRITE(CODE,COLOR,FLIPX,FLIPY,SX,SY)					\
-{																	\
-	if (flip_screen_get(machine))											\
-		pdrawgfx_transpen(bitmap,\
-				cliprect,machine.gfx[2],							\
-				CODE,												\
-				COLOR,												\
-				!(FLIPX),!(FLIPY),									\
-				511-16-(SX),255-16-(SY),	machine.priority_bitmap,0x02,15);					\
-	else															\
-		pdrawgfx_transpen(bitmap,\
-				cliprect,machine.gfx[2],							\
-				CODE,												\
-				COLOR,												\
-				FLIPX,FLIPY,										\
-				SX,SY,				machine.priority_bitmap,0x02,15);					\
-}
+	cps_add_sprite_tile(state, cliprect, flip, CODE, COLOR, FLIPX, FLIPY, SX, SY, 0)
 
 
 	int i, baseadd;
 	UINT16 *base = state->m_buffered_obj;
 
+	state->m_sprite_tile_count = 0;
+
 	/* some sf2 hacks draw the sprites in reverse order */
 	if (state->m_game_config->bootleg_kludge == 1)
 	{
@@ -2540,39 +2598,21 @@ static void cps2_find_last_sprite( running_machine &machine )    /* Find the off
 	state->m_cps2_last_sprite_offset = state->m_cps2_obj_size / 2 - 4;
 }
 
-static void cps2_render_sprites( running_machine &machine, bitmap_t *bitmap, const rectangle *cliprect, int *primasks )
+/* as above; xport and yport are the values of the CPS2_OBJ_XOFFS and CPS2_OBJ_YOFFS registers */
+static void cps2_build_sprite_tiles( running_machine &machine, const rectangle *cliprect, int xport, int yport )
 {
 	cps_state *state = machine.driver_data<cps_state>();
+	int flip = flip_screen_get(machine);
 
 #define DRAWSPRITE(CODE,COLOR,FLIPX,FLIPY,SX,SY)									\
-{																					\
-	if (flip_screen_get(machine))															\
-		pdrawgfx_transpen(bitmap,\
-				cliprect,machine.gfx[2],											\
-				CODE,																\
-				COLOR,																\
-				!(FLIPX),!(FLIPY),													\
-				511-16-(SX),255-16-(SY),				machine.priority_bitmap,primasks[priority],15);					\
-	else																			\
-		pdrawgfx_transpen(bitmap,\
-				cliprect,machine.gfx[2],											\
-				CODE,																\
-				COLOR,																\
-				FLIPX,FLIPY,														\
-				SX,SY,							machine.priority_bitmap,primasks[priority],15);					\
-}
+	cps_add_sprite_tile(state, cliprect, flip, CODE, COLOR, FLIPX, FLIPY, SX, SY, priority)
 
 	int i;
 	UINT16 *base = state->m_cps2_buffered_obj;
-	int xoffs = 64 - cps2_port(machine, CPS2_OBJ_XOFFS);
-	int yoffs = 16 - cps2_port(machine, CPS2_OBJ_YOFFS);
+	int xoffs = 64 - xport;
+	int yoffs = 16 - yport;
 
-#ifdef MAME_DEBUG
-	if (machine.input().code_pressed(KEYCODE_Z) && machine.input().code_pressed(KEYCODE_R))
-	{
-		return;
-	}
-#endif
+	state->m_sprite_tile_count = 0;
 
 	for (i = state->m_cps2_last_sprite_offset; i >= 0; i -= 4)
 	{
@@ -2585,8 +2625,8 @@ static void cps2_render_sprites( running_machine &machine, bitmap_t *bitmap, con
 
 		if (colour & 0x80)
 		{
-			x += cps2_port(machine, CPS2_OBJ_XOFFS);  /* fix the offset of some games */
-			y += cps2_port(machine, CPS2_OBJ_YOFFS);  /* like Marvel vs. Capcom ending credits */
+			x += xport;  /* fix the offset of some games */
+			y += yport;  /* like Marvel vs. Capcom ending credits */
 		}
 
 		if (colour & 0xff00)
@@ -2684,6 +2724,95 @@ static void cps2_render_sprites( running_machine &machine, bitmap_t *bitmap, con
 					(x+xoffs) & 0x3ff,(y+yoffs) & 0x3ff);
 		}
 	}
+#undef DRAWSPRITE
+}
+
+
+/*
+    The tiles are sorted into bins of CPS_SPRITE_BIN_HEIGHT scanlines, so that
+    drawing a band of the screen only looks at the tiles that touch it. A tile
+    straddling two bins goes in both, and each bin keeps the drawing order;
+    since every bin is drawn clipped to its own scanlines, the result is the
+    same as drawing the whole list in order.
+*/
+static void cps_bin_sprite_tiles( running_machine &machine, const rectangle *cliprect )
+{
+	cps_state *state = machine.driver_data<cps_state>();
+	int *start = state->m_sprite_bin_start;
+	int i, bin;
+
+	assert(cliprect->max_y / CPS_SPRITE_BIN_HEIGHT < state->m_sprite_bins);
+
+	/* count the tiles in each bin */
+	memset(start, 0, (state->m_sprite_bins + 1) * sizeof(*start));
+	for (i = 0; i < state->m_sprite_tile_count; i++)
+	{
+		const struct cps_sprite_tile *tile = &state->m_sprite_tiles[i];
+		int last = MIN(tile->sy + 15, cliprect->max_y) / CPS_SPRITE_BIN_HEIGHT;
+
+		for (bin = MAX(tile->sy, cliprect->min_y) / CPS_SPRITE_BIN_HEIGHT; bin <= last; bin++)
+			start[bin]++;
+	}
+
+	/* turn the counts into the end of each bin, then fill them backwards */
+	for (bin = 1; bin <= state->m_sprite_bins; bin++)
+		start[bin] += start[bin - 1];
+
+	for (i = state->m_sprite_tile_count - 1; i >= 0; i--)
+	{
+		const struct cps_sprite_tile *tile = &state->m_sprite_tiles[i];
+		int last = MIN(tile->sy + 15, cliprect->max_y) / CPS_SPRITE_BIN_HEIGHT;
+
+		for (bin = MAX(tile->sy, cliprect->min_y) / CPS_SPRITE_BIN_HEIGHT; bin <= last; bin++)
+			state->m_sprite_bin_list[--start[bin]] = i;
+	}
+}
+
+INLINE void cps_draw_sprite_tile( bitmap_t *bitmap, bitmap_t *priority_bitmap, const rectangle *cliprect, const gfx_element *gfx, const struct cps_sprite_tile *tile, const int *primasks )
+{
+	pdrawgfx_transpen(bitmap, cliprect, gfx,
+			tile->code,
+			tile->color,
+			tile->flipx, tile->flipy,
+			tile->sx, tile->sy,
+			priority_bitmap, (primasks != NULL) ? primasks[tile->priority] : 0x02, 15);
+}
+
+/* cliprect must lie within the area the tiles were binned for */
+static void cps_draw_sprite_bins( running_machine &machine, bitmap_t *bitmap, bitmap_t *priority_bitmap, const rectangle *cliprect, const int *primasks )
+{
+	cps_state *state = machine.driver_data<cps_state>();
+	const gfx_element *gfx = machine.gfx[2];
+	int bin;
+
+	for (bin = cliprect->min_y / CPS_SPRITE_BIN_HEIGHT; bin <= cliprect->max_y / CPS_SPRITE_BIN_HEIGHT; bin++)
+	{
+		rectangle clip = *cliprect;
+		int entry;
+
+		clip.min_y = MAX(clip.min_y, bin * CPS_SPRITE_BIN_HEIGHT);
+		clip.max_y = MIN(clip.max_y, bin * CPS_SPRITE_BIN_HEIGHT + CPS_SPRITE_BIN_HEIGHT - 1);
+
+		for (entry = state->m_sprite_bin_start[bin]; entry < state->m_sprite_bin_start[bin + 1]; entry++)
+			cps_draw_sprite_tile(bitmap, priority_bitmap, &clip, gfx, &state->m_sprite_tiles[state->m_sprite_bin_list[entry]], primasks);
+	}
+}
+
+static void cps1_render_sprites( running_machine &machine, bitmap_t *bitmap, const rectangle *cliprect )
+{
+	cps_draw_sprite_bins(machine, bitmap, machine.priority_bitmap, cliprect, NULL);
+}
+
+static void cps2_render_sprites( running_machine &machine, bitmap_t *bitmap, const rectangle *cliprect, int *primasks )
+{
+#ifdef MAME_DEBUG
+	if (machine.input().code_pressed(KEYCODE_Z) && machine.input().code_pressed(KEYCODE_R))
+	{
+		return;
+	}
+#endif
+
+	cps_draw_sprite_bins(machine, bitmap, machine.priority_bitmap, cliprect, primasks);
 }
 
 
@@ -2796,16 +2925,15 @@ static void cps1_render_high_layer( running_machine &machine, bitmap_t *bitmap,
 
 ***************************************************************************/
 
-SCREEN_UPDATE( cps1 )
+/* everything that changes state runs here, before the screen is drawn in bands */
+SCREEN_PREPARE( cps1 )
 {
 	cps_state *state = screen->machine().driver_data<cps_state>();
-	int layercontrol, l0, l1, l2, l3;
 	int videocontrol = state->m_cps_a_regs[CPS1_VIDEOCONTROL];
+	int layer;
 
 	flip_screen_set(screen->machine(), videocontrol & 0x8000);
 
-	layercontrol = state->m_cps_b_regs[state->m_game_config->layer_control / 2];
-
 	/* Get video memory base registers */
 	cps1_get_video_base(screen->machine());
 
@@ -2817,6 +2945,13 @@ SCREEN_UPDATE( cps1 )
 		cps2_find_last_sprite(screen->machine());
 	}
 
+	/* expand the sprites that touch this update once, rather than in every band */
+	if (state->m_cps_version == 1)
+		cps1_build_sprite_tiles(screen->machine(), cliprect);
+	else
+		cps2_build_sprite_tiles(screen->machine(), cliprect, cps2_port(screen->machine(), CPS2_OBJ_XOFFS), cps2_port(screen->machine(), CPS2_OBJ_YOFFS));
+	cps_bin_sprite_tiles(screen->machine(), cliprect);
+
 	cps1_update_transmasks(screen->machine());
 
 	tilemap_set_scrollx(state->m_bg_tilemap[0], 0, state->m_scroll1x);
@@ -2844,6 +2979,17 @@ SCREEN_UPDATE( cps1 )
 	tilemap_set_scrollx(state->m_bg_tilemap[2], 0, state->m_scroll3x);
 	tilemap_set_scrolly(state->m_bg_tilemap[2], 0, state->m_scroll3y);
 
+	/* bring the tilemaps up to date here, so the tile callbacks don't run on the band threads */
+	for (layer = 0; layer < 3; layer++)
+		tilemap_get_pixmap(state->m_bg_tilemap[layer]);
+}
+
+SCREEN_UPDATE( cps1 )
+{
+	cps_state *state = screen->machine().driver_data<cps_state>();
+	int layercontrol, l0, l1, l2, l3;
+
+	layercontrol = state->m_cps_b_regs[state->m_game_config->layer_control / 2];
 
 	/* Blank screen */
 	if (state->m_cps_version == 1)
@@ -2960,6 +3106,10 @@ SCREEN_EOF( cps1 )
 		/* CPS1 sprites have to be delayed one frame */
 		memcpy(state->m_buffered_obj, state->m_obj, state->m_obj_size);
 	}
+
+#if CPS_SPRITE_RECORD
+	cps_record_sprites(machine);
+#endif
 }
 
 void cps2_set_sprite_priorities( running_machine &machine )
@@ -2974,3 +3124,188 @@ void cps2_objram_latch( running_machine &machine )
 	cps2_set_sprite_priorities(machine);
 	memcpy(state->m_cps2_buffered_obj, cps2_objbase(machine), state->m_cps2_obj_size);
 }
+
+
+
+/***************************************************************************
+
+    Sprite list recording and benchmark
+
+***************************************************************************/
+
+#if CPS_SPRITE_RECORD || CPS_SPRITE_BENCHMARK
+
+/*
+    <game>.obj holds one record per frame, in host byte order: for CPS2 the
+    CPS2_OBJ_XOFFS and CPS2_OBJ_YOFFS registers followed by the buffered
+    object RAM, for CPS1 just the buffered object RAM.
+*/
+static int cps_sprite_record_size( cps_state *state )
+{
+	return (state->m_cps_version == 2) ? 2 * 2 + state->m_cps2_obj_size : state->m_obj_size;
+}
+
+#endif
+
+#if CPS_SPRITE_RECORD
+
+static void cps_record_sprites( running_machine &machine )
+{
+	cps_state *state = machine.driver_data<cps_state>();
+	astring filename(machine.system().name, ".obj");
+	FILE *fp = fopen(filename, "ab");
+
+	if (fp)
+	{
+		if (state->m_cps_version == 2)
+		{
+			UINT16 ports[2];
+
+			ports[0] = cps2_port(machine, CPS2_OBJ_XOFFS);
+			ports[1] = cps2_port(machine, CPS2_OBJ_YOFFS);
+			fwrite(ports, sizeof(ports), 1, fp);
+			fwrite(state->m_cps2_buffered_obj, state->m_cps2_obj_size, 1, fp);
+		}
+		else
+			fwrite(state->m_buffered_obj, state->m_obj_size, 1, fp);
+		fclose(fp);
+	}
+}
+
+#endif	/* CPS_SPRITE_RECORD */
+
+#if CPS_SPRITE_BENCHMARK
+
+/* load one recorded frame and expand its sprite list */
+static void cps_benchmark_build_frame( running_machine &machine, const UINT8 *record, const rectangle *cliprect )
+{
+	cps_state *state = machine.driver_data<cps_state>();
+
+	if (state->m_cps_version == 2)
+	{
+		const UINT16 *ports = (const UINT16 *)record;
+
+		memcpy(state->m_cps2_buffered_obj, record + 2 * 2, state->m_cps2_obj_size);
+		cps2_find_last_sprite(machine);
+		cps2_build_sprite_tiles(machine, cliprect, ports[0], ports[1]);
+	}
+	else
+	{
+		memcpy(state->m_buffered_obj, record, state->m_obj_size);
+		cps1_find_last_sprite(machine);
+		cps1_build_sprite_tiles(machine, cliprect);
+	}
+}
+
+/*
+    Draw every recorded frame in bands, the way partial and banded updates
+    do: first walking the whole object list for each band like the old
+    renderer, then with the list expanded once per frame and binned. The
+    priority bitmap is striped so that the priority masks matter.
+*/
+static void cps_sprite_benchmark( running_machine &machine )
+{
+	static const int s_bands[] = { 0, 32, 8 };
+	static const int s_primasks[8] = { 0xff, 0xfe, 0xfc, 0xf8, 0xf0, 0xcc, 0xaa, 0x00 };
+	cps_state *state = machine.driver_data<cps_state>();
+	const rectangle &visarea = machine.primary_screen->visible_area();
+	const int *primasks = (state->m_cps_version == 2) ? s_primasks : NULL;
+	int recordsize = cps_sprite_record_size(state);
+	astring filename(machine.system().name, ".obj");
+	UINT8 *records;
+	int frames;
+	FILE *fp;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL)
+	{
+		mame_printf_info("CPS sprite benchmark: no recorded frames in %s\n", filename.cstr());
+		return;
+	}
+	fseek(fp, 0, SEEK_END);
+	frames = ftell(fp) / recordsize;
+	fseek(fp, 0, SEEK_SET);
+	records = global_alloc_array(UINT8, frames * recordsize + 1);
+	frames = fread(records, recordsize, frames, fp);
+	fclose(fp);
+
+	mame_printf_info("CPS sprite benchmark, %d frames from %s:\n", frames, filename.cstr());
+	for (int band = 0; band < ARRAY_LENGTH(s_bands); band++)
+	{
+		int bandheight = (s_bands[band] != 0) ? s_bands[band] : visarea.max_y + 1 - visarea.min_y;
+		bitmap_t *dest[2], *pri[2];
+		osd_ticks_t ticks[2];
+		UINT32 tiles[2] = { 0, 0 };
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			dest[pass] = global_alloc(bitmap_t(machine.primary_screen->width(), machine.primary_screen->height(), BITMAP_FORMAT_INDEXED16));
+			pri[pass] = global_alloc(bitmap_t(machine.primary_screen->width(), machine.primary_screen->height(), BITMAP_FORMAT_INDEXED8));
+
+			ticks[pass] = osd_ticks();
+			for (int frame = 0; frame < frames; frame++)
+			{
+				const UINT8 *record = &records[frame * recordsize];
+
+				bitmap_fill(dest[pass], NULL, 0);
+				for (int y = 0; y < pri[pass]->height; y += 8)
+				{
+					rectangle stripe = { 0, pri[pass]->width - 1, y, MIN(y + 7, pri[pass]->height - 1) };
+					bitmap_fill(pri[pass], &stripe, (y / 8) & 7);
+				}
+
+				if (pass == 1)
+				{
+					cps_benchmark_build_frame(machine, record, &visarea);
+					cps_bin_sprite_tiles(machine, &visarea);
+					tiles[pass] += state->m_sprite_tile_count;
+				}
+
+				for (int y = visarea.min_y; y <= visarea.max_y; y += bandheight)
+				{
+					rectangle clip = visarea;
+
+					clip.min_y = y;
+					clip.max_y = MIN(y + bandheight - 1, visarea.max_y);
+					if (pass == 0)
+					{
+						cps_benchmark_build_frame(machine, record, NULL);
+						tiles[pass] += state->m_sprite_tile_count;
+						for (int i = 0; i < state->m_sprite_tile_count; i++)
+							cps_draw_sprite_tile(dest[pass], pri[pass], &clip, machine.gfx[2], &state->m_sprite_tiles[i], primasks);
+					}
+					else
+						cps_draw_sprite_bins(machine, dest[pass], pri[pass], &clip, primasks);
+				}
+			}
+			ticks[pass] = MAX(osd_ticks() - ticks[pass], 1);
+		}
+
+		bool match = true;
+		for (int y = visarea.min_y; y <= visarea.max_y; y++)
+			if (memcmp(BITMAP_ADDR16(dest[0], y, visarea.min_x), BITMAP_ADDR16(dest[1], y, visarea.min_x), (visarea.max_x + 1 - visarea.min_x) * 2) != 0 ||
+				memcmp(BITMAP_ADDR8(pri[0], y, visarea.min_x), BITMAP_ADDR8(pri[1], y, visarea.min_x), visarea.max_x + 1 - visarea.min_x) != 0)
+				match = false;
+
+		mame_printf_info("  %3d-line bands  per tile %7.3fms (%6d tiles)  binned %7.3fms (%6d tiles)  (%5.2fx)%s\n",
+				bandheight,
+				(double)ticks[0] * 1000.0 / (double)osd_ticks_per_second() / MAX(frames, 1), tiles[0] / MAX(frames, 1),
+				(double)ticks[1] * 1000.0 / (double)osd_ticks_per_second() / MAX(frames, 1), tiles[1] / MAX(frames, 1),
+				(double)ticks[0] / (double)ticks[1], match ? "" : "  MISMATCH");
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			global_free(dest[pass]);
+			global_free(pri[pass]);
+		}
+	}
+
+	/* leave the sprite state as VIDEO_START found it */
+	global_free(records);
+	if (state->m_cps_version == 2)
+		memset(state->m_cps2_buffered_obj, 0, state->m_cps2_obj_size);
+	memset(state->m_buffered_obj, 0, state->m_obj_size);
+	state->m_sprite_tile_count = 0;
+}
+
+#endif	/* CPS_SPRITE_BENCHMARK */
@@ -7,6 +7,7 @@
 #include "emu.h"
 #include "includes/neogeo.h"
 #include "video/resnet.h"
+#include "romcache.h"
 
 #define NUM_PENS	(0x1000)
 
@@ -675,16 +676,50 @@ static void start_sprite_line_timer( running_machine &machine )
 }
 
 
+static void optimize_sprite_data_range( void *param, INT32 start, INT32 end, int threadid )
+{
+	neogeo_state *state = (neogeo_state *)param;
+
+	/* each 0x80 byte tile becomes 0x100 bytes of the output */
+	const UINT8 *src = state->machine().region("sprites")->base() + start * 0x80;
+	UINT8 *dest = state->m_sprite_gfx + start * 0x100;
+	int i;
+
+	for (i = start; i < end; i++, src += 0x80)
+	{
+		int y;
+
+		for (y = 0; y < 0x10; y++)
+		{
+			int x;
+
+			for (x = 0; x < 8; x++)
+			{
+				*(dest++) = (((src[0x43 | (y << 2)] >> x) & 0x01) << 3) |
+						    (((src[0x41 | (y << 2)] >> x) & 0x01) << 2) |
+							(((src[0x42 | (y << 2)] >> x) & 0x01) << 1) |
+							(((src[0x40 | (y << 2)] >> x) & 0x01) << 0);
+			}
+
+			for (x = 0; x < 8; x++)
+			{
+				*(dest++) = (((src[0x03 | (y << 2)] >> x) & 0x01) << 3) |
+						    (((src[0x01 | (y << 2)] >> x) & 0x01) << 2) |
+							(((src[0x02 | (y << 2)] >> x) & 0x01) << 1) |
+							(((src[0x00 | (y << 2)] >> x) & 0x01) << 0);
+			}
+		}
+	}
+}
+
+
 static void optimize_sprite_data( running_machine &machine )
 {
 	neogeo_state *state = machine.driver_data<neogeo_state>();
 
 	/* convert the sprite graphics data into a format that
        allows faster blitting */
-	int i;
 	int len;
-	UINT8 *src;
-	UINT8 *dest;
 	UINT32 bit;
 
 	/* get mask based on the length rounded up to the nearest
@@ -701,35 +736,31 @@ static void optimize_sprite_data( running_machine &machine )
 		state->m_sprite_gfx_address_mask >>= 1;
 	}
 
-	state->m_sprite_gfx = auto_alloc_array_clear(machine, UINT8, state->m_sprite_gfx_address_mask + 1);
+	/* the converted data depends only on the (decrypted) sprite ROMs */
+	rom_transform_cache cache(machine, "neosprites");
+	cache.add_input(machine.region("sprites")->base(), len);
+
+	/* share a cached copy between instances if we can, else make our own */
+	state->m_sprite_gfx = (UINT8 *)cache.map(state->m_sprite_gfx_address_mask + 1);
+	if (state->m_sprite_gfx != NULL)
+		return;
 
-	src = machine.region("sprites")->base();
-	dest = state->m_sprite_gfx;
+	state->m_sprite_gfx = auto_alloc_array_clear(machine, UINT8, state->m_sprite_gfx_address_mask + 1);
 
-	for (i = 0; i < len; i += 0x80, src += 0x80)
+	if (!cache.load(state->m_sprite_gfx, state->m_sprite_gfx_address_mask + 1))
 	{
-		int y;
+		/* tiles are independent, so convert them on the work queue */
+		osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
 
-		for (y = 0; y < 0x10; y++)
+		if (queue != NULL)
 		{
-			int x;
-
-			for (x = 0; x < 8; x++)
-			{
-				*(dest++) = (((src[0x43 | (y << 2)] >> x) & 0x01) << 3) |
-						    (((src[0x41 | (y << 2)] >> x) & 0x01) << 2) |
-							(((src[0x42 | (y << 2)] >> x) & 0x01) << 1) |
-							(((src[0x40 | (y << 2)] >> x) & 0x01) << 0);
-			}
-
-			for (x = 0; x < 8; x++)
-			{
-				*(dest++) = (((src[0x03 | (y << 2)] >> x) & 0x01) << 3) |
-						    (((src[0x01 | (y << 2)] >> x) & 0x01) << 2) |
-							(((src[0x02 | (y << 2)] >> x) & 0x01) << 1) |
-							(((src[0x00 | (y << 2)] >> x) & 0x01) << 0);
-			}
+			osd_work_queue_parallel_for(queue, optimize_sprite_data_range, state, len / 0x80, 0);
+			osd_work_queue_free(queue);
 		}
+		else
+			optimize_sprite_data_range(state, 0, len / 0x80, 0);
+
+		cache.save(state->m_sprite_gfx, state->m_sprite_gfx_address_mask + 1);
 	}
 }
 
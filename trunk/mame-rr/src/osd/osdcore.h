@@ -71,6 +71,9 @@ extern "C" {
 #define OPEN_FLAG_CREATE_PATHS	0x0008		/* create paths as necessary */
 #define OPEN_FLAG_NO_PRELOAD	0x0010		/* do not decompress on open */
 
+/* flags controlling file mapping */
+#define MAP_FLAG_COPY_ON_WRITE	0x0001		/* writes go to private copies of the pages */
+
 /* error codes returned by routines below */
 enum _file_error
 {
@@ -89,6 +92,9 @@ typedef enum _file_error file_error;
 /* osd_file is an opaque type which represents an open file */
 typedef struct _osd_file osd_file;
 
+/* osd_mapping is an opaque type which represents part of a file mapped into memory */
+typedef struct _osd_mapping osd_mapping;
+
 /*-----------------------------------------------------------------------------
     osd_open: open a new file.
 
@@ -196,6 +202,57 @@ file_error osd_read(osd_file *file, void *buffer, UINT64 offset, UINT32 length,
 file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 length, UINT32 *actual);
 
 
+/*-----------------------------------------------------------------------------
+    osd_map: map part of an open file into memory for reading
+
+    Parameters:
+
+        file - handle to a file previously opened via osd_open
+
+        offset - offset within the file of the first byte to map
+
+        length - number of bytes to map
+
+        flags - MAP_FLAG_COPY_ON_WRITE to allow writing to the mapped data;
+            each written page becomes private to the process, and neither
+            the file nor other mappings of it see the change
+
+        base - pointer to a pointer to receive the address of the first
+            mapped byte
+
+        mapping - pointer to an osd_mapping * to receive the mapping, which
+            must later be released with osd_unmap
+
+    Return value:
+
+        a file_error describing any error that occurred while mapping the
+        file, or FILERR_NONE if no error occurred; platforms that cannot map
+        files return FILERR_FAILURE, and callers should fall back to osd_read
+
+    Notes:
+
+        Without MAP_FLAG_COPY_ON_WRITE the mapped data is read-only. Either
+        way it remains valid after the file is closed until osd_unmap is
+        called, and pages that have not been written are shared with every
+        other process mapping the same file.
+-----------------------------------------------------------------------------*/
+file_error osd_map(osd_file *file, UINT64 offset, UINT32 length, UINT32 flags, void **base, osd_mapping **mapping);
+
+
+/*-----------------------------------------------------------------------------
+    osd_unmap: release memory mapped by osd_map
+
+    Parameters:
+
+        mapping - the mapping returned by osd_map
+
+    Return value:
+
+        None
+-----------------------------------------------------------------------------*/
+void osd_unmap(osd_mapping *mapping);
+
+
 /*-----------------------------------------------------------------------------
     osd_rmfile: deletes a file
 
@@ -287,6 +344,7 @@ struct _osd_directory_entry
 	const char *		name;			/* name of the entry */
 	osd_dir_entry_type	type;			/* type of the entry */
 	UINT64				size;			/* size of the entry */
+	UINT64				last_modified;	/* modification time in OSD units, or 0 if unknown */
 };
 
 
@@ -536,6 +594,9 @@ typedef struct _osd_work_item osd_work_item;
 /* osd_work_callback is a callback function that does work */
 typedef void *(*osd_work_callback)(void *param, int threadid);
 
+/* osd_work_range_callback is a callback function that does work on elements start..end-1 of a range */
+typedef void (*osd_work_range_callback)(void *param, INT32 start, INT32 end, int threadid);
+
 
 /*-----------------------------------------------------------------------------
     osd_work_queue_alloc: create a new work queue
@@ -663,6 +724,38 @@ INLINE osd_work_item *osd_work_item_queue(osd_work_queue *queue, osd_work_callba
 }
 
 
+/*-----------------------------------------------------------------------------
+    osd_work_queue_parallel_for: split a range of elements into chunks and
+        process them on a work queue, returning once all are done
+
+    Parameters:
+
+        queue - pointer to an osd_work_queue that was previously created via
+            osd_work_queue_alloc
+
+        callback - pointer to a function that will do the work; it is called
+            once per chunk with the first and one-past-the-last element
+
+        param - a void * parameter that is passed to every call
+
+        count - total number of elements in the range
+
+        grain - number of elements per chunk, or 0 to let the queue pick a
+            size based on the number of threads
+
+    Return value:
+
+        None.
+
+    Notes:
+
+        The calling thread processes chunks as well, so the callback must
+        be safe to run on it. Chunks are claimed dynamically, so uneven
+        amounts of work per element balance out across the threads.
+-----------------------------------------------------------------------------*/
+void osd_work_queue_parallel_for(osd_work_queue *queue, osd_work_range_callback callback, void *param, INT32 count, INT32 grain);
+
+
 /*-----------------------------------------------------------------------------
     osd_work_item_wait: wait for a work item to complete
 
@@ -864,6 +957,11 @@ char *osd_get_clipboard_text(void);
         an allocated pointer to an osd_directory_entry representing
         info on the path; even if the file does not exist
 
+    Notes:
+
+        last_modified is only meaningful when compared against another value
+        returned for the same path; it changes whenever the file is written
+
 -----------------------------------------------------------------------------*/
 osd_directory_entry *osd_stat(const char *path);
 
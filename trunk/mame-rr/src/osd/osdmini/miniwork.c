@@ -132,6 +132,18 @@ osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_call
 }
 
 
+//============================================================
+//  osd_work_queue_parallel_for
+//============================================================
+
+void osd_work_queue_parallel_for(osd_work_queue *queue, osd_work_range_callback callback, void *param, INT32 count, INT32 grain)
+{
+	// execute the whole range directly
+	if (count > 0)
+		(*callback)(param, 0, count, 0);
+}
+
+
 //============================================================
 //  osd_work_item_wait
 //============================================================
@@ -28,6 +28,9 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <errno.h>
+#if defined(SDLMAME_UNIX)
+#include <sys/mman.h>
+#endif
 
 // MAME headers
 #include "sdlfile.h"
@@ -387,6 +390,66 @@ file_error osd_close(osd_file *file)
     }
 }
 
+//============================================================
+//  osd_map
+//============================================================
+
+struct _osd_mapping
+{
+	void *		base;
+	size_t		length;
+};
+
+file_error osd_map(osd_file *file, UINT64 offset, UINT32 length, UINT32 flags, void **base, osd_mapping **mapping)
+{
+#if defined(SDLMAME_UNIX)
+	if (file->type != SDLFILE_FILE)
+		return FILERR_FAILURE;
+
+	// mappings must start on a page boundary
+	UINT64 pagemask = sysconf(_SC_PAGESIZE) - 1;
+	UINT64 start = offset & ~pagemask;
+	size_t maplength = (size_t)(offset - start) + length;
+
+	// copy-on-write mappings are private and writable
+	int prot = (flags & MAP_FLAG_COPY_ON_WRITE) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+	int share = (flags & MAP_FLAG_COPY_ON_WRITE) ? MAP_PRIVATE : MAP_SHARED;
+
+	#if defined(SDLMAME_DARWIN) || defined(SDLMAME_BSD) || defined(SDLMAME_NO64BITIO)
+	void *result = mmap(NULL, maplength, prot, share, file->handle, start);
+	#else
+	void *result = mmap64(NULL, maplength, prot, share, file->handle, start);
+	#endif
+	if (result == MAP_FAILED)
+		return error_to_file_error(errno);
+
+	*mapping = (osd_mapping *)osd_malloc(sizeof(**mapping));
+	if (*mapping == NULL)
+	{
+		munmap(result, maplength);
+		return FILERR_OUT_OF_MEMORY;
+	}
+	(*mapping)->base = result;
+	(*mapping)->length = maplength;
+	*base = (UINT8 *)result + (offset - start);
+	return FILERR_NONE;
+#else
+	return FILERR_FAILURE;
+#endif
+}
+
+//============================================================
+//  osd_unmap
+//============================================================
+
+void osd_unmap(osd_mapping *mapping)
+{
+#if defined(SDLMAME_UNIX)
+	munmap(mapping->base, mapping->length);
+	osd_free(mapping);
+#endif
+}
+
 //============================================================
 //  osd_rmfile
 //============================================================
@@ -46,10 +46,13 @@ int sdl_num_processors = 0;
 
 #define SDLENV_PROCESSORS				"OSDPROCESSORS"
 #define SDLENV_CPUMASKS					"OSDCPUMASKS"
+#define SDLENV_WORKBENCH				"OSDWORKBENCH"
 
 #define INFINITE				(osd_ticks_per_second() *  (osd_ticks_t) 10000)
 #define SPIN_LOOP_TIME			(osd_ticks_per_second() / 10000)
 
+#define STAT_SIZE_BUCKETS		(32)
+
 
 //============================================================
 //  MACROS
@@ -79,23 +82,30 @@ struct _work_thread_info
 	osd_event *			wakeevent;		// wake event for the thread
 	volatile INT32		active;			// are we actively processing work?
 
+	volatile INT32		lock;			// spin lock protecting this thread's deque
+	osd_work_item *		head;			// first item in this thread's deque
+	osd_work_item **	tailptr;		// pointer to the tail pointer of the deque
+	volatile INT32		count;			// number of items in the deque
+
 #if KEEP_STATISTICS
 	INT32				itemsdone;
+	INT32				itemsstolen;
 	osd_ticks_t			actruntime;
 	osd_ticks_t			runtime;
 	osd_ticks_t			spintime;
 	osd_ticks_t			waittime;
+	INT32				sizecount[STAT_SIZE_BUCKETS];	// items completed, by log2 of their run time
+	osd_ticks_t			sizeticks[STAT_SIZE_BUCKETS];	// total run time of those items
 #endif
 };
 
 
 struct _osd_work_queue
 {
-	osd_scalable_lock *	lock;			// lock for protecting the queue
-	osd_work_item * volatile list;		// list of items in the queue
-	osd_work_item ** volatile tailptr;	// pointer to the tail pointer of work items in the queue
 	osd_work_item * volatile free;		// free list of work items
 	volatile INT32		items;			// items in the queue
+	volatile INT32		pending;		// items in the queue that have not yet been started
+	volatile INT32		nextthread;		// rotating index of the first deque to receive work
 	volatile INT32		livethreads;	// number of live threads
 	volatile INT32		waiting;		// is someone waiting on the queue to complete?
 	volatile UINT8		exiting;		// should the threads exit on their next opportunity?
@@ -106,9 +116,11 @@ struct _osd_work_queue
 
 #if KEEP_STATISTICS
 	volatile INT32		itemsqueued;	// total items queued
+	volatile INT32		batches;		// number of calls to osd_work_item_queue_multiple
 	volatile INT32		setevents;		// number of times we called SetEvent
 	volatile INT32		extraitems;		// how many extra items we got after the first in the queue loop
 	volatile INT32		spinloops;		// how many times spinning bought us more items
+	volatile INT32		steals;			// number of successful steals from another thread's deque
 #endif
 };
 
@@ -125,6 +137,17 @@ struct _osd_work_item
 	volatile INT32		done;			// is the item done?
 };
 
+
+typedef struct _work_range work_range;
+struct _work_range
+{
+	osd_work_range_callback callback;	// range callback function
+	void *				param;			// callback parameter
+	INT32				count;			// total number of elements
+	INT32				grain;			// number of elements handed out at a time
+	volatile INT32		next;			// next element to hand out
+};
+
 typedef void *PVOID;
 
 //============================================================
@@ -141,6 +164,81 @@ static int effective_num_processors(void);
 static UINT32 effective_cpu_mask(int index);
 static void * worker_thread_entry(void *param);
 static void worker_thread_process(osd_work_queue *queue, work_thread_info *thread);
+static void *parallel_for_helper(void *param, int threadid);
+#if KEEP_STATISTICS
+static void work_queue_benchmark(void);
+#endif
+
+
+//============================================================
+//  INLINE FUNCTIONS
+//============================================================
+
+//-------------------------------------------------
+//  deque_lock/deque_unlock - acquire and release
+//  the spin lock on a thread's deque; the lock is
+//  only ever held for a handful of instructions
+//-------------------------------------------------
+
+INLINE void deque_lock(work_thread_info *thread)
+{
+	while (thread->lock != 0 || compare_exchange32(&thread->lock, 0, 1) != 0)
+		osd_yield_processor();
+}
+
+INLINE void deque_unlock(work_thread_info *thread)
+{
+	atomic_exchange32(&thread->lock, 0);
+}
+
+
+//-------------------------------------------------
+//  deque_append - append a chain of items to the
+//  end of a thread's deque
+//-------------------------------------------------
+
+INLINE void deque_append(work_thread_info *thread, osd_work_item *first, osd_work_item **tailptr, INT32 count)
+{
+	deque_lock(thread);
+	*thread->tailptr = first;
+	thread->tailptr = tailptr;
+	thread->count += count;
+	deque_unlock(thread);
+}
+
+
+//-------------------------------------------------
+//  deque_remove - remove up to 'count' items from
+//  the front of a thread's deque, returning the
+//  chain and its tail pointer
+//-------------------------------------------------
+
+INLINE INT32 deque_remove(work_thread_info *thread, INT32 count, osd_work_item **first, osd_work_item ***tailptr)
+{
+	osd_work_item *item;
+	INT32 taken = 0;
+
+	deque_lock(thread);
+	item = thread->head;
+	*first = item;
+	while (item != NULL && taken < count)
+	{
+		*tailptr = &item->next;
+		item = item->next;
+		taken++;
+	}
+	if (taken > 0)
+	{
+		// detach the chain from the remaining items
+		thread->head = item;
+		if (item == NULL)
+			thread->tailptr = &thread->head;
+		**tailptr = NULL;
+		thread->count -= taken;
+	}
+	deque_unlock(thread);
+	return taken;
+}
 
 
 //============================================================
@@ -153,6 +251,16 @@ osd_work_queue *osd_work_queue_alloc(int flags)
 	osd_work_queue *queue;
 	int threadnum;
 
+#if KEEP_STATISTICS
+	// run the throughput benchmark once if requested
+	static int benchmarked;
+	if (!benchmarked && osd_getenv(SDLENV_WORKBENCH) != NULL)
+	{
+		benchmarked = TRUE;
+		work_queue_benchmark();
+	}
+#endif
+
 	// allocate a new queue
 	queue = (osd_work_queue *)osd_malloc(sizeof(*queue));
 	if (queue == NULL)
@@ -160,7 +268,6 @@ osd_work_queue *osd_work_queue_alloc(int flags)
 	memset(queue, 0, sizeof(*queue));
 
 	// initialize basic queue members
-	queue->tailptr = (osd_work_item **)&queue->list;
 	queue->flags = flags;
 
 	// allocate events for the queue
@@ -168,11 +275,6 @@ osd_work_queue *osd_work_queue_alloc(int flags)
 	if (queue->doneevent == NULL)
 		goto error;
 
-	// initialize the critical section
-	queue->lock = osd_scalable_lock_alloc();
-	if (queue->lock == NULL)
-		goto error;
-
 	// determine how many threads to create...
 	// on a single-CPU system, create 1 thread for I/O queues, and 0 threads for everything else
 	if (numprocs == 1)
@@ -191,6 +293,10 @@ osd_work_queue *osd_work_queue_alloc(int flags)
 		goto error;
 	memset(queue->thread, 0, (queue->threads + 1) * sizeof(queue->thread[0]));
 
+	// every thread, including the calling thread, gets an empty deque
+	for (threadnum = 0; threadnum <= queue->threads; threadnum++)
+		queue->thread[threadnum].tailptr = &queue->thread[threadnum].head;
+
 	// iterate over threads
 	for (threadnum = 0; threadnum < queue->threads; threadnum++)
 	{
@@ -291,12 +397,21 @@ int osd_work_queue_wait(osd_work_queue *queue, osd_ticks_t timeout)
 		begin_timing(thread->waittime);
 	}
 
-	// reset our done event and double-check the items before waiting
-	osd_event_reset(queue->doneevent);
-	atomic_exchange32(&queue->waiting, TRUE);
-	if (queue->items != 0)
-		osd_event_wait(queue->doneevent, timeout);
-	atomic_exchange32(&queue->waiting, FALSE);
+	// reset our done event and double-check the items before waiting; a thread
+	// that runs out of work signals us even if others are still busy, so keep
+	// waiting until the count actually hits 0
+	{
+		osd_ticks_t stopwait = osd_ticks() + timeout;
+
+		atomic_exchange32(&queue->waiting, TRUE);
+		while (queue->items != 0 && osd_ticks() < stopwait)
+		{
+			osd_event_reset(queue->doneevent);
+			if (queue->items != 0)
+				osd_event_wait(queue->doneevent, stopwait - osd_ticks());
+		}
+		atomic_exchange32(&queue->waiting, FALSE);
+	}
 
 	// return TRUE if we actually hit 0
 	return (queue->items == 0);
@@ -343,25 +458,60 @@ void osd_work_queue_free(osd_work_queue *queue)
 		}
 
 #if KEEP_STATISTICS
-		// output per-thread statistics
-		for (threadnum = 0; threadnum <= queue->threads; threadnum++)
 		{
-			work_thread_info *thread = &queue->thread[threadnum];
-			osd_ticks_t total = thread->runtime + thread->waittime + thread->spintime;
-			printf("Thread %d:  items=%9d run=%5.2f%% (%5.2f%%)  spin=%5.2f%%  wait/other=%5.2f%% total=%9d\n",
-					threadnum, thread->itemsdone,
-					(double)thread->runtime * 100.0 / (double)total,
-					(double)thread->actruntime * 100.0 / (double)total,
-					(double)thread->spintime * 100.0 / (double)total,
-					(double)thread->waittime * 100.0 / (double)total,
-					(UINT32) total);
+			INT32 sizecount[STAT_SIZE_BUCKETS] = { 0 };
+			osd_ticks_t sizeticks[STAT_SIZE_BUCKETS] = { 0 };
+			int bucket;
+
+			// output per-thread statistics
+			for (threadnum = 0; threadnum <= queue->threads; threadnum++)
+			{
+				work_thread_info *thread = &queue->thread[threadnum];
+				osd_ticks_t total = thread->runtime + thread->waittime + thread->spintime;
+				printf("Thread %d:  items=%9d stolen=%9d run=%5.2f%% (%5.2f%%)  spin=%5.2f%%  wait/other=%5.2f%% total=%9d\n",
+						threadnum, thread->itemsdone, thread->itemsstolen,
+						(double)thread->runtime * 100.0 / (double)total,
+						(double)thread->actruntime * 100.0 / (double)total,
+						(double)thread->spintime * 100.0 / (double)total,
+						(double)thread->waittime * 100.0 / (double)total,
+						(UINT32) total);
+
+				for (bucket = 0; bucket < STAT_SIZE_BUCKETS; bucket++)
+				{
+					sizecount[bucket] += thread->sizecount[bucket];
+					sizeticks[bucket] += thread->sizeticks[bucket];
+				}
+			}
+
+			// output the distribution of item sizes
+			for (bucket = 0; bucket < STAT_SIZE_BUCKETS; bucket++)
+				if (sizecount[bucket] != 0)
+					printf("Items < 2^%-2d ticks: count=%9d  avg=%9.0f ticks  share=%5.2f%%\n",
+							bucket + 1, sizecount[bucket],
+							(double)sizeticks[bucket] / (double)sizecount[bucket],
+							(double)sizecount[bucket] * 100.0 / (double)queue->itemsqueued);
 		}
 #endif
 	}
 
 	// free the list
 	if (queue->thread != NULL)
+	{
+		int threadnum;
+
+		// free any items left in the deques
+		for (threadnum = 0; threadnum <= queue->threads; threadnum++)
+			while (queue->thread[threadnum].head != NULL)
+			{
+				osd_work_item *item = queue->thread[threadnum].head;
+				queue->thread[threadnum].head = item->next;
+				if (item->event != NULL)
+					osd_event_free(item->event);
+				osd_free(item);
+			}
+
 		osd_free(queue->thread);
+	}
 
 	// free all the events
 	if (queue->doneevent != NULL)
@@ -377,24 +527,15 @@ void osd_work_queue_free(osd_work_queue *queue)
 		osd_free(item);
 	}
 
-	// free all items in the active list
-	while (queue->list != NULL)
-	{
-		osd_work_item *item = (osd_work_item *)queue->list;
-		queue->list = item->next;
-		if (item->event != NULL)
-			osd_event_free(item->event);
-		osd_free(item);
-	}
-
 #if KEEP_STATISTICS
 	printf("Items queued   = %9d\n", queue->itemsqueued);
+	printf("Batches        = %9d\n", queue->batches);
 	printf("SetEvent calls = %9d\n", queue->setevents);
 	printf("Extra items    = %9d\n", queue->extraitems);
 	printf("Spin loops     = %9d\n", queue->spinloops);
+	printf("Steals         = %9d\n", queue->steals);
 #endif
 
-	osd_scalable_lock_free(queue->lock);
 	// free the queue itself
 	osd_free(queue);
 }
@@ -406,24 +547,33 @@ void osd_work_queue_free(osd_work_queue *queue)
 
 osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_callback callback, INT32 numitems, void *parambase, INT32 paramstep, UINT32 flags)
 {
-	osd_work_item *itemlist = NULL, *lastitem = NULL;
+	osd_work_item *itemlist = NULL, *lastitem = NULL, *spare = NULL;
 	osd_work_item **item_tailptr = &itemlist;
-	INT32 lockslot;
-	int itemnum;
+	INT32 targets, perthread, first, remaining, busy = 0;
+	int itemnum, targetnum;
+
+	if (numitems <= 0)
+		return NULL;
+
+	// grab the whole free list in one go; swapping the head out is immune to
+	// the ABA problem that popping items one at a time would have
+	do
+	{
+		spare = (osd_work_item *)queue->free;
+	} while (spare != NULL && compare_exchange_ptr((PVOID volatile *)&queue->free, spare, NULL) != spare);
 
 	// loop over items, building up a local list of work
 	for (itemnum = 0; itemnum < numitems; itemnum++)
 	{
 		osd_work_item *item;
 
-		// first allocate a new work item; try the free list first
-		do
-		{
-			item = (osd_work_item *)queue->free;
-		} while (item != NULL && compare_exchange_ptr((PVOID volatile *)&queue->free, item, item->next) != item);
+		// first allocate a new work item; try the spares first
+		item = spare;
+		if (item != NULL)
+			spare = item->next;
 
 		// if nothing, allocate something new
-		if (item == NULL)
+		else
 		{
 			// allocate the item
 			item = (osd_work_item *)osd_malloc(sizeof(*item));
@@ -448,35 +598,74 @@ osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_call
 		parambase = (UINT8 *)parambase + paramstep;
 	}
 
-	// enqueue the whole thing within the critical section
-	lockslot = osd_scalable_lock_acquire(queue->lock);
-	*queue->tailptr = itemlist;
-	queue->tailptr = item_tailptr;
-	osd_scalable_lock_release(queue->lock, lockslot);
+	// return any unused spares to the free list; usually nobody has released
+	// anything in the meantime and we can just put the list back
+	if (spare != NULL && compare_exchange_ptr((PVOID volatile *)&queue->free, NULL, spare) != NULL)
+	{
+		osd_work_item *sparetail = spare, *next;
+		while (sparetail->next != NULL)
+			sparetail = sparetail->next;
+		do
+		{
+			next = (osd_work_item *)queue->free;
+			sparetail->next = next;
+		} while (compare_exchange_ptr((PVOID volatile *)&queue->free, next, spare) != next);
+	}
 
-	// increment the number of items in the queue
+	// account for the items before anyone can see them
 	atomic_add32(&queue->items, numitems);
 	add_to_stat(&queue->itemsqueued, numitems);
+	add_to_stat(&queue->batches, 1);
+
+	// split the batch into contiguous runs, one per worker deque, starting at a
+	// rotating position so that single items spread across the threads; with no
+	// threads, everything goes to the calling thread's deque
+	targets = (queue->threads == 0) ? 1 : MIN(queue->threads, numitems);
+	perthread = numitems / targets;
+	remaining = numitems % targets;
+	first = (queue->threads == 0) ? 0 : (atomic_increment32(&queue->nextthread) % queue->threads);
+
+	for (targetnum = 0; targetnum < targets; targetnum++)
+	{
+		work_thread_info *thread = &queue->thread[(queue->threads == 0) ? 0 : ((first + targetnum) % queue->threads)];
+		INT32 count = perthread + (targetnum < remaining);
+		osd_work_item *runstart = itemlist, **runtail = &itemlist;
+
+		// detach the next run from the local list
+		for (itemnum = 0; itemnum < count; itemnum++)
+			runtail = &(*runtail)->next;
+		itemlist = *runtail;
+		*runtail = NULL;
+
+		// only count the items as pending once they can be found; otherwise idle
+		// threads would spin waiting for the rest of the batch to land
+		atomic_add32(&queue->pending, count);
+		deque_append(thread, runstart, runtail, count);
+
+		// if this thread is not active, wake him up; otherwise, note that an
+		// idle thread should come and steal from him
+		if (queue->threads != 0 && !thread->active)
+		{
+			osd_event_set(thread->wakeevent);
+			add_to_stat(&queue->setevents, 1);
+		}
+		else
+			busy++;
+	}
 
-	// look for free threads to do the work
-	if (queue->livethreads < queue->threads)
+	// wake up idle threads to steal the work that landed on busy ones
+	if (queue->threads != 0 && busy > 0 && queue->livethreads < queue->threads)
 	{
 		int threadnum;
 
-		// iterate over all the threads
-		for (threadnum = 0; threadnum < queue->threads; threadnum++)
+		for (threadnum = 0; threadnum < queue->threads && busy > 0; threadnum++)
 		{
 			work_thread_info *thread = &queue->thread[threadnum];
-
-			// if this thread is not active, wake him up
-			if (!thread->active)
+			if (!thread->active && thread->count == 0)
 			{
 				osd_event_set(thread->wakeevent);
 				add_to_stat(&queue->setevents, 1);
-
-				// for non-shared, the first one we find is good enough
-				if (--numitems == 0)
-					break;
+				busy--;
 			}
 		}
 	}
@@ -493,6 +682,47 @@ osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_call
 }
 
 
+//============================================================
+//  osd_work_queue_parallel_for
+//============================================================
+
+void osd_work_queue_parallel_for(osd_work_queue *queue, osd_work_range_callback callback, void *param, INT32 count, INT32 grain)
+{
+	osd_work_item *helper[WORK_MAX_THREADS];
+	work_range range;
+	INT32 chunks, helpers, helpernum;
+
+	if (count <= 0)
+		return;
+
+	// by default, hand out about four chunks per thread so that uneven chunks balance out
+	if (grain <= 0)
+		grain = MAX(1, count / ((queue->threads + 1) * 4));
+
+	range.callback = callback;
+	range.param = param;
+	range.count = count;
+	range.grain = grain;
+	range.next = 0;
+
+	// queue one helper per worker thread that has something to do; each one
+	// claims chunks until the range is exhausted
+	chunks = (count + grain - 1) / grain;
+	helpers = MIN(queue->threads, chunks - 1);
+	for (helpernum = 0; helpernum < helpers; helpernum++)
+		helper[helpernum] = osd_work_item_queue(queue, parallel_for_helper, &range, 0);
+
+	// claim chunks on this thread as well
+	parallel_for_helper(&range, queue->threads);
+
+	// the range lives on our stack, so wait for every helper to return; a
+	// helper that starts late simply finds nothing left to do
+	for (helpernum = 0; helpernum < helpers; helpernum++)
+		if (helper[helpernum] != NULL)
+			osd_work_item_release(helper[helpernum]);
+}
+
+
 //============================================================
 //  osd_work_item_wait
 //============================================================
@@ -503,12 +733,25 @@ int osd_work_item_wait(osd_work_item *item, osd_ticks_t timeout)
 	if (item->done)
 		return TRUE;
 
+	// if this is a multi queue, help out rather than blocking right away
+	if (item->queue->flags & WORK_QUEUE_FLAG_MULTI)
+	{
+		osd_work_queue *queue = item->queue;
+		worker_thread_process(queue, &queue->thread[queue->threads]);
+		if (item->done)
+			return TRUE;
+	}
+
 	// if we don't have an event, create one
 	if (item->event == NULL)
 		item->event = osd_event_alloc(TRUE, FALSE);		// manual reset, not signalled
 	else
 		 osd_event_reset(item->event);
 
+	// make the event visible before checking done again; pairs with the barrier
+	// in worker_thread_process between setting done and reading the event
+	atomic_add32(&item->done, 0);
+
 	// if we don't have an event, we need to spin (shouldn't ever really happen)
 	if (item->event == NULL)
 	{
@@ -520,9 +763,14 @@ int osd_work_item_wait(osd_work_item *item, osd_ticks_t timeout)
 		} while (!item->done && osd_ticks() < stopspin);
 	}
 
-	// otherwise, block on the event until done
-	else if (!item->done)
-		osd_event_wait(item->event, timeout);
+	// otherwise, block on the event until done; the event belongs to the item
+	// rather than to a single use of it, so ignore a stale signal from before
+	else
+	{
+		osd_ticks_t stopwait = osd_ticks() + timeout;
+		while (!item->done && osd_ticks() < stopwait)
+			osd_event_wait(item->event, stopwait - osd_ticks());
+	}
 
 	// return TRUE if the refcount actually hit 0
 	return item->done;
@@ -639,7 +887,7 @@ static void *worker_thread_entry(void *param)
 	{
 		// block waiting for work or exit
 		// bail on exit, and only wait if there are no pending items in queue
-		if (!queue->exiting && queue->list == NULL)
+		if (!queue->exiting && queue->pending == 0)
 		{
 			begin_timing(thread->waittime);
 			osd_event_wait(thread->wakeevent, INFINITE);
@@ -661,7 +909,7 @@ static void *worker_thread_entry(void *param)
 			worker_thread_process(queue, thread);
 
 			// if we're a high frequency queue, spin for a while before giving up
-			if (queue->flags & WORK_QUEUE_FLAG_HIGH_FREQ && queue->list == NULL)
+			if (queue->flags & WORK_QUEUE_FLAG_HIGH_FREQ && queue->pending == 0)
 			{
 				// spin for a while looking for more work
 				begin_timing(thread->spintime);
@@ -669,14 +917,14 @@ static void *worker_thread_entry(void *param)
 
 				do {
 					int spin = 10000;
-					while (--spin && queue->list == NULL)
+					while (--spin && queue->pending == 0)
 						osd_yield_processor();
-				} while (queue->list == NULL && osd_ticks() < stopspin);
+				} while (queue->pending == 0 && osd_ticks() < stopspin);
 				end_timing(thread->spintime);
 			}
 
 			// if nothing more, release the processor
-			if (queue->list == NULL)
+			if (queue->pending == 0)
 				break;
 			add_to_stat(&queue->spinloops, 1);
 		}
@@ -694,6 +942,54 @@ static void *worker_thread_entry(void *param)
 }
 
 
+//============================================================
+//  worker_thread_steal - take work from the
+//  fullest other deque: one item to run now,
+//  plus half of the rest into our own deque
+//============================================================
+
+static osd_work_item *worker_thread_steal(osd_work_queue *queue, work_thread_info *thread)
+{
+	int threadnum = thread - queue->thread;
+	int numthreads = queue->threads + 1;
+
+	while (queue->pending != 0)
+	{
+		work_thread_info *victim = NULL;
+		osd_work_item *item, **tailptr;
+		INT32 best = 0, taken;
+		int offset;
+
+		// find the deque with the most items in it
+		for (offset = 1; offset < numthreads; offset++)
+		{
+			work_thread_info *other = &queue->thread[(threadnum + offset) % numthreads];
+			if (other->count > best)
+			{
+				best = other->count;
+				victim = other;
+			}
+		}
+		if (victim == NULL)
+			return NULL;
+
+		// grab half of its items, rounding up
+		taken = deque_remove(victim, (best + 1) / 2, &item, &tailptr);
+		if (taken == 0)
+			continue;
+		add_to_stat(&queue->steals, 1);
+		add_to_stat(&thread->itemsstolen, taken);
+
+		// keep the first one to run and queue the rest locally
+		if (taken > 1)
+			deque_append(thread, item->next, tailptr, taken - 1);
+		item->next = NULL;
+		return item;
+	}
+	return NULL;
+}
+
+
 //============================================================
 //  worker_thread_process
 //============================================================
@@ -705,53 +1001,68 @@ static void worker_thread_process(osd_work_queue *queue, work_thread_info *threa
 	begin_timing(thread->runtime);
 
 	// loop until everything is processed
-	while (queue->list != NULL)
+	while (queue->pending != 0)
 	{
-		osd_work_item *item;
-		INT32 lockslot;
+		osd_work_item *item, **tailptr;
 
-		// use a critical section to synchronize the removal of items
-		lockslot = osd_scalable_lock_acquire(queue->lock);
-		{
-			// pull the item from the queue
-			item = (osd_work_item *)queue->list;
-			if (item != NULL)
-			{
-				queue->list = item->next;
-				if (queue->list == NULL)
-					queue->tailptr = (osd_work_item **)&queue->list;
-			}
-		}
-		osd_scalable_lock_release(queue->lock, lockslot);
+		// pull the next item from our own deque, or steal one
+		if (deque_remove(thread, 1, &item, &tailptr) == 0)
+			item = worker_thread_steal(queue, thread);
 
 		// process non-NULL items
 		if (item != NULL)
 		{
+			atomic_decrement32(&queue->pending);
+
 			// call the callback and stash the result
+#if KEEP_STATISTICS
+			osd_ticks_t itemticks = get_profile_ticks();
+			int bucket;
 			begin_timing(thread->actruntime);
 			item->result = (*item->callback)(item->param, threadid);
 			end_timing(thread->actruntime);
 
-			// decrement the item count after we are done
+			// bin the item by the log2 of its run time
+			itemticks = get_profile_ticks() - itemticks;
+			bucket = 31 - count_leading_zeros((UINT32)MIN(itemticks, 0xffffffff) | 1);
+			thread->sizecount[bucket]++;
+			thread->sizeticks[bucket] += itemticks;
+#else
+			item->result = (*item->callback)(item->param, threadid);
+#endif
+
+			// decrement the item count after we are done; once the item is marked
+			// done its owner may release and reuse it, so grab the flags first
+			UINT32 flags = item->flags;
 			atomic_decrement32(&queue->items);
 			atomic_exchange32(&item->done, TRUE);
 			add_to_stat(&thread->itemsdone, 1);
 
+			// the event must be read after marking the item done (the exchange is
+			// a full barrier): a waiter creates it lazily and then rechecks done,
+			// so either we see its event or it sees us done; the event stays with
+			// the item across reuse, so the pointer remains valid
+			osd_event *event = item->event;
+
 			// if it's an auto-release item, release it
-			if (item->flags & WORK_ITEM_FLAG_AUTO_RELEASE)
+			if (flags & WORK_ITEM_FLAG_AUTO_RELEASE)
 				osd_work_item_release(item);
 
 			// set the result and signal the event
-			else if (item->event != NULL)
+			else if (event != NULL)
 			{
-				osd_event_set(item->event);
-				add_to_stat(&item->queue->setevents, 1);
+				osd_event_set(event);
+				add_to_stat(&queue->setevents, 1);
 			}
 
 			// if we removed an item and there's still work to do, bump the stats
-			if (queue->list != NULL)
+			if (queue->pending != 0)
 				add_to_stat(&queue->extraitems, 1);
 		}
+
+		// another thread got to the last items first
+		else
+			break;
 	}
 
 	// we don't need to set the doneevent for multi queues because they spin
@@ -764,4 +1075,106 @@ static void worker_thread_process(osd_work_queue *queue, work_thread_info *threa
 	end_timing(thread->runtime);
 }
 
+
+//============================================================
+//  parallel_for_helper
+//============================================================
+
+static void *parallel_for_helper(void *param, int threadid)
+{
+	work_range *range = (work_range *)param;
+
+	// claim chunks until there are none left
+	for ( ;; )
+	{
+		INT32 end = atomic_add32(&range->next, range->grain);
+		INT32 start = end - range->grain;
+		if (start >= range->count)
+			break;
+		(*range->callback)(range->param, start, MIN(end, range->count), threadid);
+	}
+	return NULL;
+}
+
+
+#if KEEP_STATISTICS
+
+//============================================================
+//  work_queue_benchmark - measure queue throughput
+//  for a range of item sizes; enabled by setting
+//  OSDWORKBENCH in the environment
+//============================================================
+
+static void *benchmark_item(void *param, int threadid)
+{
+	volatile UINT32 *work = (volatile UINT32 *)param;
+	UINT32 iter, accum = 0;
+
+	// burn a fixed number of iterations
+	for (iter = 0; iter < work[0]; iter++)
+		accum = accum * 1664525 + 1013904223;
+	work[1] = accum;
+	return NULL;
+}
+
+static void benchmark_range(void *param, INT32 start, INT32 end, int threadid)
+{
+	UINT32 *work = (UINT32 *)param;
+	for ( ; start < end; start++)
+		benchmark_item(&work[start * 2], threadid);
+}
+
+static void work_queue_benchmark(void)
+{
+	const INT32 numitems = 4096;
+	UINT32 *work = (UINT32 *)osd_malloc_array(numitems * 2 * sizeof(UINT32));
+	osd_work_queue *queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+	UINT32 size;
+
+	if (work == NULL || queue == NULL)
+		goto done;
+
+	printf("Work queue benchmark: %d threads, %d items per pass\n", queue->threads + 1, numitems);
+	printf("   size     serial items/s    queued items/s  (speedup)   parallel_for items/s  (speedup)\n");
+
+	for (size = 16; size <= 65536; size *= 4)
+	{
+		osd_ticks_t start, serial, queued, ranged;
+		INT32 itemnum;
+
+		for (itemnum = 0; itemnum < numitems; itemnum++)
+			work[itemnum * 2] = size;
+
+		// run everything on this thread as a baseline
+		start = osd_ticks();
+		for (itemnum = 0; itemnum < numitems; itemnum++)
+			benchmark_item(&work[itemnum * 2], 0);
+		serial = MAX(osd_ticks() - start, 1);
+
+		// one work item per element
+		start = osd_ticks();
+		osd_work_item_queue_multiple(queue, benchmark_item, numitems, work, 2 * sizeof(UINT32), WORK_ITEM_FLAG_AUTO_RELEASE);
+		osd_work_queue_wait(queue, INFINITE);
+		queued = MAX(osd_ticks() - start, 1);
+
+		// chunked ranges
+		start = osd_ticks();
+		osd_work_queue_parallel_for(queue, benchmark_range, work, numitems, 0);
+		ranged = MAX(osd_ticks() - start, 1);
+
+		printf("%7d  %17.0f  %16.0f  (%6.2fx)  %21.0f  (%6.2fx)\n", size,
+				(double)numitems * (double)osd_ticks_per_second() / (double)serial,
+				(double)numitems * (double)osd_ticks_per_second() / (double)queued, (double)serial / (double)queued,
+				(double)numitems * (double)osd_ticks_per_second() / (double)ranged, (double)serial / (double)ranged);
+	}
+
+done:
+	if (queue != NULL)
+		osd_work_queue_free(queue);
+	if (work != NULL)
+		osd_free(work);
+}
+
+#endif
+
 #endif // SDLMAME_NOASM
@@ -150,7 +150,7 @@ static void DisplayReplayProperties(HWND hDlg, bool bClear)
 		return;
 	if (memcmp(movie_header, "MAMETAS\0", 8) != 0)
 		return;
-	if (movie_header[0x08] != INP_HEADER_MAJVERSION)
+	if (movie_header[0x08] != INP_HEADER_MAJVERSION && movie_header[0x08] != INP_HEADER_V1VERSION)
 		return;
 
 	if (_waccess(szChoice, W_OK)) {
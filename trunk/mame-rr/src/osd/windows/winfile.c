@@ -277,6 +277,68 @@ file_error osd_close(osd_file *file)
 }
 
 
+//============================================================
+//  osd_map
+//============================================================
+
+struct _osd_mapping
+{
+	HANDLE		handle;
+	void *		view;
+};
+
+file_error osd_map(osd_file *file, UINT64 offset, UINT32 length, UINT32 flags, void **base, osd_mapping **mapping)
+{
+	SYSTEM_INFO sysinfo;
+	HANDLE handle;
+	UINT64 start;
+	void *view;
+
+	if (file->type != WINFILE_FILE)
+		return FILERR_FAILURE;
+
+	// views must start on an allocation granularity boundary
+	GetSystemInfo(&sysinfo);
+	start = offset - offset % sysinfo.dwAllocationGranularity;
+
+	// copy-on-write views need a mapping object that allows them
+	handle = CreateFileMapping(file->handle, NULL, (flags & MAP_FLAG_COPY_ON_WRITE) ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	if (handle == NULL)
+		return win_error_to_mame_file_error(GetLastError());
+	view = MapViewOfFile(handle, (flags & MAP_FLAG_COPY_ON_WRITE) ? FILE_MAP_COPY : FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)start, (SIZE_T)(offset - start) + length);
+	if (view == NULL)
+	{
+		DWORD error = GetLastError();
+		CloseHandle(handle);
+		return win_error_to_mame_file_error(error);
+	}
+
+	*mapping = (osd_mapping *)malloc(sizeof(**mapping));
+	if (*mapping == NULL)
+	{
+		UnmapViewOfFile(view);
+		CloseHandle(handle);
+		return FILERR_OUT_OF_MEMORY;
+	}
+	(*mapping)->handle = handle;
+	(*mapping)->view = view;
+	*base = (UINT8 *)view + (offset - start);
+	return FILERR_NONE;
+}
+
+
+//============================================================
+//  osd_unmap
+//============================================================
+
+void osd_unmap(osd_mapping *mapping)
+{
+	UnmapViewOfFile(mapping->view);
+	CloseHandle(mapping->handle);
+	free(mapping);
+}
+
+
 //============================================================
 //  osd_rmfile
 //============================================================
@@ -476,6 +538,7 @@ osd_directory_entry *osd_stat(const char *path)
 	result->name = ((char *) result) + sizeof(*result);
 	result->type = win_attributes_to_entry_type(find_data.dwFileAttributes);
 	result->size = find_data.nFileSizeLow | ((UINT64) find_data.nFileSizeHigh << 32);
+	result->last_modified = find_data.ftLastWriteTime.dwLowDateTime | ((UINT64) find_data.ftLastWriteTime.dwHighDateTime << 32);
 
 done:
 	if (t_path != NULL)
@@ -175,6 +175,17 @@ struct _osd_work_item
 	volatile INT32		done;			// is the item done?
 };
 
+
+typedef struct _work_range work_range;
+struct _work_range
+{
+	osd_work_range_callback callback;	// range callback function
+	void *				param;			// callback parameter
+	INT32				count;			// total number of elements
+	INT32				grain;			// number of elements handed out at a time
+	volatile INT32		next;			// next element to hand out
+};
+
 //============================================================
 //  GLOBAL VARIABLES
 //============================================================
@@ -188,6 +199,7 @@ int osd_num_processors = 0;
 static int effective_num_processors(void);
 static unsigned __stdcall worker_thread_entry(void *param);
 static void worker_thread_process(osd_work_queue *queue, work_thread_info *thread);
+static void *parallel_for_helper(void *param, int threadid);
 
 
 
@@ -623,6 +635,47 @@ osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_call
 }
 
 
+//============================================================
+//  osd_work_queue_parallel_for
+//============================================================
+
+void osd_work_queue_parallel_for(osd_work_queue *queue, osd_work_range_callback callback, void *param, INT32 count, INT32 grain)
+{
+	osd_work_item *helper[WORK_MAX_THREADS];
+	work_range range;
+	INT32 chunks, helpers, helpernum;
+
+	if (count <= 0)
+		return;
+
+	// by default, hand out about four chunks per thread so that uneven chunks balance out
+	if (grain <= 0)
+		grain = MAX(1, count / ((queue->threads + 1) * 4));
+
+	range.callback = callback;
+	range.param = param;
+	range.count = count;
+	range.grain = grain;
+	range.next = 0;
+
+	// queue one helper per worker thread that has something to do; each one
+	// claims chunks until the range is exhausted
+	chunks = (count + grain - 1) / grain;
+	helpers = MIN(queue->threads, chunks - 1);
+	for (helpernum = 0; helpernum < helpers; helpernum++)
+		helper[helpernum] = osd_work_item_queue(queue, parallel_for_helper, &range, 0);
+
+	// claim chunks on this thread as well
+	parallel_for_helper(&range, queue->threads);
+
+	// the range lives on our stack, so wait for every helper to return; a
+	// helper that starts late simply finds nothing left to do
+	for (helpernum = 0; helpernum < helpers; helpernum++)
+		if (helper[helpernum] != NULL)
+			osd_work_item_release(helper[helpernum]);
+}
+
+
 //============================================================
 //  osd_work_item_wait
 //============================================================
@@ -776,6 +829,27 @@ static unsigned __stdcall worker_thread_entry(void *param)
 }
 
 
+//============================================================
+//  parallel_for_helper
+//============================================================
+
+static void *parallel_for_helper(void *param, int threadid)
+{
+	work_range *range = (work_range *)param;
+
+	// claim chunks until there are none left
+	for ( ;; )
+	{
+		INT32 end = interlocked_add(&range->next, range->grain);
+		INT32 start = end - range->grain;
+		if (start >= range->count)
+			break;
+		(*range->callback)(range->param, start, MIN(end, range->count), threadid);
+	}
+	return NULL;
+}
+
+
 //============================================================
 //  worker_thread_process
 //============================================================
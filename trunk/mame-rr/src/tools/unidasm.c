@@ -38,6 +38,7 @@
 ****************************************************************************/
 
 #include "emu.h"
+#include "debug/debugtrc.h"
 #include <ctype.h>
 
 enum _display_type
@@ -85,6 +86,10 @@ struct _options
 	const dasm_table_entry *dasm;
 	UINT32					skip;
 	UINT32					count;
+	UINT8					trace;
+	UINT8					hasrange;
+	offs_t					rangestart;
+	offs_t					rangeend;
 };
 
 
@@ -360,6 +365,7 @@ static int parse_options(int argc, char *argv[], options *opts)
 	int pending_mode = FALSE;
 	int pending_skip = FALSE;
 	int pending_count = FALSE;
+	int pending_range = FALSE;
 	int curarch;
 	int numrows;
 	int arg;
@@ -374,7 +380,7 @@ static int parse_options(int argc, char *argv[], options *opts)
 		// is it a switch?
 		if (curarg[0] == '-')
 		{
-			if (pending_base || pending_arch || pending_mode || pending_skip || pending_count)
+			if (pending_base || pending_arch || pending_mode || pending_skip || pending_count || pending_range)
 				goto usage;
 
 			if (tolower((UINT8)curarg[1]) == 'a')
@@ -395,6 +401,10 @@ static int parse_options(int argc, char *argv[], options *opts)
 				opts->norawbytes = TRUE;
 			else if (tolower((UINT8)curarg[1]) == 'u')
 				opts->upper = TRUE;
+			else if (tolower((UINT8)curarg[1]) == 't')
+				opts->trace = TRUE;
+			else if (tolower((UINT8)curarg[1]) == 'r')
+				pending_range = TRUE;
 			else
 				goto usage;
 		}
@@ -450,6 +460,15 @@ static int parse_options(int argc, char *argv[], options *opts)
 			pending_count = FALSE;
 		}
 
+		// PC range for traces
+		else if (pending_range)
+		{
+			if (sscanf(curarg, "%x-%x", &opts->rangestart, &opts->rangeend) != 2)
+				goto usage;
+			opts->hasrange = TRUE;
+			pending_range = FALSE;
+		}
+
 		// filename
 		else if (opts->filename == NULL)
 			opts->filename = curarg;
@@ -460,7 +479,7 @@ static int parse_options(int argc, char *argv[], options *opts)
 	}
 
 	// if we have a dangling option, error
-	if (pending_base || pending_arch || pending_mode || pending_skip || pending_count)
+	if (pending_base || pending_arch || pending_mode || pending_skip || pending_count || pending_range)
 		goto usage;
 
 	// if no file or no architecture, fail
@@ -472,6 +491,7 @@ usage:
 	printf("Usage: %s <filename> -arch <architecture> [-basepc <pc>] \n", argv[0]);
 	printf("   [-mode <n>] [-norawbytes] [-flipped] [-upper] [-lower]\n");
 	printf("   [-skip <n>] [-count <n>]\n");
+	printf("   [-trace [-range <start>-<end>]]\n");
 	printf("\n");
 	printf("Supported architectures:");
 	numrows = (ARRAY_LENGTH(dasm_table) + 6) / 7;
@@ -489,6 +509,180 @@ usage:
 };
 
 
+static int disassemble_trace(const options *opts, const UINT8 *data, UINT32 length)
+{
+	const UINT8 *src = data, *end = data + length;
+	char regnames[TRACE_BINARY_MAX_REGS][256];
+	UINT64 regvalues[TRACE_BINARY_MAX_REGS];
+	UINT32 printed = 0, matched = 0;
+	UINT64 value;
+	astring pending;
+	offs_t curpc = 0;
+	int namenum;
+
+	// validate the header
+	if (length < sizeof(TRACE_BINARY_MAGIC) + 4 || memcmp(data, TRACE_BINARY_MAGIC, sizeof(TRACE_BINARY_MAGIC)) != 0)
+	{
+		fprintf(stderr, "File '%s' is not a binary trace\n", opts->filename);
+		return 1;
+	}
+	src += sizeof(TRACE_BINARY_MAGIC) + 1;
+	int opbytes = *src++;
+	int addrchars = *src++;
+	int numregs = *src++;
+	if (opbytes > TRACE_BINARY_MAX_BYTES)
+		goto corrupt;
+
+	// read the CPU tag and register names
+	for (namenum = -1; namenum < numregs; namenum++)
+	{
+		if (src >= end || src + 1 + *src > end)
+			goto corrupt;
+		int namelen = *src++;
+		if (namenum < 0)
+			printf("; trace of CPU '%.*s'\n", namelen, (const char *)src);
+		else
+		{
+			memcpy(regnames[namenum], src, namelen);
+			regnames[namenum][namelen] = 0;
+		}
+		src += namelen;
+	}
+	memset(regvalues, 0, sizeof(regvalues));
+
+	// walk the records
+	{
+		trace_opcode_cache opcache(opbytes);
+		while (src < end)
+		{
+			UINT8 type = *src++;
+			switch (type & TRACE_RECORD_TYPE_MASK)
+			{
+				case TRACE_RECORD_INSN:
+				{
+					UINT8 oprom[TRACE_BINARY_MAX_BYTES + 8], opram[TRACE_BINARY_MAX_BYTES + 8];
+					astring regs;
+
+					// PC delta
+					if (!trace_get_varint(src, end, value))
+						goto corrupt;
+					curpc += trace_unzigzag(value);
+
+					// opcode bytes, either inline or from the cache
+					memset(oprom, 0, sizeof(oprom));
+					if (type & TRACE_INSN_KNOWN)
+					{
+						const UINT8 *known = opcache.find(curpc);
+						if (known == NULL)
+							goto corrupt;
+						memcpy(oprom, known, opbytes);
+					}
+					else
+					{
+						if (src + opbytes > end)
+							goto corrupt;
+						memcpy(oprom, src, opbytes);
+						opcache.update(curpc, oprom);
+						src += opbytes;
+					}
+
+					// argument bytes, if different
+					memcpy(opram, oprom, sizeof(opram));
+					if (type & TRACE_INSN_OPRAM)
+					{
+						if (src + opbytes > end)
+							goto corrupt;
+						memcpy(opram, src, opbytes);
+						src += opbytes;
+					}
+
+					// register changes
+					if (type & TRACE_INSN_REGS)
+					{
+						if (src >= end)
+							goto corrupt;
+						int changes = *src++;
+						while (changes-- > 0)
+						{
+							if (src >= end || *src >= numregs)
+								goto corrupt;
+							int regnum = *src++;
+							if (!trace_get_varint(src, end, value))
+								goto corrupt;
+							regvalues[regnum] ^= value;
+							regs.catprintf(" %s=%" I64FMT "X", regnames[regnum], regvalues[regnum]);
+						}
+					}
+
+					// filter by range, then by skip and count
+					if (opts->hasrange && (curpc < opts->rangestart || curpc > opts->rangeend))
+					{
+						pending.reset();
+						break;
+					}
+					if (matched++ < opts->skip || (opts->count != 0 && printed >= opts->count))
+					{
+						pending.reset();
+						break;
+					}
+					printed++;
+
+					// disassemble and output, with any pending text first
+					char buffer[1024];
+					(*opts->dasm->func)(NULL, buffer, curpc, oprom, opram, opts->mode);
+					if (opts->lower)
+						for (char *p = buffer; *p != 0; p++)
+							*p = tolower((UINT8)*p);
+					else if (opts->upper)
+						for (char *p = buffer; *p != 0; p++)
+							*p = toupper((UINT8)*p);
+					printf("%s%0*X: %s", pending.cstr(), addrchars, curpc, buffer);
+					if (regs.len() != 0)
+						printf("\t;%s", regs.cstr());
+					printf("\n");
+					pending.reset();
+					break;
+				}
+
+				case TRACE_RECORD_LOOP:
+					if (!trace_get_varint(src, end, value))
+						goto corrupt;
+					if (opts->hasrange || printed == 0)
+						break;
+					printf("\n   (loops for %d instructions)\n\n", (int)value);
+					break;
+
+				case TRACE_RECORD_TEXT:
+					if (!trace_get_varint(src, end, value) || src + value > end)
+						goto corrupt;
+					pending.cat((const char *)src, value);
+					src += value;
+					break;
+
+				case TRACE_RECORD_FRAME:
+					if (!trace_get_varint(src, end, value))
+						goto corrupt;
+					if (!opts->hasrange)
+						printf("; frame %d\n", (int)value);
+					break;
+
+				default:
+					goto corrupt;
+			}
+
+			// stop once we've output enough
+			if (opts->count != 0 && printed >= opts->count)
+				break;
+		}
+	}
+	return 0;
+
+corrupt:
+	fprintf(stderr, "Binary trace '%s' is truncated or corrupt at offset %d\n", opts->filename, (int)(src - data));
+	return 1;
+}
+
+
 int main(int argc, char *argv[])
 {
 	file_error filerr;
@@ -529,6 +723,14 @@ int main(int argc, char *argv[])
 	// run it
 	try
 	{
+		// binary traces from the debugger are handled separately
+		if (opts.trace)
+		{
+			result = disassemble_trace(&opts, (const UINT8 *)data, length);
+			osd_free(data);
+			return result;
+		}
+
 		if (length > opts.skip)
 			length = length - opts.skip;
 		if ((length > opts.count) && (opts.count != 0))
@@ -39,3 +39,7 @@
 
 extern const char build_version[];
 const char build_version[] = "0.144[RR] ("__DATE__")";
+
+/* this file is rebuilt whenever any library changes, so the time identifies the build */
+extern const char build_id[];
+const char build_id[] = __DATE__ " " __TIME__;